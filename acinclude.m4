@@ -951,6 +951,25 @@ epoll_create1(EPOLL_CLOEXEC);
     )
 }])
 
+dnl ################################################################################
+dnl # LIBZMQ_CHECK_POLLER_IO_URING([action-if-found], [action-if-not-found])       #
+dnl # Checks io_uring headers are recent enough, availability is checked at       #
+dnl # runtime and epoll is used when the kernel does not support io_uring          #
+dnl ################################################################################
+AC_DEFUN([LIBZMQ_CHECK_POLLER_IO_URING], [{
+    AC_COMPILE_IFELSE([
+        AC_LANG_PROGRAM([
+#include <sys/epoll.h>
+#include <linux/io_uring.h>
+        ],[[
+struct io_uring_getevents_arg arg;
+unsigned features = IORING_FEAT_EXT_ARG;
+epoll_create1(EPOLL_CLOEXEC);
+        ]])],
+        [$1], [$2]
+    )
+}])
+
 dnl ################################################################################
 dnl # LIBZMQ_CHECK_POLLER_DEVPOLL([action-if-found], [action-if-not-found])        #
 dnl # Checks devpoll polling system                                                #
@@ -1036,7 +1055,7 @@ AC_DEFUN([LIBZMQ_CHECK_POLLER], [{
     # Allow user to override poller autodetection
     AC_ARG_WITH([poller],
         [AS_HELP_STRING([--with-poller],
-        [choose polling system manually. Valid values are 'kqueue', 'epoll', 'devpoll', 'pollset', 'poll', 'select', or 'auto'. [default=auto]])])
+        [choose polling system manually. Valid values are 'kqueue', 'epoll', 'io_uring', 'devpoll', 'pollset', 'poll', 'select', or 'auto'. [default=auto]])])
 
     if test "x$with_poller" == "x"; then
         pollers=auto
@@ -1085,6 +1104,13 @@ AC_DEFUN([LIBZMQ_CHECK_POLLER], [{
                         ;;
                 esac
             ;;
+            io_uring)
+                LIBZMQ_CHECK_POLLER_IO_URING([
+                    AC_MSG_NOTICE([Using 'io_uring' polling system])
+                    AC_DEFINE(ZMQ_USE_IO_URING, 1, [Use 'io_uring' polling system])
+                    poller_found=1
+                ])
+            ;;
             devpoll)
                 LIBZMQ_CHECK_POLLER_DEVPOLL([
                     AC_MSG_NOTICE([Using 'devpoll' polling system])
@@ -0,0 +1,187 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  Measures the cost of receiving messages on a PULL socket fair-queuing
+//  among many inproc PUSH senders whose queues are all full, reading
+//  the given number of messages from a sender before moving on to the
+//  next one (ZMQ_FQ_BATCH).
+
+int main (int argc, char *argv[])
+{
+    if (argc != 5) {
+        printf ("usage: fq_thr <sender-count> <message-size> "
+                "<messages-per-sender> <batch>\n");
+        return 1;
+    }
+
+    const int sender_count = atoi (argv[1]);
+    const size_t message_size = atoi (argv[2]);
+    const int per_sender = atoi (argv[3]);
+    const int batch = atoi (argv[4]);
+
+    void *ctx = zmq_ctx_new ();
+    if (!ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    //  Every sender is a socket of its own.
+    int rc = zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, sender_count + 1);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    if (!pull) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_setsockopt (pull, ZMQ_FQ_BATCH, &batch, sizeof batch);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_setsockopt (pull, ZMQ_RCVHWM, &per_sender, sizeof per_sender);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_bind (pull, "inproc://fq_thr");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void **senders = (void **) malloc (sender_count * sizeof (void *));
+    if (!senders) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+
+    //  Fill the queues of all the senders before receiving anything.
+    for (int i = 0; i != sender_count; i++) {
+        senders[i] = zmq_socket (ctx, ZMQ_PUSH);
+        if (!senders[i]) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_setsockopt (senders[i], ZMQ_SNDHWM, &per_sender,
+                             sizeof per_sender);
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_connect (senders[i], "inproc://fq_thr");
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+
+        zmq_msg_t msg;
+        for (int j = 0; j != per_sender; j++) {
+            rc = zmq_msg_init_size (&msg, message_size);
+            if (rc != 0) {
+                printf ("error in zmq_msg_init_size: %s\n",
+                        zmq_strerror (errno));
+                return -1;
+            }
+#if defined ZMQ_MAKE_VALGRIND_HAPPY
+            memset (zmq_msg_data (&msg), 0, message_size);
+#endif
+            rc = zmq_msg_send (&msg, senders[i], 0);
+            if (rc < 0) {
+                printf ("error in zmq_msg_send: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+    }
+
+    zmq_msg_t msg;
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    const int message_count = sender_count * per_sender;
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != message_count; i++) {
+        rc = zmq_msg_recv (&msg, pull, 0);
+        if (rc < 0) {
+            printf ("error in zmq_msg_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    const double throughput = (double) message_count / elapsed * 1000000;
+    printf ("sender count: %d\n", sender_count);
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", message_count);
+    printf ("batch: %d\n", batch);
+    printf ("mean throughput: %d [msg/s]\n", (int) throughput);
+
+    for (int i = 0; i != sender_count; i++) {
+        rc = zmq_close (senders[i]);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    free (senders);
+
+    rc = zmq_close (pull);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,318 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+
+#include <algorithm>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  Measures the latency of messages load balanced by a PUSH socket among
+//  a number of inproc PULL consumers, one of which spends the given time
+//  on each message it receives. Each message carries the time it was sent
+//  at, and the consumers record how long it took to reach them.
+
+struct consumer_t
+{
+    void *pull;
+    void *control;
+    void *watch;
+    int delay;
+
+    //  Latencies of the messages received, in microseconds.
+    unsigned long *latencies;
+    int received;
+};
+
+static void consumer_routine (void *arg_)
+{
+    consumer_t *consumer = (consumer_t *) arg_;
+    void *pull = consumer->pull;
+    void *control = consumer->control;
+
+    zmq_pollitem_t items[] = {{pull, 0, ZMQ_POLLIN, 0},
+                              {control, 0, ZMQ_POLLIN, 0}};
+    bool done = false;
+    while (true) {
+        int rc = zmq_poll (items, 2, -1);
+        if (rc < 0) {
+            printf ("error in zmq_poll: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+
+        //  Once the producer is done, all the messages are already queued
+        //  and the rest is received without blocking.
+        if (items[1].revents & ZMQ_POLLIN)
+            done = true;
+
+        unsigned long sent_at;
+        while (zmq_recv (pull, &sent_at, sizeof sent_at, ZMQ_DONTWAIT) >= 0) {
+            const unsigned long now = zmq_stopwatch_intermediate (
+              consumer->watch);
+            consumer->latencies[consumer->received++] = now - sent_at;
+
+            //  Simulate the processing of the message.
+            while (consumer->delay > 0
+                   && zmq_stopwatch_intermediate (consumer->watch) - now
+                        < (unsigned long) consumer->delay)
+                ;
+        }
+        if (zmq_errno () != EAGAIN) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        if (done)
+            break;
+    }
+
+    int rc = zmq_close (control);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    rc = zmq_close (pull);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+}
+
+static int parse_strategy (const char *name_)
+{
+    if (strcmp (name_, "round-robin") == 0)
+        return ZMQ_LB_ROUND_ROBIN;
+    if (strcmp (name_, "shortest-queue") == 0)
+        return ZMQ_LB_SHORTEST_QUEUE;
+    if (strcmp (name_, "power-of-two") == 0)
+        return ZMQ_LB_POWER_OF_TWO;
+    if (strcmp (name_, "weighted") == 0)
+        return ZMQ_LB_WEIGHTED;
+    printf ("unknown strategy: %s\n", name_);
+    exit (1);
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 6) {
+        printf ("usage: lb_thr <strategy> <consumer-count> <message-count> "
+                "<message-rate> <slow-delay-us>\n"
+                "strategies: round-robin, shortest-queue, power-of-two, "
+                "weighted\n"
+                "the weighted strategy gives the slow consumer weight 1 and "
+                "the others weight 10\n");
+        return 1;
+    }
+
+    const int strategy = parse_strategy (argv[1]);
+    const int consumer_count = atoi (argv[2]);
+    const int message_count = atoi (argv[3]);
+    const int message_rate = atoi (argv[4]);
+    const int slow_delay = atoi (argv[5]);
+    if (consumer_count < 1 || message_count < 1 || message_rate < 1) {
+        printf ("invalid arguments\n");
+        return 1;
+    }
+
+    void *ctx = zmq_ctx_new ();
+    if (!ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    if (!push) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    int rc =
+      zmq_setsockopt (push, ZMQ_LB_STRATEGY, &strategy, sizeof strategy);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void *watch = zmq_stopwatch_start ();
+    consumer_t *consumers =
+      (consumer_t *) malloc (consumer_count * sizeof (consumer_t));
+    void **controls = (void **) malloc (consumer_count * sizeof (void *));
+    void **threads = (void **) malloc (consumer_count * sizeof (void *));
+    if (!consumers || !controls || !threads) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+
+    char endpoint[64];
+    for (int i = 0; i != consumer_count; i++) {
+        consumers[i].watch = watch;
+        consumers[i].delay = i == 0 ? slow_delay : 0;
+        consumers[i].latencies =
+          (unsigned long *) malloc (message_count * sizeof (unsigned long));
+        if (!consumers[i].latencies) {
+            printf ("error in malloc\n");
+            return -1;
+        }
+        consumers[i].received = 0;
+
+        consumers[i].pull = zmq_socket (ctx, ZMQ_PULL);
+        if (!consumers[i].pull) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        sprintf (endpoint, "inproc://lb_thr_%d", i);
+        rc = zmq_bind (consumers[i].pull, endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+
+        //  The peers are attached with the weight set when connecting
+        //  to them.
+        const int weight = i == 0 ? 1 : 10;
+        rc = zmq_setsockopt (push, ZMQ_LB_WEIGHT, &weight, sizeof weight);
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_connect (push, endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+
+        sprintf (endpoint, "inproc://lb_thr_control_%d", i);
+        controls[i] = zmq_socket (ctx, ZMQ_PAIR);
+        consumers[i].control = zmq_socket (ctx, ZMQ_PAIR);
+        if (!controls[i] || !consumers[i].control) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_bind (controls[i], endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_connect (consumers[i].control, endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+
+        //  The sockets are used by the consumer thread from now on.
+        threads[i] = zmq_threadstart (consumer_routine, &consumers[i]);
+    }
+
+    void *elapsed_watch = zmq_stopwatch_start ();
+    const unsigned long start = zmq_stopwatch_intermediate (watch);
+    for (int i = 0; i != message_count; i++) {
+        //  Send the messages at the given rate.
+        const unsigned long due =
+          start + (unsigned long) ((double) i * 1000000 / message_rate);
+        unsigned long sent_at;
+        while ((sent_at = zmq_stopwatch_intermediate (watch)) < due)
+            ;
+        rc = zmq_send (push, &sent_at, sizeof sent_at, 0);
+        if (rc < 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    for (int i = 0; i != consumer_count; i++) {
+        rc = zmq_send (controls[i], NULL, 0, 0);
+        if (rc < 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    for (int i = 0; i != consumer_count; i++)
+        zmq_threadclose (threads[i]);
+    const unsigned long elapsed = zmq_stopwatch_stop (elapsed_watch);
+
+    //  Gather the latencies of all the consumers.
+    unsigned long *latencies =
+      (unsigned long *) malloc (message_count * sizeof (unsigned long));
+    if (!latencies) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+    int received = 0;
+    for (int i = 0; i != consumer_count; i++) {
+        memcpy (latencies + received, consumers[i].latencies,
+                consumers[i].received * sizeof (unsigned long));
+        received += consumers[i].received;
+    }
+    if (received != message_count) {
+        printf ("error: received %d messages of %d\n", received,
+                message_count);
+        return -1;
+    }
+    std::sort (latencies, latencies + message_count);
+
+    printf ("strategy: %s\n", argv[1]);
+    printf ("consumer count: %d\n", consumer_count);
+    printf ("message count: %d\n", message_count);
+    printf ("message rate: %d [msg/s]\n", message_rate);
+    printf ("slow consumer delay: %d [us]\n", slow_delay);
+    printf ("messages to slow consumer: %d\n", consumers[0].received);
+    printf ("mean throughput: %d [msg/s]\n",
+            (int) ((double) message_count * 1000000 / elapsed));
+    printf ("latency p50: %lu [us]\n", latencies[message_count / 2]);
+    printf ("latency p99: %lu [us]\n",
+            latencies[(int) (message_count * 0.99)]);
+    printf ("latency max: %lu [us]\n", latencies[message_count - 1]);
+
+    for (int i = 0; i != consumer_count; i++) {
+        rc = zmq_close (controls[i]);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        free (consumers[i].latencies);
+    }
+    free (latencies);
+    free (threads);
+    free (controls);
+    free (consumers);
+    zmq_stopwatch_stop (watch);
+
+    rc = zmq_close (push);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,227 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+
+//  Measures the cost of publishing messages to many subscribers connected
+//  over TCP, the subscribers being served by the I/O threads. Messages are
+//  sent in batches using zmq_sendmmsg, a batch of 1 meaning zmq_msg_send.
+//  Only the sending is timed, the messages are then received by all the
+//  subscribers to check that they are delivered.
+
+#define MAX_BATCH_SIZE 1024
+
+int main (int argc, char *argv[])
+{
+    if (argc != 5) {
+        printf ("usage: pub_fanout <subscriber-count> <message-size> "
+                "<message-count> <batch-size>\n");
+        return 1;
+    }
+
+    const int subscriber_count = atoi (argv[1]);
+    const size_t message_size = atoi (argv[2]);
+    const int message_count = atoi (argv[3]);
+    const int batch_size = atoi (argv[4]);
+    if (batch_size < 1 || batch_size > MAX_BATCH_SIZE) {
+        printf ("batch size must be between 1 and %d\n", MAX_BATCH_SIZE);
+        return 1;
+    }
+
+    void *ctx = zmq_ctx_new ();
+    if (!ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    int rc = zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, subscriber_count + 1);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    //  An XPUB socket, to know when all the subscribers are connected.
+    void *pub = zmq_socket (ctx, ZMQ_XPUB);
+    if (!pub) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    const int verbose = 1;
+    rc = zmq_setsockopt (pub, ZMQ_XPUB_VERBOSE, &verbose, sizeof verbose);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    const int hwm = 0;
+    rc = zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof hwm);
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_bind (pub, "tcp://127.0.0.1:*");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    char endpoint[256];
+    size_t endpoint_size = sizeof endpoint;
+    rc = zmq_getsockopt (pub, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_size);
+    if (rc != 0) {
+        printf ("error in zmq_getsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void **subs = (void **) malloc (subscriber_count * sizeof (void *));
+    if (!subs) {
+        printf ("error in malloc\n");
+        return -1;
+    }
+    for (int i = 0; i != subscriber_count; i++) {
+        subs[i] = zmq_socket (ctx, ZMQ_SUB);
+        if (!subs[i]) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_setsockopt (subs[i], ZMQ_RCVHWM, &hwm, sizeof hwm);
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_setsockopt (subs[i], ZMQ_SUBSCRIBE, "", 0);
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        rc = zmq_connect (subs[i], endpoint);
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    //  Wait for the subscriptions.
+    char subscription[16];
+    for (int i = 0; i != subscriber_count; i++) {
+        rc = zmq_recv (pub, subscription, sizeof subscription, 0);
+        if (rc < 0) {
+            printf ("error in zmq_recv: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+
+    zmq_msg_t msgs[MAX_BATCH_SIZE];
+    unsigned long elapsed = 0;
+    for (int sent = 0; sent != message_count;) {
+        int count = message_count - sent;
+        if (count > batch_size)
+            count = batch_size;
+        for (int i = 0; i != count; i++) {
+            rc = zmq_msg_init_size (&msgs[i], message_size);
+            if (rc != 0) {
+                printf ("error in zmq_msg_init_size: %s\n",
+                        zmq_strerror (errno));
+                return -1;
+            }
+        }
+
+        void *watch = zmq_stopwatch_start ();
+        if (count == 1)
+            rc = zmq_msg_send (&msgs[0], pub, 0) < 0 ? -1 : 1;
+        else
+            rc = zmq_sendmmsg (pub, msgs, count, 0);
+        elapsed += zmq_stopwatch_stop (watch);
+        if (rc != count) {
+            printf ("error in zmq_sendmmsg: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        sent += count;
+
+        for (int i = 0; i != count; i++) {
+            rc = zmq_msg_close (&msgs[i]);
+            if (rc != 0) {
+                printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+    }
+
+    zmq_msg_t msg;
+    rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    for (int i = 0; i != subscriber_count; i++) {
+        for (int j = 0; j != message_count; j++) {
+            rc = zmq_msg_recv (&msg, subs[i], 0);
+            if (rc < 0) {
+                printf ("error in zmq_msg_recv: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+    }
+    rc = zmq_msg_close (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    const double copies = (double) message_count * subscriber_count;
+    printf ("subscriber count: %d\n", subscriber_count);
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", message_count);
+    printf ("batch size: %d\n", batch_size);
+    printf ("send time: %.1f [us/msg]\n", (double) elapsed / message_count);
+    printf ("send cost per subscriber: %.1f [ns]\n", elapsed * 1000 / copies);
+
+    for (int i = 0; i != subscriber_count; i++) {
+        rc = zmq_close (subs[i]);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    free (subs);
+
+    rc = zmq_close (pub);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
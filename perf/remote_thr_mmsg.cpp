@@ -0,0 +1,127 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+//  Same as remote_thr, but sends the messages in batches using
+//  zmq_sendmmsg. To be used together with local_thr_mmsg.
+
+#define MAX_BATCH_SIZE 1024
+
+int main (int argc, char *argv[])
+{
+    const char *connect_to;
+    int message_count;
+    int message_size;
+    int batch_size;
+    void *ctx;
+    void *s;
+    int rc;
+    int i;
+    int sent;
+    zmq_msg_t msgs[MAX_BATCH_SIZE];
+
+    if (argc != 5) {
+        printf ("usage: remote_thr_mmsg <connect-to> <message-size> "
+                "<message-count> <batch-size>\n");
+        return 1;
+    }
+    connect_to = argv[1];
+    message_size = atoi (argv[2]);
+    message_count = atoi (argv[3]);
+    batch_size = atoi (argv[4]);
+    if (batch_size < 1 || batch_size > MAX_BATCH_SIZE) {
+        printf ("batch size must be between 1 and %d\n", MAX_BATCH_SIZE);
+        return 1;
+    }
+
+    ctx = zmq_init (1);
+    if (!ctx) {
+        printf ("error in zmq_init: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    s = zmq_socket (ctx, ZMQ_PUSH);
+    if (!s) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_connect (s, connect_to);
+    if (rc != 0) {
+        printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    for (sent = 0; sent != message_count;) {
+        int count = message_count - sent;
+        if (count > batch_size)
+            count = batch_size;
+        for (i = 0; i != count; i++) {
+            rc = zmq_msg_init_size (&msgs[i], message_size);
+            if (rc != 0) {
+                printf ("error in zmq_msg_init_size: %s\n",
+                        zmq_strerror (errno));
+                return -1;
+            }
+        }
+
+        //  A blocking zmq_sendmmsg sends the whole batch.
+        rc = zmq_sendmmsg (s, msgs, count, 0);
+        if (rc != count) {
+            printf ("error in zmq_sendmmsg: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+        sent += count;
+
+        for (i = 0; i != count; i++) {
+            rc = zmq_msg_close (&msgs[i]);
+            if (rc != 0) {
+                printf ("error in zmq_msg_close: %s\n", zmq_strerror (errno));
+                return -1;
+            }
+        }
+    }
+
+    rc = zmq_close (s);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
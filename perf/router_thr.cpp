@@ -0,0 +1,257 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../include/zmq.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//  Measures the throughput of a ROUTER socket talking to a growing number
+//  of DEALER peers over inproc: the rate at which it routes messages to
+//  the peers (fan-out) and receives messages from them (fan-in). Only the
+//  calls made on the ROUTER socket are timed.
+
+static void **peers_create (void *ctx_, int peer_count_)
+{
+    void **peers = (void **) malloc (peer_count_ * sizeof (void *));
+    if (!peers) {
+        printf ("error in malloc\n");
+        exit (1);
+    }
+
+    for (int i = 0; i != peer_count_; i++) {
+        peers[i] = zmq_socket (ctx_, ZMQ_DEALER);
+        if (!peers[i]) {
+            printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        char routing_id[16];
+        sprintf (routing_id, "peer%d", i);
+        int rc = zmq_setsockopt (peers[i], ZMQ_ROUTING_ID, routing_id,
+                                 strlen (routing_id));
+        if (rc != 0) {
+            printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        rc = zmq_connect (peers[i], "inproc://router_thr");
+        if (rc != 0) {
+            printf ("error in zmq_connect: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+    return peers;
+}
+
+static void send_to_router (void **peers_, int peer_count_, size_t size_)
+{
+    zmq_msg_t msg;
+    for (int i = 0; i != peer_count_; i++) {
+        int rc = zmq_msg_init_size (&msg, size_);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+#if defined ZMQ_MAKE_VALGRIND_HAPPY
+        memset (zmq_msg_data (&msg), 0, size_);
+#endif
+        rc = zmq_msg_send (&msg, peers_[i], 0);
+        if (rc < 0) {
+            printf ("error in zmq_msg_send: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+}
+
+static void recv_from_router (void **peers_, int peer_count_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    for (int i = 0; i != peer_count_; i++) {
+        rc = zmq_msg_recv (&msg, peers_[i], 0);
+        if (rc < 0) {
+            printf ("error in zmq_msg_recv: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+    zmq_msg_close (&msg);
+}
+
+//  Receives a message, routing id first, from each of the peers.
+static void fan_in (void *router_, int peer_count_)
+{
+    zmq_msg_t msg;
+    int rc = zmq_msg_init (&msg);
+    if (rc != 0) {
+        printf ("error in zmq_msg_init: %s\n", zmq_strerror (errno));
+        exit (1);
+    }
+    for (int i = 0; i != 2 * peer_count_; i++) {
+        rc = zmq_msg_recv (&msg, router_, 0);
+        if (rc < 0) {
+            printf ("error in zmq_msg_recv: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+    zmq_msg_close (&msg);
+}
+
+//  Sends a message, routing id first, to each of the peers.
+static void fan_out (void *router_, int peer_count_, size_t size_)
+{
+    zmq_msg_t msg;
+    for (int i = 0; i != peer_count_; i++) {
+        char routing_id[16];
+        sprintf (routing_id, "peer%d", i);
+        int rc = zmq_send (router_, routing_id, strlen (routing_id),
+                           ZMQ_SNDMORE);
+        if (rc < 0) {
+            printf ("error in zmq_send: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+        rc = zmq_msg_init_size (&msg, size_);
+        if (rc != 0) {
+            printf ("error in zmq_msg_init_size: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+#if defined ZMQ_MAKE_VALGRIND_HAPPY
+        memset (zmq_msg_data (&msg), 0, size_);
+#endif
+        rc = zmq_msg_send (&msg, router_, 0);
+        if (rc < 0) {
+            printf ("error in zmq_msg_send: %s\n", zmq_strerror (errno));
+            exit (1);
+        }
+    }
+}
+
+int main (int argc, char *argv[])
+{
+    if (argc != 4) {
+        printf (
+          "usage: router_thr <peer-count> <message-size> <round-count>\n");
+        return 1;
+    }
+
+    const int peer_count = atoi (argv[1]);
+    const size_t message_size = atoi (argv[2]);
+    const int round_count = atoi (argv[3]);
+
+    void *ctx = zmq_ctx_new ();
+    if (!ctx) {
+        printf ("error in zmq_ctx_new: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    //  Every peer is a socket of its own.
+    int rc = zmq_ctx_set (ctx, ZMQ_MAX_SOCKETS, peer_count + 1);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_set: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void *router = zmq_socket (ctx, ZMQ_ROUTER);
+    if (!router) {
+        printf ("error in zmq_socket: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    int mandatory = 1;
+    rc = zmq_setsockopt (router, ZMQ_ROUTER_MANDATORY, &mandatory,
+                         sizeof (mandatory));
+    if (rc != 0) {
+        printf ("error in zmq_setsockopt: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+    rc = zmq_bind (router, "inproc://router_thr");
+    if (rc != 0) {
+        printf ("error in zmq_bind: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    void **peers = peers_create (ctx, peer_count);
+
+    //  Receiving a first message from every peer makes sure the router
+    //  knows all of them before routing messages to them.
+    send_to_router (peers, peer_count, message_size);
+    fan_in (router, peer_count);
+
+    unsigned long fan_out_elapsed = 0;
+    unsigned long fan_in_elapsed = 0;
+    for (int i = 0; i != round_count; i++) {
+        void *watch = zmq_stopwatch_start ();
+        fan_out (router, peer_count, message_size);
+        fan_out_elapsed += zmq_stopwatch_stop (watch);
+        recv_from_router (peers, peer_count);
+
+        send_to_router (peers, peer_count, message_size);
+        watch = zmq_stopwatch_start ();
+        fan_in (router, peer_count);
+        fan_in_elapsed += zmq_stopwatch_stop (watch);
+    }
+    if (fan_out_elapsed == 0)
+        fan_out_elapsed = 1;
+    if (fan_in_elapsed == 0)
+        fan_in_elapsed = 1;
+
+    const double message_count = (double) peer_count * round_count;
+    printf ("peer count: %d\n", peer_count);
+    printf ("message size: %d [B]\n", (int) message_size);
+    printf ("message count: %d\n", (int) message_count);
+    printf ("fan-out throughput: %d [msg/s]\n",
+            (int) (message_count * 1000000 / fan_out_elapsed));
+    printf ("fan-in throughput: %d [msg/s]\n",
+            (int) (message_count * 1000000 / fan_in_elapsed));
+
+    for (int i = 0; i != peer_count; i++) {
+        rc = zmq_close (peers[i]);
+        if (rc != 0) {
+            printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+            return -1;
+        }
+    }
+    free (peers);
+
+    rc = zmq_close (router);
+    if (rc != 0) {
+        printf ("error in zmq_close: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    rc = zmq_ctx_term (ctx);
+    if (rc != 0) {
+        printf ("error in zmq_ctx_term: %s\n", zmq_strerror (errno));
+        return -1;
+    }
+
+    return 0;
+}
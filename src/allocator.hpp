@@ -0,0 +1,88 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_ALLOCATOR_HPP_INCLUDED__
+#define __ZMQ_ALLOCATOR_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <stdlib.h>
+
+namespace zmq
+{
+//  Allocates the memory holding the messages passed through the sockets
+//  of a context, as set by zmq_ctx_set_allocator. When default-constructed,
+//  it allocates from the heap.
+
+class allocator_t
+{
+  public:
+    typedef void *(allocate_fn) (size_t size_, void *hint_);
+    typedef void (deallocate_fn) (void *data_, size_t size_, void *hint_);
+
+    allocator_t () : allocate_func (NULL), deallocate_func (NULL), hint (NULL)
+    {
+    }
+
+    allocator_t (allocate_fn *allocate_func_,
+                 deallocate_fn *deallocate_func_,
+                 void *hint_) :
+        allocate_func (allocate_func_),
+        deallocate_func (deallocate_func_),
+        hint (hint_)
+    {
+    }
+
+    //  Returns true if memory is allocated from the heap.
+    bool is_default () const { return allocate_func == NULL; }
+
+    //  Returns NULL if out of memory.
+    void *allocate (size_t size_) const
+    {
+        if (allocate_func)
+            return allocate_func (size_, hint);
+        return malloc (size_);
+    }
+
+    //  Size must be the one the memory was allocated with.
+    void deallocate (void *data_, size_t size_) const
+    {
+        if (deallocate_func)
+            deallocate_func (data_, size_, hint);
+        else
+            free (data_);
+    }
+
+  private:
+    allocate_fn *allocate_func;
+    deallocate_fn *deallocate_func;
+    void *hint;
+};
+}
+
+#endif
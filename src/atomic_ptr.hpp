@@ -272,6 +272,26 @@ struct atomic_value_t
 #endif
     }
 
+    //  Perform atomic 'compare and swap' operation on the value. The
+    //  value is compared to 'cmp' argument and if they are equal, it is
+    //  set to 'val'. Old value is returned.
+    int cas (int cmp_, const int val_)
+    {
+#if defined ZMQ_ATOMIC_PTR_CXX11
+        value.compare_exchange_strong (cmp_, val_, std::memory_order_acq_rel);
+        return cmp_;
+#else
+        return (int) (ptrdiff_t) atomic_cas ((void **) &value,
+                                             (void *) (ptrdiff_t) cmp_,
+                                             (void *) (ptrdiff_t) val_
+#if defined ZMQ_ATOMIC_PTR_MUTEX
+                                             ,
+                                             sync
+#endif
+        );
+#endif
+    }
+
   private:
 #if defined ZMQ_ATOMIC_PTR_CXX11
     std::atomic<int> value;
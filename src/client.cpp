@@ -34,7 +34,9 @@
 #include "msg.hpp"
 
 zmq::client_t::client_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
-    socket_base_t (parent_, tid_, sid_, true)
+    socket_base_t (parent_, tid_, sid_, true),
+    fq (options),
+    lb (options)
 {
     options.type = ZMQ_CLIENT;
 }
@@ -38,6 +38,7 @@ namespace zmq
 class object_t;
 class own_t;
 struct i_engine;
+struct dns_request_t;
 class pipe_t;
 class socket_base_t;
 
@@ -61,6 +62,7 @@ __declspec(align (64))
         attach,
         bind,
         activate_read,
+        activate_read_batch,
         activate_write,
         hiccup,
         pipe_term,
@@ -73,6 +75,8 @@ __declspec(align (64))
         reap,
         reaped,
         inproc_connected,
+        resolve,
+        resolved,
         done
     } type;
 
@@ -115,6 +119,16 @@ __declspec(align (64))
         {
         } activate_read;
 
+        //  Sent by the writer of several pipes to inform their dormant
+        //  readers, which all live in the thread of the destination, that
+        //  there are messages in the pipes. The array is allocated by the
+        //  sender and deallocated by the destination.
+        struct
+        {
+            zmq::pipe_t **pipes;
+            size_t count;
+        } activate_read_batch;
+
         //  Sent by pipe reader to inform pipe writer about how many
         //  messages it has read so far.
         struct
@@ -186,6 +200,20 @@ __declspec(align (64))
         {
         } reaped;
 
+        //  Sent by connecter to the resolver thread of the context to ask
+        //  it to resolve an address.
+        struct
+        {
+            zmq::dns_request_t *request;
+        } resolve;
+
+        //  Sent by resolver thread to the connecter when the request
+        //  is processed, whether it succeeded or not.
+        struct
+        {
+            zmq::dns_request_t *request;
+        } resolved;
+
         //  Sent by reaper thread to the term thread when all the sockets
         //  are successfully deallocated.
         struct
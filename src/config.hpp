@@ -41,8 +41,15 @@ enum
     //  memory allocation by approximately 99.6%
     message_pipe_granularity = 256,
 
-    //  Commands in pipe per allocation event.
-    command_pipe_granularity = 16,
+    //  Number of topics without a pending message a pipe conflating the
+    //  messages by topic keeps the slot of, and number of spare message
+    //  buffers it keeps, so that topics updated steadily do not cause
+    //  memory allocations.
+    conflate_topics_cache_size = 64,
+
+    //  Number of commands a mailbox can hold before it falls back to
+    //  a slower, locked queue. Must be a power of two.
+    command_queue_size = 64,
 
     //  Determines how often does socket poll for new commands when it
     //  still has unprocessed messages to handle. Thus, if it is set to 100,
@@ -52,6 +59,16 @@ enum
     //  real-time behaviour (less latency peaks).
     inbound_poll_rate = 100,
 
+    //  Maximal number of messages zmq_proxy forwards in one direction
+    //  before polling the sockets again. Lower values make the proxy
+    //  react faster to commands on the control socket.
+    proxy_burst_size = 1000,
+
+    //  Maximal number of connections a listener accepts each time its
+    //  socket becomes readable, before letting the I/O thread handle
+    //  other events.
+    max_accepts_per_event = 256,
+
     //  Maximal batching size for engines with receiving functionality.
     //  So, if there are 10 messages that fit into the batch size, all of
     //  them may be read by a single 'recv' system call, thus avoiding
@@ -64,9 +81,22 @@ enum
     //  unnecessary network stack traversals.
     out_batch_size = 8192,
 
+    //  Maximal number of bytes of free blocks each thread keeps in each
+    //  size class of the slab allocator for message contents.
+    slab_cache_size = 262144,
+
+    //  Maximal number of receive buffers each decoder keeps for reuse
+    //  once the zero-copy messages built on top of them are closed.
+    recv_buffer_pool_size = 4,
+
     //  Maximal delta between high and low watermark.
     max_wm_delta = 1024,
 
+    //  Maximal time (in milliseconds) a TCP connection is kept open after
+    //  its engine is gone, waiting for the kernel to complete the zero-copy
+    //  writes made on it. Once it expires, the connection is reset.
+    zero_copy_linger = 5000,
+
     //  Maximum number of events the I/O thread can process in one go.
     max_io_events = 256,
 
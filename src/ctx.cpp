@@ -47,6 +47,7 @@
 #include "err.hpp"
 #include "msg.hpp"
 #include "random.hpp"
+#include "slab_allocator.hpp"
 
 #ifdef ZMQ_HAVE_VMCI
 #include <vmci_sockets.h>
@@ -70,6 +71,7 @@ zmq::ctx_t::ctx_t () :
     starting (true),
     terminating (false),
     reaper (NULL),
+    dns_resolver (NULL),
     slot_count (0),
     slots (NULL),
     max_sockets (clipped_maxsocket (ZMQ_MAX_SOCKETS_DFLT)),
@@ -77,7 +79,8 @@ zmq::ctx_t::ctx_t () :
     io_thread_count (ZMQ_IO_THREADS_DFLT),
     blocky (true),
     ipv6 (false),
-    zero_copy (true)
+    zero_copy (true),
+    msg_slab (false)
 {
 #ifdef HAVE_FORK
     pid = getpid ();
@@ -87,6 +90,9 @@ zmq::ctx_t::ctx_t () :
     vmci_family = -1;
 #endif
 
+    dns_resolver = new (std::nothrow) dns_resolver_t (this);
+    alloc_assert (dns_resolver);
+
     //  Initialise crypto library, if needed.
     zmq::random_open ();
 }
@@ -115,6 +121,9 @@ zmq::ctx_t::~ctx_t ()
     //  Deallocate the reaper thread object.
     LIBZMQ_DELETE (reaper);
 
+    //  Stop the resolver thread, if it was ever started.
+    LIBZMQ_DELETE (dns_resolver);
+
     //  Deallocate the array of mailboxes. No special work is
     //  needed as mailboxes themselves were deallocated with their
     //  corresponding io_thread/socket objects.
@@ -123,6 +132,9 @@ zmq::ctx_t::~ctx_t ()
     //  De-initialise crypto library, if needed.
     zmq::random_close ();
 
+    if (msg_slab)
+        slab_disable ();
+
     //  Remove the tag, so that the object is considered dead.
     tag = ZMQ_CTX_TAG_VALUE_BAD;
 }
@@ -249,6 +261,17 @@ int zmq::ctx_t::set (int option_, int optval_)
     } else if (option_ == ZMQ_ZERO_COPY_RECV && optval_ >= 0) {
         scoped_lock_t locker (opt_sync);
         zero_copy = (optval_ != 0);
+    } else if (option_ == ZMQ_MSG_SLAB && optval_ >= 0) {
+        scoped_lock_t locker (opt_sync);
+        if (msg_slab != (optval_ != 0)) {
+            msg_slab = (optval_ != 0);
+            if (msg_slab)
+                slab_enable ();
+            else
+                slab_disable ();
+        }
+    } else if (option_ == ZMQ_DNS_CACHE_TTL && optval_ >= 0) {
+        dns_resolver->set_cache_ttl (optval_);
     } else {
         rc = thread_ctx_t::set (option_, optval_);
     }
@@ -274,6 +297,12 @@ int zmq::ctx_t::get (int option_)
         rc = sizeof (zmq_msg_t);
     else if (option_ == ZMQ_ZERO_COPY_RECV) {
         rc = zero_copy;
+    } else if (option_ == ZMQ_BUSY_POLL) {
+        rc = get_busy_poll ();
+    } else if (option_ == ZMQ_MSG_SLAB) {
+        rc = msg_slab;
+    } else if (option_ == ZMQ_DNS_CACHE_TTL) {
+        rc = dns_resolver->get_cache_ttl ();
     } else {
         errno = EINVAL;
         rc = -1;
@@ -281,6 +310,18 @@ int zmq::ctx_t::get (int option_)
     return rc;
 }
 
+void zmq::ctx_t::set_allocator (const allocator_t &allocator_)
+{
+    scoped_lock_t locker (opt_sync);
+    allocator = allocator_;
+}
+
+zmq::allocator_t zmq::ctx_t::get_allocator ()
+{
+    scoped_lock_t locker (opt_sync);
+    return allocator;
+}
+
 bool zmq::ctx_t::start ()
 {
     //  Initialise the array of mailboxes. Additional three slots are for
@@ -414,9 +455,15 @@ zmq::object_t *zmq::ctx_t::get_reaper ()
     return reaper;
 }
 
+zmq::dns_resolver_t *zmq::ctx_t::get_dns_resolver ()
+{
+    return dns_resolver;
+}
+
 zmq::thread_ctx_t::thread_ctx_t () :
     thread_priority (ZMQ_THREAD_PRIORITY_DFLT),
-    thread_sched_policy (ZMQ_THREAD_SCHED_POLICY_DFLT)
+    thread_sched_policy (ZMQ_THREAD_SCHED_POLICY_DFLT),
+    busy_poll (0)
 {
 }
 
@@ -465,6 +512,9 @@ int zmq::thread_ctx_t::set (int option_, int optval_)
     } else if (option_ == ZMQ_THREAD_PRIORITY && optval_ >= 0) {
         scoped_lock_t locker (opt_sync);
         thread_priority = optval_;
+    } else if (option_ == ZMQ_BUSY_POLL && optval_ >= 0) {
+        scoped_lock_t locker (opt_sync);
+        busy_poll = optval_;
     } else {
         errno = EINVAL;
         rc = -1;
@@ -472,6 +522,11 @@ int zmq::thread_ctx_t::set (int option_, int optval_)
     return rc;
 }
 
+int zmq::thread_ctx_t::get_busy_poll () const
+{
+    return busy_poll;
+}
+
 void zmq::ctx_t::send_command (uint32_t tid_, const command_t &command_)
 {
     slots[tid_]->send (command_);
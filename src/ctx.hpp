@@ -43,6 +43,8 @@
 #include "options.hpp"
 #include "atomic_counter.hpp"
 #include "thread.hpp"
+#include "allocator.hpp"
+#include "dns_resolver.hpp"
 
 namespace zmq
 {
@@ -71,6 +73,9 @@ class thread_ctx_t
 
     int set (int option_, int optval_);
 
+    //  Returns the busy polling interval in microseconds, 0 if disabled.
+    int get_busy_poll () const;
+
   protected:
     //  Synchronisation of access to context options.
     mutex_t opt_sync;
@@ -81,6 +86,10 @@ class thread_ctx_t
     int thread_sched_policy;
     std::set<int> thread_affinity_cpus;
     std::string thread_name_prefix;
+
+    //  Interval in microseconds the threads poll for events for before
+    //  blocking.
+    int busy_poll;
 };
 
 //  Context object encapsulates all the global state associated with
@@ -114,6 +123,10 @@ class ctx_t : public thread_ctx_t
     int set (int option_, int optval_);
     int get (int option_);
 
+    //  Set and get the allocator of the memory holding the messages.
+    void set_allocator (const allocator_t &allocator_);
+    allocator_t get_allocator ();
+
     //  Create and destroy a socket.
     zmq::socket_base_t *create_socket (int type_);
     void destroy_socket (zmq::socket_base_t *socket_);
@@ -129,6 +142,9 @@ class ctx_t : public thread_ctx_t
     //  Returns reaper thread object.
     zmq::object_t *get_reaper ();
 
+    //  Returns the resolver of the TCP addresses to connect to.
+    zmq::dns_resolver_t *get_dns_resolver ();
+
     //  Management of inproc endpoints.
     int register_endpoint (const char *addr_, const endpoint_t &endpoint_);
     int unregister_endpoint (const std::string &addr_, socket_base_t *socket_);
@@ -193,6 +209,9 @@ class ctx_t : public thread_ctx_t
     //  The reaper thread.
     zmq::reaper_t *reaper;
 
+    //  Resolver of the TCP addresses, shared by the I/O threads.
+    zmq::dns_resolver_t *dns_resolver;
+
     //  I/O threads.
     typedef std::vector<zmq::io_thread_t *> io_threads_t;
     io_threads_t io_threads;
@@ -237,6 +256,12 @@ class ctx_t : public thread_ctx_t
     // Should we use zero copy message decoding in this context?
     bool zero_copy;
 
+    //  Did this context enable the slab allocator for message contents?
+    bool msg_slab;
+
+    //  Allocator of the memory holding the messages.
+    allocator_t allocator;
+
     ctx_t (const ctx_t &);
     const ctx_t &operator= (const ctx_t &);
 
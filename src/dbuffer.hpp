@@ -32,26 +32,31 @@
 
 #include <stdlib.h>
 #include <stddef.h>
-#include <algorithm>
 
-#include "mutex.hpp"
+#include "atomic_ptr.hpp"
 #include "msg.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
-//  dbuffer is a single-producer single-consumer double-buffer
-//  implementation.
+//  dbuffer is a single-producer single-consumer lock-free buffer
+//  holding the most recently written value.
 //
-//  The producer writes to a back buffer and then tries to swap
-//  pointers between the back and front buffers. If it fails,
-//  due to the consumer reading from the front buffer, it just
-//  gives up, which is ok since writes are many and redundant.
+//  It has three slots. The producer owns the back slot and the consumer
+//  owns the front slot, while the third one is shared. The producer
+//  writes to the back slot, stamps it with the next sequence number and
+//  exchanges it with the shared slot, making it visible to the consumer.
+//  Any value the consumer did not pick up meanwhile is overwritten by
+//  the next write, which is ok since writes are many and redundant.
 //
-//  The reader simply reads from the front buffer.
+//  The consumer exchanges its front slot with the shared one when it has
+//  read the value of the front slot. The slot obtained holds a new value
+//  if its sequence number is greater than the last one read, otherwise it
+//  is the slot the consumer itself handed over before.
 //
-//  has_msg keeps track of whether there has been a not yet read
-//  value written, it is used by ypipe_conflate to mimic ypipe
-//  functionality regarding a reader being asleep
+//  check_read tells whether there is a not yet read value, it is used by
+//  ypipe_conflate to mimic ypipe functionality regarding a reader being
+//  asleep
 
 template <typename T> class dbuffer_t;
 
@@ -60,17 +65,21 @@ template <> class dbuffer_t<msg_t>
   public:
     inline dbuffer_t () :
         back (&storage[0]),
+        sequence (0),
         front (&storage[1]),
-        has_msg (false)
+        last_read (0)
     {
-        back->init ();
-        front->init ();
+        for (int i = 0; i != 3; i++) {
+            storage[i].msg.init ();
+            storage[i].sequence = 0;
+        }
+        shared.set (&storage[2]);
     }
 
     inline ~dbuffer_t ()
     {
-        back->close ();
-        front->close ();
+        for (int i = 0; i != 3; i++)
+            storage[i].msg.close ();
     }
 
     inline void write (const msg_t &value_)
@@ -78,59 +87,61 @@ template <> class dbuffer_t<msg_t>
         msg_t &xvalue = const_cast<msg_t &> (value_);
 
         zmq_assert (xvalue.check ());
-        back->move (xvalue); // cannot just overwrite, might leak
-
-        zmq_assert (back->check ());
+        back->msg.move (xvalue); // cannot just overwrite, might leak
 
-        if (sync.try_lock ()) {
-            std::swap (back, front);
-            has_msg = true;
+        zmq_assert (back->msg.check ());
 
-            sync.unlock ();
-        }
+        back->sequence = ++sequence;
+        back = shared.xchg (back);
     }
 
     inline bool read (msg_t *value_)
     {
-        if (!value_)
+        if (!value_ || !check_read ())
             return false;
 
-        {
-            scoped_lock_t lock (sync);
-            if (!has_msg)
-                return false;
-
-            zmq_assert (front->check ());
+        zmq_assert (front->msg.check ());
 
-            *value_ = *front;
-            front->init (); // avoid double free
+        *value_ = front->msg;
+        front->msg.init (); // avoid double free
 
-            has_msg = false;
-            return true;
-        }
+        last_read = front->sequence;
+        return true;
     }
 
-
     inline bool check_read ()
     {
-        scoped_lock_t lock (sync);
+        if (front->sequence > last_read)
+            return true;
 
-        return has_msg;
+        front = shared.xchg (front);
+        return front->sequence > last_read;
     }
 
     inline bool probe (bool (*fn) (const msg_t &))
     {
-        scoped_lock_t lock (sync);
-        return (*fn) (*front);
+        return (*fn) (front->msg);
     }
 
-
   private:
-    msg_t storage[2];
-    msg_t *back, *front;
+    struct slot_t
+    {
+        msg_t msg;
+        uint64_t sequence;
+    };
+
+    slot_t storage[3];
+
+    //  Owned by the producer.
+    slot_t *back;
+    uint64_t sequence;
+
+    //  Owned by the consumer.
+    slot_t *front;
+    uint64_t last_read;
 
-    mutex_t sync;
-    bool has_msg;
+    //  Handed over between the producer and the consumer.
+    atomic_ptr_t<slot_t> shared;
 
     //  Disable copying of dbuffer.
     dbuffer_t (const dbuffer_t &);
@@ -35,6 +35,8 @@
 
 zmq::dealer_t::dealer_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_),
+    fq (options),
+    lb (options),
     probe_router (false)
 {
     options.type = ZMQ_DEALER;
@@ -134,9 +136,9 @@ void zmq::dealer_t::xpipe_terminated (pipe_t *pipe_)
     lb.pipe_terminated (pipe_);
 }
 
-int zmq::dealer_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
+int zmq::dealer_t::sendpipe (msg_t *msg_, pipe_t **pipe_, msg_t *key_)
 {
-    return lb.sendpipe (msg_, pipe_);
+    return lb.sendpipe (msg_, pipe_, key_);
 }
 
 int zmq::dealer_t::recvpipe (msg_t *msg_, pipe_t **pipe_)
@@ -62,8 +62,11 @@ class dealer_t : public socket_base_t
     void xwrite_activated (zmq::pipe_t *pipe_);
     void xpipe_terminated (zmq::pipe_t *pipe_);
 
-    //  Send and recv - knowing which pipe was used.
-    int sendpipe (zmq::msg_t *msg_, zmq::pipe_t **pipe_);
+    //  Send and recv - knowing which pipe was used. The load balancing
+    //  key is taken from key_ if set, see lb_t::sendpipe.
+    int sendpipe (zmq::msg_t *msg_,
+                  zmq::pipe_t **pipe_,
+                  zmq::msg_t *key_ = NULL);
     int recvpipe (zmq::msg_t *msg_, zmq::pipe_t **pipe_);
 
   private:
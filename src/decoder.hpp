@@ -169,6 +169,10 @@ class decoder_base_t : public i_decoder
         next = next_;
     }
 
+    //  Returns true if the state machine is about to run the given
+    //  action and none of the data it waits for was read yet.
+    bool at_step (step_t step_) const { return next == step_; }
+
   private:
     //  Next step. If set to NULL, it means that associated data stream
     //  is dead. Note that there can be still data in the process in such
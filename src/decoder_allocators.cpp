@@ -31,47 +31,140 @@
 #include "decoder_allocators.hpp"
 
 #include <cmath>
+#include <new>
 
+#include "config.hpp"
 #include "msg.hpp"
 
+zmq::shared_buffer_pool_t::shared_buffer_pool_t (
+  std::size_t buffer_size_,
+  std::size_t max_buffers_,
+  const allocator_t &allocator_) :
+    buffer_size (buffer_size_),
+    max_buffers (max_buffers_),
+    allocator (allocator_),
+    refs (1),
+    closed (false)
+{
+    buffers.reserve (max_buffers);
+}
+
+zmq::shared_buffer_pool_t::~shared_buffer_pool_t ()
+{
+    zmq_assert (buffers.empty ());
+}
+
+unsigned char *zmq::shared_buffer_pool_t::get ()
+{
+    refs.add (1);
+
+    {
+        scoped_lock_t lock (sync);
+        if (!buffers.empty ()) {
+            unsigned char *buffer = buffers.back ();
+            buffers.pop_back ();
+            return buffer;
+        }
+    }
+
+    unsigned char *buffer =
+      static_cast<unsigned char *> (allocator.allocate (buffer_size));
+    alloc_assert (buffer);
+    return buffer;
+}
+
+void zmq::shared_buffer_pool_t::put (unsigned char *buffer_)
+{
+    bool recycled = false;
+    {
+        scoped_lock_t lock (sync);
+        if (!closed && buffers.size () < max_buffers) {
+            buffers.push_back (buffer_);
+            recycled = true;
+        }
+    }
+    if (!recycled)
+        allocator.deallocate (buffer_, buffer_size);
+
+    drop_ref ();
+}
+
+void zmq::shared_buffer_pool_t::close ()
+{
+    {
+        scoped_lock_t lock (sync);
+        zmq_assert (!closed);
+        closed = true;
+        for (std::vector<unsigned char *>::iterator it = buffers.begin ();
+             it != buffers.end (); ++it)
+            allocator.deallocate (*it, buffer_size);
+        buffers.clear ();
+    }
+
+    drop_ref ();
+}
+
+void zmq::shared_buffer_pool_t::drop_ref ()
+{
+    if (!refs.sub (1))
+        delete this;
+}
+
 zmq::shared_message_memory_allocator::shared_message_memory_allocator (
-  std::size_t bufsize_) :
+  std::size_t bufsize_, const allocator_t &allocator_) :
     buf (NULL),
     bufsize (0),
     max_size (bufsize_),
     msg_content (NULL),
     maxCounters (static_cast<size_t> (
       std::ceil (static_cast<double> (max_size)
-                 / static_cast<double> (msg_t::max_vsm_size))))
+                 / static_cast<double> (msg_t::max_vsm_size)))),
+    pool (NULL)
 {
+    init_pool (allocator_);
 }
 
 zmq::shared_message_memory_allocator::shared_message_memory_allocator (
-  std::size_t bufsize_, std::size_t maxMessages) :
+  std::size_t bufsize_,
+  std::size_t maxMessages,
+  const allocator_t &allocator_) :
     buf (NULL),
     bufsize (0),
     max_size (bufsize_),
     msg_content (NULL),
-    maxCounters (maxMessages)
+    maxCounters (maxMessages),
+    pool (NULL)
 {
+    init_pool (allocator_);
 }
 
 zmq::shared_message_memory_allocator::~shared_message_memory_allocator ()
 {
     deallocate ();
+    pool->close ();
+}
+
+void zmq::shared_message_memory_allocator::init_pool (
+  const allocator_t &allocator_)
+{
+    // allocate memory for reference counters together with reception buffer
+    std::size_t const allocationsize =
+      sizeof (header_t) + max_size
+      + maxCounters * sizeof (zmq::msg_t::content_t);
+
+    pool = new (std::nothrow)
+      shared_buffer_pool_t (allocationsize, recv_buffer_pool_size, allocator_);
+    alloc_assert (pool);
 }
 
 unsigned char *zmq::shared_message_memory_allocator::allocate ()
 {
     if (buf) {
         // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (buf);
-
         // if refcnt drops to 0, there are no message using the buffer
         // because either all messages have been closed or only vsm-messages
         // were created
-        if (c->sub (1)) {
+        if (header (buf)->refcnt.sub (1)) {
             // buffer is still in use as message data. "Release" it and create a new one
             // release pointer because we are going to create a new buffer
             release ();
@@ -80,33 +173,25 @@ unsigned char *zmq::shared_message_memory_allocator::allocate ()
 
     // if buf != NULL it is not used by any message so we can re-use it for the next run
     if (!buf) {
-        // allocate memory for reference counters together with reception buffer
-        std::size_t const allocationsize =
-          max_size + sizeof (zmq::atomic_counter_t)
-          + maxCounters * sizeof (zmq::msg_t::content_t);
-
-        buf = static_cast<unsigned char *> (std::malloc (allocationsize));
-        alloc_assert (buf);
-
-        new (buf) atomic_counter_t (1);
+        buf = pool->get ();
+        new (&header (buf)->refcnt) atomic_counter_t (1);
+        header (buf)->pool = pool;
     } else {
         // release reference count to couple lifetime to messages
-        zmq::atomic_counter_t *c =
-          reinterpret_cast<zmq::atomic_counter_t *> (buf);
-        c->set (1);
+        header (buf)->refcnt.set (1);
     }
 
     bufsize = max_size;
     msg_content = reinterpret_cast<zmq::msg_t::content_t *> (
-      buf + sizeof (atomic_counter_t) + max_size);
-    return buf + sizeof (zmq::atomic_counter_t);
+      buf + sizeof (header_t) + max_size);
+    return buf + sizeof (header_t);
 }
 
 void zmq::shared_message_memory_allocator::deallocate ()
 {
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (buf);
-    if (buf && !c->sub (1)) {
-        std::free (buf);
+    if (buf && !header (buf)->refcnt.sub (1)) {
+        header (buf)->refcnt.~atomic_counter_t ();
+        pool->put (buf);
     }
     release ();
 }
@@ -123,19 +208,18 @@ unsigned char *zmq::shared_message_memory_allocator::release ()
 
 void zmq::shared_message_memory_allocator::inc_ref ()
 {
-    (reinterpret_cast<zmq::atomic_counter_t *> (buf))->add (1);
+    header (buf)->refcnt.add (1);
 }
 
 void zmq::shared_message_memory_allocator::call_dec_ref (void *, void *hint)
 {
     zmq_assert (hint);
     unsigned char *buf = static_cast<unsigned char *> (hint);
-    zmq::atomic_counter_t *c = reinterpret_cast<zmq::atomic_counter_t *> (buf);
+    header_t *h = header (buf);
 
-    if (!c->sub (1)) {
-        c->~atomic_counter_t ();
-        std::free (buf);
-        buf = NULL;
+    if (!h->refcnt.sub (1)) {
+        h->refcnt.~atomic_counter_t ();
+        h->pool->put (buf);
     }
 }
 
@@ -147,5 +231,5 @@ std::size_t zmq::shared_message_memory_allocator::size () const
 
 unsigned char *zmq::shared_message_memory_allocator::data ()
 {
-    return buf + sizeof (zmq::atomic_counter_t);
+    return buf + sizeof (header_t);
 }
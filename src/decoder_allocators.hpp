@@ -32,9 +32,12 @@
 
 #include <cstddef>
 #include <cstdlib>
+#include <vector>
 
+#include "allocator.hpp"
 #include "atomic_counter.hpp"
 #include "msg.hpp"
+#include "mutex.hpp"
 #include "err.hpp"
 
 namespace zmq
@@ -68,6 +71,54 @@ class c_single_allocator
     c_single_allocator &operator= (c_single_allocator const &);
 };
 
+//  Pool of equally sized buffers. Buffers put back into the pool are
+//  kept for reuse, up to a bounded number, rather than freed. Buffers can
+//  be put back from any thread and may outlive the owner of the pool, so
+//  the pool is reference counted by its owner and by every buffer taken
+//  from it, and destroys itself when all of them are gone.
+class shared_buffer_pool_t
+{
+  public:
+    shared_buffer_pool_t (std::size_t buffer_size_,
+                          std::size_t max_buffers_,
+                          const allocator_t &allocator_ = allocator_t ());
+
+    //  Returns a buffer taken from the pool or newly allocated.
+    unsigned char *get ();
+
+    //  Gives a buffer obtained by get back to the pool.
+    void put (unsigned char *buffer_);
+
+    //  Called by the owner of the pool when it is no longer going to
+    //  take buffers from it. Pooled buffers are freed straight away,
+    //  those still in use once they are put back.
+    void close ();
+
+  private:
+    ~shared_buffer_pool_t ();
+
+    //  Drops a reference, destroying the pool on the last one.
+    void drop_ref ();
+
+    const std::size_t buffer_size;
+    const std::size_t max_buffers;
+
+    //  Allocator the buffers are taken from.
+    const allocator_t allocator;
+
+    //  One reference held by the owner plus one per buffer in use.
+    atomic_counter_t refs;
+
+    //  Synchronisation of access to the fields below, as buffers are
+    //  put back from the threads closing the messages.
+    mutex_t sync;
+    bool closed;
+    std::vector<unsigned char *> buffers;
+
+    shared_buffer_pool_t (const shared_buffer_pool_t &);
+    const shared_buffer_pool_t &operator= (const shared_buffer_pool_t &);
+};
+
 // This allocator allocates a reference counted buffer which is used by v2_decoder_t
 // to use zero-copy msg::init_data to create messages with memory from this buffer as
 // data storage.
@@ -77,14 +128,21 @@ class c_single_allocator
 // from zero to one, gets passed to the user application, processed in the user thread and deleted
 // which would then deallocate the buffer. The drawback is that the buffer may be allocated longer
 // than necessary because it is only deleted when allocate is called the next time.
+//
+// Buffers are taken from a pool owned by the allocator and are given back to it when
+// the last message using them is closed, so that receiving at a high rate does not
+// allocate and free a buffer per batch.
 class shared_message_memory_allocator
 {
   public:
-    explicit shared_message_memory_allocator (std::size_t bufsize_);
+    explicit shared_message_memory_allocator (
+      std::size_t bufsize_, const allocator_t &allocator_ = allocator_t ());
 
     // Create an allocator for a maximum number of messages
-    shared_message_memory_allocator (std::size_t bufsize_,
-                                     std::size_t maxMessages);
+    shared_message_memory_allocator (
+      std::size_t bufsize_,
+      std::size_t maxMessages,
+      const allocator_t &allocator_ = allocator_t ());
 
     ~shared_message_memory_allocator ();
 
@@ -120,11 +178,31 @@ class shared_message_memory_allocator
     void advance_content () { msg_content++; }
 
   private:
+    //  Header at the start of each buffer.
+    struct header_t
+    {
+        atomic_counter_t refcnt;
+        shared_buffer_pool_t *pool;
+    };
+
+    static header_t *header (unsigned char *buf_)
+    {
+        return reinterpret_cast<header_t *> (buf_);
+    }
+
+    //  Allocates the pool of buffers.
+    void init_pool (const allocator_t &allocator_);
+
     unsigned char *buf;
     std::size_t bufsize;
     const std::size_t max_size;
     zmq::msg_t::content_t *msg_content;
     std::size_t maxCounters;
+    shared_buffer_pool_t *pool;
+
+    shared_message_memory_allocator (const shared_message_memory_allocator &);
+    const shared_message_memory_allocator &
+    operator= (const shared_message_memory_allocator &);
 };
 }
 
@@ -36,6 +36,7 @@
 
 zmq::dish_t::dish_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_, true),
+    fq (options),
     has_message (false)
 {
     options.type = ZMQ_DISH;
@@ -28,6 +28,8 @@
 */
 
 #include "precompiled.hpp"
+#include <algorithm>
+
 #include "dist.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
@@ -66,9 +68,13 @@ void zmq::dist_t::match (pipe_t *pipe_)
     if (pipes.index (pipe_) < matching)
         return;
 
-    //  If the pipe isn't eligible, ignore it.
-    if (pipes.index (pipe_) >= eligible)
+    //  If the pipe isn't eligible, ignore it. It has reached its HWM,
+    //  so the message is dropped as far as the pipe is concerned. The drop
+    //  is counted once the message is actually sent.
+    if (pipes.index (pipe_) >= eligible) {
+        dropped.push_back (pipe_);
         return;
+    }
 
     //  Mark the pipe as matching.
     pipes.swap (pipes.index (pipe_), matching);
@@ -89,11 +95,25 @@ void zmq::dist_t::reverse_match ()
     for (pipes_t::size_type i = prev_matching; i < eligible; ++i) {
         pipes.swap (i, matching++);
     }
+
+    //  Likewise, the message is now dropped for the pipes beyond their HWM
+    //  that were not matched.
+    if (eligible < pipes.size ()) {
+        std::sort (dropped.begin (), dropped.end ());
+        std::vector<pipe_t *> unmatched;
+        for (pipes_t::size_type i = eligible; i < pipes.size (); ++i)
+            if (!std::binary_search (dropped.begin (), dropped.end (),
+                                     pipes[i]))
+                unmatched.push_back (pipes[i]);
+        dropped.swap (unmatched);
+    } else
+        dropped.clear ();
 }
 
 void zmq::dist_t::unmatch ()
 {
     matching = 0;
+    dropped.clear ();
 }
 
 void zmq::dist_t::pipe_terminated (pipe_t *pipe_)
@@ -112,6 +132,9 @@ void zmq::dist_t::pipe_terminated (pipe_t *pipe_)
         pipes.swap (pipes.index (pipe_), eligible - 1);
         eligible--;
     }
+    if (unlikely (!dropped.empty ()))
+        dropped.erase (std::remove (dropped.begin (), dropped.end (), pipe_),
+                       dropped.end ());
 
     pipes.erase (pipe_);
 }
@@ -143,6 +166,10 @@ int zmq::dist_t::send_to_matching (msg_t *msg_)
     //  Is this end of a multipart message?
     bool msg_more = msg_->flags () & msg_t::more ? true : false;
 
+    //  The message is being sent, account for the pipes it is dropped for.
+    if (!more && unlikely (!dropped.empty ()))
+        count_dropped ();
+
     //  Push the message to matching pipes.
     distribute (msg_);
 
@@ -166,6 +193,15 @@ void zmq::dist_t::distribute (msg_t *msg_)
         return;
     }
 
+    //  Flush all the pipes once the message is written to them, so that
+    //  the readers living in the same thread are activated together.
+    flush_batch_t *batch = NULL;
+    if (matching > 1 && !(msg_->flags () & msg_t::more)) {
+        batch = pipes[0]->get_flush_batch ();
+        if (batch)
+            batch->open ();
+    }
+
     if (msg_->is_vsm ()) {
         for (pipes_t::size_type i = 0; i < matching; ++i)
             if (!write (pipes[i], msg_))
@@ -174,6 +210,8 @@ void zmq::dist_t::distribute (msg_t *msg_)
         errno_assert (rc == 0);
         rc = msg_->init ();
         errno_assert (rc == 0);
+        if (batch)
+            batch->close ();
         return;
     }
 
@@ -195,6 +233,20 @@ void zmq::dist_t::distribute (msg_t *msg_)
     //  close the message. That's because we've already used all the references.
     int rc = msg_->init ();
     errno_assert (rc == 0);
+
+    if (batch)
+        batch->close ();
+}
+
+void zmq::dist_t::count_dropped ()
+{
+    std::sort (dropped.begin (), dropped.end ());
+    const std::vector<pipe_t *>::iterator end =
+      std::unique (dropped.begin (), dropped.end ());
+    for (std::vector<pipe_t *>::iterator it = dropped.begin (); it != end;
+         ++it)
+        (*it)->count_dropped ();
+    dropped.clear ();
 }
 
 bool zmq::dist_t::has_out ()
@@ -205,6 +257,7 @@ bool zmq::dist_t::has_out ()
 bool zmq::dist_t::write (pipe_t *pipe_, msg_t *msg_)
 {
     if (!pipe_->write (msg_)) {
+        pipe_->count_dropped ();
         pipes.swap (pipes.index (pipe_), matching - 1);
         matching--;
         pipes.swap (pipes.index (pipe_), active - 1);
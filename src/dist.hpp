@@ -86,6 +86,10 @@ class dist_t
     //  Put the message to all active pipes.
     void distribute (zmq::msg_t *msg_);
 
+    //  Counts the current message as dropped for each of the pipes
+    //  collected in the dropped list, once per pipe.
+    void count_dropped ();
+
     //  List of outbound pipes.
     typedef array_t<zmq::pipe_t, 2> pipes_t;
     pipes_t pipes;
@@ -108,6 +112,11 @@ class dist_t
     //  True if last we are in the middle of a multipart message.
     bool more;
 
+    //  Pipes the message being matched is dropped for because they have
+    //  reached their HWM. A pipe may be listed more than once if several
+    //  of its subscriptions match.
+    std::vector<zmq::pipe_t *> dropped;
+
     dist_t (const dist_t &);
     const dist_t &operator= (const dist_t &);
 };
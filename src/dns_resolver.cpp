@@ -0,0 +1,247 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include <string.h>
+
+#include "macros.hpp"
+#include "dns_resolver.hpp"
+#include "command.hpp"
+#include "ctx.hpp"
+#include "err.hpp"
+#include "ip.hpp"
+#include "mailbox.hpp"
+#include "object.hpp"
+
+#ifndef ZMQ_HAVE_WINDOWS
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netdb.h>
+#endif
+
+//  Returns true if the host part of a "[source;]host:port" address is a
+//  numeric IP address, which can be resolved without a name lookup.
+static bool is_numeric_host (const std::string &address_)
+{
+    const std::string::size_type start = address_.rfind (';');
+    std::string host = address_.substr (
+      start == std::string::npos ? 0 : start + 1);
+    host = host.substr (0, host.rfind (':'));
+    if (host.size () >= 2 && host[0] == '[' && host[host.size () - 1] == ']')
+        host = host.substr (1, host.size () - 2);
+    host = host.substr (0, host.rfind ('%'));
+    if (host.empty ())
+        return false;
+
+    addrinfo req;
+    memset (&req, 0, sizeof (req));
+    req.ai_family = AF_UNSPEC;
+    req.ai_socktype = SOCK_STREAM;
+    req.ai_flags = AI_NUMERICHOST;
+
+    addrinfo *res;
+    if (getaddrinfo (host.c_str (), NULL, &req, &res) != 0)
+        return false;
+    freeaddrinfo (res);
+    return true;
+}
+
+static int default_resolve (zmq::tcp_address_t *addr_,
+                            const char *address_,
+                            bool ipv6_)
+{
+    return addr_->resolve (address_, false, ipv6_);
+}
+
+zmq::dns_request_t::dns_request_t (object_t *requester_,
+                                   const std::string &address_,
+                                   bool ipv6_) :
+    requester (requester_),
+    address (address_),
+    ipv6 (ipv6_),
+    cancelled (0),
+    rc (-1)
+{
+}
+
+zmq::dns_resolver_t::dns_resolver_t (ctx_t *ctx_) :
+    ctx (ctx_),
+    mailbox (NULL),
+    cache_ttl (0),
+    resolve_func (default_resolve)
+{
+}
+
+zmq::dns_resolver_t::~dns_resolver_t ()
+{
+    //  All the connecters are gone by now, so no request is pending.
+    if (mailbox) {
+        command_t cmd;
+        cmd.destination = NULL;
+        cmd.type = command_t::stop;
+        mailbox->send (cmd);
+        worker.stop ();
+        LIBZMQ_DELETE (mailbox);
+    }
+}
+
+int zmq::dns_resolver_t::lookup (const std::string &address_,
+                                 bool ipv6_,
+                                 tcp_address_t *addr_)
+{
+    {
+        scoped_lock_t locker (sync);
+        if (find_cached (address_, ipv6_, addr_))
+            return 0;
+    }
+
+    if (!is_numeric_host (address_)) {
+        errno = EAGAIN;
+        return -1;
+    }
+    return addr_->resolve (address_.c_str (), false, ipv6_);
+}
+
+void zmq::dns_resolver_t::resolve (dns_request_t *request_)
+{
+    {
+        scoped_lock_t locker (sync);
+        if (!mailbox) {
+            mailbox = new (std::nothrow) mailbox_t;
+            alloc_assert (mailbox);
+            errno_assert (mailbox->valid ());
+            ctx->start_thread (worker, worker_routine, this);
+        }
+    }
+
+    command_t cmd;
+    cmd.destination = NULL;
+    cmd.type = command_t::resolve;
+    cmd.args.resolve.request = request_;
+    mailbox->send (cmd);
+}
+
+void zmq::dns_resolver_t::set_cache_ttl (int ttl_)
+{
+    scoped_lock_t locker (sync);
+    cache_ttl = ttl_;
+    if (cache_ttl == 0)
+        cache.clear ();
+}
+
+int zmq::dns_resolver_t::get_cache_ttl ()
+{
+    scoped_lock_t locker (sync);
+    return cache_ttl;
+}
+
+void zmq::dns_resolver_t::set_resolve_fn (resolve_fn *resolve_fn_)
+{
+    scoped_lock_t locker (sync);
+    resolve_func = resolve_fn_ ? resolve_fn_ : default_resolve;
+}
+
+bool zmq::dns_resolver_t::find_cached (const std::string &address_,
+                                       bool ipv6_,
+                                       tcp_address_t *addr_)
+{
+    const cache_t::iterator it =
+      cache.find (std::make_pair (address_, ipv6_));
+    if (it == cache.end ())
+        return false;
+    if (it->second.expiry <= clock.now_ms ()) {
+        cache.erase (it);
+        return false;
+    }
+    *addr_ = it->second.addr;
+    return true;
+}
+
+void zmq::dns_resolver_t::worker_routine (void *arg_)
+{
+    ((dns_resolver_t *) arg_)->loop ();
+}
+
+void zmq::dns_resolver_t::loop ()
+{
+    while (true) {
+        command_t cmd;
+        const int rc = mailbox->recv (&cmd, -1);
+        if (rc == -1 && errno == EINTR)
+            continue;
+        errno_assert (rc == 0);
+
+        if (cmd.type == command_t::stop)
+            break;
+        zmq_assert (cmd.type == command_t::resolve);
+        dns_request_t *request = cmd.args.resolve.request;
+
+        //  Skip the lookup if the requester gave up on it in the meantime
+        //  or if an earlier request for the same address filled the cache.
+        resolve_fn *resolve;
+        bool cached;
+        {
+            scoped_lock_t locker (sync);
+            resolve = resolve_func;
+            cached = find_cached (request->address, request->ipv6,
+                                  &request->result);
+        }
+        if (cached)
+            request->rc = 0;
+        else if (!request->cancelled.load ()) {
+            request->rc = resolve (&request->result, request->address.c_str (),
+                                   request->ipv6);
+            if (request->rc == 0) {
+                scoped_lock_t locker (sync);
+                if (cache_ttl > 0) {
+                    //  Drop the expired entries so that the cache does not
+                    //  grow with addresses that are not used any more.
+                    const uint64_t now = clock.now_ms ();
+                    for (cache_t::iterator it = cache.begin ();
+                         it != cache.end ();)
+                        if (it->second.expiry <= now)
+                            cache.erase (it++);
+                        else
+                            ++it;
+                    cache_entry_t &entry = cache[std::make_pair (
+                      request->address, request->ipv6)];
+                    entry.addr = request->result;
+                    entry.expiry = now + cache_ttl;
+                }
+            }
+        }
+
+        //  Hand the request back to the requester's thread.
+        command_t reply;
+        reply.destination = request->requester;
+        reply.type = command_t::resolved;
+        reply.args.resolved.request = request;
+        ctx->send_command (request->requester->get_tid (), reply);
+    }
+}
@@ -0,0 +1,146 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_DNS_RESOLVER_HPP_INCLUDED__
+#define __ZMQ_DNS_RESOLVER_HPP_INCLUDED__
+
+#include <map>
+#include <string>
+
+#include "atomic_ptr.hpp"
+#include "clock.hpp"
+#include "mutex.hpp"
+#include "stdint.hpp"
+#include "tcp_address.hpp"
+#include "thread.hpp"
+
+namespace zmq
+{
+class ctx_t;
+class mailbox_t;
+class object_t;
+
+//  Request to resolve a TCP address off the I/O thread. The resolver
+//  always hands the request back to the requester with a 'resolved'
+//  command, even if it was cancelled, so that the requester knows when
+//  it may deallocate it.
+
+struct dns_request_t
+{
+    dns_request_t (object_t *requester_,
+                   const std::string &address_,
+                   bool ipv6_);
+
+    //  Object to send the 'resolved' command to.
+    object_t *const requester;
+
+    //  Address to resolve, in the format accepted by tcp_address_t.
+    const std::string address;
+    const bool ipv6;
+
+    //  Set by the requester if it's no longer interested in the result.
+    atomic_value_t cancelled;
+
+    //  Outcome of the resolution: 0 and the resolved address on success,
+    //  -1 otherwise.
+    int rc;
+    tcp_address_t result;
+};
+
+//  Resolves TCP addresses on behalf of the connecters of a context, so
+//  that slow name lookups do not stall the I/O threads, and caches the
+//  results for a configurable amount of time.
+
+class dns_resolver_t
+{
+  public:
+    //  Function translating the address into an address structure,
+    //  tcp_address_t::resolve by default.
+    typedef int(resolve_fn) (tcp_address_t *addr_,
+                             const char *address_,
+                             bool ipv6_);
+
+    dns_resolver_t (ctx_t *ctx_);
+    ~dns_resolver_t ();
+
+    //  Resolves the address straight away if it is numeric or cached.
+    //  Returns -1 with EAGAIN errno if the address has to be resolved
+    //  asynchronously.
+    int lookup (const std::string &address_, bool ipv6_, tcp_address_t *addr_);
+
+    //  Queues the request to the worker thread, which is started on
+    //  first use.
+    void resolve (dns_request_t *request_);
+
+    //  Time in milliseconds the results are cached for, 0 if disabled.
+    void set_cache_ttl (int ttl_);
+    int get_cache_ttl ();
+
+    //  Replaces the function used to resolve the addresses which are
+    //  not numeric. Meant for testing.
+    void set_resolve_fn (resolve_fn *resolve_fn_);
+
+  private:
+    static void worker_routine (void *arg_);
+    void loop ();
+
+    //  Returns true and fills in the address if a result is cached.
+    //  Must be called with the sync mutex locked.
+    bool find_cached (const std::string &address_,
+                      bool ipv6_,
+                      tcp_address_t *addr_);
+
+    ctx_t *const ctx;
+
+    //  Queue of the pending requests, allocated along with the worker.
+    mailbox_t *mailbox;
+    thread_t worker;
+
+    //  Results of the previous lookups and the time they expire at.
+    struct cache_entry_t
+    {
+        tcp_address_t addr;
+        uint64_t expiry;
+    };
+    typedef std::map<std::pair<std::string, bool>, cache_entry_t> cache_t;
+    cache_t cache;
+    int cache_ttl;
+    clock_t clock;
+
+    resolve_fn *resolve_func;
+
+    //  Synchronisation of the cache, the options and the worker start.
+    mutex_t sync;
+
+    dns_resolver_t (const dns_resolver_t &);
+    const dns_resolver_t &operator= (const dns_resolver_t &);
+};
+}
+
+#endif
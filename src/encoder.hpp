@@ -61,6 +61,7 @@ template <typename T> class encoder_base_t : public i_encoder
         new_msg_flag (false),
         bufsize (bufsize_),
         buf ((unsigned char *) malloc (bufsize_)),
+        in_place_threshold (0),
         in_progress (NULL)
     {
         alloc_assert (buf);
@@ -98,6 +99,10 @@ template <typename T> class encoder_base_t : public i_encoder
                 (static_cast<T *> (this)->*next) ();
             }
 
+            //  Large chunks are left to encode_in_place.
+            if (in_place_threshold && to_write >= in_place_threshold)
+                break;
+
             //  If there are no data in the buffer yet and we are able to
             //  fill whole buffer in a single go, let's use zero-copy.
             //  There's no disadvantage to it as we cannot stuck multiple
@@ -135,6 +140,25 @@ template <typename T> class encoder_base_t : public i_encoder
         (static_cast<T *> (this)->*next) ();
     }
 
+    void set_in_place_threshold (size_t threshold_)
+    {
+        in_place_threshold = threshold_;
+    }
+
+    size_t encode_in_place (unsigned char **data_)
+    {
+        //  Chunks this large are never copied, so encode must have
+        //  stopped in front of it.
+        if (!in_place_threshold || to_write < in_place_threshold)
+            return 0;
+
+        *data_ = write_pos;
+        const size_t size = to_write;
+        write_pos = NULL;
+        to_write = 0;
+        return size;
+    }
+
   protected:
     //  Prototype of state machine action.
     typedef void (T::*step_t) ();
@@ -169,6 +193,9 @@ template <typename T> class encoder_base_t : public i_encoder
     const size_t bufsize;
     unsigned char *const buf;
 
+    //  Chunks at least this large are not copied to the buffer.
+    size_t in_place_threshold;
+
     encoder_base_t (const encoder_base_t &);
     void operator= (const encoder_base_t &);
 
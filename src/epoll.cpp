@@ -159,6 +159,7 @@ int zmq::epoll_t::max_fds ()
 void zmq::epoll_t::loop ()
 {
     epoll_event ev_buf[max_io_events];
+    bool idle = true;
 
     while (true) {
         //  Execute any due timers.
@@ -172,13 +173,15 @@ void zmq::epoll_t::loop ()
             continue;
         }
 
-        //  Wait for events.
+        //  Wait for events, unless busy polling.
+        const bool spin = busy_polling (idle);
         int n = epoll_wait (epoll_fd, &ev_buf[0], max_io_events,
-                            timeout ? timeout : -1);
+                            spin ? 0 : timeout ? timeout : -1);
         if (n == -1) {
             errno_assert (errno == EINTR);
             continue;
         }
+        idle = n == 0;
 
         for (int i = 0; i < n; i++) {
             poll_entry_t *pe = ((poll_entry_t *) ev_buf[i].data.ptr);
@@ -32,8 +32,15 @@
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
-
-zmq::fq_t::fq_t () : active (0), last_in (NULL), current (0), more (false)
+#include "options.hpp"
+
+zmq::fq_t::fq_t (const options_t &options_) :
+    options (options_),
+    active (0),
+    last_in (NULL),
+    current (0),
+    current_read (0),
+    more (false)
 {
 }
 
@@ -60,6 +67,8 @@ void zmq::fq_t::pipe_terminated (pipe_t *pipe_)
         pipes.swap (index, active);
         if (current == active)
             current = 0;
+        if (index == current)
+            current_read = 0;
     }
     pipes.erase (pipe_);
 
@@ -102,7 +111,10 @@ int zmq::fq_t::recvpipe (msg_t *msg_, pipe_t **pipe_)
             more = msg_->flags () & msg_t::more ? true : false;
             if (!more) {
                 last_in = pipes[current];
-                current = (current + 1) % active;
+                if (++current_read >= options.fq_batch) {
+                    current_read = 0;
+                    current = (current + 1) % active;
+                }
             }
             return 0;
         }
@@ -116,6 +128,7 @@ int zmq::fq_t::recvpipe (msg_t *msg_, pipe_t **pipe_)
         pipes.swap (current, active);
         if (current == active)
             current = 0;
+        current_read = 0;
     }
 
     //  No message is available. Initialise the output parameter
@@ -145,6 +158,7 @@ bool zmq::fq_t::has_in ()
         pipes.swap (current, active);
         if (current == active)
             current = 0;
+        current_read = 0;
     }
 
     return false;
@@ -37,14 +37,18 @@
 
 namespace zmq
 {
+struct options_t;
+
 //  Class manages a set of inbound pipes. On receive it performs fair
 //  queueing so that senders gone berserk won't cause denial of
-//  service for decent senders.
+//  service for decent senders. Up to ZMQ_FQ_BATCH messages of the
+//  owning socket are read from a pipe in a row, so that busy pipes
+//  stay in the cache.
 
 class fq_t
 {
   public:
-    fq_t ();
+    fq_t (const options_t &options_);
     ~fq_t ();
 
     void attach (pipe_t *pipe_);
@@ -57,6 +61,9 @@ class fq_t
     const blob_t &get_credential () const;
 
   private:
+    //  Options of the owning socket.
+    const options_t &options;
+
     //  Inbound pipes.
     typedef array_t<pipe_t, 1> pipes_t;
     pipes_t pipes;
@@ -73,6 +80,9 @@ class fq_t
     //  Index of the next bound pipe to read a message from.
     pipes_t::size_type current;
 
+    //  Number of messages read from the current pipe in a row.
+    int current_read;
+
     //  If true, part of a multipart message was already received, but
     //  there are following parts still waiting in the current pipe.
     bool more;
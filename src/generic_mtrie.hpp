@@ -34,10 +34,12 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <set>
 
 #include "stdint.hpp"
+#include "trie_node.hpp"
 
 namespace zmq
 {
 //  Multi-trie (prefix tree). Each node in the trie is a set of pointers.
+//  The trie is path-compressed, see trie_node_t.
 template <typename T> class generic_mtrie_t
 {
   public:
@@ -83,29 +85,28 @@ template <typename T> class generic_mtrie_t
                 Arg arg_);
 
   private:
-    bool add_helper (prefix_t prefix_, size_t size_, value_t *value_);
-    template <typename Arg>
-    void rm_helper (value_t *value_,
-                    unsigned char **buff_,
-                    size_t buffsize_,
-                    size_t maxbuffsize_,
-                    void (*func_) (prefix_t data_, size_t size_, Arg arg_),
-                    Arg arg_,
-                    bool call_on_uniq_);
-    rm_result rm_helper (prefix_t prefix_, size_t size_, value_t *value_);
-    bool is_redundant () const;
-
     typedef std::set<value_t *> pipes_t;
-    pipes_t *pipes;
+    typedef trie_node_t<pipes_t *> node_t;
 
-    unsigned char min;
-    unsigned short count;
-    unsigned short live_nodes;
-    union
-    {
-        class generic_mtrie_t<value_t> *node;
-        class generic_mtrie_t<value_t> **table;
-    } next;
+    template <typename Arg>
+    static void rm_helper (node_t *&node_,
+                           value_t *value_,
+                           unsigned char **buff_,
+                           size_t buffsize_,
+                           size_t *maxbuffsize_,
+                           void (*func_) (prefix_t data_,
+                                          size_t size_,
+                                          Arg arg_),
+                           Arg arg_,
+                           bool call_on_uniq_);
+    static rm_result
+    rm_helper (node_t *&node_, prefix_t prefix_, size_t size_, value_t *value_);
+    static void destroy (node_t *node_);
+
+    //  Root of the path-compressed trie. Its prefix is always empty.
+    //  The value of each node is the set of pipes subscribed to the key
+    //  the node stands for, NULL if there are none.
+    node_t *root;
 
     generic_mtrie_t (const generic_mtrie_t<value_t> &);
     const generic_mtrie_t<value_t> &
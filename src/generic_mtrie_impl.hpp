@@ -27,14 +27,15 @@ You should have received a copy of the GNU Lesser General Public License
 along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
+
 #ifndef __ZMQ_GENERIC_MTRIE_IMPL_HPP_INCLUDED__
 #define __ZMQ_GENERIC_MTRIE_IMPL_HPP_INCLUDED__
 
 
 #include <stdlib.h>
+#include <string.h>
 
 #include <new>
-#include <algorithm>
 
 #include "err.hpp"
 #include "pipe.hpp"
@@ -42,112 +43,58 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include "generic_mtrie.hpp"
 
 template <typename T>
-zmq::generic_mtrie_t<T>::generic_mtrie_t () :
-    pipes (0),
-    min (0),
-    count (0),
-    live_nodes (0)
+zmq::generic_mtrie_t<T>::generic_mtrie_t () : root (node_t::make (NULL, 0))
 {
 }
 
 template <typename T> zmq::generic_mtrie_t<T>::~generic_mtrie_t ()
 {
-    LIBZMQ_DELETE (pipes);
-
-    if (count == 1) {
-        zmq_assert (next.node);
-        LIBZMQ_DELETE (next.node);
-    } else if (count > 1) {
-        for (unsigned short i = 0; i != count; ++i) {
-            LIBZMQ_DELETE (next.table[i]);
-        }
-        free (next.table);
-    }
+    destroy (root);
 }
 
-template <typename T>
-bool zmq::generic_mtrie_t<T>::add (prefix_t prefix_,
-                                   size_t size_,
-                                   value_t *pipe_)
+template <typename T> void zmq::generic_mtrie_t<T>::destroy (node_t *node_)
 {
-    return add_helper (prefix_, size_, pipe_);
+    LIBZMQ_DELETE (node_->value);
+    for (uint32_t i = 0; i != node_->count; ++i)
+        destroy (node_->children ()[i]);
+    node_t::free_node (node_);
 }
 
 template <typename T>
-bool zmq::generic_mtrie_t<T>::add_helper (prefix_t prefix_,
-                                          size_t size_,
-                                          value_t *pipe_)
+bool zmq::generic_mtrie_t<T>::add (prefix_t prefix_,
+                                   size_t size_,
+                                   value_t *pipe_)
 {
-    //  We are at the node corresponding to the prefix. We are done.
-    if (!size_) {
-        bool result = !pipes;
-        if (!pipes) {
-            pipes = new (std::nothrow) pipes_t;
-            alloc_assert (pipes);
+    node_t **node = &root;
+    while (size_) {
+        //  If there's no child sharing the first byte of the prefix,
+        //  the rest of the prefix becomes a new leaf.
+        node_t **child = (*node)->find_slot (*prefix_);
+        if (!child) {
+            node_t *leaf = node_t::make (prefix_, size_);
+            node_t::add_child (*node, leaf);
+            child = (*node)->find_slot (*prefix_);
         }
-        pipes->insert (pipe_);
-        return result;
-    }
 
-    unsigned char c = *prefix_;
-    if (c < min || c >= min + count) {
-        //  The character is out of range of currently handled
-        //  characters. We have to extend the table.
-        if (!count) {
-            min = c;
-            count = 1;
-            next.node = NULL;
-        } else if (count == 1) {
-            unsigned char oldc = min;
-            generic_mtrie_t *oldp = next.node;
-            count = (min < c ? c - min : min - c) + 1;
-            next.table =
-              (generic_mtrie_t **) malloc (sizeof (generic_mtrie_t *) * count);
-            alloc_assert (next.table);
-            for (unsigned short i = 0; i != count; ++i)
-                next.table[i] = 0;
-            min = std::min (min, c);
-            next.table[oldc - min] = oldp;
-        } else if (min < c) {
-            //  The new character is above the current character range.
-            unsigned short old_count = count;
-            count = c - min + 1;
-            next.table = (generic_mtrie_t **) realloc (
-              next.table, sizeof (generic_mtrie_t *) * count);
-            alloc_assert (next.table);
-            for (unsigned short i = old_count; i != count; i++)
-                next.table[i] = NULL;
-        } else {
-            //  The new character is below the current character range.
-            unsigned short old_count = count;
-            count = (min + old_count) - c;
-            next.table = (generic_mtrie_t **) realloc (
-              next.table, sizeof (generic_mtrie_t *) * count);
-            alloc_assert (next.table);
-            memmove (next.table + min - c, next.table,
-                     old_count * sizeof (generic_mtrie_t *));
-            for (unsigned short i = 0; i != min - c; i++)
-                next.table[i] = NULL;
-            min = c;
-        }
+        //  If the prefix diverges from the child's prefix (or ends) in
+        //  the middle of it, split the child at that point.
+        const size_t common = (*child)->common_prefix (prefix_, size_);
+        if (common < (*child)->prefix_size)
+            node_t::split (*child, common);
+
+        node = child;
+        prefix_ += common;
+        size_ -= common;
     }
 
-    //  If next node does not exist, create one.
-    if (count == 1) {
-        if (!next.node) {
-            next.node = new (std::nothrow) generic_mtrie_t;
-            alloc_assert (next.node);
-            ++live_nodes;
-        }
-        return next.node->add_helper (prefix_ + 1, size_ - 1, pipe_);
-    } else {
-        if (!next.table[c - min]) {
-            next.table[c - min] = new (std::nothrow) generic_mtrie_t;
-            alloc_assert (next.table[c - min]);
-            ++live_nodes;
-        }
-        return next.table[c - min]->add_helper (prefix_ + 1, size_ - 1, pipe_);
+    //  We are at the node corresponding to the prefix.
+    bool result = !(*node)->value;
+    if (!(*node)->value) {
+        (*node)->value = new (std::nothrow) pipes_t;
+        alloc_assert ((*node)->value);
     }
+    (*node)->value->insert (pipe_);
+    return result;
 }
 
 
@@ -161,23 +108,36 @@ void zmq::generic_mtrie_t<T>::rm (value_t *pipe_,
                                   bool call_on_uniq_)
 {
     unsigned char *buff = NULL;
-    rm_helper (pipe_, &buff, 0, 0, func_, arg_, call_on_uniq_);
+    size_t maxbuffsize = 0;
+    rm_helper (root, pipe_, &buff, 0, &maxbuffsize, func_, arg_,
+               call_on_uniq_);
     free (buff);
 }
 
 template <typename T>
 template <typename Arg>
-void zmq::generic_mtrie_t<T>::rm_helper (value_t *pipe_,
+void zmq::generic_mtrie_t<T>::rm_helper (node_t *&node_,
+                                         value_t *pipe_,
                                          unsigned char **buff_,
                                          size_t buffsize_,
-                                         size_t maxbuffsize_,
+                                         size_t *maxbuffsize_,
                                          void (*func_) (prefix_t data_,
                                                         size_t size_,
                                                         Arg arg_),
                                          Arg arg_,
                                          bool call_on_uniq_)
 {
+    //  Append the prefix of the node to the buffer.
+    if (buffsize_ + node_->prefix_size >= *maxbuffsize_) {
+        *maxbuffsize_ = buffsize_ + node_->prefix_size + 256;
+        *buff_ = (unsigned char *) realloc (*buff_, *maxbuffsize_);
+        alloc_assert (*buff_);
+    }
+    memcpy (*buff_ + buffsize_, node_->prefix (), node_->prefix_size);
+    buffsize_ += node_->prefix_size;
+
     //  Remove the subscription from this node.
+    pipes_t *&pipes = node_->value;
     if (pipes && pipes->erase (pipe_)) {
         if (!call_on_uniq_ || pipes->empty ()) {
             func_ (*buff_, buffsize_, arg_);
@@ -188,123 +148,37 @@ void zmq::generic_mtrie_t<T>::rm_helper (value_t *pipe_,
         }
     }
 
-    //  Adjust the buffer.
-    if (buffsize_ >= maxbuffsize_) {
-        maxbuffsize_ = buffsize_ + 256;
-        *buff_ = (unsigned char *) realloc (*buff_, maxbuffsize_);
-        alloc_assert (*buff_);
-    }
-
-    //  If there are no subnodes in the trie, return.
-    if (count == 0)
-        return;
-
-    //  If there's one subnode (optimisation).
-    if (count == 1) {
-        (*buff_)[buffsize_] = min;
-        buffsize_++;
-        next.node->rm_helper (pipe_, buff_, buffsize_, maxbuffsize_, func_,
-                              arg_, call_on_uniq_);
-
-        //  Prune the node if it was made redundant by the removal
-        if (next.node->is_redundant ()) {
-            LIBZMQ_DELETE (next.node);
-            count = 0;
-            --live_nodes;
-            zmq_assert (live_nodes == 0);
-        }
-        return;
-    }
-
-    //  If there are multiple subnodes.
-    //
-    //  New min non-null character in the node table after the removal
-    unsigned char new_min = min + count - 1;
-    //  New max non-null character in the node table after the removal
-    unsigned char new_max = min;
-    for (unsigned short c = 0; c != count; c++) {
-        (*buff_)[buffsize_] = min + c;
-        if (next.table[c]) {
-            next.table[c]->rm_helper (pipe_, buff_, buffsize_ + 1, maxbuffsize_,
-                                      func_, arg_, call_on_uniq_);
-
-            //  Prune redundant nodes from the mtrie
-            if (next.table[c]->is_redundant ()) {
-                LIBZMQ_DELETE (next.table[c]);
-
-                zmq_assert (live_nodes > 0);
-                --live_nodes;
-            } else {
-                //  The node is not redundant, so it's a candidate for being
-                //  the new min/max node.
-                //
-                //  We loop through the node array from left to right, so the
-                //  first non-null, non-redundant node encountered is the new
-                //  minimum index. Conversely, the last non-redundant, non-null
-                //  node encountered is the new maximum index.
-                if (c + min < new_min)
-                    new_min = c + min;
-                if (c + min > new_max)
-                    new_max = c + min;
-            }
+    uint32_t i = 0;
+    while (i != node_->count) {
+        node_t *&child = node_->children ()[i];
+        rm_helper (child, pipe_, buff_, buffsize_, maxbuffsize_, func_, arg_,
+                   call_on_uniq_);
+
+        //  Prune the child if it was made redundant by the removal,
+        //  otherwise merge it with its only remaining child, if any.
+        if (child->is_redundant ()) {
+            node_t::free_node (child);
+            node_t::rm_child (node_, i);
+        } else {
+            node_t::compact (child);
+            i++;
         }
     }
-
-    zmq_assert (count > 1);
-
-    //  Free the node table if it's no longer used.
-    if (live_nodes == 0) {
-        free (next.table);
-        next.table = NULL;
-        count = 0;
-    }
-    //  Compact the node table if possible
-    else if (live_nodes == 1) {
-        //  If there's only one live node in the table we can
-        //  switch to using the more compact single-node
-        //  representation
-        zmq_assert (new_min == new_max);
-        zmq_assert (new_min >= min && new_min < min + count);
-        generic_mtrie_t *node = next.table[new_min - min];
-        zmq_assert (node);
-        free (next.table);
-        next.node = node;
-        count = 1;
-        min = new_min;
-    } else if (new_min > min || new_max < min + count - 1) {
-        zmq_assert (new_max - new_min + 1 > 1);
-
-        generic_mtrie_t **old_table = next.table;
-        zmq_assert (new_min > min || new_max < min + count - 1);
-        zmq_assert (new_min >= min);
-        zmq_assert (new_max <= min + count - 1);
-        zmq_assert (new_max - new_min + 1 < count);
-
-        count = new_max - new_min + 1;
-        next.table =
-          (generic_mtrie_t **) malloc (sizeof (generic_mtrie_t *) * count);
-        alloc_assert (next.table);
-
-        memmove (next.table, old_table + (new_min - min),
-                 sizeof (generic_mtrie_t *) * count);
-        free (old_table);
-
-        min = new_min;
-    }
 }
 
 template <typename T>
 typename zmq::generic_mtrie_t<T>::rm_result
 zmq::generic_mtrie_t<T>::rm (prefix_t prefix_, size_t size_, value_t *pipe_)
 {
-    return rm_helper (prefix_, size_, pipe_);
+    return rm_helper (root, prefix_, size_, pipe_);
 }
 
 template <typename T>
 typename zmq::generic_mtrie_t<T>::rm_result zmq::generic_mtrie_t<T>::rm_helper (
-  prefix_t prefix_, size_t size_, value_t *pipe_)
+  node_t *&node_, prefix_t prefix_, size_t size_, value_t *pipe_)
 {
     if (!size_) {
+        pipes_t *&pipes = node_->value;
         if (!pipes)
             return not_found;
 
@@ -317,83 +191,21 @@ typename zmq::generic_mtrie_t<T>::rm_result zmq::generic_mtrie_t<T>::rm_helper (
         return (erased == 1) ? values_remain : not_found;
     }
 
-    unsigned char c = *prefix_;
-    if (!count || c < min || c >= min + count)
-        return not_found;
-
-    generic_mtrie_t *next_node = count == 1 ? next.node : next.table[c - min];
-
-    if (!next_node)
+    node_t **child = node_->find_slot (*prefix_);
+    if (!child || (*child)->prefix_size > size_
+        || memcmp ((*child)->prefix (), prefix_, (*child)->prefix_size) != 0)
         return not_found;
 
-    rm_result ret = next_node->rm_helper (prefix_ + 1, size_ - 1, pipe_);
+    rm_result ret = rm_helper (*child, prefix_ + (*child)->prefix_size,
+                               size_ - (*child)->prefix_size, pipe_);
 
-    if (next_node->is_redundant ()) {
-        LIBZMQ_DELETE (next_node);
-        zmq_assert (count > 0);
-
-        if (count == 1) {
-            next.node = 0;
-            count = 0;
-            --live_nodes;
-            zmq_assert (live_nodes == 0);
-        } else {
-            next.table[c - min] = 0;
-            zmq_assert (live_nodes > 1);
-            --live_nodes;
-
-            //  Compact the table if possible
-            if (live_nodes == 1) {
-                //  If there's only one live node in the table we can
-                //  switch to using the more compact single-node
-                //  representation
-                unsigned short i;
-                for (i = 0; i < count; ++i)
-                    if (next.table[i])
-                        break;
-
-                zmq_assert (i < count);
-                min += i;
-                count = 1;
-                generic_mtrie_t *oldp = next.table[i];
-                free (next.table);
-                next.node = oldp;
-            } else if (c == min) {
-                //  We can compact the table "from the left"
-                unsigned short i;
-                for (i = 1; i < count; ++i)
-                    if (next.table[i])
-                        break;
-
-                zmq_assert (i < count);
-                min += i;
-                count -= i;
-                generic_mtrie_t **old_table = next.table;
-                next.table = (generic_mtrie_t **) malloc (
-                  sizeof (generic_mtrie_t *) * count);
-                alloc_assert (next.table);
-                memmove (next.table, old_table + i,
-                         sizeof (generic_mtrie_t *) * count);
-                free (old_table);
-            } else if (c == min + count - 1) {
-                //  We can compact the table "from the right"
-                unsigned short i;
-                for (i = 1; i < count; ++i)
-                    if (next.table[count - 1 - i])
-                        break;
-
-                zmq_assert (i < count);
-                count -= i;
-                generic_mtrie_t **old_table = next.table;
-                next.table = (generic_mtrie_t **) malloc (
-                  sizeof (generic_mtrie_t *) * count);
-                alloc_assert (next.table);
-                memmove (next.table, old_table,
-                         sizeof (generic_mtrie_t *) * count);
-                free (old_table);
-            }
-        }
-    }
+    //  Prune the child if it became redundant, otherwise merge it with
+    //  its only remaining child, if any, to keep the trie compressed.
+    if ((*child)->is_redundant ()) {
+        node_t::free_node (*child);
+        node_t::rm_child (node_, child - node_->children ());
+    } else
+        node_t::compact (*child);
 
     return ret;
 }
@@ -405,12 +217,12 @@ void zmq::generic_mtrie_t<T>::match (prefix_t data_,
                                      void (*func_) (value_t *pipe_, Arg arg_),
                                      Arg arg_)
 {
-    generic_mtrie_t *current = this;
+    node_t *current = root;
     while (true) {
         //  Signal the pipes attached to this node.
-        if (current->pipes) {
-            for (typename pipes_t::iterator it = current->pipes->begin ();
-                 it != current->pipes->end (); ++it)
+        if (current->value) {
+            for (typename pipes_t::iterator it = current->value->begin ();
+                 it != current->value->end (); ++it)
                 func_ (*it, arg_);
         }
 
@@ -418,36 +230,17 @@ void zmq::generic_mtrie_t<T>::match (prefix_t data_,
         if (!size_)
             break;
 
-        //  If there are no subnodes in the trie, return.
-        if (current->count == 0)
+        //  If there's no child for the first byte of the data or the data
+        //  doesn't continue with the whole prefix of the child, we are done.
+        current = current->find (*data_);
+        if (!current || current->prefix_size > size_
+            || memcmp (current->prefix (), data_, current->prefix_size) != 0)
             break;
 
-        //  If there's one subnode (optimisation).
-        if (current->count == 1) {
-            if (data_[0] != current->min)
-                break;
-            current = current->next.node;
-            data_++;
-            size_--;
-            continue;
-        }
-
-        //  If there are multiple subnodes.
-        if (data_[0] < current->min
-            || data_[0] >= current->min + current->count)
-            break;
-        if (!current->next.table[data_[0] - current->min])
-            break;
-        current = current->next.table[data_[0] - current->min];
-        data_++;
-        size_--;
+        data_ += current->prefix_size;
+        size_ -= current->prefix_size;
     }
 }
 
-template <typename T> bool zmq::generic_mtrie_t<T>::is_redundant () const
-{
-    return !pipes && live_nodes == 0;
-}
-
 
 #endif
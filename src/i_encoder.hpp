@@ -51,6 +51,16 @@ struct i_encoder
 
     //  Load a new message into encoder.
     virtual void load_msg (msg_t *msg_) = 0;
+
+    //  If threshold is not zero, encode stops in front of any chunk of
+    //  the message that is at least threshold bytes long instead of copying
+    //  it, so that the chunk can be retrieved by encode_in_place.
+    virtual void set_in_place_threshold (size_t threshold_) = 0;
+
+    //  Returns the chunk that encode has stopped in front of, if any, and
+    //  moves past it. The chunk points to the message being encoded and is
+    //  valid until the next call to encode. Returns 0 if there is none.
+    virtual size_t encode_in_place (unsigned char **data_) = 0;
 };
 }
 
@@ -56,8 +56,10 @@ void zmq::io_object_t::unplug ()
     zmq_assert (poller);
 
     //  Forget about old poller in preparation to be migrated
-    //  to a different I/O thread.
+    //  to a different I/O thread. Timer handles are only meaningful
+    //  to the poller they were taken from.
     poller = NULL;
+    timers.clear ();
 }
 
 zmq::io_object_t::handle_t zmq::io_object_t::add_fd (fd_t fd_)
@@ -92,12 +94,32 @@ void zmq::io_object_t::reset_pollout (handle_t handle_)
 
 void zmq::io_object_t::add_timer (int timeout_, int id_)
 {
-    poller->add_timer (timeout_, this, id_);
+    //  A timer with the same ID still pending is replaced, as its handle
+    //  would be lost otherwise.
+    for (timers_t::iterator it = timers.begin (); it != timers.end (); ++it)
+        if (it->first == id_) {
+            if (poller->timer_pending (it->second))
+                poller->cancel_timer (it->second);
+            it->second = poller->add_timer (timeout_, this, id_);
+            return;
+        }
+    timers.push_back (
+      std::make_pair (id_, poller->add_timer (timeout_, this, id_)));
 }
 
 void zmq::io_object_t::cancel_timer (int id_)
 {
-    poller->cancel_timer (this, id_);
+    //  There are only a few timer IDs per object.
+    for (timers_t::iterator it = timers.begin (); it != timers.end (); ++it)
+        if (it->first == id_) {
+            poller->cancel_timer (it->second);
+            *it = timers.back ();
+            timers.pop_back ();
+            return;
+        }
+
+    //  Timer not found.
+    zmq_assert (false);
 }
 
 void zmq::io_object_t::in_event ()
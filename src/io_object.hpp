@@ -31,6 +31,7 @@
 #define __ZMQ_IO_OBJECT_HPP_INCLUDED__
 
 #include <stddef.h>
+#include <vector>
 
 #include "stdint.hpp"
 #include "poller.hpp"
@@ -76,6 +77,12 @@ class io_object_t : public i_poll_events
   private:
     poller_t *poller;
 
+    //  Handles of the timers added by the object, along with their IDs.
+    //  Handles of expired timers are kept until the ID is reused. There
+    //  is at most one pending timer per ID.
+    typedef std::vector<std::pair<int, poller_t::timer_handle_t> > timers_t;
+    timers_t timers;
+
     io_object_t (const io_object_t &);
     const io_object_t &operator= (const io_object_t &);
 };
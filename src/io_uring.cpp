@@ -0,0 +1,493 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "io_uring.hpp"
+#if defined ZMQ_USE_IO_URING
+
+#include <sys/epoll.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <endian.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <new>
+
+#include "macros.hpp"
+#include "err.hpp"
+#include "config.hpp"
+#include "i_poll_events.hpp"
+
+zmq::io_uring_t::io_uring_t (const zmq::thread_ctx_t &ctx_) :
+    worker_poller_base_t (ctx_),
+    ring_fd (retired_fd),
+    epoll_fd (retired_fd),
+    ring_ptr (NULL),
+    ring_size (0),
+    sqes (NULL),
+    sqes_size (0),
+    sq_head (NULL),
+    sq_tail (NULL),
+    sq_mask (0),
+    sq_entries (0),
+    sq_local_tail (0),
+    cq_head (NULL),
+    cq_tail (NULL),
+    cq_mask (0),
+    cqes (NULL)
+{
+    //  Kernels without io_uring support (or with io_uring disabled, e.g. by
+    //  a seccomp policy) are served by the epoll based loop.
+    if (!setup_ring ()) {
+        epoll_fd = epoll_create1 (EPOLL_CLOEXEC);
+        errno_assert (epoll_fd != -1);
+    }
+}
+
+zmq::io_uring_t::~io_uring_t ()
+{
+    //  Wait till the worker thread exits.
+    stop_worker ();
+
+    teardown_ring ();
+    if (epoll_fd != retired_fd)
+        close (epoll_fd);
+    for (retired_t::iterator it = retired.begin (); it != retired.end ();
+         ++it) {
+        LIBZMQ_DELETE (*it);
+    }
+}
+
+bool zmq::io_uring_t::setup_ring ()
+{
+    io_uring_params params;
+    memset (&params, 0, sizeof params);
+    params.flags = IORING_SETUP_CLAMP;
+
+    int rc = syscall (__NR_io_uring_setup, ring_entries, &params);
+    if (rc == -1)
+        return false;
+    ring_fd = rc;
+
+    //  Both rings are expected to share a single mapping, completions must
+    //  not be dropped when the completion ring overflows and waiting for
+    //  completions must accept a timeout.
+    const unsigned required =
+      IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((params.features & required) != required) {
+        teardown_ring ();
+        return false;
+    }
+
+    ring_size =
+      std::max (params.sq_off.array + params.sq_entries * sizeof (unsigned),
+                params.cq_off.cqes + params.cq_entries * sizeof (io_uring_cqe));
+    void *ptr = mmap (NULL, ring_size, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQ_RING);
+    if (ptr == MAP_FAILED) {
+        teardown_ring ();
+        return false;
+    }
+    ring_ptr = ptr;
+
+    sqes_size = params.sq_entries * sizeof (io_uring_sqe);
+    ptr = mmap (NULL, sqes_size, PROT_READ | PROT_WRITE,
+                MAP_SHARED | MAP_POPULATE, ring_fd, IORING_OFF_SQES);
+    if (ptr == MAP_FAILED) {
+        teardown_ring ();
+        return false;
+    }
+    sqes = (io_uring_sqe *) ptr;
+
+    unsigned char *ring = (unsigned char *) ring_ptr;
+    sq_head = (unsigned *) (ring + params.sq_off.head);
+    sq_tail = (unsigned *) (ring + params.sq_off.tail);
+    sq_mask = *(unsigned *) (ring + params.sq_off.ring_mask);
+    sq_entries = params.sq_entries;
+    sq_local_tail = *sq_tail;
+    cq_head = (unsigned *) (ring + params.cq_off.head);
+    cq_tail = (unsigned *) (ring + params.cq_off.tail);
+    cq_mask = *(unsigned *) (ring + params.cq_off.ring_mask);
+    cqes = (io_uring_cqe *) (ring + params.cq_off.cqes);
+
+    //  Submission queue entries are used in the order of the ring slots.
+    unsigned *sq_array = (unsigned *) (ring + params.sq_off.array);
+    for (unsigned i = 0; i != sq_entries; i++)
+        sq_array[i] = i;
+
+    return true;
+}
+
+void zmq::io_uring_t::teardown_ring ()
+{
+    if (sqes) {
+        munmap (sqes, sqes_size);
+        sqes = NULL;
+    }
+    if (ring_ptr) {
+        munmap (ring_ptr, ring_size);
+        ring_ptr = NULL;
+    }
+    if (ring_fd != retired_fd) {
+        close (ring_fd);
+        ring_fd = retired_fd;
+    }
+}
+
+zmq::io_uring_t::handle_t zmq::io_uring_t::add_fd (fd_t fd_,
+                                                   i_poll_events *events_)
+{
+    check_thread ();
+    poll_entry_t *pe = new (std::nothrow) poll_entry_t;
+    alloc_assert (pe);
+
+    pe->fd = fd_;
+    pe->mask = 0;
+    pe->armed_mask = 0;
+    pe->armed = false;
+    pe->cancelling = false;
+    pe->events = events_;
+
+    if (ring_fd == retired_fd) {
+        epoll_event ev;
+        memset (&ev, 0, sizeof ev);
+        ev.data.ptr = pe;
+        int rc = epoll_ctl (epoll_fd, EPOLL_CTL_ADD, fd_, &ev);
+        errno_assert (rc != -1);
+    }
+
+    //  Increase the load metric of the thread.
+    adjust_load (1);
+
+    return pe;
+}
+
+void zmq::io_uring_t::rm_fd (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    if (ring_fd == retired_fd) {
+        epoll_event ev;
+        memset (&ev, 0, sizeof ev);
+        int rc = epoll_ctl (epoll_fd, EPOLL_CTL_DEL, pe->fd, &ev);
+        errno_assert (rc != -1);
+    } else if (pe->armed)
+        cancel (pe);
+
+    //  The entry is deallocated once its poll request (if any) completes.
+    pe->fd = retired_fd;
+    retired.push_back (pe);
+
+    //  Decrease the load metric of the thread.
+    adjust_load (-1);
+}
+
+void zmq::io_uring_t::set_pollin (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->mask |= POLLIN;
+    update (pe);
+}
+
+void zmq::io_uring_t::reset_pollin (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->mask &= ~((uint32_t) POLLIN);
+    update (pe);
+}
+
+void zmq::io_uring_t::set_pollout (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->mask |= POLLOUT;
+    update (pe);
+}
+
+void zmq::io_uring_t::reset_pollout (handle_t handle_)
+{
+    check_thread ();
+    poll_entry_t *pe = (poll_entry_t *) handle_;
+    pe->mask &= ~((uint32_t) POLLOUT);
+    update (pe);
+}
+
+void zmq::io_uring_t::stop ()
+{
+    check_thread ();
+}
+
+int zmq::io_uring_t::max_fds ()
+{
+    return -1;
+}
+
+void zmq::io_uring_t::update (poll_entry_t *pe_)
+{
+    if (ring_fd == retired_fd) {
+        epoll_event ev;
+        memset (&ev, 0, sizeof ev);
+        ev.events = pe_->mask;
+        ev.data.ptr = pe_;
+        int rc = epoll_ctl (epoll_fd, EPOLL_CTL_MOD, pe_->fd, &ev);
+        errno_assert (rc != -1);
+        return;
+    }
+
+    //  Events removed from the interest set are filtered out when the poll
+    //  request completes, while added ones require the request in flight
+    //  to be cancelled. It is re-armed with the new set on completion.
+    if (!pe_->armed) {
+        if (pe_->mask)
+            arm (pe_);
+    } else if (pe_->mask & ~pe_->armed_mask)
+        cancel (pe_);
+}
+
+void zmq::io_uring_t::arm (poll_entry_t *pe_)
+{
+    uint32_t events = pe_->mask;
+#if __BYTE_ORDER == __BIG_ENDIAN
+    events = (events << 16) | (events >> 16);
+#endif
+
+    io_uring_sqe *sqe = get_sqe ();
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = pe_->fd;
+    sqe->poll32_events = events;
+    sqe->user_data = (uint64_t) (uintptr_t) pe_;
+
+    pe_->armed = true;
+    pe_->armed_mask = pe_->mask;
+}
+
+void zmq::io_uring_t::cancel (poll_entry_t *pe_)
+{
+    if (pe_->cancelling)
+        return;
+
+    //  Completion of the cancel request itself carries no user data, the
+    //  cancelled poll request completes with -ECANCELED.
+    io_uring_sqe *sqe = get_sqe ();
+    sqe->opcode = IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t) (uintptr_t) pe_;
+    sqe->user_data = 0;
+
+    pe_->cancelling = true;
+}
+
+io_uring_sqe *zmq::io_uring_t::get_sqe ()
+{
+    //  If the submission ring is full, pass the queued requests to the
+    //  kernel straight away.
+    if (sq_local_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE)
+        == sq_entries) {
+        submit (false, 0);
+        zmq_assert (sq_local_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE)
+                    < sq_entries);
+    }
+
+    io_uring_sqe *sqe = &sqes[sq_local_tail & sq_mask];
+    memset (sqe, 0, sizeof (io_uring_sqe));
+    sq_local_tail++;
+    return sqe;
+}
+
+void zmq::io_uring_t::submit (bool wait_, int timeout_)
+{
+    __atomic_store_n (sq_tail, sq_local_tail, __ATOMIC_RELEASE);
+    unsigned to_submit =
+      sq_local_tail - __atomic_load_n (sq_head, __ATOMIC_ACQUIRE);
+    if (!to_submit && !wait_)
+        return;
+
+    unsigned min_complete = 0;
+    unsigned flags = 0;
+    io_uring_getevents_arg arg;
+    __kernel_timespec ts;
+    if (wait_) {
+        min_complete = 1;
+        flags = IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG;
+        memset (&arg, 0, sizeof arg);
+        if (timeout_) {
+            ts.tv_sec = timeout_ / 1000;
+            ts.tv_nsec = (timeout_ % 1000) * 1000000;
+            arg.ts = (uint64_t) (uintptr_t) &ts;
+        }
+    }
+
+    int rc = syscall (__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                      flags, wait_ ? &arg : NULL, wait_ ? sizeof arg : 0);
+
+    //  ETIME means the timeout expired, EAGAIN and EBUSY that completions
+    //  have to be reaped before more requests can be submitted. Requests
+    //  that were not consumed stay queued for the next call.
+    if (rc == -1)
+        errno_assert (errno == ETIME || errno == EINTR || errno == EAGAIN
+                      || errno == EBUSY);
+}
+
+void zmq::io_uring_t::dispatch (poll_entry_t *pe_, uint32_t revents_)
+{
+    if (revents_ & (POLLERR | POLLHUP))
+        pe_->events->in_event ();
+    if (pe_->fd == retired_fd)
+        return;
+    if (revents_ & pe_->mask & POLLOUT)
+        pe_->events->out_event ();
+    if (pe_->fd == retired_fd)
+        return;
+    if (revents_ & pe_->mask & POLLIN)
+        pe_->events->in_event ();
+}
+
+void zmq::io_uring_t::destroy_retired ()
+{
+    retired_t::size_type kept = 0;
+    for (retired_t::size_type i = 0; i != retired.size (); i++) {
+        if (retired[i]->armed)
+            retired[kept++] = retired[i];
+        else
+            LIBZMQ_DELETE (retired[i]);
+    }
+    retired.resize (kept);
+}
+
+void zmq::io_uring_t::loop ()
+{
+    if (ring_fd != retired_fd)
+        loop_ring ();
+    else
+        loop_epoll ();
+}
+
+void zmq::io_uring_t::loop_ring ()
+{
+    completion_t completions[max_io_events];
+    bool idle = true;
+
+    while (true) {
+        //  Execute any due timers.
+        int timeout = (int) execute_timers ();
+
+        if (get_load () == 0) {
+            if (timeout == 0)
+                break;
+
+            // TODO sleep for timeout
+            continue;
+        }
+
+        //  Submit the queued requests and wait for completions. When busy
+        //  polling, the completion queue is just checked.
+        submit (!busy_polling (idle), timeout);
+
+        //  Move the completions out of the ring first, handling them
+        //  queues new requests which may require submitting.
+        unsigned head = *cq_head;
+        const unsigned tail = __atomic_load_n (cq_tail, __ATOMIC_ACQUIRE);
+        int n = 0;
+        for (; head != tail && n != max_io_events; head++, n++) {
+            const io_uring_cqe &cqe = cqes[head & cq_mask];
+            completions[n].user_data = cqe.user_data;
+            completions[n].res = cqe.res;
+        }
+        __atomic_store_n (cq_head, head, __ATOMIC_RELEASE);
+        idle = n == 0;
+
+        for (int i = 0; i < n; i++) {
+            if (completions[i].user_data == 0)
+                continue;
+
+            poll_entry_t *pe = (poll_entry_t *) completions[i].user_data;
+            pe->armed = false;
+            pe->cancelling = false;
+
+            if (pe->fd == retired_fd)
+                continue;
+
+            //  Cancelled requests complete with an error and are only
+            //  re-armed.
+            if (completions[i].res > 0)
+                dispatch (pe, (uint32_t) completions[i].res);
+
+            if (pe->fd != retired_fd && !pe->armed && pe->mask)
+                arm (pe);
+        }
+
+        //  Destroy retired event sources.
+        destroy_retired ();
+    }
+}
+
+void zmq::io_uring_t::loop_epoll ()
+{
+    epoll_event ev_buf[max_io_events];
+    bool idle = true;
+
+    while (true) {
+        //  Execute any due timers.
+        int timeout = (int) execute_timers ();
+
+        if (get_load () == 0) {
+            if (timeout == 0)
+                break;
+
+            // TODO sleep for timeout
+            continue;
+        }
+
+        //  Wait for events, unless busy polling.
+        const bool spin = busy_polling (idle);
+        int n = epoll_wait (epoll_fd, &ev_buf[0], max_io_events,
+                            spin ? 0 : timeout ? timeout : -1);
+        if (n == -1) {
+            errno_assert (errno == EINTR);
+            continue;
+        }
+        idle = n == 0;
+
+        for (int i = 0; i < n; i++) {
+            poll_entry_t *pe = ((poll_entry_t *) ev_buf[i].data.ptr);
+            if (pe->fd != retired_fd)
+                dispatch (pe, ev_buf[i].events);
+        }
+
+        //  Destroy retired event sources.
+        destroy_retired ();
+    }
+}
+
+#endif
@@ -0,0 +1,189 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_IO_URING_HPP_INCLUDED__
+#define __ZMQ_IO_URING_HPP_INCLUDED__
+
+//  poller.hpp decides which polling mechanism to use.
+#include "poller.hpp"
+#if defined ZMQ_USE_IO_URING
+
+#include <vector>
+#include <sys/epoll.h>
+#include <linux/io_uring.h>
+
+#include "ctx.hpp"
+#include "config.hpp"
+#include "fd.hpp"
+#include "stdint.hpp"
+#include "thread.hpp"
+#include "poller_base.hpp"
+
+namespace zmq
+{
+struct i_poll_events;
+
+//  This class implements socket polling mechanism using the Linux-specific
+//  io_uring interface. Every file descriptor with an active interest set
+//  has a single one-shot poll request in flight. Requests issued while
+//  handling a batch of completions are queued and submitted together with
+//  the wait for the next batch, i.e. by a single system call per loop
+//  iteration. If the kernel does not support io_uring (or lacks the
+//  features needed here) the poller falls back to epoll.
+
+class io_uring_t : public worker_poller_base_t
+{
+  public:
+    typedef void *handle_t;
+
+    io_uring_t (const thread_ctx_t &ctx_);
+    ~io_uring_t ();
+
+    //  "poller" concept.
+    handle_t add_fd (fd_t fd_, zmq::i_poll_events *events_);
+    void rm_fd (handle_t handle_);
+    void set_pollin (handle_t handle_);
+    void reset_pollin (handle_t handle_);
+    void set_pollout (handle_t handle_);
+    void reset_pollout (handle_t handle_);
+    void stop ();
+
+    static int max_fds ();
+
+  private:
+    //  Size of the submission ring. The kernel sizes the completion ring
+    //  twice as large.
+    enum
+    {
+        ring_entries = 4 * max_io_events
+    };
+
+    struct poll_entry_t
+    {
+        fd_t fd;
+
+        //  Events the owner is interested in (POLLIN/POLLOUT, which have
+        //  the same values as EPOLLIN/EPOLLOUT).
+        uint32_t mask;
+
+        //  Events the poll request in flight waits for.
+        uint32_t armed_mask;
+
+        //  True if a poll request for the entry is in flight.
+        bool armed;
+
+        //  True if a request to cancel the poll request was queued.
+        bool cancelling;
+
+        zmq::i_poll_events *events;
+    };
+
+    //  Result of a completed request, copied out of the completion ring.
+    struct completion_t
+    {
+        uint64_t user_data;
+        int res;
+    };
+
+    //  Main event loop.
+    void loop ();
+    void loop_ring ();
+    void loop_epoll ();
+
+    //  Sets up the rings, returns false if io_uring cannot be used.
+    bool setup_ring ();
+
+    //  Unmaps the rings and closes the io_uring file descriptor.
+    void teardown_ring ();
+
+    //  Propagates the change of the entry's interest set to the kernel.
+    void update (poll_entry_t *pe_);
+
+    //  Queues a poll request for the current interest set of the entry.
+    void arm (poll_entry_t *pe_);
+
+    //  Queues a request to cancel the poll request of the entry.
+    void cancel (poll_entry_t *pe_);
+
+    //  Returns next free submission queue entry.
+    io_uring_sqe *get_sqe ();
+
+    //  Submits the queued requests. If wait_ is true, waits till at least
+    //  one completion is available or timeout_ (in milliseconds, 0 meaning
+    //  infinity) expires.
+    void submit (bool wait_, int timeout_);
+
+    //  Invokes the events associated with a completed poll request.
+    void dispatch (poll_entry_t *pe_, uint32_t revents_);
+
+    //  Deallocates retired entries that have no requests in flight.
+    void destroy_retired ();
+
+    //  Main io_uring file descriptor, retired_fd if epoll is used.
+    fd_t ring_fd;
+
+    //  Main epoll file descriptor, retired_fd if io_uring is used.
+    fd_t epoll_fd;
+
+    //  Mapped submission and completion rings and submission queue entries.
+    void *ring_ptr;
+    size_t ring_size;
+    io_uring_sqe *sqes;
+    size_t sqes_size;
+
+    //  Pointers to the fields of the submission ring.
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned sq_mask;
+    unsigned sq_entries;
+
+    //  Local copy of the submission ring's tail. Published to the kernel
+    //  in submit.
+    unsigned sq_local_tail;
+
+    //  Pointers to the fields of the completion ring.
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned cq_mask;
+    io_uring_cqe *cqes;
+
+    //  List of retired event sources.
+    typedef std::vector<poll_entry_t *> retired_t;
+    retired_t retired;
+
+    io_uring_t (const io_uring_t &);
+    const io_uring_t &operator= (const io_uring_t &);
+};
+
+typedef io_uring_t poller_t;
+}
+
+#endif
+
+#endif
@@ -172,6 +172,8 @@ int zmq::kqueue_t::max_fds ()
 
 void zmq::kqueue_t::loop ()
 {
+    bool idle = true;
+
     while (true) {
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
@@ -184,11 +186,14 @@ void zmq::kqueue_t::loop ()
             continue;
         }
 
-        //  Wait for events.
+        //  Wait for events, unless busy polling.
         struct kevent ev_buf[max_io_events];
+        const bool spin = busy_polling (idle);
+        if (spin)
+            timeout = 0;
         timespec ts = {timeout / 1000, (timeout % 1000) * 1000000};
         int n = kevent (kqueue_fd, NULL, 0, &ev_buf[0], max_io_events,
-                        timeout ? &ts : NULL);
+                        timeout || spin ? &ts : NULL);
 #ifdef HAVE_FORK
         if (unlikely (pid != getpid ())) {
             //printf("zmq::kqueue_t::loop aborting on forked child %d\n", (int)getpid());
@@ -200,6 +205,7 @@ void zmq::kqueue_t::loop ()
             errno_assert (errno == EINTR);
             continue;
         }
+        idle = n == 0;
 
         for (int i = 0; i < n; i++) {
             poll_entry_t *pe = (poll_entry_t *) ev_buf[i].udata;
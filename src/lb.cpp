@@ -28,12 +28,24 @@
 */
 
 #include "precompiled.hpp"
+#include <algorithm>
+
 #include "lb.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
 #include "msg.hpp"
+#include "options.hpp"
+#include "random.hpp"
 
-zmq::lb_t::lb_t () : active (0), current (0), more (false), dropping (false)
+zmq::lb_t::lb_t (const options_t &options_) :
+    options (options_),
+    active (0),
+    current (0),
+    current_sent (0),
+    random_state (generate_random () | 1),
+    ring_dirty (false),
+    more (false),
+    dropping (false)
 {
 }
 
@@ -44,7 +56,9 @@ zmq::lb_t::~lb_t ()
 
 void zmq::lb_t::attach (pipe_t *pipe_)
 {
+    pipe_->set_weight (options.lb_weight);
     pipes.push_back (pipe_);
+    ring_dirty = true;
     activated (pipe_);
 }
 
@@ -64,8 +78,11 @@ void zmq::lb_t::pipe_terminated (pipe_t *pipe_)
         pipes.swap (index, active);
         if (current == active)
             current = 0;
+        if (index == current)
+            current_sent = 0;
     }
     pipes.erase (pipe_);
+    ring_dirty = true;
 }
 
 void zmq::lb_t::activated (pipe_t *pipe_)
@@ -80,7 +97,7 @@ int zmq::lb_t::send (msg_t *msg_)
     return sendpipe (msg_, NULL);
 }
 
-int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
+int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_, msg_t *key_)
 {
     //  Drop the message if required. If we are at the end of the message
     //  switch back to non-dropping mode.
@@ -96,6 +113,10 @@ int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
     }
 
     while (active > 0) {
+        //  All the frames of a message go to the same pipe.
+        if (!more)
+            choose (key_ ? key_ : msg_);
+
         if (pipes[current]->write (msg_)) {
             if (pipe_)
                 *pipe_ = pipes[current];
@@ -117,6 +138,7 @@ int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
             pipes.swap (current, active);
         else
             current = 0;
+        current_sent = 0;
     }
 
     //  If there are no pipes we cannot send the message.
@@ -131,8 +153,14 @@ int zmq::lb_t::sendpipe (msg_t *msg_, pipe_t **pipe_)
     if (!more) {
         pipes[current]->flush ();
 
-        if (++current >= active)
-            current = 0;
+        //  The weighted strategy stays with the pipe for as many messages
+        //  as its weight.
+        if (options.lb_strategy != ZMQ_LB_WEIGHTED
+            || ++current_sent >= pipes[current]->get_weight ()) {
+            current_sent = 0;
+            if (++current >= active)
+                current = 0;
+        }
     }
 
     //  Detach the message from the data buffer.
@@ -159,7 +187,138 @@ bool zmq::lb_t::has_out ()
         pipes.swap (current, active);
         if (current == active)
             current = 0;
+        current_sent = 0;
     }
 
     return false;
 }
+
+//  Finalises a hash so that close inputs spread over the whole ring.
+static uint32_t mix (uint32_t h_)
+{
+    h_ ^= h_ >> 16;
+    h_ *= 0x85ebca6b;
+    h_ ^= h_ >> 13;
+    h_ *= 0xc2b2ae35;
+    h_ ^= h_ >> 16;
+    return h_;
+}
+
+static uint32_t hash_key (const unsigned char *key_, size_t size_)
+{
+    //  FNV-1a.
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i != size_; i++)
+        h = (h ^ key_[i]) * 16777619u;
+    return mix (h);
+}
+
+void zmq::lb_t::choose (msg_t *key_)
+{
+    switch (options.lb_strategy) {
+        case ZMQ_LB_SHORTEST_QUEUE: {
+            //  Scan the active pipes starting with the one next in the
+            //  round-robin order, so that the pipes with equal queues
+            //  are used in turn.
+            pipes_t::size_type best = current;
+            uint64_t best_queued = pipes[current]->get_queued ();
+            pipes_t::size_type index = current;
+            for (pipes_t::size_type i = 1; i < active && best_queued > 0;
+                 i++) {
+                if (++index == active)
+                    index = 0;
+                const uint64_t queued = pipes[index]->get_queued ();
+                if (queued < best_queued) {
+                    best = index;
+                    best_queued = queued;
+                }
+            }
+            current = best;
+            break;
+        }
+
+        case ZMQ_LB_POWER_OF_TWO: {
+            //  Pick the less loaded of two distinct random pipes.
+            if (active < 2)
+                break;
+            const pipes_t::size_type first = random_active ();
+            pipes_t::size_type second = random_active ();
+            if (second == first && ++second == active)
+                second = 0;
+            current = pipes[first]->get_queued ()
+                          <= pipes[second]->get_queued ()
+                        ? first
+                        : second;
+            break;
+        }
+
+        case ZMQ_LB_CONSISTENT_HASH: {
+            //  While the pipe of the key is full, fall back to round-robin.
+            const pipes_t::size_type index = pipes.index (find_on_ring (key_));
+            if (index < active)
+                current = index;
+            break;
+        }
+
+        default:
+            //  Round-robin and weighted strategies advance the current
+            //  pipe once the previous message is sent.
+            break;
+    }
+}
+
+zmq::pipe_t *zmq::lb_t::find_on_ring (msg_t *key_)
+{
+    if (ring_dirty)
+        build_ring ();
+
+    size_t offset = options.lb_key_offset;
+    size_t size = key_->size ();
+    offset = std::min (offset, size);
+    size -= offset;
+    if (options.lb_key_size > 0)
+        size = std::min (size, (size_t) options.lb_key_size);
+    const uint32_t h =
+      hash_key ((const unsigned char *) key_->data () + offset, size);
+
+    ring_t::const_iterator it = std::lower_bound (
+      ring.begin (), ring.end (), std::make_pair (h, (pipe_t *) NULL));
+    if (it == ring.end ())
+        it = ring.begin ();
+    return it->second;
+}
+
+void zmq::lb_t::build_ring ()
+{
+    ring.clear ();
+    ring.reserve (pipes.size () * ring_points_per_pipe);
+    for (pipes_t::size_type i = 0; i != pipes.size (); i++) {
+        //  The points depend on the peer only. A peer the socket connected
+        //  to keeps its points when it reconnects, and so its keys. The
+        //  peers of accepted connections are told apart by their pipe.
+        const std::string &endpoint = pipes[i]->get_endpoint ();
+        uint32_t seed;
+        if (!endpoint.empty ())
+            seed = hash_key ((const unsigned char *) endpoint.data (),
+                             endpoint.size ());
+        else {
+            const uint64_t id = (uint64_t) (uintptr_t) pipes[i];
+            seed = mix ((uint32_t) id ^ mix ((uint32_t) (id >> 32)));
+        }
+        for (uint32_t point = 0; point != ring_points_per_pipe; point++)
+            ring.push_back (
+              std::make_pair (mix (seed + point * 0x9e3779b9), pipes[i]));
+    }
+    std::sort (ring.begin (), ring.end ());
+    ring_dirty = false;
+}
+
+uint32_t zmq::lb_t::random_active ()
+{
+    //  Xorshift, there is no need for anything stronger to spread
+    //  the load.
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state % active;
+}
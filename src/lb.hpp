@@ -30,18 +30,25 @@
 #ifndef __ZMQ_LB_HPP_INCLUDED__
 #define __ZMQ_LB_HPP_INCLUDED__
 
+#include <utility>
+#include <vector>
+
 #include "array.hpp"
 #include "pipe.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
+struct options_t;
+
 //  This class manages a set of outbound pipes. On send it load balances
-//  messages fairly among the pipes.
+//  messages among the pipes, using the strategy selected by the
+//  ZMQ_LB_STRATEGY option of the owning socket.
 
 class lb_t
 {
   public:
-    lb_t ();
+    lb_t (const options_t &options_);
     ~lb_t ();
 
     void attach (pipe_t *pipe_);
@@ -54,11 +61,30 @@ class lb_t
     //  It is possible for this function to return success but keep pipe_
     //  unset if the rest of a multipart message to a terminated pipe is
     //  being dropped. For the first frame, this will never happen.
-    int sendpipe (msg_t *msg_, pipe_t **pipe_);
+    //  If key_ is set, it is the frame the ZMQ_LB_CONSISTENT_HASH strategy
+    //  takes the key from, instead of the first frame of the message.
+    int sendpipe (msg_t *msg_, pipe_t **pipe_, msg_t *key_ = NULL);
 
     bool has_out ();
 
   private:
+    //  Chooses the active pipe to send the message with the given key
+    //  frame to.
+    void choose (msg_t *key_);
+
+    //  Returns a random index of an active pipe.
+    uint32_t random_active ();
+
+    //  Returns the pipe owning the point of the hash ring that follows
+    //  the hash of the key in the given frame.
+    pipe_t *find_on_ring (msg_t *key_);
+
+    //  Rebuilds the hash ring from the current list of pipes.
+    void build_ring ();
+
+    //  Options of the owning socket.
+    const options_t &options;
+
     //  List of outbound pipes.
     typedef array_t<pipe_t, 2> pipes_t;
     pipes_t pipes;
@@ -70,6 +96,26 @@ class lb_t
     //  Points to the last pipe that the most recent message was sent to.
     pipes_t::size_type current;
 
+    //  Number of messages sent to the current pipe in a row, used by
+    //  the weighted strategy.
+    int current_sent;
+
+    //  State of the generator used by the power of two choices strategy.
+    uint32_t random_state;
+
+    //  Consistent hash ring used by the ZMQ_LB_CONSISTENT_HASH strategy,
+    //  sorted by the hash of the points. Each pipe owns a fixed number of
+    //  points that do not depend on the other pipes, so that attaching or
+    //  terminating a pipe only remaps the keys falling next to its points.
+    //  The ring is rebuilt lazily after the list of pipes changes.
+    enum
+    {
+        ring_points_per_pipe = 64
+    };
+    typedef std::vector<std::pair<uint32_t, pipe_t *> > ring_t;
+    ring_t ring;
+    bool ring_dirty;
+
     //  True if last we are in the middle of a multipart message.
     bool more;
 
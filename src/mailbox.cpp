@@ -29,9 +29,10 @@
 
 #include "precompiled.hpp"
 #include "mailbox.hpp"
+#include "clock.hpp"
 #include "err.hpp"
 
-zmq::mailbox_t::mailbox_t ()
+zmq::mailbox_t::mailbox_t (int busy_poll_) : busy_poll (busy_poll_)
 {
     //  Get the pipe into passive state. That way, if the users starts by
     //  polling on the associated file descriptor it will get woken up when
@@ -44,11 +45,6 @@ zmq::mailbox_t::mailbox_t ()
 zmq::mailbox_t::~mailbox_t ()
 {
     //  TODO: Retrieve and deallocate commands inside the cpipe.
-
-    // Work around problem that other threads might still be in our
-    // send() method, by waiting on the mutex before disappearing.
-    sync.lock ();
-    sync.unlock ();
 }
 
 zmq::fd_t zmq::mailbox_t::get_fd () const
@@ -58,16 +54,26 @@ zmq::fd_t zmq::mailbox_t::get_fd () const
 
 void zmq::mailbox_t::send (const command_t &cmd_)
 {
-    sync.lock ();
-    cpipe.write (cmd_, false);
-    const bool ok = cpipe.flush ();
-    sync.unlock ();
-    if (!ok)
+    if (!cpipe.write (cmd_))
         signaler.send ();
 }
 
 int zmq::mailbox_t::recv (command_t *cmd_, int timeout_)
 {
+    //  Spin on the queue for a while before waiting for the signal. While
+    //  the pipe is active, the senders don't have to signal us at all.
+    if (busy_poll && timeout_ != 0) {
+        if (!active)
+            active = cpipe.wake ();
+        if (active) {
+            const uint64_t end = clock_t::now_us () + busy_poll;
+            do {
+                if (cpipe.poll (cmd_))
+                    return 0;
+            } while (clock_t::now_us () < end);
+        }
+    }
+
     //  Try to get the command straight away.
     if (active) {
         if (cpipe.read (cmd_))
@@ -36,8 +36,7 @@
 #include "fd.hpp"
 #include "config.hpp"
 #include "command.hpp"
-#include "ypipe.hpp"
-#include "mutex.hpp"
+#include "mpsc_queue.hpp"
 #include "i_mailbox.hpp"
 
 namespace zmq
@@ -45,7 +44,9 @@ namespace zmq
 class mailbox_t : public i_mailbox
 {
   public:
-    mailbox_t ();
+    //  If busy_poll is not zero, blocking recv polls the queue for that many
+    //  microseconds before waiting for a signal.
+    mailbox_t (int busy_poll_ = 0);
     ~mailbox_t ();
 
     fd_t get_fd () const;
@@ -62,23 +63,22 @@ class mailbox_t : public i_mailbox
 #endif
 
   private:
-    //  The pipe to store actual commands.
-    typedef ypipe_t<command_t, command_pipe_granularity> cpipe_t;
+    //  The queue to store actual commands. There's only one thread
+    //  receiving from the mailbox, but there is arbitrary number of threads
+    //  sending, which is exactly what the queue allows without locking.
+    typedef mpsc_queue_t<command_t, command_queue_size> cpipe_t;
     cpipe_t cpipe;
 
     //  Signaler to pass signals from writer thread to reader thread.
     signaler_t signaler;
 
-    //  There's only one thread receiving from the mailbox, but there
-    //  is arbitrary number of threads sending. Given that ypipe requires
-    //  synchronised access on both of its endpoints, we have to synchronise
-    //  the sending side.
-    mutex_t sync;
-
     //  True if the underlying pipe is active, ie. when we are allowed to
     //  read commands from it.
     bool active;
 
+    //  Busy polling interval in microseconds.
+    const int busy_poll;
+
     //  Disable copying of mailbox_t object.
     mailbox_t (const mailbox_t &);
     const mailbox_t &operator= (const mailbox_t &);
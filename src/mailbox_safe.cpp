@@ -77,19 +77,18 @@ void zmq::mailbox_safe_t::clear_signalers ()
 
 void zmq::mailbox_safe_t::send (const command_t &cmd_)
 {
-    sync->lock ();
-    cpipe.write (cmd_, false);
-    const bool ok = cpipe.flush ();
-
-    if (!ok) {
+    //  The lock is needed only to wake up the receivers. Taking it ensures
+    //  that a receiver that found the queue empty is already waiting on the
+    //  condition variable.
+    if (!cpipe.write (cmd_)) {
+        sync->lock ();
         cond_var.broadcast ();
         for (std::vector<signaler_t *>::iterator it = signalers.begin ();
              it != signalers.end (); ++it) {
             (*it)->send ();
         }
+        sync->unlock ();
     }
-
-    sync->unlock ();
 }
 
 int zmq::mailbox_safe_t::recv (command_t *cmd_, int timeout_)
@@ -37,7 +37,7 @@
 #include "fd.hpp"
 #include "config.hpp"
 #include "command.hpp"
-#include "ypipe.hpp"
+#include "mpsc_queue.hpp"
 #include "mutex.hpp"
 #include "i_mailbox.hpp"
 #include "condition_variable.hpp"
@@ -69,8 +69,9 @@ class mailbox_safe_t : public i_mailbox
 #endif
 
   private:
-    //  The pipe to store actual commands.
-    typedef ypipe_t<command_t, command_pipe_granularity> cpipe_t;
+    //  The queue to store actual commands. Receivers are serialised by
+    //  sync, senders don't have to be.
+    typedef mpsc_queue_t<command_t, command_queue_size> cpipe_t;
     cpipe_t cpipe;
 
     //  Condition variable to pass signals from writer thread to reader thread.
@@ -0,0 +1,262 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_MPSC_QUEUE_HPP_INCLUDED__
+#define __ZMQ_MPSC_QUEUE_HPP_INCLUDED__
+
+#include <deque>
+
+#include "atomic_ptr.hpp"
+#include "mutex.hpp"
+#include "err.hpp"
+
+#ifdef ZMQ_HAVE_WINDOWS
+#include "windows.hpp"
+#else
+#include <sched.h>
+#endif
+
+namespace zmq
+{
+//  Lock-free queue implementation.
+//  Only a single thread can read from the queue at any specific moment.
+//  Arbitrary number of threads can write to the queue concurrently.
+//  T is the type of the object in the queue.
+//  N is the number of items the queue holds without locking. It must be
+//  a power of two.
+//
+//  Items are stored in a ring of N slots. Writers reserve a slot by
+//  advancing the write position with a compare-and-swap and then mark the
+//  slot as filled; the reader consumes the slots in order and marks them
+//  as free for the next round. When the ring is full, writers switch to
+//  an overflow queue protected by a mutex until the reader drains it.
+//
+//  Same as with ypipe_t, the reader is put to sleep when it finds the
+//  queue empty and the first writer to arrive afterwards is told to wake
+//  it up. Both the sleeping and the overflow states are stored in the
+//  lowest bits of the write position, so that a single atomic operation
+//  both reserves a slot and checks for them.
+
+template <typename T, int N> class mpsc_queue_t
+{
+  public:
+    //  Initialises the queue.
+    inline mpsc_queue_t () : writer (0), reader (0)
+    {
+        for (int i = 0; i != N; i++)
+            states[i].value.store (i * step);
+    }
+
+    inline ~mpsc_queue_t ()
+    {
+        //  A writer that has used the overflow queue may still be
+        //  releasing the lock. Wait for it before disappearing.
+        sync.lock ();
+        sync.unlock ();
+    }
+
+    //  Write an item to the queue. Returns false if the reader thread is
+    //  sleeping. In that case, caller is obliged to wake the reader up.
+    //  Can be called from any number of threads at the same time.
+    inline bool write (const T &value_)
+    {
+        while (true) {
+            const int w = writer.load ();
+            if (w & overflow_flag) {
+                //  Keep using the overflow queue until the reader switches
+                //  back to the ring. The reader never sleeps meanwhile.
+                scoped_lock_t lock (sync);
+                if (writer.load () & overflow_flag) {
+                    overflow.push_back (value_);
+                    return true;
+                }
+                continue;
+            }
+
+            const int pos = w & ~flags;
+            const int slot = ((unsigned int) pos / step) & (N - 1);
+            const int diff = (int) ((unsigned int) states[slot].value.load ()
+                                    - (unsigned int) pos);
+            if (diff == 0) {
+                //  Reserve the slot, waking up the reader if needed.
+                if (writer.cas (w, (int) ((unsigned int) pos + step)) != w)
+                    continue;
+                values[slot] = value_;
+                states[slot].value.store (pos | filled);
+                return !(w & asleep_flag);
+            }
+            if (diff < 0) {
+                //  The slot wasn't consumed yet in the previous round,
+                //  i.e. the ring is full.
+                scoped_lock_t lock (sync);
+                if (writer.cas (w, w | overflow_flag) != w)
+                    continue;
+                overflow.push_back (value_);
+                return !(w & asleep_flag);
+            }
+
+            //  Some other writer has taken the slot already.
+        }
+    }
+
+    //  Reads an item from the queue. Returns false if there is no value
+    //  available, in which case the reader is considered to be asleep and
+    //  the next writer will be asked to wake it up.
+    inline bool read (T *value_) { return read (value_, true); }
+
+    //  Same as read, except that the reader doesn't go to sleep if there
+    //  is no value available. Used to busy poll the queue.
+    inline bool poll (T *value_) { return read (value_, false); }
+
+    //  Takes the sleeping reader out of the sleeping state on its own.
+    //  Returns false if a writer has done so already, in which case the
+    //  writer is going to wake the reader up.
+    inline bool wake ()
+    {
+        while (true) {
+            const int w = writer.load ();
+            if (!(w & asleep_flag))
+                return false;
+            if (writer.cas (w, w & ~asleep_flag) == w)
+                return true;
+        }
+    }
+
+  private:
+    inline bool read (T *value_, bool sleep_)
+    {
+        //  Items taken over from the overflow queue go first. The ring
+        //  is not used until they are all read.
+        if (!drained.empty ()) {
+            if (value_)
+                *value_ = drained.front ();
+            drained.pop_front ();
+            return true;
+        }
+
+        while (true) {
+            const int slot = (reader / step) & (N - 1);
+            if (states[slot].value.load () == (int) (reader | filled)) {
+                if (value_)
+                    *value_ = values[slot];
+                states[slot].value.store ((int) (reader + N * step));
+                reader += step;
+                return true;
+            }
+
+            const int w = writer.load ();
+            if ((unsigned int) (w & ~flags) != reader) {
+                //  A writer has reserved the slot but has not filled it
+                //  yet. It is a matter of a few instructions, so wait.
+                yield ();
+                continue;
+            }
+
+            if (w & overflow_flag) {
+                //  The ring is empty. Items written in the meantime are in
+                //  the overflow queue; take them all at once. Once there
+                //  are none left, switch back to the ring.
+                scoped_lock_t lock (sync);
+                if (!overflow.empty ()) {
+                    drained.swap (overflow);
+                    if (value_)
+                        *value_ = drained.front ();
+                    drained.pop_front ();
+                    return true;
+                }
+                const int old = writer.cas (w, w & ~overflow_flag);
+                zmq_assert (old == w);
+                continue;
+            }
+
+            //  The queue is empty. Go to sleep unless some writer has just
+            //  reserved a slot.
+            if (!sleep_ || writer.cas (w, w | asleep_flag) == w)
+                return false;
+        }
+    }
+
+    enum
+    {
+        //  Flags stored in the write position.
+        asleep_flag = 1,
+        overflow_flag = 2,
+        flags = asleep_flag | overflow_flag,
+
+        //  Positions are multiples of step to leave space for the flags.
+        step = 4,
+
+        //  Slot state of a slot that was filled at the given position.
+        filled = 1
+    };
+
+    static inline void yield ()
+    {
+#ifdef ZMQ_HAVE_WINDOWS
+        SwitchToThread ();
+#else
+        sched_yield ();
+#endif
+    }
+
+    //  The items in the ring.
+    T values[N];
+
+    //  State of each slot: its position if the slot is free to be written
+    //  at that position, the position with the 'filled' bit set if it was
+    //  written and not yet read.
+    struct state_t
+    {
+        state_t () : value (0) {}
+        atomic_value_t value;
+    };
+    state_t states[N];
+
+    //  Position the next writer is going to write to, with the flags.
+    atomic_value_t writer;
+
+    //  Position the reader is going to read from. Accessed only by the
+    //  reader.
+    unsigned int reader;
+
+    //  Items written while the ring was full.
+    std::deque<T> overflow;
+    mutex_t sync;
+
+    //  Items moved out of the overflow queue by the reader. Accessed only
+    //  by the reader.
+    std::deque<T> drained;
+
+    //  Disable copying of mpsc_queue_t object.
+    mpsc_queue_t (const mpsc_queue_t &);
+    const mpsc_queue_t &operator= (const mpsc_queue_t &);
+};
+}
+
+#endif
@@ -38,6 +38,7 @@
 #include "stdint.hpp"
 #include "likely.hpp"
 #include "metadata.hpp"
+#include "slab_allocator.hpp"
 #include "err.hpp"
 
 //  Check whether the sizes of public representation of the message (zmq_msg_t)
@@ -82,7 +83,7 @@ int zmq::msg_t::init ()
     return 0;
 }
 
-int zmq::msg_t::init_size (size_t size_)
+int zmq::msg_t::init_size (size_t size_, const allocator_t *allocator_)
 {
     if (size_ <= max_vsm_size) {
         u.vsm.metadata = NULL;
@@ -99,7 +100,8 @@ int zmq::msg_t::init_size (size_t size_)
         u.lmsg.routing_id = 0;
         u.lmsg.content = NULL;
         if (sizeof (content_t) + size_ > size_)
-            u.lmsg.content = (content_t *) malloc (sizeof (content_t) + size_);
+            u.lmsg.content =
+              (content_t *) slab_alloc (sizeof (content_t) + size_, allocator_);
         if (unlikely (!u.lmsg.content)) {
             errno = ENOMEM;
             return -1;
@@ -163,7 +165,7 @@ int zmq::msg_t::init_data (void *data_,
         u.lmsg.flags = 0;
         u.lmsg.group[0] = '\0';
         u.lmsg.routing_id = 0;
-        u.lmsg.content = (content_t *) malloc (sizeof (content_t));
+        u.lmsg.content = (content_t *) slab_alloc (sizeof (content_t));
         if (!u.lmsg.content) {
             errno = ENOMEM;
             return -1;
@@ -228,7 +230,7 @@ int zmq::msg_t::close ()
             if (u.lmsg.content->ffn)
                 u.lmsg.content->ffn (u.lmsg.content->data,
                                      u.lmsg.content->hint);
-            free (u.lmsg.content);
+            slab_free (u.lmsg.content);
         }
     }
 
@@ -490,7 +492,7 @@ bool zmq::msg_t::rm_refs (int refs_)
 
         if (u.lmsg.content->ffn)
             u.lmsg.content->ffn (u.lmsg.content->data, u.lmsg.content->hint);
-        free (u.lmsg.content);
+        slab_free (u.lmsg.content);
 
         return false;
     }
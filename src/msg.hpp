@@ -33,6 +33,7 @@
 #include <stddef.h>
 #include <stdio.h>
 
+#include "allocator.hpp"
 #include "config.hpp"
 #include "err.hpp"
 #include "fd.hpp"
@@ -89,7 +90,9 @@ class msg_t
               void *hint,
               content_t *content_ = NULL);
 
-    int init_size (size_t size_);
+    //  If given, content too large to be stored in the message itself
+    //  is allocated from the allocator.
+    int init_size (size_t size_, const allocator_t *allocator_ = NULL);
     int init_data (void *data_, size_t size_, msg_free_fn *ffn_, void *hint_);
     int init_external_storage (content_t *content_,
                                void *data_,
@@ -30,6 +30,8 @@
 #include "precompiled.hpp"
 #include <string.h>
 #include <stdarg.h>
+#include <algorithm>
+#include <new>
 
 #include "object.hpp"
 #include "ctx.hpp"
@@ -75,6 +77,12 @@ void zmq::object_t::process_command (command_t &cmd_)
             process_activate_read ();
             break;
 
+        case command_t::activate_read_batch:
+            process_activate_read_batch (
+              cmd_.args.activate_read_batch.pipes,
+              cmd_.args.activate_read_batch.count);
+            break;
+
         case command_t::activate_write:
             process_activate_write (cmd_.args.activate_write.msgs_read);
             break;
@@ -144,6 +152,10 @@ void zmq::object_t::process_command (command_t &cmd_)
             process_reaped ();
             break;
 
+        case command_t::resolved:
+            process_resolved (cmd_.args.resolved.request);
+            break;
+
         case command_t::inproc_connected:
             process_seqnum ();
             break;
@@ -266,6 +278,23 @@ void zmq::object_t::send_activate_read (pipe_t *destination_)
     send_command (cmd);
 }
 
+void zmq::object_t::send_activate_read_batch (pipe_t **destinations_,
+                                              size_t count_)
+{
+    //  The readers share the thread, so the command is sent to the first
+    //  one and the array is handed over to it.
+    pipe_t **pipes = new (std::nothrow) pipe_t *[count_];
+    alloc_assert (pipes);
+    std::copy (destinations_, destinations_ + count_, pipes);
+
+    command_t cmd;
+    cmd.destination = destinations_[0];
+    cmd.type = command_t::activate_read_batch;
+    cmd.args.activate_read_batch.pipes = pipes;
+    cmd.args.activate_read_batch.count = count_;
+    send_command (cmd);
+}
+
 void zmq::object_t::send_activate_write (pipe_t *destination_,
                                          uint64_t msgs_read_)
 {
@@ -412,6 +441,11 @@ void zmq::object_t::process_activate_read ()
     zmq_assert (false);
 }
 
+void zmq::object_t::process_activate_read_batch (pipe_t **, size_t)
+{
+    zmq_assert (false);
+}
+
 void zmq::object_t::process_activate_write (uint64_t)
 {
     zmq_assert (false);
@@ -467,6 +501,11 @@ void zmq::object_t::process_reaped ()
     zmq_assert (false);
 }
 
+void zmq::object_t::process_resolved (dns_request_t *)
+{
+    zmq_assert (false);
+}
+
 void zmq::object_t::process_seqnum ()
 {
     zmq_assert (false);
@@ -45,6 +45,7 @@ class socket_base_t;
 class session_base_t;
 class io_thread_t;
 class own_t;
+struct dns_request_t;
 
 //  Base class for all objects that participate in inter-thread
 //  communication.
@@ -94,6 +95,8 @@ class object_t
                       zmq::i_engine *engine_,
                       bool inc_seqnum_ = true);
     void send_activate_read (zmq::pipe_t *destination_);
+    void send_activate_read_batch (zmq::pipe_t **destinations_,
+                                   size_t count_);
     void send_activate_write (zmq::pipe_t *destination_, uint64_t msgs_read_);
     void send_hiccup (zmq::pipe_t *destination_, void *pipe_);
     void send_pipe_term (zmq::pipe_t *destination_);
@@ -115,6 +118,8 @@ class object_t
     virtual void process_attach (zmq::i_engine *engine_);
     virtual void process_bind (zmq::pipe_t *pipe_);
     virtual void process_activate_read ();
+    virtual void process_activate_read_batch (zmq::pipe_t **pipes_,
+                                              size_t count_);
     virtual void process_activate_write (uint64_t msgs_read_);
     virtual void process_hiccup (void *pipe_);
     virtual void process_pipe_term ();
@@ -126,6 +131,7 @@ class object_t
     virtual void process_term_endpoint (std::string *endpoint_);
     virtual void process_reap (zmq::socket_base_t *socket_);
     virtual void process_reaped ();
+    virtual void process_resolved (zmq::dns_request_t *request_);
 
     //  Special handler called after a command that requires a seqnum
     //  was processed. The implementation should catch up with its counter
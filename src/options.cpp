@@ -36,6 +36,7 @@
 
 #ifndef ZMQ_HAVE_WINDOWS
 #include <net/if.h>
+#include <sys/socket.h>
 #endif
 
 #if defined IFNAMSIZ
@@ -232,7 +233,17 @@ zmq::options_t::options_t () :
     use_fd (-1),
     zap_enforce_domain (false),
     loopback_fastpath (false),
-    zero_copy (true)
+    zero_copy (true),
+    counters_ivl (0),
+    zero_copy_send (0),
+    exact_topics (false),
+    tcp_listeners (1),
+    lb_strategy (ZMQ_LB_ROUND_ROBIN),
+    lb_weight (1),
+    lb_key_offset (0),
+    lb_key_size (0),
+    fq_batch (1),
+    conflate_topics (false)
 {
     memset (curve_public_key, 0, CURVE_KEYSIZE);
     memset (curve_secret_key, 0, CURVE_KEYSIZE);
@@ -706,6 +717,76 @@ int zmq::options_t::setsockopt (int option_,
             return do_setsockopt_int_as_bool_relaxed (optval_, optvallen_,
                                                       &loopback_fastpath);
 
+        case ZMQ_COUNTERS_IVL:
+            if (is_int && value >= 0) {
+                counters_ivl = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ZERO_COPY_SEND:
+            if (is_int && value >= 0) {
+                zero_copy_send = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_EXACT_TOPICS:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &exact_topics);
+
+        case ZMQ_TCP_LISTENERS:
+            //  Listeners can only share an endpoint with SO_REUSEPORT.
+#ifdef SO_REUSEPORT
+            if (is_int && value >= 1) {
+#else
+            if (is_int && value == 1) {
+#endif
+                tcp_listeners = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_STRATEGY:
+            if (is_int && value >= ZMQ_LB_ROUND_ROBIN
+                && value <= ZMQ_LB_CONSISTENT_HASH) {
+                lb_strategy = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_WEIGHT:
+            if (is_int && value >= 1) {
+                lb_weight = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_KEY_OFFSET:
+            if (is_int && value >= 0) {
+                lb_key_offset = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_KEY_SIZE:
+            if (is_int && value >= 0) {
+                lb_key_size = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_FQ_BATCH:
+            if (is_int && value >= 1) {
+                fq_batch = value;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CONFLATE_TOPICS:
+            return do_setsockopt_int_as_bool_strict (optval_, optvallen_,
+                                                     &conflate_topics);
+
         case ZMQ_METADATA:
             if (optvallen_ > 0 && !is_int) {
                 std::string s ((char *) optval_);
@@ -1120,6 +1201,76 @@ int zmq::options_t::getsockopt (int option_,
             }
             break;
 
+        case ZMQ_COUNTERS_IVL:
+            if (is_int) {
+                *value = counters_ivl;
+                return 0;
+            }
+            break;
+
+        case ZMQ_ZERO_COPY_SEND:
+            if (is_int) {
+                *value = zero_copy_send;
+                return 0;
+            }
+            break;
+
+        case ZMQ_EXACT_TOPICS:
+            if (is_int) {
+                *value = exact_topics;
+                return 0;
+            }
+            break;
+
+        case ZMQ_TCP_LISTENERS:
+            if (is_int) {
+                *value = tcp_listeners;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_STRATEGY:
+            if (is_int) {
+                *value = lb_strategy;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_WEIGHT:
+            if (is_int) {
+                *value = lb_weight;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_KEY_OFFSET:
+            if (is_int) {
+                *value = lb_key_offset;
+                return 0;
+            }
+            break;
+
+        case ZMQ_LB_KEY_SIZE:
+            if (is_int) {
+                *value = lb_key_size;
+                return 0;
+            }
+            break;
+
+        case ZMQ_FQ_BATCH:
+            if (is_int) {
+                *value = fq_batch;
+                return 0;
+            }
+            break;
+
+        case ZMQ_CONFLATE_TOPICS:
+            if (is_int) {
+                *value = conflate_topics;
+                return 0;
+            }
+            break;
+
         default:
 #if defined(ZMQ_ACT_MILITANT)
             malformed = false;
@@ -35,6 +35,7 @@
 #include <set>
 #include <map>
 
+#include "allocator.hpp"
 #include "atomic_ptr.hpp"
 #include "stddef.h"
 #include "stdint.hpp"
@@ -260,6 +261,48 @@ struct options_t
     // Use zero copy strategy for storing message content when decoding.
     bool zero_copy;
 
+    //  Allocator of the memory holding the received messages.
+    allocator_t allocator;
+
+    //  Interval in milliseconds between counters snapshots published
+    //  on the monitor socket. Default 0 (disabled).
+    int counters_ivl;
+
+    //  Minimal size of the messages whose content is sent without being
+    //  copied by the kernel, if supported. Default 0 (disabled).
+    int zero_copy_send;
+
+    //  If true, subscriptions made on (X)PUB and (X)SUB sockets match
+    //  messages whose first frame is equal to the topic rather than
+    //  starting with it. Empty subscriptions still match all messages.
+    bool exact_topics;
+
+    //  Number of listeners sharing each TCP endpoint the socket is bound
+    //  to, spread across the I/O threads. Default 1.
+    int tcp_listeners;
+
+    //  Strategy used to choose the peer each outbound message is sent to,
+    //  one of ZMQ_LB_*. Default ZMQ_LB_ROUND_ROBIN.
+    int lb_strategy;
+
+    //  Weight of the peers attached from now on, used by the
+    //  ZMQ_LB_WEIGHTED strategy. Default 1.
+    int lb_weight;
+
+    //  Range of the first frame of the messages used as the key by the
+    //  ZMQ_LB_CONSISTENT_HASH strategy. A size of 0 extends the range to
+    //  the end of the frame. Default 0, 0 (the whole frame).
+    int lb_key_offset;
+    int lb_key_size;
+
+    //  Maximum number of messages read from an inbound pipe in a row
+    //  before moving on to the next one. Default 1.
+    int fq_batch;
+
+    //  If true, (X)SUB sockets keep only the most recently arrived message
+    //  of each topic, the topic being the first frame of the message.
+    bool conflate_topics;
+
     // Application metadata
     std::map<std::string, std::string> app_metadata;
 };
@@ -30,38 +30,29 @@
 #include "precompiled.hpp"
 #include <new>
 #include <stddef.h>
+#include <algorithm>
 
 #include "macros.hpp"
 #include "pipe.hpp"
 #include "err.hpp"
+#include "ctx.hpp"
 
 #include "ypipe.hpp"
 #include "ypipe_conflate.hpp"
+#include "ypipe_conflate_topics.hpp"
 
 int zmq::pipepair (class object_t *parents_[2],
                    class pipe_t *pipes_[2],
                    int hwms_[2],
-                   bool conflate_[2])
+                   conflate_t conflate_[2])
 {
     //   Creates two pipe objects. These objects are connected by two ypipes,
     //   each to pass messages in one direction.
 
-    typedef ypipe_t<msg_t, message_pipe_granularity> upipe_normal_t;
-    typedef ypipe_conflate_t<msg_t> upipe_conflate_t;
+    const allocator_t allocator = parents_[0]->get_ctx ()->get_allocator ();
 
-    pipe_t::upipe_t *upipe1;
-    if (conflate_[0])
-        upipe1 = new (std::nothrow) upipe_conflate_t ();
-    else
-        upipe1 = new (std::nothrow) upipe_normal_t ();
-    alloc_assert (upipe1);
-
-    pipe_t::upipe_t *upipe2;
-    if (conflate_[1])
-        upipe2 = new (std::nothrow) upipe_conflate_t ();
-    else
-        upipe2 = new (std::nothrow) upipe_normal_t ();
-    alloc_assert (upipe2);
+    pipe_t::upipe_t *upipe1 = pipe_t::create_upipe (conflate_[0], allocator);
+    pipe_t::upipe_t *upipe2 = pipe_t::create_upipe (conflate_[1], allocator);
 
     pipes_[0] = new (std::nothrow)
       pipe_t (parents_[0], upipe1, upipe2, hwms_[1], hwms_[0], conflate_[0]);
@@ -76,12 +67,27 @@ int zmq::pipepair (class object_t *parents_[2],
     return 0;
 }
 
+zmq::pipe_t::upipe_t *
+zmq::pipe_t::create_upipe (conflate_t conflate_, const allocator_t &allocator_)
+{
+    upipe_t *upipe;
+    if (conflate_ == conflate_last)
+        upipe = new (std::nothrow) ypipe_conflate_t<msg_t> ();
+    else if (conflate_ == conflate_by_topic)
+        upipe = new (std::nothrow) ypipe_conflate_topics_t ();
+    else
+        upipe = new (std::nothrow)
+          ypipe_t<msg_t, message_pipe_granularity> (allocator_);
+    alloc_assert (upipe);
+    return upipe;
+}
+
 zmq::pipe_t::pipe_t (object_t *parent_,
                      upipe_t *inpipe_,
                      upipe_t *outpipe_,
                      int inhwm_,
                      int outhwm_,
-                     bool conflate_) :
+                     conflate_t conflate_) :
     object_t (parent_),
     inpipe (inpipe_),
     outpipe (outpipe_),
@@ -94,11 +100,15 @@ zmq::pipe_t::pipe_t (object_t *parent_,
     msgs_read (0),
     msgs_written (0),
     peers_msgs_read (0),
+    msgs_dropped (0),
+    activations (0),
     peer (NULL),
     sink (NULL),
+    flush_batch (NULL),
     state (active),
     delay (true),
     server_socket_routing_id (0),
+    weight (1),
     conflate (conflate_)
 {
 }
@@ -121,6 +131,16 @@ void zmq::pipe_t::set_event_sink (i_pipe_events *sink_)
     sink = sink_;
 }
 
+void zmq::pipe_t::set_flush_batch (flush_batch_t *batch_)
+{
+    flush_batch = batch_;
+}
+
+zmq::flush_batch_t *zmq::pipe_t::get_flush_batch () const
+{
+    return flush_batch;
+}
+
 void zmq::pipe_t::set_server_socket_routing_id (
   uint32_t server_socket_routing_id_)
 {
@@ -143,6 +163,16 @@ const zmq::blob_t &zmq::pipe_t::get_routing_id ()
     return router_socket_routing_id;
 }
 
+void zmq::pipe_t::set_endpoint (const std::string &endpoint_)
+{
+    endpoint = endpoint_;
+}
+
+const std::string &zmq::pipe_t::get_endpoint () const
+{
+    return endpoint;
+}
+
 const zmq::blob_t &zmq::pipe_t::get_credential () const
 {
     return credential;
@@ -234,9 +264,15 @@ bool zmq::pipe_t::write (msg_t *msg_)
 
     bool more = msg_->flags () & msg_t::more ? true : false;
     const bool is_routing_id = msg_->is_routing_id ();
-    outpipe->write (*msg_, more);
-    if (!more && !is_routing_id)
-        msgs_written++;
+    const bool queued = outpipe->write (*msg_, more);
+    if (!more && !is_routing_id) {
+        //  A message replacing a pending one does not use up the high
+        //  water mark, the replaced message is dropped instead.
+        if (queued)
+            msgs_written++;
+        else
+            msgs_dropped++;
+    }
 
     return true;
 }
@@ -260,18 +296,43 @@ void zmq::pipe_t::flush ()
     if (state == term_ack_sent)
         return;
 
+    //  The owner is sending a batch of messages, flush when it's done.
+    if (flush_batch && flush_batch->defer (this))
+        return;
+
+    pipe_t *reader = flush_outpipe ();
+    if (reader)
+        send_activate_read (reader);
+}
+
+zmq::pipe_t *zmq::pipe_t::flush_outpipe ()
+{
+    //  The peer does not exist anymore at this point.
+    if (state == term_ack_sent)
+        return NULL;
+
     if (outpipe && !outpipe->flush ())
-        send_activate_read (peer);
+        return peer;
+    return NULL;
 }
 
 void zmq::pipe_t::process_activate_read ()
 {
     if (!in_active && (state == active || state == waiting_for_delimiter)) {
         in_active = true;
+        activations++;
         sink->read_activated (this);
     }
 }
 
+void zmq::pipe_t::process_activate_read_batch (pipe_t **pipes_,
+                                               size_t count_)
+{
+    for (size_t i = 0; i != count_; i++)
+        pipes_[i]->process_activate_read ();
+    delete[] pipes_;
+}
+
 void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
 {
     //  Remember the peer's message sequence number.
@@ -279,6 +340,7 @@ void zmq::pipe_t::process_activate_write (uint64_t msgs_read_)
 
     if (!out_active && state == active) {
         out_active = true;
+        activations++;
         sink->write_activated (this);
     }
 }
@@ -368,7 +430,7 @@ void zmq::pipe_t::process_pipe_term_ack ()
     //  hand because msg_t doesn't have automatic destructor. Then deallocate
     //  the ypipe itself.
 
-    if (!conflate) {
+    if (conflate == conflate_none) {
         msg_t msg;
         while (inpipe->read (&msg)) {
             int rc = msg.close ();
@@ -504,12 +566,7 @@ void zmq::pipe_t::hiccup ()
     inpipe = NULL;
 
     //  Create new inpipe.
-    if (conflate)
-        inpipe = new (std::nothrow) ypipe_conflate_t<msg_t> ();
-    else
-        inpipe = new (std::nothrow) ypipe_t<msg_t, message_pipe_granularity> ();
-
-    alloc_assert (inpipe);
+    inpipe = create_upipe (conflate, get_ctx ()->get_allocator ());
     in_active = true;
 
     //  Notify the peer about the hiccup.
@@ -544,7 +601,111 @@ bool zmq::pipe_t::check_hwm () const
     return (!full);
 }
 
+uint64_t zmq::pipe_t::get_queued () const
+{
+    return msgs_written - peers_msgs_read;
+}
+
+void zmq::pipe_t::set_weight (int weight_)
+{
+    weight = weight_;
+}
+
+int zmq::pipe_t::get_weight () const
+{
+    return weight;
+}
+
+void zmq::pipe_t::get_counters (zmq_pipe_counters_t *counters_) const
+{
+    counters_->msgs_in = msgs_read;
+    counters_->msgs_out = msgs_written;
+    //  As seen from this end, the peer may have read some more already.
+    counters_->msgs_queued = msgs_written - peers_msgs_read;
+    counters_->msgs_dropped = msgs_dropped;
+    counters_->activations = activations;
+
+    const size_t size =
+      std::min (router_socket_routing_id.size (), sizeof counters_->routing_id);
+    counters_->routing_id_size = (uint8_t) size;
+    if (size > 0)
+        memcpy (counters_->routing_id, router_socket_routing_id.data (), size);
+}
+
 void zmq::pipe_t::send_hwms_to_peer (int inhwm_, int outhwm_)
 {
     send_pipe_hwm (peer, inhwm_, outhwm_);
 }
+
+zmq::flush_batch_t::flush_batch_t () : depth (0), batched (0)
+{
+}
+
+zmq::flush_batch_t::~flush_batch_t ()
+{
+    zmq_assert (depth == 0);
+}
+
+void zmq::flush_batch_t::open ()
+{
+    depth++;
+}
+
+//  Orders the readers by the thread they live in.
+static bool tid_less (zmq::pipe_t *lhs_, zmq::pipe_t *rhs_)
+{
+    return lhs_->get_tid () < rhs_->get_tid ();
+}
+
+void zmq::flush_batch_t::close ()
+{
+    zmq_assert (depth > 0);
+    if (--depth > 0)
+        return;
+
+    //  Pipes may be recorded several times, flushing an already flushed
+    //  pipe is cheap and returns no reader to activate.
+    for (pipes_t::size_type i = 0; i != pipes.size (); i++) {
+        pipe_t *reader = pipes[i]->flush_outpipe ();
+        if (reader)
+            readers.push_back (reader);
+    }
+
+    //  Activate the readers with a command per thread.
+    if (readers.size () == 1)
+        pipes[0]->send_activate_read (readers[0]);
+    else if (!readers.empty ()) {
+        std::sort (readers.begin (), readers.end (), tid_less);
+        pipes_t::size_type first = 0;
+        for (pipes_t::size_type i = 1; i <= readers.size (); i++) {
+            if (i < readers.size ()
+                && readers[i]->get_tid () == readers[first]->get_tid ())
+                continue;
+            if (i - first == 1)
+                pipes[0]->send_activate_read (readers[first]);
+            else {
+                pipes[0]->send_activate_read_batch (&readers[first],
+                                                    i - first);
+                batched += i - first;
+            }
+            first = i;
+        }
+    }
+    readers.clear ();
+    pipes.clear ();
+}
+
+uint64_t zmq::flush_batch_t::batched_activations () const
+{
+    return batched;
+}
+
+bool zmq::flush_batch_t::defer (pipe_t *pipe_)
+{
+    if (depth == 0)
+        return false;
+
+    if (pipes.empty () || pipes.back () != pipe_)
+        pipes.push_back (pipe_);
+    return true;
+}
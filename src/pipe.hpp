@@ -30,6 +30,9 @@
 #ifndef __ZMQ_PIPE_HPP_INCLUDED__
 #define __ZMQ_PIPE_HPP_INCLUDED__
 
+#include <string>
+#include <vector>
+
 #include "msg.hpp"
 #include "ypipe_base.hpp"
 #include "config.hpp"
@@ -42,6 +45,20 @@ namespace zmq
 {
 class object_t;
 class pipe_t;
+class flush_batch_t;
+
+//  Ways the messages are queued in a direction of a pipepair.
+enum conflate_t
+{
+    //  All the messages are kept.
+    conflate_none,
+
+    //  Only the most recently arrived message is kept.
+    conflate_last,
+
+    //  Only the most recently arrived message of each topic is kept.
+    conflate_by_topic
+};
 
 //  Create a pipepair for bi-directional transfer of messages.
 //  First HWM is for messages passed from first pipe to the second pipe.
@@ -49,12 +66,12 @@ class pipe_t;
 //  Delay specifies how the pipe behaves when the peer terminates. If true
 //  pipe receives all the pending messages before terminating, otherwise it
 //  terminates straight away.
-//  If conflate is true, only the most recently arrived message could be
-//  read (older messages are discarded)
+//  Conflate specifies for each pipe which of the messages arriving to it
+//  could be read (older messages are discarded)
 int pipepair (zmq::object_t *parents_[2],
               zmq::pipe_t *pipes_[2],
               int hwms_[2],
-              bool conflate_[2]);
+              conflate_t conflate_[2]);
 
 struct i_pipe_events
 {
@@ -79,12 +96,16 @@ class pipe_t : public object_t,
     friend int pipepair (zmq::object_t *parents_[2],
                          zmq::pipe_t *pipes_[2],
                          int hwms_[2],
-                         bool conflate_[2]);
+                         conflate_t conflate_[2]);
 
   public:
     //  Specifies the object to send events to.
     void set_event_sink (i_pipe_events *sink_);
 
+    //  Specifies the batch to postpone flushes to while it is open.
+    void set_flush_batch (flush_batch_t *batch_);
+    flush_batch_t *get_flush_batch () const;
+
     //  Pipe endpoint can store an routing ID to be used by its clients.
     void set_server_socket_routing_id (uint32_t routing_id_);
     uint32_t get_server_socket_routing_id ();
@@ -95,6 +116,11 @@ class pipe_t : public object_t,
 
     const blob_t &get_credential () const;
 
+    //  Endpoint the owning socket connected to when the pipe was created,
+    //  empty for the pipes of connections it accepted.
+    void set_endpoint (const std::string &endpoint_);
+    const std::string &get_endpoint () const;
+
     //  Returns true if there is at least one message to read in the pipe.
     bool check_read ();
 
@@ -143,12 +169,31 @@ class pipe_t : public object_t,
     //  Returns true if HWM is not reached
     bool check_hwm () const;
 
+    //  Returns the number of messages written to the pipe that the peer
+    //  is not known to have read yet.
+    uint64_t get_queued () const;
+
+    //  Load balancing weight of the pipe, defaults to 1.
+    void set_weight (int weight_);
+    int get_weight () const;
+
+    //  Records a message the owning socket had to drop because
+    //  the pipe was full.
+    void count_dropped () { msgs_dropped++; }
+
+    //  Fills in the counters of this pipe endpoint.
+    void get_counters (zmq_pipe_counters_t *counters_) const;
+
   private:
     //  Type of the underlying lock-free pipe.
     typedef ypipe_base_t<msg_t> upipe_t;
 
+    //  The batch flushes the pipes itself.
+    friend class flush_batch_t;
+
     //  Command handlers.
     void process_activate_read ();
+    void process_activate_read_batch (pipe_t **pipes_, size_t count_);
     void process_activate_write (uint64_t msgs_read_);
     void process_hiccup (void *pipe_);
     void process_pipe_term ();
@@ -158,6 +203,14 @@ class pipe_t : public object_t,
     //  Handler for delimiter read from the pipe.
     void process_delimiter ();
 
+    //  Flushes the outbound pipe. Returns the peer if it is asleep and
+    //  has to be activated, NULL otherwise.
+    pipe_t *flush_outpipe ();
+
+    //  Creates an underlying pipe queueing messages the given way.
+    static upipe_t *create_upipe (conflate_t conflate_,
+                                  const allocator_t &allocator_);
+
     //  Constructor is private. Pipe can only be created using
     //  pipepair function.
     pipe_t (object_t *parent_,
@@ -165,7 +218,7 @@ class pipe_t : public object_t,
             upipe_t *outpipe_,
             int inhwm_,
             int outhwm_,
-            bool conflate_);
+            conflate_t conflate_);
 
     //  Pipepair uses this function to let us know about
     //  the peer pipe object.
@@ -200,12 +253,20 @@ class pipe_t : public object_t,
     //  can be higher at the moment.
     uint64_t peers_msgs_read;
 
+    //  Number of messages dropped on the way to this pipe and number
+    //  of times the pipe was reactivated (became readable or writable).
+    uint64_t msgs_dropped;
+    uint64_t activations;
+
     //  The pipe object on the other side of the pipepair.
     pipe_t *peer;
 
     //  Sink to send events to.
     i_pipe_events *sink;
 
+    //  Batch owned by the sink, collects flushes while it is open.
+    flush_batch_t *flush_batch;
+
     //  States of the pipe endpoint:
     //  active: common state before any termination begins,
     //  delimiter_received: delimiter was read from pipe before
@@ -238,6 +299,12 @@ class pipe_t : public object_t,
     //  Routing id of the writer. Used uniquely by the reader side.
     int server_socket_routing_id;
 
+    //  Load balancing weight of the writer side.
+    int weight;
+
+    //  Endpoint the pipe was connected to, if any.
+    std::string endpoint;
+
     //  Pipe's credential.
     blob_t credential;
 
@@ -247,12 +314,55 @@ class pipe_t : public object_t,
     //  Computes appropriate low watermark from the given high watermark.
     static int compute_lwm (int hwm_);
 
-    const bool conflate;
+    const conflate_t conflate;
 
     //  Disable copying.
     pipe_t (const pipe_t &);
     const pipe_t &operator= (const pipe_t &);
 };
+
+//  While a batch is open, flushes of the pipes associated with it are
+//  postponed and recorded instead. All the recorded pipes are flushed
+//  when the batch is closed, so that sending a sequence of messages costs
+//  a single flush per pipe, and the readers living in the same thread
+//  are woken up by a single command. Batches can be nested, the pipes
+//  are flushed when the outermost one is closed.
+//  Must be closed before any command is processed by the owner, as
+//  commands may deallocate the recorded pipes.
+
+class flush_batch_t
+{
+  public:
+    flush_batch_t ();
+    ~flush_batch_t ();
+
+    void open ();
+    void close ();
+
+    //  If the batch is open, records the pipe and returns true.
+    //  Otherwise returns false and the pipe is expected to flush itself.
+    bool defer (pipe_t *pipe_);
+
+    //  Number of readers activated by a command shared with other readers.
+    uint64_t batched_activations () const;
+
+  private:
+    //  Number of times the batch was opened and not closed yet.
+    int depth;
+
+    uint64_t batched;
+
+    //  Pipes written to since the batch was opened.
+    typedef std::vector<pipe_t *> pipes_t;
+    pipes_t pipes;
+
+    //  Readers to be activated once the pipes are flushed, kept to reuse
+    //  the memory.
+    pipes_t readers;
+
+    flush_batch_t (const flush_batch_t &);
+    const flush_batch_t &operator= (const flush_batch_t &);
+};
 }
 
 #endif
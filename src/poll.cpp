@@ -138,6 +138,8 @@ int zmq::poll_t::max_fds ()
 
 void zmq::poll_t::loop ()
 {
+    bool idle = true;
+
     while (true) {
         //  Execute any due timers.
         int timeout = (int) execute_timers ();
@@ -154,8 +156,10 @@ void zmq::poll_t::loop ()
             continue;
         }
 
-        //  Wait for events.
-        int rc = poll (&pollset[0], pollset.size (), timeout ? timeout : -1);
+        //  Wait for events, unless busy polling.
+        const bool spin = busy_polling (idle);
+        int rc = poll (&pollset[0], pollset.size (),
+                       spin ? 0 : timeout ? timeout : -1);
 #ifdef ZMQ_HAVE_WINDOWS
         wsa_assert (rc != SOCKET_ERROR);
 #else
@@ -164,6 +168,7 @@ void zmq::poll_t::loop ()
             continue;
         }
 #endif
+        idle = rc == 0;
 
         //  If there are no events (i.e. it's a timeout) there's no point
         //  in checking the pollset.
@@ -30,8 +30,9 @@
 #ifndef __ZMQ_POLLER_HPP_INCLUDED__
 #define __ZMQ_POLLER_HPP_INCLUDED__
 
-#if defined ZMQ_USE_KQUEUE + defined ZMQ_USE_EPOLL + defined ZMQ_USE_DEVPOLL   \
-    + defined ZMQ_USE_POLLSET + defined ZMQ_USE_POLL + defined ZMQ_USE_SELECT  \
+#if defined ZMQ_USE_KQUEUE + defined ZMQ_USE_EPOLL + defined ZMQ_USE_IO_URING \
+    + defined ZMQ_USE_DEVPOLL + defined ZMQ_USE_POLLSET + defined ZMQ_USE_POLL \
+    + defined ZMQ_USE_SELECT                                                   \
   > 1
 #error More than one of the ZMQ_USE_* macros defined
 #endif
@@ -40,6 +41,8 @@
 #include "kqueue.hpp"
 #elif defined ZMQ_USE_EPOLL
 #include "epoll.hpp"
+#elif defined ZMQ_USE_IO_URING
+#include "io_uring.hpp"
 #elif defined ZMQ_USE_DEVPOLL
 #include "devpoll.hpp"
 #elif defined ZMQ_USE_POLLSET
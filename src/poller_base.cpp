@@ -55,24 +55,21 @@ void zmq::poller_base_t::adjust_load (int amount_)
         load.sub (-amount_);
 }
 
-void zmq::poller_base_t::add_timer (int timeout_, i_poll_events *sink_, int id_)
+zmq::poller_base_t::timer_handle_t
+zmq::poller_base_t::add_timer (int timeout_, i_poll_events *sink_, int id_)
 {
     uint64_t expiration = clock.now_ms () + timeout_;
-    timer_info_t info = {sink_, id_};
-    timers.insert (timers_t::value_type (expiration, info));
+    return timers.add (expiration, sink_, id_);
 }
 
-void zmq::poller_base_t::cancel_timer (i_poll_events *sink_, int id_)
+void zmq::poller_base_t::cancel_timer (timer_handle_t handle_)
 {
-    //  Complexity of this operation is O(n). We assume it is rarely used.
-    for (timers_t::iterator it = timers.begin (); it != timers.end (); ++it)
-        if (it->second.sink == sink_ && it->second.id == id_) {
-            timers.erase (it);
-            return;
-        }
-
-    //  Timer not found.
-    zmq_assert (false);
+    timers.cancel (handle_);
+}
+
+bool zmq::poller_base_t::timer_pending (timer_handle_t handle_) const
+{
+    return timers.pending (handle_);
 }
 
 uint64_t zmq::poller_base_t::execute_timers ()
@@ -81,34 +78,13 @@ uint64_t zmq::poller_base_t::execute_timers ()
     if (timers.empty ())
         return 0;
 
-    //  Get the current time.
-    uint64_t current = clock.now_ms ();
-
-    //   Execute the timers that are already due.
-    timers_t::iterator it = timers.begin ();
-    while (it != timers.end ()) {
-        //  If we have to wait to execute the item, same will be true about
-        //  all the following items (multimap is sorted). Thus we can stop
-        //  checking the subsequent timers and return the time to wait for
-        //  the next timer (at least 1ms).
-        if (it->first > current)
-            return it->first - current;
-
-        //  Trigger the timer.
-        it->second.sink->timer_event (it->second.id);
-
-        //  Remove it from the list of active timers.
-        timers_t::iterator o = it;
-        ++it;
-        timers.erase (o);
-    }
-
-    //  There are no more timers.
-    return 0;
+    return timers.execute (clock.now_ms ());
 }
 
 zmq::worker_poller_base_t::worker_poller_base_t (const thread_ctx_t &ctx_) :
-    ctx (ctx_)
+    ctx (ctx_),
+    busy_poll (ctx_.get_busy_poll ()),
+    busy_poll_start (0)
 {
 }
 
@@ -123,6 +99,17 @@ void zmq::worker_poller_base_t::start ()
     ctx.start_thread (worker, worker_routine, this);
 }
 
+bool zmq::worker_poller_base_t::busy_polling (bool idle_)
+{
+    if (!busy_poll)
+        return false;
+
+    const uint64_t now = clock_t::now_us ();
+    if (!idle_)
+        busy_poll_start = now;
+    return now - busy_poll_start < busy_poll;
+}
+
 void zmq::worker_poller_base_t::check_thread ()
 {
 #ifdef _DEBUG
@@ -30,11 +30,10 @@
 #ifndef __ZMQ_POLLER_BASE_HPP_INCLUDED__
 #define __ZMQ_POLLER_BASE_HPP_INCLUDED__
 
-#include <map>
-
 #include "clock.hpp"
 #include "atomic_counter.hpp"
 #include "ctx.hpp"
+#include "timer_wheel.hpp"
 
 namespace zmq
 {
@@ -44,8 +43,8 @@ struct i_poll_events;
 // convention, this is done via a typedef.
 //
 // At the time of writing, the following implementations of the poller_t
-// concept exist: zmq::devpoll_t, zmq::epoll_t, zmq::kqueue_t, zmq::poll_t,
-// zmq::pollset_t, zmq::select_t
+// concept exist: zmq::devpoll_t, zmq::epoll_t, zmq::io_uring_t, zmq::kqueue_t,
+// zmq::poll_t, zmq::pollset_t, zmq::select_t
 //
 // An implementation of the poller_t concept must provide the following public
 // methods:
@@ -54,11 +53,15 @@ struct i_poll_events;
 //
 //   Add a timeout to expire in timeout_ milliseconds. After the
 //   expiration, timer_event on sink_ object will be called with
-//   argument set to id_.
-// void add_timer(int timeout_, zmq::i_poll_events *sink_, int id_);
+//   argument set to id_. Returns a handle to cancel the timer with.
+// timer_handle_t add_timer(int timeout_, zmq::i_poll_events *sink_, int id_);
+//
+//   Cancel the timer identified by handle_, which must not have expired.
+// void cancel_timer(timer_handle_t handle_);
 //
-//   Cancel the timer created by sink_ object with ID equal to id_.
-// void cancel_timer(zmq::i_poll_events *sink_, int id_);
+//   Returns true if the timer identified by handle_ has not expired or
+//   been cancelled.
+// bool timer_pending(timer_handle_t handle_) const;
 //
 //   Adds a fd to the poller. Initially, no events are activated. These must
 //   be activated by the set_* methods using the returned handle_.
@@ -122,13 +125,17 @@ struct i_poll_events;
 class poller_base_t
 {
   public:
+    typedef timer_wheel_t::handle_t timer_handle_t;
+
     poller_base_t ();
     virtual ~poller_base_t ();
 
     // Methods from the poller concept.
     int get_load () const;
-    void add_timer (int timeout_, zmq::i_poll_events *sink_, int id_);
-    void cancel_timer (zmq::i_poll_events *sink_, int id_);
+    timer_handle_t
+    add_timer (int timeout_, zmq::i_poll_events *sink_, int id_);
+    void cancel_timer (timer_handle_t handle_);
+    bool timer_pending (timer_handle_t handle_) const;
 
   protected:
     //  Called by individual poller implementations to manage the load.
@@ -142,14 +149,8 @@ class poller_base_t
     //  Clock instance private to this I/O thread.
     clock_t clock;
 
-    //  List of active timers.
-    struct timer_info_t
-    {
-        zmq::i_poll_events *sink;
-        int id;
-    };
-    typedef std::multimap<uint64_t, timer_info_t> timers_t;
-    timers_t timers;
+    //  Active timers.
+    timer_wheel_t timers;
 
     //  Load of the poller. Currently the number of file descriptors
     //  registered.
@@ -179,6 +180,12 @@ class worker_poller_base_t : public poller_base_t
     //  leaf class.
     void stop_worker ();
 
+    //  Returns true if the poller is to check for events without blocking.
+    //  With busy polling enabled in the context, that is the case until no
+    //  events have arrived for the configured time. Idle tells whether the
+    //  previous check found no events.
+    bool busy_polling (bool idle_);
+
   private:
     //  Main worker thread routine.
     static void worker_routine (void *arg_);
@@ -188,6 +195,12 @@ class worker_poller_base_t : public poller_base_t
     // Reference to ZMQ context.
     const thread_ctx_t &ctx;
 
+    //  Busy polling interval in microseconds, 0 if disabled.
+    const uint64_t busy_poll;
+
+    //  Time the last events arrived at while busy polling.
+    uint64_t busy_poll_start;
+
     //  Handle of the physical thread doing the I/O work.
     thread_t worker;
 };
@@ -124,39 +124,46 @@ int forward (class zmq::socket_base_t *from_,
              class zmq::socket_base_t *capture_,
              zmq::msg_t &msg_)
 {
-    int more;
-    size_t moresz;
-    size_t complete_msg_size = 0;
-    while (true) {
-        int rc = from_->recv (&msg_, 0);
-        if (unlikely (rc < 0))
-            return -1;
+    //  Forward a burst of messages per poll, as long as more can be
+    //  forwarded without blocking, to amortise the cost of polling.
+    for (int i = 0; i < zmq::proxy_burst_size; i++) {
+        if (i > 0 && (!from_->has_in () || !to_->has_out ()))
+            break;
 
-        complete_msg_size += msg_.size ();
+        int more;
+        size_t moresz;
+        size_t complete_msg_size = 0;
+        while (true) {
+            int rc = from_->recv (&msg_, 0);
+            if (unlikely (rc < 0))
+                return -1;
 
-        moresz = sizeof more;
-        rc = from_->getsockopt (ZMQ_RCVMORE, &more, &moresz);
-        if (unlikely (rc < 0))
-            return -1;
+            complete_msg_size += msg_.size ();
 
-        //  Copy message to capture socket if any
-        rc = capture (capture_, msg_, more);
-        if (unlikely (rc < 0))
-            return -1;
+            moresz = sizeof more;
+            rc = from_->getsockopt (ZMQ_RCVMORE, &more, &moresz);
+            if (unlikely (rc < 0))
+                return -1;
 
-        rc = to_->send (&msg_, more ? ZMQ_SNDMORE : 0);
-        if (unlikely (rc < 0))
-            return -1;
+            //  Copy message to capture socket if any
+            rc = capture (capture_, msg_, more);
+            if (unlikely (rc < 0))
+                return -1;
 
-        if (more == 0)
-            break;
-    }
+            rc = to_->send (&msg_, more ? ZMQ_SNDMORE : 0);
+            if (unlikely (rc < 0))
+                return -1;
 
-    // A multipart message counts as 1 packet:
-    from_stats->msg_in++;
-    from_stats->bytes_in += complete_msg_size;
-    to_stats->msg_out++;
-    to_stats->bytes_out += complete_msg_size;
+            if (more == 0)
+                break;
+        }
+
+        // A multipart message counts as 1 packet:
+        from_stats->msg_in++;
+        from_stats->bytes_in += complete_msg_size;
+        to_stats->msg_out++;
+        to_stats->bytes_out += complete_msg_size;
+    }
 
     return 0;
 }
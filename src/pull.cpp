@@ -35,7 +35,8 @@
 #include "pipe.hpp"
 
 zmq::pull_t::pull_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
-    socket_base_t (parent_, tid_, sid_)
+    socket_base_t (parent_, tid_, sid_),
+    fq (options)
 {
     options.type = ZMQ_PULL;
 }
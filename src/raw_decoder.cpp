@@ -34,7 +34,9 @@
 #include "raw_decoder.hpp"
 #include "err.hpp"
 
-zmq::raw_decoder_t::raw_decoder_t (size_t bufsize_) : allocator (bufsize_, 1)
+zmq::raw_decoder_t::raw_decoder_t (size_t bufsize_,
+                                   const allocator_t &allocator_) :
+    allocator (bufsize_, 1, allocator_)
 {
     int rc = in_progress.init ();
     errno_assert (rc == 0);
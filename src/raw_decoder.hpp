@@ -43,7 +43,8 @@ namespace zmq
 class raw_decoder_t : public i_decoder
 {
   public:
-    raw_decoder_t (size_t bufsize_);
+    raw_decoder_t (size_t bufsize_,
+                   const allocator_t &allocator_ = allocator_t ());
     virtual ~raw_decoder_t ();
 
     //  i_decoder interface.
@@ -93,7 +93,8 @@ int zmq::req_t::xsend (msg_t *msg_)
             errno_assert (rc == 0);
             id.set_flags (msg_t::more);
 
-            rc = dealer_t::sendpipe (&id, &reply_pipe);
+            //  The peer is chosen by the request, not by its envelope.
+            rc = dealer_t::sendpipe (&id, &reply_pipe, msg_);
             if (rc != 0)
                 return -1;
         }
@@ -103,7 +104,7 @@ int zmq::req_t::xsend (msg_t *msg_)
         errno_assert (rc == 0);
         bottom.set_flags (msg_t::more);
 
-        rc = dealer_t::sendpipe (&bottom, &reply_pipe);
+        rc = dealer_t::sendpipe (&bottom, &reply_pipe, msg_);
         if (rc != 0)
             return -1;
         zmq_assert (reply_pipe);
@@ -38,6 +38,7 @@
 
 zmq::router_t::router_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_),
+    fq (options),
     prefetched (false),
     routing_id_sent (false),
     current_in (NULL),
@@ -63,8 +64,7 @@ zmq::router_t::router_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
 zmq::router_t::~router_t ()
 {
     zmq_assert (anonymous_pipes.empty ());
-    ;
-    zmq_assert (outpipes.empty ());
+    zmq_assert (outpipes.size () == 0);
     prefetched_id.close ();
     prefetched_msg.close ();
 }
@@ -160,9 +160,10 @@ void zmq::router_t::xpipe_terminated (pipe_t *pipe_)
     if (it != anonymous_pipes.end ())
         anonymous_pipes.erase (it);
     else {
-        outpipes_t::iterator iter = outpipes.find (pipe_->get_routing_id ());
-        zmq_assert (iter != outpipes.end ());
-        outpipes.erase (iter);
+        const blob_t &routing_id = pipe_->get_routing_id ();
+        const bool erased =
+          outpipes.erase (routing_id.data (), routing_id.size ());
+        zmq_assert (erased);
         fq.pipe_terminated (pipe_);
         pipe_->rollback ();
         if (pipe_ == current_out)
@@ -186,14 +187,11 @@ void zmq::router_t::xread_activated (pipe_t *pipe_)
 
 void zmq::router_t::xwrite_activated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zmq_assert (it != outpipes.end ());
-    zmq_assert (!it->second.active);
-    it->second.active = true;
+    const blob_t &routing_id = pipe_->get_routing_id ();
+    outpipe_t *outpipe = outpipes.find (routing_id.data (), routing_id.size ());
+    zmq_assert (outpipe && outpipe->pipe == pipe_);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
 }
 
 int zmq::router_t::xsend (msg_t *msg_)
@@ -212,21 +210,20 @@ int zmq::router_t::xsend (msg_t *msg_)
             //  Find the pipe associated with the routing id stored in the prefix.
             //  If there's no such pipe just silently ignore the message, unless
             //  router_mandatory is set.
-            blob_t routing_id ((unsigned char *) msg_->data (), msg_->size (),
-                               zmq::reference_tag_t ());
-            outpipes_t::iterator it = outpipes.find (routing_id);
+            outpipe_t *outpipe = outpipes.find (
+              (unsigned char *) msg_->data (), msg_->size ());
 
-            if (it != outpipes.end ()) {
-                current_out = it->second.pipe;
+            if (outpipe) {
+                current_out = outpipe->pipe;
 
                 // Check whether pipe is closed or not
                 if (!current_out->check_write ()) {
                     // Check whether pipe is full or not
                     bool pipe_full = !current_out->check_hwm ();
-                    it->second.active = false;
-                    current_out = NULL;
+                    outpipe->active = false;
 
                     if (mandatory) {
+                        current_out = NULL;
                         more_out = false;
                         if (pipe_full)
                             errno = EAGAIN;
@@ -234,6 +231,8 @@ int zmq::router_t::xsend (msg_t *msg_)
                             errno = EHOSTUNREACH;
                         return -1;
                     }
+                    current_out->count_dropped ();
+                    current_out = NULL;
                 }
             } else if (mandatory) {
                 more_out = false;
@@ -430,9 +429,9 @@ bool zmq::router_t::xhas_out ()
         return true;
 
     bool has_out = false;
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
-        has_out |= it->second.pipe->check_hwm ();
+    for (size_t i = 0; i != outpipes.capacity (); i++)
+        if (outpipes.key (i))
+            has_out |= outpipes.value (i).pipe->check_hwm ();
 
     return has_out;
 }
@@ -447,15 +446,14 @@ int zmq::router_t::get_peer_state (const void *routing_id_,
 {
     int res = 0;
 
-    blob_t routing_id_blob ((unsigned char *) routing_id_, routing_id_size_);
-    outpipes_t::const_iterator it = outpipes.find (routing_id_blob);
-    if (it == outpipes.end ()) {
+    const outpipe_t *outpipe =
+      outpipes.find ((const unsigned char *) routing_id_, routing_id_size_);
+    if (!outpipe) {
         errno = EHOSTUNREACH;
         return -1;
     }
 
-    const outpipe_t &outpipe = it->second;
-    if (outpipe.pipe->check_hwm ())
+    if (outpipe->pipe->check_hwm ())
         res |= ZMQ_POLLOUT;
 
     /** \todo does it make any sense to check the inpipe as well? */
@@ -473,9 +471,8 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_)
         routing_id.set ((unsigned char *) connect_routing_id.c_str (),
                         connect_routing_id.length ());
         connect_routing_id.clear ();
-        outpipes_t::iterator it = outpipes.find (routing_id);
-        if (it != outpipes.end ())
-            zmq_assert (false); //  Not allowed to duplicate an existing rid
+        //  Not allowed to duplicate an existing rid
+        zmq_assert (!outpipes.find (routing_id.data (), routing_id.size ()));
     } else if (
       options
         .raw_socket) { //  Always assign an integral routing id for raw-socket
@@ -499,10 +496,11 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_)
             msg.close ();
         } else {
             routing_id.set ((unsigned char *) msg.data (), msg.size ());
-            outpipes_t::iterator it = outpipes.find (routing_id);
             msg.close ();
+            outpipe_t *outpipe =
+              outpipes.find (routing_id.data (), routing_id.size ());
 
-            if (it != outpipes.end ()) {
+            if (outpipe) {
                 if (!handover)
                     //  Ignore peers with duplicate ID
                     return false;
@@ -515,20 +513,18 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_)
                     put_uint32 (buf + 1, next_integral_routing_id++);
                     blob_t new_routing_id (buf, sizeof buf);
 
-                    it->second.pipe->set_router_socket_routing_id (
+                    const outpipe_t existing_outpipe = *outpipe;
+                    existing_outpipe.pipe->set_router_socket_routing_id (
                       new_routing_id);
-                    outpipe_t existing_outpipe = {it->second.pipe,
-                                                  it->second.active};
-
-                    ok = outpipes
-                           .ZMQ_MAP_INSERT_OR_EMPLACE (
-                             ZMQ_MOVE (new_routing_id), existing_outpipe)
-                           .second;
-                    zmq_assert (ok);
+                    outpipes.insert (new_routing_id.data (),
+                                     new_routing_id.size ()) =
+                      existing_outpipe;
 
                     //  Remove the existing routing id entry to allow the new
                     //  connection to take the routing id.
-                    outpipes.erase (it);
+                    ok =
+                      outpipes.erase (routing_id.data (), routing_id.size ());
+                    zmq_assert (ok);
 
                     if (existing_outpipe.pipe == current_in)
                         terminate_current_in = true;
@@ -541,10 +537,11 @@ bool zmq::router_t::identify_peer (pipe_t *pipe_)
 
     pipe_->set_router_socket_routing_id (routing_id);
     //  Add the record into output pipes lookup table
-    outpipe_t outpipe = {pipe_, true};
-    ok = outpipes.ZMQ_MAP_INSERT_OR_EMPLACE (ZMQ_MOVE (routing_id), outpipe)
-           .second;
-    zmq_assert (ok);
+    outpipe_t &outpipe =
+      outpipes.insert (routing_id.data (), routing_id.size ());
+    zmq_assert (!outpipe.pipe);
+    outpipe.pipe = pipe_;
+    outpipe.active = true;
 
     return true;
 }
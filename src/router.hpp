@@ -38,6 +38,7 @@
 #include "blob.hpp"
 #include "msg.hpp"
 #include "fq.hpp"
+#include "topic_table.hpp"
 
 namespace zmq
 {
@@ -106,8 +107,9 @@ class router_t : public socket_base_t
     //  We keep a set of pipes that have not been identified yet.
     std::set<pipe_t *> anonymous_pipes;
 
-    //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<blob_t, outpipe_t> outpipes_t;
+    //  Outbound pipes indexed by the peer IDs. Routing a message costs
+    //  a single hash lookup, whatever the number of peers is.
+    typedef topic_table_t<outpipe_t> outpipes_t;
     outpipes_t outpipes;
 
     //  The pipe we are currently writing to.
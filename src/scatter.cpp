@@ -35,7 +35,8 @@
 #include "msg.hpp"
 
 zmq::scatter_t::scatter_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
-    socket_base_t (parent_, tid_, sid_, true)
+    socket_base_t (parent_, tid_, sid_, true),
+    lb (options)
 {
     options.type = ZMQ_SCATTER;
 }
@@ -38,14 +38,19 @@
 
 zmq::server_t::server_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_, true),
-    next_routing_id (generate_random ())
+    fq (options),
+    free_head (no_slot),
+    free_tail (no_slot),
+    retired_head (no_slot),
+    retired_tail (no_slot)
 {
     options.type = ZMQ_SERVER;
 }
 
 zmq::server_t::~server_t ()
 {
-    zmq_assert (outpipes.empty ());
+    for (outpipes_t::size_type i = 0; i != outpipes.size (); i++)
+        zmq_assert (!outpipes[i].pipe);
 }
 
 void zmq::server_t::xattach_pipe (pipe_t *pipe_, bool subscribe_to_all_)
@@ -54,43 +59,101 @@ void zmq::server_t::xattach_pipe (pipe_t *pipe_, bool subscribe_to_all_)
 
     zmq_assert (pipe_);
 
-    uint32_t routing_id = next_routing_id++;
-    if (!routing_id)
-        routing_id = next_routing_id++; //  Never use Routing ID zero
+    //  Take the oldest free slot, a new one or the oldest retired one,
+    //  in this order.
+    uint32_t index = pop_slot (free_head, free_tail);
+    if (index == no_slot && outpipes.size () < max_slots) {
+        index = (uint32_t) outpipes.size ();
+
+        //  Start from a random generation so that the IDs are not
+        //  the same for every socket. Never use Routing ID zero.
+        uint32_t generation = generate_random () & generation_mask;
+        if (!generation)
+            generation = 1;
+        outpipe_t outpipe = {NULL, false, generation, generation, no_slot};
+        outpipes.push_back (outpipe);
+    }
+    if (index == no_slot)
+        index = pop_slot (retired_head, retired_tail);
+    if (index == no_slot) {
+        //  All the routing IDs are in use, refuse the peer.
+        pipe_->terminate (false);
+        return;
+    }
 
-    pipe_->set_server_socket_routing_id (routing_id);
-    //  Add the record into output pipes lookup table
-    outpipe_t outpipe = {pipe_, true};
-    bool ok = outpipes.ZMQ_MAP_INSERT_OR_EMPLACE (routing_id, outpipe).second;
-    zmq_assert (ok);
+    outpipe_t &outpipe = outpipes[index];
+    outpipe.pipe = pipe_;
+    outpipe.active = true;
+    pipe_->set_server_socket_routing_id (outpipe.generation << index_bits
+                                         | index);
 
     fq.attach (pipe_);
 }
 
 void zmq::server_t::xpipe_terminated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it =
-      outpipes.find (pipe_->get_server_socket_routing_id ());
-    zmq_assert (it != outpipes.end ());
-    outpipes.erase (it);
+    //  Peers refused by xattach_pipe have no routing ID and are not
+    //  known to the fair queue.
+    const uint32_t routing_id = pipe_->get_server_socket_routing_id ();
+    if (!routing_id)
+        return;
+
+    outpipe_t *outpipe = find_outpipe (routing_id);
+    zmq_assert (outpipe && outpipe->pipe == pipe_);
+    outpipe->pipe = NULL;
+    outpipe->generation = (outpipe->generation + 1) & generation_mask;
+    if (!outpipe->generation)
+        outpipe->generation = 1;
+
+    //  Queue the slot for reuse, unless all of its generations were used.
+    const uint32_t index = routing_id & (max_slots - 1);
+    if (outpipe->generation != outpipe->first_generation)
+        push_slot (free_head, free_tail, index);
+    else
+        push_slot (retired_head, retired_tail, index);
+
     fq.pipe_terminated (pipe_);
 }
 
+void zmq::server_t::push_slot (uint32_t &head_,
+                               uint32_t &tail_,
+                               uint32_t index_)
+{
+    outpipes[index_].next_free = no_slot;
+    if (tail_ != no_slot)
+        outpipes[tail_].next_free = index_;
+    else
+        head_ = index_;
+    tail_ = index_;
+}
+
+uint32_t zmq::server_t::pop_slot (uint32_t &head_, uint32_t &tail_)
+{
+    const uint32_t index = head_;
+    if (index != no_slot) {
+        head_ = outpipes[index].next_free;
+        if (head_ == no_slot)
+            tail_ = no_slot;
+    }
+    return index;
+}
+
 void zmq::server_t::xread_activated (pipe_t *pipe_)
 {
-    fq.activated (pipe_);
+    if (pipe_->get_server_socket_routing_id ())
+        fq.activated (pipe_);
 }
 
 void zmq::server_t::xwrite_activated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zmq_assert (it != outpipes.end ());
-    zmq_assert (!it->second.active);
-    it->second.active = true;
+    const uint32_t routing_id = pipe_->get_server_socket_routing_id ();
+    if (!routing_id)
+        return;
+
+    outpipe_t *outpipe = find_outpipe (routing_id);
+    zmq_assert (outpipe && outpipe->pipe == pipe_);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
 }
 
 int zmq::server_t::xsend (msg_t *msg_)
@@ -101,12 +164,11 @@ int zmq::server_t::xsend (msg_t *msg_)
         return -1;
     }
     //  Find the pipe associated with the routing stored in the message.
-    uint32_t routing_id = msg_->get_routing_id ();
-    outpipes_t::iterator it = outpipes.find (routing_id);
+    outpipe_t *outpipe = find_outpipe (msg_->get_routing_id ());
 
-    if (it != outpipes.end ()) {
-        if (!it->second.pipe->check_write ()) {
-            it->second.active = false;
+    if (outpipe) {
+        if (!outpipe->pipe->check_write ()) {
+            outpipe->active = false;
             errno = EAGAIN;
             return -1;
         }
@@ -119,13 +181,13 @@ int zmq::server_t::xsend (msg_t *msg_)
     int rc = msg_->reset_routing_id ();
     errno_assert (rc == 0);
 
-    bool ok = it->second.pipe->write (msg_);
+    bool ok = outpipe->pipe->write (msg_);
     if (unlikely (!ok)) {
         // Message failed to send - we must close it ourselves.
         rc = msg_->close ();
         errno_assert (rc == 0);
     } else
-        it->second.pipe->flush ();
+        outpipe->pipe->flush ();
 
     //  Detach the message from the data buffer.
     rc = msg_->init ();
@@ -180,3 +242,14 @@ const zmq::blob_t &zmq::server_t::get_credential () const
 {
     return fq.get_credential ();
 }
+
+zmq::server_t::outpipe_t *zmq::server_t::find_outpipe (uint32_t routing_id_)
+{
+    const uint32_t index = routing_id_ & (max_slots - 1);
+    if (index >= outpipes.size ())
+        return NULL;
+    outpipe_t &outpipe = outpipes[index];
+    if (!outpipe.pipe || outpipe.generation != routing_id_ >> index_bits)
+        return NULL;
+    return &outpipe;
+}
@@ -30,7 +30,7 @@
 #ifndef __ZMQ_SERVER_HPP_INCLUDED__
 #define __ZMQ_SERVER_HPP_INCLUDED__
 
-#include <map>
+#include <vector>
 
 #include "socket_base.hpp"
 #include "session_base.hpp"
@@ -68,19 +68,57 @@ class server_t : public socket_base_t
     //  Fair queueing object for inbound pipes.
     fq_t fq;
 
+    //  Routing IDs are generated. The low bits of an ID are the index of
+    //  the slot of the peer, the high bits are the generation of the slot,
+    //  which changes every time the slot is reused so that the ID of a
+    //  disconnected peer does not route messages to its successor. Once
+    //  a slot went through all of its generations, it is retired. Retired
+    //  slots are reused only when no new slot can be added, so an ID comes
+    //  back only once all the max_slots slots were created.
+    enum
+    {
+        index_bits = 20,
+        max_slots = 1 << index_bits,
+        generation_mask = (1 << (32 - index_bits)) - 1,
+        no_slot = max_slots
+    };
+
     struct outpipe_t
     {
         zmq::pipe_t *pipe;
         bool active;
+        uint32_t generation;
+
+        //  Generation the slot started with.
+        uint32_t first_generation;
+
+        //  Next slot in the queue of free or retired slots, if this one
+        //  is in either of them.
+        uint32_t next_free;
     };
 
+    //  Appends the slot to the queue, or removes its oldest slot. Returns
+    //  no_slot if the queue is empty.
+    void push_slot (uint32_t &head_, uint32_t &tail_, uint32_t index_);
+    uint32_t pop_slot (uint32_t &head_, uint32_t &tail_);
+
+    //  Returns the slot of the peer with the routing ID, NULL if there
+    //  is no such peer.
+    outpipe_t *find_outpipe (uint32_t routing_id_);
+
     //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<uint32_t, outpipe_t> outpipes_t;
+    typedef std::vector<outpipe_t> outpipes_t;
     outpipes_t outpipes;
 
-    //  Routing IDs are generated. It's a simple increment and wrap-over
-    //  algorithm. This value is the next ID to use (if not used already).
-    uint32_t next_routing_id;
+    //  Queue of the free slots. Reusing the slot that has been free for the
+    //  longest time postpones the reuse of the IDs as much as possible.
+    uint32_t free_head;
+    uint32_t free_tail;
+
+    //  Queue of the slots which went through all of their generations.
+    //  They are reused only once no new slot can be added.
+    uint32_t retired_head;
+    uint32_t retired_tail;
 
     server_t (const server_t &);
     const server_t &operator= (const server_t &);
@@ -347,7 +347,7 @@ int zmq::session_base_t::zap_connect ()
     object_t *parents[2] = {this, peer.socket};
     pipe_t *new_pipes[2] = {NULL, NULL};
     int hwms[2] = {0, 0};
-    bool conflates[2] = {false, false};
+    conflate_t conflates[2] = {conflate_none, conflate_none};
     int rc = pipepair (parents, new_pipes, hwms, conflates);
     errno_assert (rc == 0);
 
@@ -392,9 +392,17 @@ void zmq::session_base_t::process_attach (i_engine *engine_)
               || options.type == ZMQ_PUSH || options.type == ZMQ_PUB
               || options.type == ZMQ_SUB);
 
+        //  Only the messages received by the socket are conflated by topic.
+        bool conflate_topics =
+          !conflate && options.conflate_topics
+          && (options.type == ZMQ_SUB || options.type == ZMQ_XSUB);
+
         int hwms[2] = {conflate ? -1 : options.rcvhwm,
                        conflate ? -1 : options.sndhwm};
-        bool conflates[2] = {conflate, conflate};
+        conflate_t conflates[2] = {
+          conflate ? conflate_last : conflate_none,
+          conflate ? conflate_last
+                   : conflate_topics ? conflate_by_topic : conflate_none};
         int rc = pipepair (parents, pipes, hwms, conflates);
         errno_assert (rc == 0);
 
@@ -406,6 +414,8 @@ void zmq::session_base_t::process_attach (i_engine *engine_)
         pipe = pipes[0];
 
         //  Ask socket to plug into the remote end of the pipe.
+        if (active)
+            pipes[1]->set_endpoint (addr->protocol + "://" + addr->address);
         send_bind (socket, pipes[1]);
     }
 
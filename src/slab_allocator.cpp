@@ -0,0 +1,323 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "slab_allocator.hpp"
+
+#include <stdlib.h>
+#include <new>
+
+#include "atomic_counter.hpp"
+#include "atomic_ptr.hpp"
+#include "config.hpp"
+#include "err.hpp"
+#include "likely.hpp"
+
+#if !defined ZMQ_HAVE_WINDOWS
+#include <pthread.h>
+#endif
+
+namespace zmq
+{
+struct slab_cache_t;
+
+//  Header preceding each block of memory.
+struct slab_block_t
+{
+    //  Cache the block belongs to, NULL if allocated from the heap.
+    slab_cache_t *cache;
+
+    union
+    {
+        //  Size class of the block while it is in use.
+        size_t size_class;
+        //  Next block while it is in one of the free lists.
+        slab_block_t *next;
+    };
+};
+
+//  Blocks, including their header, are 2^min_class_shift bytes in the
+//  smallest size class and twice as big in each of the next ones.
+enum
+{
+    min_class_shift = 7,
+    max_class_shift = 13,
+    class_count = max_class_shift - min_class_shift + 1
+};
+
+struct slab_class_t
+{
+    //  Free blocks, only accessed by the owner of the cache.
+    slab_block_t *free;
+    int free_count;
+
+    //  Blocks freed by other threads.
+    atomic_ptr_t<slab_block_t> remote;
+};
+
+struct slab_cache_t
+{
+    slab_class_t classes[class_count];
+
+    //  Number of blocks allocated from the heap and not released yet,
+    //  plus one while the owning thread is alive.
+    atomic_counter_t refs;
+};
+
+//  Header preceding the header of each block allocated from an allocator
+//  set by the user.
+struct slab_custom_block_t
+{
+    allocator_t allocator;
+    size_t size;
+};
+
+//  Number of contexts that enabled the allocator.
+static atomic_counter_t enabled;
+
+//  Marks the list of remotely freed blocks of a cache whose thread exited.
+static slab_block_t orphaned;
+
+//  Marks the blocks allocated from an allocator set by the user.
+static slab_cache_t custom;
+
+static void release_block (slab_block_t *block_)
+{
+    slab_cache_t *cache = block_->cache;
+    free (block_);
+    if (!cache->refs.sub (1))
+        delete cache;
+}
+
+#if !defined ZMQ_HAVE_WINDOWS
+static pthread_once_t key_once = PTHREAD_ONCE_INIT;
+static pthread_key_t key;
+
+//  Called when a thread that owns a cache exits.
+static void release_cache (void *cache_)
+{
+    slab_cache_t *cache = static_cast<slab_cache_t *> (cache_);
+    for (int i = 0; i != class_count; i++) {
+        slab_class_t &size_class = cache->classes[i];
+        slab_block_t *block = size_class.free;
+        while (block) {
+            slab_block_t *next = block->next;
+            release_block (block);
+            block = next;
+        }
+
+        //  From now on, other threads release the blocks they free.
+        block = size_class.remote.xchg (&orphaned);
+        while (block) {
+            slab_block_t *next = block->next;
+            release_block (block);
+            block = next;
+        }
+    }
+
+    if (!cache->refs.sub (1))
+        delete cache;
+}
+
+static void create_key ()
+{
+    const int rc = pthread_key_create (&key, release_cache);
+    posix_assert (rc);
+}
+
+static slab_cache_t *get_cache (bool create_)
+{
+    int rc = pthread_once (&key_once, create_key);
+    posix_assert (rc);
+
+    slab_cache_t *cache =
+      static_cast<slab_cache_t *> (pthread_getspecific (key));
+    if (unlikely (!cache && create_)) {
+        cache = new (std::nothrow) slab_cache_t;
+        alloc_assert (cache);
+        for (int i = 0; i != class_count; i++) {
+            cache->classes[i].free = NULL;
+            cache->classes[i].free_count = 0;
+        }
+        cache->refs.set (1);
+        rc = pthread_setspecific (key, cache);
+        posix_assert (rc);
+    }
+    return cache;
+}
+#else
+//  Thread exit can not be hooked into, so threads do not have caches.
+static slab_cache_t *get_cache (bool)
+{
+    return NULL;
+}
+#endif
+
+//  Returns the size class of blocks of the given size, or -1 if too big.
+static int size_class_of (size_t size_)
+{
+    for (int i = 0; i != class_count; i++)
+        if (size_ <= (size_t) 1 << (min_class_shift + i))
+            return i;
+    return -1;
+}
+
+//  Maximal number of free blocks kept in the given size class.
+static int max_free (int size_class_)
+{
+    return slab_cache_size >> (min_class_shift + size_class_);
+}
+}
+
+void zmq::slab_enable ()
+{
+    enabled.add (1);
+}
+
+void zmq::slab_disable ()
+{
+    enabled.sub (1);
+}
+
+void *zmq::slab_alloc (size_t size_, const allocator_t *allocator_)
+{
+    if (unlikely (size_ > SIZE_MAX - sizeof (slab_block_t)))
+        return NULL;
+
+    if (allocator_ && !allocator_->is_default ()) {
+        const size_t header_size =
+          sizeof (slab_custom_block_t) + sizeof (slab_block_t);
+        if (unlikely (size_ > SIZE_MAX - header_size))
+            return NULL;
+        slab_custom_block_t *custom_block =
+          static_cast<slab_custom_block_t *> (
+            allocator_->allocate (header_size + size_));
+        if (unlikely (!custom_block))
+            return NULL;
+        new (&custom_block->allocator) allocator_t (*allocator_);
+        custom_block->size = header_size + size_;
+        slab_block_t *block =
+          reinterpret_cast<slab_block_t *> (custom_block + 1);
+        block->cache = &custom;
+        return block + 1;
+    }
+
+    const int size_class =
+      enabled.get () ? size_class_of (size_ + sizeof (slab_block_t)) : -1;
+    slab_cache_t *cache = size_class >= 0 ? get_cache (true) : NULL;
+    if (!cache) {
+        slab_block_t *block = static_cast<slab_block_t *> (
+          malloc (sizeof (slab_block_t) + size_));
+        if (unlikely (!block))
+            return NULL;
+        block->cache = NULL;
+        return block + 1;
+    }
+
+    slab_class_t &free_list = cache->classes[size_class];
+    if (!free_list.free) {
+        //  Take over the blocks freed by other threads, keeping no more
+        //  than the cache would keep if they were freed locally.
+        slab_block_t *block = free_list.remote.xchg (NULL);
+        const int limit = max_free (size_class);
+        while (block) {
+            slab_block_t *next = block->next;
+            if (free_list.free_count < limit) {
+                block->next = free_list.free;
+                free_list.free = block;
+                free_list.free_count++;
+            } else
+                release_block (block);
+            block = next;
+        }
+    }
+
+    slab_block_t *block = free_list.free;
+    if (block) {
+        free_list.free = block->next;
+        free_list.free_count--;
+    } else {
+        block = static_cast<slab_block_t *> (
+          malloc ((size_t) 1 << (min_class_shift + size_class)));
+        if (unlikely (!block))
+            return NULL;
+        block->cache = cache;
+        cache->refs.add (1);
+    }
+    block->size_class = size_class;
+    return block + 1;
+}
+
+void zmq::slab_free (void *ptr_)
+{
+    if (!ptr_)
+        return;
+
+    slab_block_t *block = static_cast<slab_block_t *> (ptr_) - 1;
+    slab_cache_t *cache = block->cache;
+    if (!cache) {
+        free (block);
+        return;
+    }
+    if (cache == &custom) {
+        slab_custom_block_t *custom_block =
+          reinterpret_cast<slab_custom_block_t *> (block) - 1;
+        const allocator_t allocator = custom_block->allocator;
+        allocator.deallocate (custom_block, custom_block->size);
+        return;
+    }
+
+    const int size_class = static_cast<int> (block->size_class);
+    slab_class_t &free_list = cache->classes[size_class];
+
+    if (cache == get_cache (false)) {
+        if (free_list.free_count < max_free (size_class)) {
+            block->next = free_list.free;
+            free_list.free = block;
+            free_list.free_count++;
+        } else
+            release_block (block);
+        return;
+    }
+
+    //  Push the block onto the list of blocks freed by other threads,
+    //  unless the thread owning the cache has exited already.
+    slab_block_t *head = NULL;
+    while (true) {
+        block->next = head;
+        slab_block_t *prev = free_list.remote.cas (head, block);
+        if (prev == head)
+            return;
+        if (prev == &orphaned) {
+            release_block (block);
+            return;
+        }
+        head = prev;
+    }
+}
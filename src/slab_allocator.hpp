@@ -0,0 +1,63 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_SLAB_ALLOCATOR_HPP_INCLUDED__
+#define __ZMQ_SLAB_ALLOCATOR_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "allocator.hpp"
+
+namespace zmq
+{
+//  Size-class slab allocator for the content of the messages too large
+//  to be stored in the message itself. Each thread allocates from a cache
+//  of its own without synchronisation. Blocks freed by other threads are
+//  pushed onto a lock-free list of the cache they come from, and its
+//  thread picks them up when it runs out of blocks of that size.
+//  When a thread exits, the free blocks of its cache are released, and
+//  the blocks still in use are released as soon as they are freed.
+
+//  Enables the slab allocator. Calls are refcounted, so that it stays
+//  enabled while any of the contexts that asked for it is alive.
+void slab_enable ();
+void slab_disable ();
+
+//  Allocates size_ bytes. Memory comes from the given allocator if it is
+//  not the default one, from the calling thread's cache if the slab
+//  allocator is enabled and the size fits in a size class, and from the
+//  heap otherwise. Returns NULL if out of memory.
+void *slab_alloc (size_t size_, const allocator_t *allocator_ = NULL);
+
+//  Frees memory returned by slab_alloc. Can be called from any thread,
+//  whether the allocator is still enabled or not.
+void slab_free (void *ptr_);
+}
+
+#endif
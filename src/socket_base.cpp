@@ -195,6 +195,7 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_,
     last_tsc (0),
     ticks (0),
     rcvmore (false),
+    counters_publish_time (0),
     monitor_socket (NULL),
     monitor_events (0),
     thread_safe (thread_safe_),
@@ -206,12 +207,15 @@ zmq::socket_base_t::socket_base_t (ctx_t *parent_,
     options.ipv6 = (parent_->get (ZMQ_IPV6) != 0);
     options.linger.store (parent_->get (ZMQ_BLOCKY) ? -1 : 0);
     options.zero_copy = parent_->get (ZMQ_ZERO_COPY_RECV);
+    options.allocator = parent_->get_allocator ();
+    memset (&counters, 0, sizeof counters);
 
     if (thread_safe) {
         mailbox = new (std::nothrow) mailbox_safe_t (&sync);
         zmq_assert (mailbox);
     } else {
-        mailbox_t *m = new (std::nothrow) mailbox_t ();
+        mailbox_t *m =
+          new (std::nothrow) mailbox_t (parent_->get (ZMQ_BUSY_POLL));
         zmq_assert (m);
 
         if (m->get_fd () != retired_fd)
@@ -340,6 +344,7 @@ void zmq::socket_base_t::attach_pipe (pipe_t *pipe_, bool subscribe_to_all_)
 {
     //  First, register the pipe so that we can terminate it later on.
     pipe_->set_event_sink (this);
+    pipe_->set_flush_batch (&flush_batch);
     pipes.push_back (pipe_);
 
     //  Let the derived socket type know about new pipe.
@@ -429,6 +434,16 @@ int zmq::socket_base_t::getsockopt (int option_,
         return do_getsockopt<int> (optval_, optvallen_, thread_safe ? 1 : 0);
     }
 
+    if (option_ == ZMQ_COUNTERS) {
+        zmq_counters_t snapshot;
+        get_counters (&snapshot);
+        return do_getsockopt<zmq_counters_t> (optval_, optvallen_, snapshot);
+    }
+
+    if (option_ == ZMQ_PIPE_COUNTERS) {
+        return get_pipe_counters (optval_, optvallen_);
+    }
+
     return options.getsockopt (option_, optval_, optvallen_);
 }
 
@@ -546,7 +561,7 @@ int zmq::socket_base_t::bind (const char *addr_)
         pipe_t *new_pipes[2] = {NULL, NULL};
 
         int hwms[2] = {options.sndhwm, options.rcvhwm};
-        bool conflates[2] = {false, false};
+        conflate_t conflates[2] = {conflate_none, conflate_none};
         rc = pipepair (parents, new_pipes, hwms, conflates);
         errno_assert (rc == 0);
 
@@ -589,6 +604,42 @@ int zmq::socket_base_t::bind (const char *addr_)
 
         add_endpoint (last_endpoint.c_str (), (own_t *) listener, NULL);
         options.connected = true;
+
+        //  Bind the additional listeners to the very same address, so that
+        //  the kernel spreads the incoming connections among them. They
+        //  are run by the eligible I/O threads in turn.
+        if (options.tcp_listeners > 1 && options.use_fd == -1) {
+            std::vector<uint64_t> threads;
+            const int io_threads = get_ctx ()->get (ZMQ_IO_THREADS);
+            for (int i = 0; i != io_threads && i != 64; i++)
+                if (!options.affinity
+                    || (options.affinity & (uint64_t (1) << i)))
+                    threads.push_back (uint64_t (1) << i);
+            if (threads.empty ())
+                threads.push_back (options.affinity);
+            const std::string bound_address =
+              last_endpoint.substr (protocol.length () + 3);
+
+            for (int i = 1; i < options.tcp_listeners; i++) {
+                io_thread = choose_io_thread (threads[i % threads.size ()]);
+                if (!io_thread)
+                    io_thread = choose_io_thread (options.affinity);
+                listener =
+                  new (std::nothrow) tcp_listener_t (io_thread, this, options);
+                alloc_assert (listener);
+                rc = listener->set_address (bound_address.c_str ());
+                if (rc != 0) {
+                    const int err = zmq_errno ();
+                    LIBZMQ_DELETE (listener);
+                    event_bind_failed (address, err);
+                    term_endpoint (last_endpoint.c_str ());
+                    errno = err;
+                    return -1;
+                }
+                add_endpoint (last_endpoint.c_str (), (own_t *) listener,
+                              NULL);
+            }
+        }
         return 0;
     }
 
@@ -710,8 +761,16 @@ int zmq::socket_base_t::connect (const char *addr_)
               || options.type == ZMQ_PUSH || options.type == ZMQ_PUB
               || options.type == ZMQ_SUB);
 
+        //  Only the messages received by the socket are conflated by topic.
+        bool conflate_topics =
+          !conflate && options.conflate_topics
+          && (options.type == ZMQ_SUB || options.type == ZMQ_XSUB);
+
         int hwms[2] = {conflate ? -1 : sndhwm, conflate ? -1 : rcvhwm};
-        bool conflates[2] = {conflate, conflate};
+        conflate_t conflates[2] = {
+          conflate ? conflate_last
+                   : conflate_topics ? conflate_by_topic : conflate_none,
+          conflate ? conflate_last : conflate_none};
         rc = pipepair (parents, new_pipes, hwms, conflates);
         if (!conflate) {
             new_pipes[0]->set_hwms_boost (peer.options.sndhwm,
@@ -771,6 +830,7 @@ int zmq::socket_base_t::connect (const char *addr_)
         }
 
         //  Attach local end of the pipe to this socket object.
+        new_pipes[0]->set_endpoint (addr_);
         attach_pipe (new_pipes[0]);
 
         // Save last endpoint URI
@@ -948,13 +1008,22 @@ int zmq::socket_base_t::connect (const char *addr_)
               || options.type == ZMQ_PUSH || options.type == ZMQ_PUB
               || options.type == ZMQ_SUB);
 
+        //  Only the messages received by the socket are conflated by topic.
+        bool conflate_topics =
+          !conflate && options.conflate_topics
+          && (options.type == ZMQ_SUB || options.type == ZMQ_XSUB);
+
         int hwms[2] = {conflate ? -1 : options.sndhwm,
                        conflate ? -1 : options.rcvhwm};
-        bool conflates[2] = {conflate, conflate};
+        conflate_t conflates[2] = {
+          conflate ? conflate_last
+                   : conflate_topics ? conflate_by_topic : conflate_none,
+          conflate ? conflate_last : conflate_none};
         rc = pipepair (parents, new_pipes, hwms, conflates);
         errno_assert (rc == 0);
 
         //  Attach local end of the pipe to the socket object.
+        new_pipes[0]->set_endpoint (addr_);
         attach_pipe (new_pipes[0], subscribe_to_all);
         newpipe = new_pipes[0];
 
@@ -1105,9 +1174,14 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
 
     msg_->reset_metadata ();
 
+    //  xsend takes the content over, so remember what is being sent.
+    const size_t msg_size = msg_->size ();
+    const bool msg_more = (flags_ & ZMQ_SNDMORE) != 0;
+
     //  Try to send the message using method in each socket class
     rc = xsend (msg_);
     if (rc == 0) {
+        count_sent (msg_size, msg_more);
         return 0;
     }
     if (unlikely (errno != EAGAIN)) {
@@ -1147,6 +1221,7 @@ int zmq::socket_base_t::send (msg_t *msg_, int flags_)
         }
     }
 
+    count_sent (msg_size, msg_more);
     return 0;
 }
 
@@ -1246,6 +1321,108 @@ int zmq::socket_base_t::recv (msg_t *msg_, int flags_)
     return 0;
 }
 
+int zmq::socket_base_t::send_batch (msg_t *msgs_, size_t count_, int flags_)
+{
+    scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+
+    //  Check whether the library haven't been shut down yet.
+    if (unlikely (ctx_terminated)) {
+        errno = ETERM;
+        return -1;
+    }
+
+    if (unlikely (!msgs_ || count_ == 0)) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    //  Process pending commands once for the whole batch.
+    int rc = process_commands (0, true);
+    if (unlikely (rc != 0)) {
+        return -1;
+    }
+
+    //  Messages are written to the pipes one by one, but the pipes are
+    //  flushed only once the batch is done.
+    flush_batch.open ();
+
+    size_t sent = 0;
+    for (; sent != count_; sent++) {
+        msg_t *msg = &msgs_[sent];
+        if (unlikely (!msg->check ())) {
+            errno = EFAULT;
+            break;
+        }
+
+        //  If ZMQ_SNDMORE is set, the batch is a single multi-part message.
+        const int msg_flags =
+          sent != count_ - 1 ? flags_ : flags_ & ~ZMQ_SNDMORE;
+
+        msg->reset_flags (msg_t::more);
+        if (msg_flags & ZMQ_SNDMORE)
+            msg->set_flags (msg_t::more);
+        msg->reset_metadata ();
+
+        const size_t msg_size = msg->size ();
+        rc = xsend (msg);
+        if (rc == 0) {
+            count_sent (msg_size, (msg_flags & ZMQ_SNDMORE) != 0);
+            continue;
+        }
+        if (unlikely (errno != EAGAIN))
+            break;
+        if ((flags_ & ZMQ_DONTWAIT) || options.sndtimeo == 0)
+            break;
+
+        //  Blocking scenario. Flush what we have, so that the peers can
+        //  make progress, and fall back to the regular send, which waits
+        //  for the pipes to become writable and processes the commands.
+        flush_batch.close ();
+        rc = send (msg, msg_flags);
+        flush_batch.open ();
+        if (rc != 0)
+            break;
+    }
+
+    const int err = errno;
+    flush_batch.close ();
+
+    if (sent == 0) {
+        errno = err;
+        return -1;
+    }
+    return (int) sent;
+}
+
+int zmq::socket_base_t::recv_batch (msg_t *msgs_, size_t count_, int flags_)
+{
+    scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
+
+    if (unlikely (!msgs_ || count_ == 0)) {
+        errno = EFAULT;
+        return -1;
+    }
+
+    //  The first message is received the regular way, including
+    //  blocking and command processing if needed.
+    int rc = recv (&msgs_[0], flags_);
+    if (rc != 0)
+        return -1;
+
+    //  Drain the messages that are already available without going
+    //  through the command processing again.
+    size_t received = 1;
+    for (; received != count_; received++) {
+        msg_t *msg = &msgs_[received];
+        if (unlikely (!msg->check ()))
+            break;
+        if (xrecv (msg) != 0)
+            break;
+        extract_flags (msg);
+    }
+    return (int) received;
+}
+
 int zmq::socket_base_t::close ()
 {
     scoped_optional_lock_t sync_lock (thread_safe ? &sync : NULL);
@@ -1357,6 +1534,9 @@ int zmq::socket_base_t::process_commands (int timeout_, bool throttle_)
         return -1;
     }
 
+    if (unlikely (options.counters_ivl > 0))
+        publish_counters ();
+
     return 0;
 }
 
@@ -1547,6 +1727,12 @@ void zmq::socket_base_t::pipe_terminated (pipe_t *pipe_)
     //  Notify the specific socket type about the pipe termination.
     xpipe_terminated (pipe_);
 
+    //  Keep what the pipe has accounted for in the socket totals.
+    zmq_pipe_counters_t pipe_counters;
+    pipe_->get_counters (&pipe_counters);
+    counters.msgs_dropped += pipe_counters.msgs_dropped;
+    counters.activations += pipe_counters.activations;
+
     // Remove pipe from inproc pipes
     for (inprocs_t::iterator it = inprocs.begin (); it != inprocs.end (); ++it)
         if (it->second == pipe_) {
@@ -1569,6 +1755,76 @@ void zmq::socket_base_t::extract_flags (msg_t *msg_)
 
     //  Remove MORE flag.
     rcvmore = msg_->flags () & msg_t::more ? true : false;
+
+    counters.bytes_in += msg_->size ();
+    if (!rcvmore)
+        counters.msgs_in++;
+}
+
+void zmq::socket_base_t::count_sent (size_t size_, bool more_)
+{
+    counters.bytes_out += size_;
+    if (!more_)
+        counters.msgs_out++;
+}
+
+void zmq::socket_base_t::get_counters (zmq_counters_t *counters_)
+{
+    *counters_ = counters;
+    counters_->batched_activations = flush_batch.batched_activations ();
+    counters_->pipes = pipes.size ();
+
+    zmq_pipe_counters_t pipe_counters;
+    for (pipes_t::size_type i = 0; i != pipes.size (); ++i) {
+        pipes[i]->get_counters (&pipe_counters);
+        counters_->msgs_dropped += pipe_counters.msgs_dropped;
+        counters_->activations += pipe_counters.activations;
+    }
+}
+
+int zmq::socket_base_t::get_pipe_counters (void *optval_, size_t *optvallen_)
+{
+    const size_t size = pipes.size () * sizeof (zmq_pipe_counters_t);
+    if (*optvallen_ < size) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    //  The buffer provided by the user is not necessarily aligned.
+    zmq_pipe_counters_t pipe_counters;
+    for (pipes_t::size_type i = 0; i != pipes.size (); ++i) {
+        pipes[i]->get_counters (&pipe_counters);
+        memcpy ((unsigned char *) optval_ + i * sizeof pipe_counters,
+                &pipe_counters, sizeof pipe_counters);
+    }
+    *optvallen_ = size;
+    return 0;
+}
+
+void zmq::socket_base_t::publish_counters ()
+{
+    const uint64_t now = clock.now_ms ();
+    if (now < counters_publish_time)
+        return;
+    counters_publish_time = now + options.counters_ivl;
+
+    scoped_lock_t lock (monitor_sync);
+    if (!(monitor_events & ZMQ_EVENT_COUNTERS))
+        return;
+
+    //  The snapshot travels in place of the address, the socket counters
+    //  first, then the counters of each pipe.
+    zmq_counters_t socket_counters;
+    get_counters (&socket_counters);
+    std::string snapshot ((const char *) &socket_counters,
+                          sizeof socket_counters);
+
+    zmq_pipe_counters_t pipe_counters;
+    for (pipes_t::size_type i = 0; i != pipes.size (); ++i) {
+        pipes[i]->get_counters (&pipe_counters);
+        snapshot.append ((const char *) &pipe_counters, sizeof pipe_counters);
+    }
+    monitor_event (ZMQ_EVENT_COUNTERS, (intptr_t) pipes.size (), snapshot);
 }
 
 int zmq::socket_base_t::monitor (const char *addr_, int events_)
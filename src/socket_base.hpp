@@ -86,6 +86,11 @@ class socket_base_t : public own_t,
     int term_endpoint (const char *addr_);
     int send (zmq::msg_t *msg_, int flags_);
     int recv (zmq::msg_t *msg_, int flags_);
+
+    //  Send or receive up to count_ messages in a single call. Returns the
+    //  number of messages transferred or -1 if there was none.
+    int send_batch (zmq::msg_t *msgs_, size_t count_, int flags_);
+    int recv_batch (zmq::msg_t *msgs_, size_t count_, int flags_);
     void add_signaler (signaler_t *s);
     void remove_signaler (signaler_t *s);
     int close ();
@@ -216,6 +221,17 @@ class socket_base_t : public own_t,
     //  to be later retrieved by getsockopt.
     void extract_flags (msg_t *msg_);
 
+    //  Accounts for a message part that was successfully sent.
+    void count_sent (size_t size_, bool more_);
+
+    //  Fills in the socket counters, including those of the pipes.
+    void get_counters (zmq_counters_t *counters_);
+    int get_pipe_counters (void *optval_, size_t *optvallen_);
+
+    //  Publishes the counters on the monitor socket if ZMQ_COUNTERS_IVL
+    //  has elapsed since the last time.
+    void publish_counters ();
+
     //  Used to check whether the object is a socket.
     uint32_t tag;
 
@@ -259,6 +275,9 @@ class socket_base_t : public own_t,
     typedef array_t<pipe_t, 3> pipes_t;
     pipes_t pipes;
 
+    //  Postpones the flushes of the attached pipes during send_batch.
+    flush_batch_t flush_batch;
+
     //  Reaper's poller and handle of this socket within it.
     poller_t *poller;
     poller_t::handle_t handle;
@@ -272,6 +291,14 @@ class socket_base_t : public own_t,
     //  True if the last message received had MORE flag set.
     bool rcvmore;
 
+    //  Traffic counters. Messages are counted once their last part is
+    //  transferred. Dropped messages and activations are accumulated here
+    //  only for the pipes that are already terminated.
+    zmq_counters_t counters;
+
+    //  Time when the counters are to be published on the monitor next.
+    uint64_t counters_publish_time;
+
     //  Improves efficiency of time measurement.
     clock_t clock;
 
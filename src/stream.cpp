@@ -38,6 +38,7 @@
 
 zmq::stream_t::stream_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_),
+    fq (options),
     prefetched (false),
     routing_id_sent (false),
     current_out (NULL),
@@ -53,7 +54,7 @@ zmq::stream_t::stream_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
 
 zmq::stream_t::~stream_t ()
 {
-    zmq_assert (outpipes.empty ());
+    zmq_assert (outpipes.size () == 0);
     prefetched_routing_id.close ();
     prefetched_msg.close ();
 }
@@ -70,9 +71,9 @@ void zmq::stream_t::xattach_pipe (pipe_t *pipe_, bool subscribe_to_all_)
 
 void zmq::stream_t::xpipe_terminated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it = outpipes.find (pipe_->get_routing_id ());
-    zmq_assert (it != outpipes.end ());
-    outpipes.erase (it);
+    const blob_t &routing_id = pipe_->get_routing_id ();
+    const bool erased = outpipes.erase (routing_id.data (), routing_id.size ());
+    zmq_assert (erased);
     fq.pipe_terminated (pipe_);
     if (pipe_ == current_out)
         current_out = NULL;
@@ -85,14 +86,11 @@ void zmq::stream_t::xread_activated (pipe_t *pipe_)
 
 void zmq::stream_t::xwrite_activated (pipe_t *pipe_)
 {
-    outpipes_t::iterator it;
-    for (it = outpipes.begin (); it != outpipes.end (); ++it)
-        if (it->second.pipe == pipe_)
-            break;
-
-    zmq_assert (it != outpipes.end ());
-    zmq_assert (!it->second.active);
-    it->second.active = true;
+    const blob_t &routing_id = pipe_->get_routing_id ();
+    outpipe_t *outpipe = outpipes.find (routing_id.data (), routing_id.size ());
+    zmq_assert (outpipe && outpipe->pipe == pipe_);
+    zmq_assert (!outpipe->active);
+    outpipe->active = true;
 }
 
 int zmq::stream_t::xsend (msg_t *msg_)
@@ -108,13 +106,13 @@ int zmq::stream_t::xsend (msg_t *msg_)
         if (msg_->flags () & msg_t::more) {
             //  Find the pipe associated with the routing id stored in the prefix.
             //  If there's no such pipe return an error
-            blob_t routing_id ((unsigned char *) msg_->data (), msg_->size ());
-            outpipes_t::iterator it = outpipes.find (routing_id);
+            outpipe_t *outpipe = outpipes.find (
+              (unsigned char *) msg_->data (), msg_->size ());
 
-            if (it != outpipes.end ()) {
-                current_out = it->second.pipe;
+            if (outpipe) {
+                current_out = outpipe->pipe;
                 if (!current_out->check_write ()) {
-                    it->second.active = false;
+                    outpipe->active = false;
                     current_out = NULL;
                     errno = EAGAIN;
                     return -1;
@@ -296,8 +294,7 @@ void zmq::stream_t::identify_peer (pipe_t *pipe_)
         routing_id.set ((unsigned char *) connect_routing_id.c_str (),
                         connect_routing_id.length ());
         connect_routing_id.clear ();
-        outpipes_t::iterator it = outpipes.find (routing_id);
-        zmq_assert (it == outpipes.end ());
+        zmq_assert (!outpipes.find (routing_id.data (), routing_id.size ()));
     } else {
         put_uint32 (buffer + 1, next_integral_routing_id++);
         routing_id.set (buffer, sizeof buffer);
@@ -306,9 +303,9 @@ void zmq::stream_t::identify_peer (pipe_t *pipe_)
     }
     pipe_->set_router_socket_routing_id (routing_id);
     //  Add the record into output pipes lookup table
-    outpipe_t outpipe = {pipe_, true};
-    const bool ok =
-      outpipes.ZMQ_MAP_INSERT_OR_EMPLACE (ZMQ_MOVE (routing_id), outpipe)
-        .second;
-    zmq_assert (ok);
+    outpipe_t &outpipe =
+      outpipes.insert (routing_id.data (), routing_id.size ());
+    zmq_assert (!outpipe.pipe);
+    outpipe.pipe = pipe_;
+    outpipe.active = true;
 }
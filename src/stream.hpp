@@ -83,7 +83,7 @@ class stream_t : public socket_base_t
     };
 
     //  Outbound pipes indexed by the peer IDs.
-    typedef std::map<blob_t, outpipe_t> outpipes_t;
+    typedef topic_table_t<outpipe_t> outpipes_t;
     outpipes_t outpipes;
 
     //  The pipe we are currently writing to.
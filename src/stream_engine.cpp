@@ -38,8 +38,10 @@
 
 #include <new>
 #include <sstream>
+#include <algorithm>
 
 #include "stream_engine.hpp"
+#include "zero_copy_tracker.hpp"
 #include "io_thread.hpp"
 #include "session_base.hpp"
 #include "v1_encoder.hpp"
@@ -74,6 +76,12 @@ zmq::stream_engine_t::stream_engine_t (fd_t fd_,
     outpos (NULL),
     outsize (0),
     encoder (NULL),
+    chunkpos (NULL),
+    chunksize (0),
+    in_place_threshold (out_batch_size),
+    chunk_zero_copy (false),
+    chunk_retained (false),
+    zero_copy (NULL),
     metadata (NULL),
     handshaking (true),
     greeting_size (v2_greeting_size),
@@ -136,12 +144,35 @@ zmq::stream_engine_t::stream_engine_t (fd_t fd_,
         if (heartbeat_timeout == -1)
             heartbeat_timeout = options.heartbeat_interval;
     }
+
+    if (options.zero_copy_send > 0 && tcp_enable_zero_copy (s)) {
+        zero_copy = new (std::nothrow) zero_copy_tracker_t ();
+        alloc_assert (zero_copy);
+        //  The content of very small messages is stored in the message
+        //  itself, which is reused for the next message while the kernel
+        //  may still be reading it, so such chunks are always copied.
+        in_place_threshold = std::max (
+          std::min (in_place_threshold, (size_t) options.zero_copy_send),
+          (size_t) msg_t::max_vsm_size + 1);
+    }
 }
 
 zmq::stream_engine_t::~stream_engine_t ()
 {
     zmq_assert (!plugged);
 
+    //  The kernel may still be reading the content of the messages sent
+    //  using zero-copy writes, so the tracker takes the socket over and
+    //  keeps the messages until it's done with them.
+    if (zero_copy) {
+        if (zero_copy->busy () && s != retired_fd) {
+            zero_copy->linger (s);
+            s = retired_fd;
+        } else
+            LIBZMQ_DELETE (zero_copy);
+        zero_copy = NULL;
+    }
+
     if (s != retired_fd) {
 #ifdef ZMQ_HAVE_WINDOWS
         int rc = closesocket (s);
@@ -190,14 +221,18 @@ void zmq::stream_engine_t::plug (io_thread_t *io_thread_,
     //  Connect to I/O threads poller object.
     io_object_t::plug (io_thread_);
     handle = add_fd (s);
+    if (zero_copy)
+        zero_copy->plug (io_thread_);
     io_error = false;
 
     if (options.raw_socket) {
         // no handshaking for raw sock, instantiate raw encoder and decoders
         encoder = new (std::nothrow) raw_encoder_t (out_batch_size);
         alloc_assert (encoder);
+        encoder->set_in_place_threshold (in_place_threshold);
 
-        decoder = new (std::nothrow) raw_decoder_t (in_batch_size);
+        decoder =
+          new (std::nothrow) raw_decoder_t (in_batch_size, options.allocator);
         alloc_assert (decoder);
 
         // disable handshaking for raw socket
@@ -287,6 +322,12 @@ void zmq::stream_engine_t::in_event ()
 {
     zmq_assert (!io_error);
 
+    //  Completions of zero-copy writes are reported as errors on the socket,
+    //  even when the input is stopped.
+    if (unlikely (zero_copy && zero_copy->busy ()))
+        if (zero_copy->reap (s) && input_stopped)
+            return;
+
     //  If still handshaking, receive and process the greeting message.
     if (unlikely (handshaking))
         if (!handshake ())
@@ -363,8 +404,11 @@ void zmq::stream_engine_t::out_event ()
 {
     zmq_assert (!io_error);
 
+    if (unlikely (zero_copy && zero_copy->busy ()))
+        zero_copy->reap (s);
+
     //  If write buffer is empty, try to read new data from the encoder.
-    if (!outsize) {
+    if (!outsize && !chunksize) {
         //  Even when we stop polling as soon as there is no
         //  data to send, the poller may invoke out_event one
         //  more time due to 'speculative write' optimisation.
@@ -375,8 +419,11 @@ void zmq::stream_engine_t::out_event ()
 
         outpos = NULL;
         outsize = encoder->encode (&outpos, 0);
+        chunksize = encoder->encode_in_place (&chunkpos);
 
-        while (outsize < (size_t) out_batch_size) {
+        //  Batch the messages until the buffer is full or there's a large
+        //  chunk of a message to be written straight from the message.
+        while (!chunksize && outsize < (size_t) out_batch_size) {
             if ((this->*next_msg) (&tx_msg) == -1)
                 break;
             encoder->load_msg (&tx_msg);
@@ -386,14 +433,21 @@ void zmq::stream_engine_t::out_event ()
             if (outpos == NULL)
                 outpos = bufptr;
             outsize += n;
+            chunksize = encoder->encode_in_place (&chunkpos);
         }
 
         //  If there is no data to send, stop polling for output.
-        if (outsize == 0) {
+        if (outsize == 0 && chunksize == 0) {
             output_stopped = true;
             reset_pollout (handle);
             return;
         }
+
+        //  The chunk belongs to the message being encoded.
+        chunk_zero_copy = zero_copy
+                          && chunksize >= (size_t) options.zero_copy_send
+                          && !tx_msg.is_vsm ();
+        chunk_retained = false;
     }
 
     //  If there are any data to write in write buffer, write as much as
@@ -401,18 +455,44 @@ void zmq::stream_engine_t::out_event ()
     //  arbitrarily large. However, we assume that underlying TCP layer has
     //  limited transmission buffer and thus the actual number of bytes
     //  written should be reasonably modest.
-    const int nbytes = tcp_write (s, outpos, outsize);
+    if (outsize) {
+        //  The buffer is reused as soon as it's written, so it can't go
+        //  along with a zero-copy chunk.
+        const int nbytes =
+          chunksize && !chunk_zero_copy
+            ? tcp_writev (s, outpos, outsize, chunkpos, chunksize)
+            : tcp_write (s, outpos, outsize);
+
+        //  IO error has occurred. We stop waiting for output events.
+        //  The engine is not terminated until we detect input error;
+        //  this is necessary to prevent losing incoming messages.
+        if (nbytes == -1) {
+            reset_pollout (handle);
+            return;
+        }
 
-    //  IO error has occurred. We stop waiting for output events.
-    //  The engine is not terminated until we detect input error;
-    //  this is necessary to prevent losing incoming messages.
-    if (nbytes == -1) {
-        reset_pollout (handle);
-        return;
+        if ((size_t) nbytes <= outsize) {
+            outpos += nbytes;
+            outsize -= nbytes;
+        } else {
+            chunkpos += nbytes - outsize;
+            chunksize -= nbytes - outsize;
+            outpos += outsize;
+            outsize = 0;
+        }
     }
 
-    outpos += nbytes;
-    outsize -= nbytes;
+    if (!outsize && chunksize) {
+        const int nbytes = chunk_zero_copy
+                             ? write_zero_copy_chunk ()
+                             : tcp_write (s, chunkpos, chunksize);
+        if (nbytes == -1) {
+            reset_pollout (handle);
+            return;
+        }
+        chunkpos += nbytes;
+        chunksize -= nbytes;
+    }
 
     //  If we are still handshaking and there are no data
     //  to send, stop polling for output.
@@ -421,6 +501,24 @@ void zmq::stream_engine_t::out_event ()
             reset_pollout (handle);
 }
 
+int zmq::stream_engine_t::write_zero_copy_chunk ()
+{
+    bool not_copied;
+    const int nbytes =
+      tcp_write_zero_copy (s, chunkpos, chunksize, &not_copied);
+    if (nbytes <= 0 || !not_copied)
+        return nbytes;
+
+    //  The chunk points to the content of the message being encoded, which
+    //  stays untouched until the chunk is written completely.
+    if (!chunk_retained) {
+        zero_copy->retain (tx_msg);
+        chunk_retained = true;
+    }
+    zero_copy->add_write ();
+    return nbytes;
+}
+
 void zmq::stream_engine_t::restart_output ()
 {
     if (unlikely (io_error))
@@ -576,6 +674,7 @@ bool zmq::stream_engine_t::handshake ()
 
         encoder = new (std::nothrow) v1_encoder_t (out_batch_size);
         alloc_assert (encoder);
+        encoder->set_in_place_threshold (in_place_threshold);
 
         decoder =
           new (std::nothrow) v1_decoder_t (in_batch_size, options.maxmsgsize);
@@ -622,6 +721,7 @@ bool zmq::stream_engine_t::handshake ()
 
         encoder = new (std::nothrow) v1_encoder_t (out_batch_size);
         alloc_assert (encoder);
+        encoder->set_in_place_threshold (in_place_threshold);
 
         decoder =
           new (std::nothrow) v1_decoder_t (in_batch_size, options.maxmsgsize);
@@ -635,16 +735,20 @@ bool zmq::stream_engine_t::handshake ()
 
         encoder = new (std::nothrow) v2_encoder_t (out_batch_size);
         alloc_assert (encoder);
+        encoder->set_in_place_threshold (in_place_threshold);
 
         decoder = new (std::nothrow)
-          v2_decoder_t (in_batch_size, options.maxmsgsize, options.zero_copy);
+          v2_decoder_t (in_batch_size, options.maxmsgsize, options.zero_copy,
+                        options.allocator);
         alloc_assert (decoder);
     } else {
         encoder = new (std::nothrow) v2_encoder_t (out_batch_size);
         alloc_assert (encoder);
+        encoder->set_in_place_threshold (in_place_threshold);
 
         decoder = new (std::nothrow)
-          v2_decoder_t (in_batch_size, options.maxmsgsize, options.zero_copy);
+          v2_decoder_t (in_batch_size, options.maxmsgsize, options.zero_copy,
+                        options.allocator);
         alloc_assert (decoder);
 
         if (options.mechanism == ZMQ_NULL
@@ -54,6 +54,7 @@ class io_thread_t;
 class msg_t;
 class session_base_t;
 class mechanism_t;
+class zero_copy_tracker_t;
 
 //  This engine handles any socket with SOCK_STREAM semantics,
 //  e.g. TCP socket or an UNIX domain socket.
@@ -131,6 +132,10 @@ class stream_engine_t : public io_object_t, public i_engine
     int process_heartbeat_message (msg_t *msg_);
     int produce_pong_message (msg_t *msg_);
 
+    //  Writes the chunk using a zero-copy write, retaining the message
+    //  if the kernel took the data without copying them.
+    int write_zero_copy_chunk ();
+
     //  Underlying socket.
     fd_t s;
 
@@ -149,6 +154,24 @@ class stream_engine_t : public io_object_t, public i_engine
     size_t outsize;
     i_encoder *encoder;
 
+    //  Chunk of the message being sent that is written straight from the
+    //  message rather than copied to the encoder's buffer. It is written
+    //  after the data in the buffer.
+    unsigned char *chunkpos;
+    size_t chunksize;
+
+    //  Chunks at least this large are written straight from the message.
+    size_t in_place_threshold;
+
+    //  True if the chunk is written using zero-copy writes, and if so,
+    //  whether the message it belongs to was already retained.
+    bool chunk_zero_copy;
+    bool chunk_retained;
+
+    //  Messages retained for the zero-copy writes in flight. NULL unless
+    //  zero-copy writes are enabled on the socket.
+    zero_copy_tracker_t *zero_copy;
+
     //  Metadata to be attached to received messages. May be NULL.
     metadata_t *metadata;
 
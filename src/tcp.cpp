@@ -48,6 +48,35 @@
 #include <ioctl.h>
 #endif
 
+#if defined ZMQ_HAVE_LINUX && defined SO_ZEROCOPY && defined MSG_ZEROCOPY
+#include <linux/errqueue.h>
+#define ZMQ_HAVE_TCP_ZERO_COPY
+#endif
+
+#ifndef ZMQ_HAVE_WINDOWS
+//  Translates the result of a send call the way tcp_write reports it.
+static int write_result (ssize_t nbytes_)
+{
+    //  Several errors are OK. When speculative write is being done we may not
+    //  be able to write a single byte from the socket. Also, SIGSTOP issued
+    //  by a debugging tool can result in EINTR error.
+    if (nbytes_ == -1
+        && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
+        return 0;
+
+    //  Signalise peer failure.
+    if (nbytes_ == -1) {
+        errno_assert (errno != EACCES && errno != EBADF && errno != EDESTADDRREQ
+                      && errno != EFAULT && errno != EISCONN
+                      && errno != EMSGSIZE && errno != ENOMEM
+                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
+        return -1;
+    }
+
+    return static_cast<int> (nbytes_);
+}
+#endif
+
 int zmq::tune_tcp_socket (fd_t s_)
 {
     //  Disable Nagle's algorithm. We are doing data batching on 0MQ level,
@@ -227,26 +256,109 @@ int zmq::tcp_write (fd_t s_, const void *data_, size_t size_)
     return nbytes;
 
 #else
-    ssize_t nbytes = send (s_, (char *) data_, size_, 0);
+    return write_result (send (s_, (char *) data_, size_, 0));
+#endif
+}
 
-    //  Several errors are OK. When speculative write is being done we may not
-    //  be able to write a single byte from the socket. Also, SIGSTOP issued
-    //  by a debugging tool can result in EINTR error.
-    if (nbytes == -1
-        && (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR))
-        return 0;
+int zmq::tcp_writev (fd_t s_,
+                     const void *data_,
+                     size_t size_,
+                     const void *data2_,
+                     size_t size2_)
+{
+#ifdef ZMQ_HAVE_WINDOWS
+    //  The second buffer is written by a subsequent call.
+    LIBZMQ_UNUSED (data2_);
+    LIBZMQ_UNUSED (size2_);
+    return tcp_write (s_, data_, size_);
+#else
+    struct iovec iov[2];
+    iov[0].iov_base = (void *) data_;
+    iov[0].iov_len = size_;
+    iov[1].iov_base = (void *) data2_;
+    iov[1].iov_len = size2_;
+
+    struct msghdr msg;
+    memset (&msg, 0, sizeof msg);
+    msg.msg_iov = iov;
+    msg.msg_iovlen = 2;
+
+    return write_result (sendmsg (s_, &msg, 0));
+#endif
+}
 
-    //  Signalise peer failure.
-    if (nbytes == -1) {
-        errno_assert (errno != EACCES && errno != EBADF && errno != EDESTADDRREQ
-                      && errno != EFAULT && errno != EISCONN
-                      && errno != EMSGSIZE && errno != ENOMEM
-                      && errno != ENOTSOCK && errno != EOPNOTSUPP);
-        return -1;
+bool zmq::tcp_enable_zero_copy (fd_t s_)
+{
+#ifdef ZMQ_HAVE_TCP_ZERO_COPY
+    int on = 1;
+    return setsockopt (s_, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof on) == 0;
+#else
+    LIBZMQ_UNUSED (s_);
+    return false;
+#endif
+}
+
+int zmq::tcp_write_zero_copy (fd_t s_,
+                              const void *data_,
+                              size_t size_,
+                              bool *zero_copy_)
+{
+    *zero_copy_ = false;
+#ifdef ZMQ_HAVE_TCP_ZERO_COPY
+    const ssize_t nbytes = send (s_, (char *) data_, size_, MSG_ZEROCOPY);
+    if (nbytes >= 0) {
+        *zero_copy_ = true;
+        return static_cast<int> (nbytes);
     }
 
-    return static_cast<int> (nbytes);
+    //  The kernel may refuse to pin more pages for the socket, in which
+    //  case the data are copied the usual way.
+    if (errno != ENOBUFS)
+        return write_result (nbytes);
+#endif
+    return tcp_write (s_, data_, size_);
+}
 
+int zmq::tcp_read_zero_copy_completion (fd_t s_,
+                                        uint32_t *first_,
+                                        uint32_t *last_)
+{
+#ifdef ZMQ_HAVE_TCP_ZERO_COPY
+    while (true) {
+        char control[CMSG_SPACE (sizeof (struct sock_extended_err))];
+        struct msghdr msg;
+        memset (&msg, 0, sizeof msg);
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof control;
+
+        const ssize_t rc = recvmsg (s_, &msg, MSG_ERRQUEUE);
+        if (rc == -1) {
+            errno_assert (errno != EBADF && errno != EFAULT
+                          && errno != ENOTSOCK);
+            if (errno == EWOULDBLOCK || errno == EINTR)
+                errno = EAGAIN;
+            return -1;
+        }
+
+        //  Skip whatever else may have been queued for the socket.
+        const struct cmsghdr *cmsg = CMSG_FIRSTHDR (&msg);
+        if (!cmsg)
+            continue;
+        const struct sock_extended_err *err =
+          (const struct sock_extended_err *) CMSG_DATA (cmsg);
+        if (err->ee_errno != 0 || err->ee_origin != SO_EE_ORIGIN_ZEROCOPY)
+            continue;
+
+        *first_ = err->ee_info;
+        *last_ = err->ee_data;
+        return 0;
+    }
+#else
+    LIBZMQ_UNUSED (s_);
+    LIBZMQ_UNUSED (first_);
+    LIBZMQ_UNUSED (last_);
+    errno = EAGAIN;
+    return -1;
 #endif
 }
 
@@ -31,6 +31,7 @@
 #define __ZMQ_TCP_HPP_INCLUDED__
 
 #include "fd.hpp"
+#include "stdint.hpp"
 
 namespace zmq
 {
@@ -58,6 +59,32 @@ int tune_tcp_maxrt (fd_t sockfd_, int timeout_);
 //  of error or orderly shutdown by the other peer -1 is returned.
 int tcp_write (fd_t s_, const void *data_, size_t size_);
 
+//  Same as tcp_write, but gathers the data from two buffers, the second
+//  one being written only once the first one was written completely.
+int tcp_writev (fd_t s_,
+                const void *data_,
+                size_t size_,
+                const void *data2_,
+                size_t size2_);
+
+//  Enables zero-copy sends on the socket. Returns false if they are
+//  not supported by the platform or by the kind of socket.
+bool tcp_enable_zero_copy (fd_t s_);
+
+//  Same as tcp_write, but the kernel is asked to send the data straight
+//  from the buffer instead of copying it. If it agrees, zero_copy_ is set
+//  to true and the buffer must be kept intact until the send is reported
+//  as completed by tcp_read_zero_copy_completion. Each such write is
+//  identified by the next number of a per-socket sequence starting at 0.
+int tcp_write_zero_copy (fd_t s_,
+                         const void *data_,
+                         size_t size_,
+                         bool *zero_copy_);
+
+//  Retrieves the range of the zero-copy writes the kernel is done with.
+//  Returns -1 with errno set to EAGAIN if there is no completion pending.
+int tcp_read_zero_copy_completion (fd_t s_, uint32_t *first_, uint32_t *last_);
+
 //  Reads data from the socket (up to 'size' bytes).
 //  Returns the number of bytes actually read or -1 on error.
 //  Zero indicates the peer has closed the connection.
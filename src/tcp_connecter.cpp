@@ -42,6 +42,8 @@
 #include "address.hpp"
 #include "tcp_address.hpp"
 #include "session_base.hpp"
+#include "ctx.hpp"
+#include "dns_resolver.hpp"
 
 #if !defined ZMQ_HAVE_WINDOWS
 #include <unistd.h>
@@ -69,6 +71,7 @@ zmq::tcp_connecter_t::tcp_connecter_t (class io_thread_t *io_thread_,
     io_object_t (io_thread_),
     addr (addr_),
     s (retired_fd),
+    resolving (NULL),
     handle ((handle_t) NULL),
     delayed_start (delayed_start_),
     connect_timer_started (false),
@@ -91,6 +94,7 @@ zmq::tcp_connecter_t::~tcp_connecter_t ()
     zmq_assert (!reconnect_timer_started);
     zmq_assert (!handle);
     zmq_assert (s == retired_fd);
+    zmq_assert (!resolving);
 }
 
 void zmq::tcp_connecter_t::process_plug ()
@@ -120,9 +124,41 @@ void zmq::tcp_connecter_t::process_term (int linger_)
     if (s != retired_fd)
         close ();
 
+    //  The resolver hands the request back even if it is cancelled,
+    //  so wait for it before deallocating the connecter.
+    if (resolving) {
+        resolving->cancelled.store (1);
+        register_term_acks (1);
+    }
+
     own_t::process_term (linger_);
 }
 
+void zmq::tcp_connecter_t::process_resolved (dns_request_t *request_)
+{
+    zmq_assert (request_ == resolving);
+    resolving = NULL;
+
+    if (is_terminating ()) {
+        LIBZMQ_DELETE (request_);
+        unregister_term_ack ();
+        return;
+    }
+
+    if (request_->rc != 0) {
+        LIBZMQ_DELETE (request_);
+        add_reconnect_timer ();
+        return;
+    }
+
+    addr->resolved.tcp_addr =
+      new (std::nothrow) tcp_address_t (request_->result);
+    alloc_assert (addr->resolved.tcp_addr);
+    LIBZMQ_DELETE (request_);
+
+    connect_resolved ();
+}
+
 void zmq::tcp_connecter_t::in_event ()
 {
     //  We are not polling for incoming data, so we are actually called
@@ -184,6 +220,35 @@ void zmq::tcp_connecter_t::timer_event (int id_)
 }
 
 void zmq::tcp_connecter_t::start_connecting ()
+{
+    if (addr->resolved.tcp_addr != NULL) {
+        LIBZMQ_DELETE (addr->resolved.tcp_addr);
+    }
+
+    //  Numeric and cached addresses are resolved straight away, host names
+    //  are looked up by the resolver thread so that a slow name server
+    //  does not stall the other connections of this I/O thread.
+    dns_resolver_t *resolver = get_ctx ()->get_dns_resolver ();
+    tcp_address_t *tcp_addr = new (std::nothrow) tcp_address_t ();
+    alloc_assert (tcp_addr);
+    const int rc = resolver->lookup (addr->address, options.ipv6, tcp_addr);
+    if (rc != 0) {
+        LIBZMQ_DELETE (tcp_addr);
+        if (errno == EAGAIN) {
+            resolving = new (std::nothrow)
+              dns_request_t (this, addr->address, options.ipv6);
+            alloc_assert (resolving);
+            resolver->resolve (resolving);
+        } else
+            add_reconnect_timer ();
+        return;
+    }
+    addr->resolved.tcp_addr = tcp_addr;
+
+    connect_resolved ();
+}
+
+void zmq::tcp_connecter_t::connect_resolved ()
 {
     //  Open the connecting socket.
     const int rc = open ();
@@ -247,22 +312,9 @@ int zmq::tcp_connecter_t::get_new_reconnect_ivl ()
 int zmq::tcp_connecter_t::open ()
 {
     zmq_assert (s == retired_fd);
-
-    //  Resolve the address
-    if (addr->resolved.tcp_addr != NULL) {
-        LIBZMQ_DELETE (addr->resolved.tcp_addr);
-    }
-
-    addr->resolved.tcp_addr = new (std::nothrow) tcp_address_t ();
-    alloc_assert (addr->resolved.tcp_addr);
-    int rc = addr->resolved.tcp_addr->resolve (addr->address.c_str (), false,
-                                               options.ipv6);
-    if (rc != 0) {
-        LIBZMQ_DELETE (addr->resolved.tcp_addr);
-        return -1;
-    }
     zmq_assert (addr->resolved.tcp_addr != NULL);
     tcp_address_t *const tcp_addr = addr->resolved.tcp_addr;
+    int rc;
 
     //  Create the socket.
     s = open_socket (tcp_addr->family (), SOCK_STREAM, IPPROTO_TCP);
@@ -40,6 +40,7 @@ namespace zmq
 class io_thread_t;
 class session_base_t;
 struct address_t;
+struct dns_request_t;
 
 class tcp_connecter_t : public own_t, public io_object_t
 {
@@ -64,6 +65,7 @@ class tcp_connecter_t : public own_t, public io_object_t
     //  Handlers for incoming commands.
     void process_plug ();
     void process_term (int linger_);
+    void process_resolved (dns_request_t *request_);
 
     //  Handlers for I/O events.
     void in_event ();
@@ -74,8 +76,13 @@ class tcp_connecter_t : public own_t, public io_object_t
     void rm_handle ();
 
     //  Internal function to start the actual connection establishment.
+    //  Resolves the address first, asynchronously if it is a host name
+    //  the resolver of the context has not cached.
     void start_connecting ();
 
+    //  Internal function to connect to the resolved address.
+    void connect_resolved ();
+
     //  Internal function to add a connect timer
     void add_connect_timer ();
 
@@ -87,7 +94,8 @@ class tcp_connecter_t : public own_t, public io_object_t
     //  Returns the currently used interval
     int get_new_reconnect_ivl ();
 
-    //  Open TCP connecting socket. Returns -1 in case of error,
+    //  Open TCP connecting socket to the resolved address.
+    //  Returns -1 in case of error,
     //  0 if connect was successful immediately. Returns -1 with
     //  EAGAIN errno if async connect was launched.
     int open ();
@@ -108,6 +116,9 @@ class tcp_connecter_t : public own_t, public io_object_t
     //  Underlying socket.
     fd_t s;
 
+    //  Lookup of the address in progress, if any.
+    dns_request_t *resolving;
+
     //  Handle corresponding to the listening socket, if file descriptor is
     //  registered with the poller, or NULL.
     handle_t handle;
@@ -94,21 +94,41 @@ void zmq::tcp_listener_t::process_term (int linger_)
 
 void zmq::tcp_listener_t::in_event ()
 {
-    fd_t fd = accept ();
+    //  Drain the backlog, so that bursts of connections do not cost
+    //  a poll per connection.
+    for (int i = 0; i != max_accepts_per_event; i++) {
+        fd_t fd = accept ();
+
+        //  No more connections are waiting to be accepted.
+        if (fd == retired_fd && errno == EAGAIN)
+            return;
+
+        //  If connection was reset by the peer in the meantime or refused
+        //  by the accept filters, just ignore it and go on with the next
+        //  one. Running out of file descriptors or memory affects the
+        //  connections still waiting as well, so these are left to the
+        //  next event.
+        if (fd == retired_fd) {
+            const int err = zmq_errno ();
+            socket->event_accept_failed (endpoint, err);
+            if (err == ECONNABORTED || err == EPROTO || err == ECONNRESET
+                || err == ECONNREFUSED || err == EINTR)
+                continue;
+            return;
+        }
 
-    //  If connection was reset by the peer in the meantime, just ignore it.
-    //  TODO: Handle specific errors like ENFILE/EMFILE etc.
-    if (fd == retired_fd) {
-        socket->event_accept_failed (endpoint, zmq_errno ());
-        return;
+        create_engine (fd);
     }
+}
 
-    int rc = tune_tcp_socket (fd);
+void zmq::tcp_listener_t::create_engine (fd_t fd_)
+{
+    int rc = tune_tcp_socket (fd_);
     rc = rc
          | tune_tcp_keepalives (
-             fd, options.tcp_keepalive, options.tcp_keepalive_cnt,
+             fd_, options.tcp_keepalive, options.tcp_keepalive_cnt,
              options.tcp_keepalive_idle, options.tcp_keepalive_intvl);
-    rc = rc | tune_tcp_maxrt (fd, options.tcp_maxrt);
+    rc = rc | tune_tcp_maxrt (fd_, options.tcp_maxrt);
     if (rc != 0) {
         socket->event_accept_failed (endpoint, zmq_errno ());
         return;
@@ -116,7 +136,7 @@ void zmq::tcp_listener_t::in_event ()
 
     //  Create the engine object for this connection.
     stream_engine_t *engine =
-      new (std::nothrow) stream_engine_t (fd, options, endpoint);
+      new (std::nothrow) stream_engine_t (fd_, options, endpoint);
     alloc_assert (engine);
 
     //  Choose I/O thread to run connecter in. Given that we are already
@@ -131,7 +151,7 @@ void zmq::tcp_listener_t::in_event ()
     session->inc_seqnum ();
     launch_child (session);
     send_attach (session, engine, false);
-    socket->event_accepted (endpoint, (int) fd);
+    socket->event_accepted (endpoint, (int) fd_);
 }
 
 void zmq::tcp_listener_t::close ()
@@ -179,6 +199,7 @@ int zmq::tcp_listener_t::set_address (const char *addr_)
 
     if (options.use_fd != -1) {
         s = options.use_fd;
+        unblock_socket (s);
         socket->event_listening (endpoint, s);
         return 0;
     }
@@ -210,6 +231,10 @@ int zmq::tcp_listener_t::set_address (const char *addr_)
         return -1;
 #endif
 
+    //  The listening socket is drained until there is no more connection
+    //  to accept, so it must not block.
+    unblock_socket (s);
+
     //  On some systems, IPv4 mapping in IPv6 sockets is disabled by default.
     //  Switch it on in such cases.
     if (address.family () == AF_INET6)
@@ -235,6 +260,13 @@ int zmq::tcp_listener_t::set_address (const char *addr_)
 
     //  Allow reusing of the address.
     int flag = 1;
+#ifdef SO_REUSEPORT
+    //  Let the other listeners sharing the endpoint bind to it as well.
+    if (options.tcp_listeners > 1) {
+        rc = setsockopt (s, SOL_SOCKET, SO_REUSEPORT, &flag, sizeof (int));
+        errno_assert (rc == 0);
+    }
+#endif
 #ifdef ZMQ_HAVE_WINDOWS
     rc = setsockopt (s, SOL_SOCKET, SO_EXCLUSIVEADDRUSE, (const char *) &flag,
                      sizeof (int));
@@ -310,6 +342,8 @@ zmq::fd_t zmq::tcp_listener_t::accept ()
         const int last_error = WSAGetLastError ();
         wsa_assert (last_error == WSAEWOULDBLOCK || last_error == WSAECONNRESET
                     || last_error == WSAEMFILE || last_error == WSAENOBUFS);
+        errno = last_error == WSAEWOULDBLOCK ? EAGAIN
+                                             : wsa_error_to_errno (last_error);
         return retired_fd;
     }
 #if !defined _WIN32_WCE && !defined ZMQ_HAVE_WINDOWS_UWP
@@ -323,6 +357,8 @@ zmq::fd_t zmq::tcp_listener_t::accept ()
                       || errno == ECONNABORTED || errno == EPROTO
                       || errno == ENOBUFS || errno == ENOMEM || errno == EMFILE
                       || errno == ENFILE);
+        if (errno == EWOULDBLOCK)
+            errno = EAGAIN;
         return retired_fd;
     }
 #endif
@@ -353,6 +389,7 @@ zmq::fd_t zmq::tcp_listener_t::accept ()
             int rc = ::close (sock);
             errno_assert (rc == 0);
 #endif
+            errno = ECONNREFUSED;
             return retired_fd;
         }
     }
@@ -365,6 +402,7 @@ zmq::fd_t zmq::tcp_listener_t::accept ()
         int rc = ::close (sock);
         errno_assert (rc == 0);
 #endif
+        errno = ECONNABORTED;
         return retired_fd;
     }
 
@@ -63,6 +63,9 @@ class tcp_listener_t : public own_t, public io_object_t
     //  Handlers for I/O events.
     void in_event ();
 
+    //  Creates the engine and session for an accepted connection.
+    void create_engine (fd_t fd_);
+
     //  Close the listening socket.
     void close ();
 
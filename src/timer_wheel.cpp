@@ -0,0 +1,279 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "timer_wheel.hpp"
+#include "i_poll_events.hpp"
+#include "err.hpp"
+
+#include <string.h>
+#include <new>
+
+//  Returns the index of the lowest set bit, bits_ must not be 0.
+static unsigned lowest_bit (uint64_t bits_)
+{
+#if defined __GNUC__
+    return (unsigned) __builtin_ctzll (bits_);
+#else
+    unsigned index = 0;
+    while (!(bits_ & 1)) {
+        bits_ >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+zmq::timer_wheel_t::timer_wheel_t () :
+    current (0),
+    count (0),
+    sequence (0),
+    free_entries (NULL)
+{
+    memset (wheel, 0, sizeof wheel);
+    memset (occupied, 0, sizeof occupied);
+}
+
+zmq::timer_wheel_t::~timer_wheel_t ()
+{
+    for (int level = 0; level != levels; level++)
+        for (int slot = 0; slot != slots; slot++)
+            while (wheel[level][slot]) {
+                entry_t *entry = wheel[level][slot];
+                wheel[level][slot] = entry->next;
+                delete entry;
+            }
+    while (free_entries) {
+        entry_t *entry = free_entries;
+        free_entries = entry->next;
+        delete entry;
+    }
+}
+
+zmq::timer_wheel_t::handle_t
+zmq::timer_wheel_t::add (uint64_t expiration_, i_poll_events *sink_, int id_)
+{
+    entry_t *entry = free_entries;
+    if (entry)
+        free_entries = entry->next;
+    else {
+        entry = new (std::nothrow) entry_t;
+        alloc_assert (entry);
+    }
+
+    entry->expiration = expiration_;
+    entry->sink = sink_;
+    entry->id = id_;
+    entry->sequence = ++sequence;
+    place (entry);
+    count++;
+
+    handle_t handle = {entry, entry->sequence};
+    return handle;
+}
+
+void zmq::timer_wheel_t::cancel (handle_t handle_)
+{
+    //  Timer not found.
+    zmq_assert (handle_.entry && handle_.entry->sequence == handle_.sequence);
+
+    unlink (handle_.entry);
+    release (handle_.entry);
+}
+
+uint64_t zmq::timer_wheel_t::execute (uint64_t now_)
+{
+    while (count) {
+        const uint64_t next = next_expiration ();
+
+        //  If we have to wait for the next timer, catch up with the clock
+        //  so that timers added meanwhile land on the finest possible level
+        //  and return the time to wait (at least 1ms).
+        if (next > now_) {
+            if (now_ > current)
+                current = now_;
+            return next - now_;
+        }
+
+        //  Advance the wheel, skipping the empty slots.
+        current = next;
+        cascade ();
+
+        //  Trigger the timers that are due. The handlers may add new timers
+        //  due immediately, these are placed to the very same slot.
+        entry_t **slot = &wheel[0][current & slot_mask];
+        while (*slot) {
+            entry_t *entry = *slot;
+            i_poll_events *sink = entry->sink;
+            const int id = entry->id;
+            unlink (entry);
+            release (entry);
+            sink->timer_event (id);
+        }
+    }
+
+    //  There are no more timers.
+    if (now_ > current)
+        current = now_;
+    return 0;
+}
+
+bool zmq::timer_wheel_t::pending (handle_t handle_) const
+{
+    //  Released entries are kept for reuse, so the handle stays valid
+    //  for as long as the wheel exists.
+    return handle_.entry && handle_.entry->sequence == handle_.sequence;
+}
+
+bool zmq::timer_wheel_t::empty () const
+{
+    return count == 0;
+}
+
+void zmq::timer_wheel_t::place (entry_t *entry_)
+{
+    //  Timers already due are placed to the slot executed next.
+    const uint64_t expiration =
+      entry_->expiration > current ? entry_->expiration : current;
+
+    //  The timer goes to the finest level on which its slot is less than
+    //  a full revolution of the level away from the slot of the current
+    //  time. On coarser levels the slot is therefore always ahead.
+    int level = 0;
+    while (level != levels - 1 && distance (expiration, level) >> slot_bits)
+        level++;
+
+    unsigned slot;
+    if (distance (expiration, level) >> slot_bits)
+        //  Beyond the range of the wheel. Parked in the slot of the coarsest
+        //  level redistributed last and placed again once it is.
+        slot = (unsigned) ((current >> (slot_bits * level)) + slot_mask)
+               & slot_mask;
+    else
+        slot = (unsigned) (expiration >> (slot_bits * level)) & slot_mask;
+
+    entry_->level = (unsigned char) level;
+    entry_->slot = (unsigned char) slot;
+    entry_->prev = NULL;
+    entry_->next = wheel[level][slot];
+    if (entry_->next)
+        entry_->next->prev = entry_;
+    wheel[level][slot] = entry_;
+    occupied[level][slot / 64] |= (uint64_t) 1 << (slot % 64);
+}
+
+uint64_t zmq::timer_wheel_t::distance (uint64_t expiration_, int level_) const
+{
+    const unsigned shift = slot_bits * level_;
+    return (expiration_ >> shift) - (current >> shift);
+}
+
+void zmq::timer_wheel_t::unlink (entry_t *entry_)
+{
+    if (entry_->prev)
+        entry_->prev->next = entry_->next;
+    else {
+        wheel[entry_->level][entry_->slot] = entry_->next;
+        if (!entry_->next)
+            occupied[entry_->level][entry_->slot / 64] &=
+              ~((uint64_t) 1 << (entry_->slot % 64));
+    }
+    if (entry_->next)
+        entry_->next->prev = entry_->prev;
+}
+
+void zmq::timer_wheel_t::release (entry_t *entry_)
+{
+    entry_->sequence = 0;
+    entry_->next = free_entries;
+    free_entries = entry_;
+    count--;
+}
+
+void zmq::timer_wheel_t::cascade ()
+{
+    //  Coarser levels go first, so that timers moved from them can be
+    //  moved further down within the same pass.
+    for (int level = levels - 1; level != 0; level--) {
+        const unsigned shift = slot_bits * level;
+        if (current & (((uint64_t) 1 << shift) - 1))
+            continue;
+
+        const unsigned slot = (unsigned) (current >> shift) & slot_mask;
+        entry_t *entry = wheel[level][slot];
+        wheel[level][slot] = NULL;
+        occupied[level][slot / 64] &= ~((uint64_t) 1 << (slot % 64));
+        while (entry) {
+            entry_t *next = entry->next;
+            place (entry);
+            entry = next;
+        }
+    }
+}
+
+uint64_t zmq::timer_wheel_t::next_expiration () const
+{
+    uint64_t next = (uint64_t) -1;
+    for (int level = 0; level != levels; level++) {
+        const unsigned shift = slot_bits * level;
+        const int distance =
+          find_occupied (level, (unsigned) (current >> shift) & slot_mask);
+        if (distance < 0)
+            continue;
+
+        //  Timers on the finest level expire at the time of their slot,
+        //  the others are redistributed when their slot starts.
+        const uint64_t start = level == 0
+                                 ? current + distance
+                                 : ((current >> shift) + distance) << shift;
+        if (start < next)
+            next = start;
+    }
+    return next;
+}
+
+int zmq::timer_wheel_t::find_occupied (int level_, unsigned start_) const
+{
+    //  Scan the bitmap starting with the word holding start_ and finishing
+    //  with the bits of the same word preceding start_.
+    const unsigned first = start_ / 64;
+    const uint64_t above = ~(uint64_t) 0 << (start_ % 64);
+    for (unsigned n = 0; n <= bitmap_words; n++) {
+        const unsigned word = (first + n) % bitmap_words;
+        uint64_t bits = occupied[level_][word];
+        if (n == 0)
+            bits &= above;
+        else if (n == bitmap_words)
+            bits &= ~above;
+        if (bits)
+            return (int) ((word * 64 + lowest_bit (bits) - start_)
+                          & slot_mask);
+    }
+    return -1;
+}
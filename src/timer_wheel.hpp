@@ -0,0 +1,156 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+#define __ZMQ_TIMER_WHEEL_HPP_INCLUDED__
+
+#include "stdint.hpp"
+
+namespace zmq
+{
+struct i_poll_events;
+
+//  Hierarchical timing wheel with millisecond resolution. Adding and
+//  cancelling a timer takes constant time. Each level of the wheel spans
+//  256 times the range of the level below it; timers due beyond the range
+//  of the finest level are kept on the coarser ones and redistributed as
+//  the wheel advances. Empty stretches of the wheel are skipped using
+//  per-level occupancy bitmaps.
+
+class timer_wheel_t
+{
+  public:
+    struct entry_t;
+
+    //  Identifies a timer so that it can be cancelled.
+    struct handle_t
+    {
+        entry_t *entry;
+        uint64_t sequence;
+    };
+
+    timer_wheel_t ();
+    ~timer_wheel_t ();
+
+    //  Adds a timer expiring at expiration_ (in milliseconds). Its expiry
+    //  is signalled by invoking timer_event on sink_ with id_.
+    handle_t add (uint64_t expiration_, zmq::i_poll_events *sink_, int id_);
+
+    //  Cancels the timer identified by handle_. The timer must not have
+    //  expired or been cancelled already.
+    void cancel (handle_t handle_);
+
+    //  Returns true if the timer identified by handle_ has neither expired
+    //  nor been cancelled yet.
+    bool pending (handle_t handle_) const;
+
+    //  Executes the timers expired at now_ (in milliseconds). Returns the
+    //  number of milliseconds to wait for the next timer or 0 meaning
+    //  "no timers".
+    uint64_t execute (uint64_t now_);
+
+    //  Returns true if there are no timers.
+    bool empty () const;
+
+    struct entry_t
+    {
+        uint64_t expiration;
+        zmq::i_poll_events *sink;
+        int id;
+
+        //  Distinguishes handles of the entry's subsequent uses, 0 if the
+        //  entry is not in use.
+        uint64_t sequence;
+
+        //  Location of the entry in the wheel.
+        unsigned char level;
+        unsigned char slot;
+
+        entry_t *prev;
+        entry_t *next;
+    };
+
+  private:
+    enum
+    {
+        levels = 4,
+        slot_bits = 8,
+        slots = 1 << slot_bits,
+        slot_mask = slots - 1,
+        bitmap_words = slots / 64
+    };
+
+    //  Links the entry into the slot matching its expiration.
+    void place (entry_t *entry_);
+
+    //  Returns the number of slots of the given level between the current
+    //  time and expiration_.
+    uint64_t distance (uint64_t expiration_, int level_) const;
+
+    //  Unlinks the entry from its slot.
+    void unlink (entry_t *entry_);
+
+    //  Returns the entry to the free list.
+    void release (entry_t *entry_);
+
+    //  Redistributes the timers from coarser levels' slots that start at
+    //  the current time.
+    void cascade ();
+
+    //  Returns the earliest time at which a timer may be due, i.e. the
+    //  expiration of the first timer on the finest level or the start of
+    //  the first occupied slot on a coarser one.
+    uint64_t next_expiration () const;
+
+    //  Returns the distance from start_ to the first occupied slot of the
+    //  given level (wrapping around), -1 if the level is empty.
+    int find_occupied (int level_, unsigned start_) const;
+
+    //  Time up to which the wheel has advanced. No timer expires earlier.
+    uint64_t current;
+
+    //  Number of active timers.
+    uint64_t count;
+
+    //  Source of the handle sequence numbers.
+    uint64_t sequence;
+
+    //  Lists of timers per slot and bitmaps of the non-empty slots.
+    entry_t *wheel[levels][slots];
+    uint64_t occupied[levels][bitmap_words];
+
+    //  Entries not in use, linked through their next pointers.
+    entry_t *free_entries;
+
+    timer_wheel_t (const timer_wheel_t &);
+    const timer_wheel_t &operator= (const timer_wheel_t &);
+};
+}
+
+#endif
@@ -0,0 +1,160 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TOPIC_MAP_HPP_INCLUDED__
+#define __ZMQ_TOPIC_MAP_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <new>
+#include <set>
+
+#include "err.hpp"
+#include "macros.hpp"
+#include "topic_table.hpp"
+
+namespace zmq
+{
+class pipe_t;
+
+//  Map of exact topics to sets of pointers, the counterpart of
+//  generic_mtrie_t for sockets matching whole topics rather than prefixes.
+//  Matching a message costs a single hash lookup, whatever the length
+//  of the topic and the number of topics are.
+
+template <typename T> class generic_topic_map_t
+{
+  public:
+    typedef T value_t;
+    typedef const unsigned char *prefix_t;
+
+    enum rm_result
+    {
+        not_found,
+        last_value_removed,
+        values_remain
+    };
+
+    inline generic_topic_map_t () {}
+
+    inline ~generic_topic_map_t ()
+    {
+        for (size_t i = 0; i != topics.capacity (); i++)
+            if (topics.key (i))
+                LIBZMQ_DELETE (topics.value (i));
+    }
+
+    //  Add topic to the map. Returns true iff no entry with the same topic_
+    //  and size_ existed before.
+    inline bool add (prefix_t topic_, size_t size_, value_t *value_)
+    {
+        pipes_t *&pipes = topics.insert (topic_, size_);
+        const bool result = !pipes;
+        if (!pipes) {
+            pipes = new (std::nothrow) pipes_t;
+            alloc_assert (pipes);
+        }
+        pipes->insert (value_);
+        return result;
+    }
+
+    //  Remove all entries with a specific value from the map.
+    //  The call_on_uniq_ flag controls if the callback is invoked
+    //  when there are no entries left on a topic only (true)
+    //  or on every removal (false). The arg_ argument is passed
+    //  through to the callback function.
+    template <typename Arg>
+    void rm (value_t *value_,
+             void (*func_) (prefix_t data_, size_t size_, Arg arg_),
+             Arg arg_,
+             bool call_on_uniq_)
+    {
+        bool emptied = false;
+        for (size_t i = 0; i != topics.capacity (); i++) {
+            pipes_t *&pipes = topics.value (i);
+            if (!topics.key (i) || !pipes->erase (value_))
+                continue;
+            if (!call_on_uniq_ || pipes->empty ())
+                func_ (topics.key (i), topics.key_size (i), arg_);
+            if (pipes->empty ()) {
+                LIBZMQ_DELETE (pipes);
+                emptied = true;
+            }
+        }
+        if (emptied)
+            topics.compact ();
+    }
+
+    //  Removes a specific entry from the map.
+    //  Returns the result of the operation.
+    inline rm_result rm (prefix_t topic_, size_t size_, value_t *value_)
+    {
+        pipes_t **pipes = topics.find (topic_, size_);
+        if (!pipes)
+            return not_found;
+
+        typename pipes_t::size_type erased = (*pipes)->erase (value_);
+        if ((*pipes)->empty ()) {
+            zmq_assert (erased == 1);
+            LIBZMQ_DELETE (*pipes);
+            topics.erase (topic_, size_);
+            return last_value_removed;
+        }
+        return (erased == 1) ? values_remain : not_found;
+    }
+
+    //  Calls a callback function for all the entries of the topic
+    //  equal to data_. The arg_ argument is passed through to the
+    //  callback function.
+    template <typename Arg>
+    void match (prefix_t data_,
+                size_t size_,
+                void (*func_) (value_t *value_, Arg arg_),
+                Arg arg_)
+    {
+        pipes_t **pipes = topics.find (data_, size_);
+        if (!pipes)
+            return;
+        for (typename pipes_t::iterator it = (*pipes)->begin ();
+             it != (*pipes)->end (); ++it)
+            func_ (*it, arg_);
+    }
+
+  private:
+    typedef std::set<value_t *> pipes_t;
+    topic_table_t<pipes_t *> topics;
+
+    generic_topic_map_t (const generic_topic_map_t<value_t> &);
+    const generic_topic_map_t<value_t> &
+    operator= (const generic_topic_map_t<value_t> &);
+};
+
+typedef generic_topic_map_t<pipe_t> topic_map_t;
+}
+
+#endif
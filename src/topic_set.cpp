@@ -0,0 +1,71 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "precompiled.hpp"
+#include "topic_set.hpp"
+
+zmq::topic_set_t::topic_set_t ()
+{
+}
+
+zmq::topic_set_t::~topic_set_t ()
+{
+}
+
+bool zmq::topic_set_t::add (unsigned char *topic_, size_t size_)
+{
+    uint32_t &refcnt = topics.insert (topic_, size_);
+    return ++refcnt == 1;
+}
+
+bool zmq::topic_set_t::rm (unsigned char *topic_, size_t size_)
+{
+    uint32_t *refcnt = topics.find (topic_, size_);
+    if (!refcnt)
+        return false;
+    if (--*refcnt)
+        return false;
+    topics.erase (topic_, size_);
+    return true;
+}
+
+bool zmq::topic_set_t::check (unsigned char *data_, size_t size_)
+{
+    return topics.find (data_, size_) != NULL;
+}
+
+void zmq::topic_set_t::apply (
+  void (*func_) (unsigned char *data_, size_t size_, void *arg_), void *arg_)
+{
+    for (size_t i = 0; i != topics.capacity (); i++)
+        if (topics.key (i))
+            func_ (const_cast<unsigned char *> (topics.key (i)),
+                   topics.key_size (i), arg_);
+}
@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TOPIC_SET_HPP_INCLUDED__
+#define __ZMQ_TOPIC_SET_HPP_INCLUDED__
+
+#include <stddef.h>
+
+#include "stdint.hpp"
+#include "topic_table.hpp"
+
+namespace zmq
+{
+//  Set of exact topics, the counterpart of trie_t for sockets matching
+//  whole topics rather than prefixes. Topics are reference counted.
+
+class topic_set_t
+{
+  public:
+    topic_set_t ();
+    ~topic_set_t ();
+
+    //  Add topic to the set. Returns true if this is a new item in the set
+    //  rather than a duplicate.
+    bool add (unsigned char *topic_, size_t size_);
+
+    //  Remove topic from the set. Returns true if the item is actually
+    //  removed from the set.
+    bool rm (unsigned char *topic_, size_t size_);
+
+    //  Check whether particular topic is in the set.
+    bool check (unsigned char *data_, size_t size_);
+
+    //  Apply the function supplied to each topic in the set.
+    void apply (void (*func_) (unsigned char *data_, size_t size_, void *arg_),
+                void *arg_);
+
+  private:
+    topic_table_t<uint32_t> topics;
+
+    topic_set_t (const topic_set_t &);
+    const topic_set_t &operator= (const topic_set_t &);
+};
+}
+
+#endif
@@ -0,0 +1,247 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TOPIC_TABLE_HPP_INCLUDED__
+#define __ZMQ_TOPIC_TABLE_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "clock.hpp"
+#include "err.hpp"
+#include "random.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Open-addressing hash table keyed on topics or routing ids (arbitrary
+//  byte strings). The hash of each key is stored along with it, so that
+//  probing only compares the keys whose hash matches and resizing does
+//  not have to hash the keys again. Keys come from peers, so each table
+//  seeds its hash with a random value, which keeps keys colliding in one
+//  table from colliding in the others.
+//  Collisions are resolved by linear probing and entries are removed by
+//  shifting the following entries back, so lookups never have to skip
+//  tombstones. Values of type V are copied by assignment, the value
+//  equal to V () is considered empty.
+
+template <typename V> class topic_table_t
+{
+  public:
+    //  Nothing guarantees rand () was seeded, hence the time and the
+    //  address of the table are mixed into the seed as well.
+    inline topic_table_t () :
+        entries (NULL),
+        mask (0),
+        count (0),
+        seed (((uint64_t) generate_random () << 32 | generate_random ())
+              ^ clock_t::now_us () ^ (uint64_t) (uintptr_t) this)
+    {
+    }
+
+    inline ~topic_table_t ()
+    {
+        for (size_t i = 0; i != capacity (); i++)
+            free (entries[i].key);
+        free (entries);
+    }
+
+    //  Returns the number of topics in the table.
+    inline size_t size () const { return count; }
+
+    //  Returns the value stored for the topic, NULL if there is none.
+    inline V *find (const unsigned char *key_, size_t size_) const
+    {
+        const size_t index = find_index (key_, size_);
+        return index != capacity () ? &entries[index].value : NULL;
+    }
+
+    //  Returns the value stored for the topic. If there is none, an empty
+    //  value is inserted first.
+    inline V &insert (const unsigned char *key_, size_t size_)
+    {
+        V *value = find (key_, size_);
+        if (value)
+            return *value;
+
+        //  Keep the load factor at or below one half.
+        if ((count + 1) * 2 > capacity ())
+            resize (capacity () ? capacity () * 2 : 16);
+
+        const uint32_t h = hash (key_, size_);
+        entry_t &entry = entries[probe (h)];
+        entry.key = (unsigned char *) malloc (size_ ? size_ : 1);
+        alloc_assert (entry.key);
+        if (size_)
+            memcpy (entry.key, key_, size_);
+        entry.size = (uint32_t) size_;
+        entry.hash = h;
+        entry.value = V ();
+        count++;
+        return entry.value;
+    }
+
+    //  Removes the topic from the table. Returns false if there was none.
+    inline bool erase (const unsigned char *key_, size_t size_)
+    {
+        const size_t index = find_index (key_, size_);
+        if (index == capacity ())
+            return false;
+        erase_at (index);
+        return true;
+    }
+
+    //  Removes all the topics holding an empty value.
+    inline void compact ()
+    {
+        if (!entries)
+            return;
+        for (size_t i = 0; i != capacity (); i++)
+            if (entries[i].key && entries[i].value == V ()) {
+                free (entries[i].key);
+                entries[i].key = NULL;
+                count--;
+            }
+        resize (capacity ());
+    }
+
+    //  Slots of the table can be iterated over by index. Slots which are
+    //  not in use have a NULL key.
+    inline size_t capacity () const { return entries ? mask + 1 : 0; }
+    inline const unsigned char *key (size_t index_) const
+    {
+        return entries[index_].key;
+    }
+    inline size_t key_size (size_t index_) const
+    {
+        return entries[index_].size;
+    }
+    inline V &value (size_t index_) { return entries[index_].value; }
+
+  private:
+    struct entry_t
+    {
+        unsigned char *key;
+        uint32_t size;
+        uint32_t hash;
+        V value;
+    };
+
+    //  Hashes the key eight bytes at a time.
+    uint32_t hash (const unsigned char *key_, size_t size_) const
+    {
+        const uint64_t mul = 0x9e3779b97f4a7c15ULL;
+        uint64_t h = (seed ^ size_) * mul;
+        uint64_t word;
+        for (; size_ >= 8; key_ += 8, size_ -= 8) {
+            memcpy (&word, key_, 8);
+            h = (h ^ word) * mul;
+            h ^= h >> 29;
+        }
+        if (size_) {
+            word = 0;
+            memcpy (&word, key_, size_);
+            h = (h ^ word) * mul;
+            h ^= h >> 29;
+        }
+        return (uint32_t) (h ^ (h >> 32));
+    }
+
+    //  Returns the slot holding the key, capacity () if there is none.
+    size_t find_index (const unsigned char *key_, size_t size_) const
+    {
+        if (!count)
+            return capacity ();
+        const uint32_t h = hash (key_, size_);
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            const entry_t &entry = entries[i];
+            if (!entry.key)
+                return capacity ();
+            if (entry.hash == h && entry.size == size_
+                && memcmp (entry.key, key_, size_) == 0)
+                return i;
+        }
+    }
+
+    //  Returns the first free slot for the hash.
+    size_t probe (uint32_t hash_) const
+    {
+        size_t i = hash_ & mask;
+        while (entries[i].key)
+            i = (i + 1) & mask;
+        return i;
+    }
+
+    void erase_at (size_t index_)
+    {
+        free (entries[index_].key);
+        count--;
+
+        //  Shift back the following entries of the cluster that would not
+        //  be reachable from their home slot anymore.
+        size_t hole = index_;
+        for (size_t i = (index_ + 1) & mask; entries[i].key;
+             i = (i + 1) & mask) {
+            const size_t home = entries[i].hash & mask;
+            if (((i - home) & mask) >= ((i - hole) & mask)) {
+                entries[hole] = entries[i];
+                hole = i;
+            }
+        }
+        entries[hole].key = NULL;
+    }
+
+    void resize (size_t capacity_)
+    {
+        entry_t *old_entries = entries;
+        const size_t old_capacity = capacity ();
+
+        entries = (entry_t *) calloc (capacity_, sizeof (entry_t));
+        alloc_assert (entries);
+        mask = capacity_ - 1;
+        for (size_t i = 0; i != old_capacity; i++)
+            if (old_entries[i].key)
+                entries[probe (old_entries[i].hash)] = old_entries[i];
+        free (old_entries);
+    }
+
+    entry_t *entries;
+    size_t mask;
+    size_t count;
+
+    //  Random seed of the hash.
+    const uint64_t seed;
+
+    topic_table_t (const topic_table_t &);
+    const topic_table_t &operator= (const topic_table_t &);
+};
+}
+
+#endif
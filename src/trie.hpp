@@ -33,6 +33,7 @@
 #include <stddef.h>
 
 #include "stdint.hpp"
+#include "trie_node.hpp"
 
 namespace zmq
 {
@@ -58,24 +59,23 @@ class trie_t
                 void *arg_);
 
   private:
-    void apply_helper (unsigned char **buff_,
-                       size_t buffsize_,
-                       size_t maxbuffsize_,
-                       void (*func_) (unsigned char *data_,
-                                      size_t size_,
-                                      void *arg_),
-                       void *arg_);
-    bool is_redundant () const;
-
-    uint32_t refcnt;
-    unsigned char min;
-    unsigned short count;
-    unsigned short live_nodes;
-    union
-    {
-        class trie_t *node;
-        class trie_t **table;
-    } next;
+    typedef trie_node_t<uint32_t> node_t;
+
+    static void apply_helper (node_t *node_,
+                              unsigned char **buff_,
+                              size_t buffsize_,
+                              size_t *maxbuffsize_,
+                              void (*func_) (unsigned char *data_,
+                                             size_t size_,
+                                             void *arg_),
+                              void *arg_);
+    static bool rm_helper (node_t *&node_, unsigned char *prefix_, size_t size_);
+    static void destroy (node_t *node_);
+
+    //  Root of the path-compressed trie. Its prefix is always empty and
+    //  its value is the number of subscriptions for the empty prefix.
+    //  The values of the other nodes are reference counts as well.
+    node_t *root;
 
     trie_t (const trie_t &);
     const trie_t &operator= (const trie_t &);
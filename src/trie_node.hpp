@@ -0,0 +1,245 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_TRIE_NODE_HPP_INCLUDED__
+#define __ZMQ_TRIE_NODE_HPP_INCLUDED__
+
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+
+#include "err.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+//  Node of a path-compressed (radix) trie. Each node stands for a run of
+//  key bytes and holds a value of type T, which is considered empty when
+//  equal to T (). The node is allocated as a single block laid out as
+//  follows:
+//
+//      header | children[count] | first_bytes[count] | prefix[prefix_size]
+//
+//  Children are sorted by the first byte of their prefix, which is stored
+//  in first_bytes, so that a lookup scans a short contiguous array rather
+//  than chasing a pointer per key byte. As the block is reallocated when
+//  the set of children changes, the functions that modify a node take a
+//  reference to the pointer held by its parent.
+
+template <typename T> struct trie_node_t
+{
+    T value;
+    uint32_t prefix_size;
+    uint32_t count;
+
+    unsigned char *prefix ()
+    {
+        return first_bytes () + count;
+    }
+
+    unsigned char *first_bytes ()
+    {
+        return (unsigned char *) (children () + count);
+    }
+
+    trie_node_t **children ()
+    {
+        return (trie_node_t **) ((unsigned char *) this + header_size ());
+    }
+
+    bool has_value () const { return !(value == T ()); }
+
+    //  Node carrying no value and having no children can be removed.
+    bool is_redundant () const { return !has_value () && count == 0; }
+
+    //  Returns the child whose prefix starts with c_, NULL if there's none.
+    //  Short arrays are scanned inline, longer ones are left to memchr,
+    //  which is vectorised by most C libraries.
+    trie_node_t *find (unsigned char c_)
+    {
+        if (count <= 8) {
+            const unsigned char *fb = first_bytes ();
+            for (uint32_t i = 0; i != count; i++)
+                if (fb[i] == c_)
+                    return children ()[i];
+            return NULL;
+        }
+        const unsigned char *pos =
+          (const unsigned char *) memchr (first_bytes (), c_, count);
+        return pos ? children ()[pos - first_bytes ()] : NULL;
+    }
+
+    //  Same as above, returns the slot holding the child.
+    trie_node_t **find_slot (unsigned char c_)
+    {
+        const unsigned char *pos =
+          (const unsigned char *) memchr (first_bytes (), c_, count);
+        return pos ? children () + (pos - first_bytes ()) : NULL;
+    }
+
+    //  Returns the length of the common prefix of the node and the key.
+    size_t common_prefix (const unsigned char *key_, size_t size_)
+    {
+        const unsigned char *node_prefix = prefix ();
+        const size_t size = std::min ((size_t) prefix_size, size_);
+        size_t i = 0;
+        while (i != size && node_prefix[i] == key_[i])
+            i++;
+        return i;
+    }
+
+    //  Allocates a node with an empty value and no children.
+    static trie_node_t *make (const unsigned char *prefix_, size_t size_)
+    {
+        trie_node_t *node = alloc (size_, 0);
+        if (size_)
+            memcpy (node->prefix (), prefix_, size_);
+        return node;
+    }
+
+    //  Deallocates the node. Its value and children are not touched.
+    static void free_node (trie_node_t *node_) { free (node_); }
+
+    //  Inserts child_ into the node, the first byte of the child's prefix
+    //  must not be used by any other child.
+    static void add_child (trie_node_t *&node_, trie_node_t *child_)
+    {
+        zmq_assert (child_->prefix_size > 0);
+        const unsigned char c = child_->prefix ()[0];
+        const uint32_t count = node_->count;
+        const size_t pos =
+          std::lower_bound (node_->first_bytes (),
+                            node_->first_bytes () + count, c)
+          - node_->first_bytes ();
+
+        trie_node_t *node = alloc (node_->prefix_size, count + 1);
+        node->value = node_->value;
+        memcpy (node->children (), node_->children (),
+                pos * sizeof (trie_node_t *));
+        node->children ()[pos] = child_;
+        memcpy (node->children () + pos + 1, node_->children () + pos,
+                (count - pos) * sizeof (trie_node_t *));
+        memcpy (node->first_bytes (), node_->first_bytes (), pos);
+        node->first_bytes ()[pos] = c;
+        memcpy (node->first_bytes () + pos + 1, node_->first_bytes () + pos,
+                count - pos + node_->prefix_size);
+        free (node_);
+        node_ = node;
+    }
+
+    //  Removes the child at the position index_ from the node. The child
+    //  itself is not deallocated.
+    static void rm_child (trie_node_t *&node_, size_t index_)
+    {
+        const uint32_t count = node_->count;
+        zmq_assert (index_ < count);
+
+        trie_node_t *node = alloc (node_->prefix_size, count - 1);
+        node->value = node_->value;
+        memcpy (node->children (), node_->children (),
+                index_ * sizeof (trie_node_t *));
+        memcpy (node->children () + index_, node_->children () + index_ + 1,
+                (count - index_ - 1) * sizeof (trie_node_t *));
+        memcpy (node->first_bytes (), node_->first_bytes (), index_);
+        memcpy (node->first_bytes () + index_,
+                node_->first_bytes () + index_ + 1,
+                count - index_ - 1 + node_->prefix_size);
+        free (node_);
+        node_ = node;
+    }
+
+    //  Splits the node after the first size_ bytes of its prefix. The node
+    //  is replaced by an empty node standing for those bytes with a single
+    //  child for the rest of the prefix.
+    static void split (trie_node_t *&node_, size_t size_)
+    {
+        zmq_assert (size_ > 0 && size_ < node_->prefix_size);
+
+        trie_node_t *parent = alloc (size_, 1);
+        trie_node_t *child = alloc (node_->prefix_size - size_, node_->count);
+        child->value = node_->value;
+        memcpy (child->children (), node_->children (),
+                node_->count * (sizeof (trie_node_t *) + 1));
+        memcpy (child->prefix (), node_->prefix () + size_,
+                child->prefix_size);
+
+        parent->children ()[0] = child;
+        parent->first_bytes ()[0] = child->prefix ()[0];
+        memcpy (parent->prefix (), node_->prefix (), size_);
+        free (node_);
+        node_ = parent;
+    }
+
+    //  If the node carries no value and has a single child, merges the
+    //  child into the node to keep the trie path-compressed.
+    static void compact (trie_node_t *&node_)
+    {
+        if (node_->has_value () || node_->count != 1)
+            return;
+
+        trie_node_t *child = node_->children ()[0];
+        trie_node_t *node =
+          alloc (node_->prefix_size + child->prefix_size, child->count);
+        node->value = child->value;
+        memcpy (node->children (), child->children (),
+                child->count * (sizeof (trie_node_t *) + 1));
+        memcpy (node->prefix (), node_->prefix (), node_->prefix_size);
+        memcpy (node->prefix () + node_->prefix_size, child->prefix (),
+                child->prefix_size);
+        free (child);
+        free (node_);
+        node_ = node;
+    }
+
+  private:
+    //  Size of the header rounded up so that the children are aligned.
+    static size_t header_size ()
+    {
+        return (sizeof (trie_node_t) + sizeof (trie_node_t *) - 1)
+               & ~(sizeof (trie_node_t *) - 1);
+    }
+
+    static trie_node_t *alloc (size_t prefix_size_, size_t count_)
+    {
+        zmq_assert (count_ <= 256);
+        trie_node_t *node = (trie_node_t *) malloc (
+          header_size () + count_ * (sizeof (trie_node_t *) + 1)
+          + prefix_size_);
+        alloc_assert (node);
+        node->value = T ();
+        node->prefix_size = (uint32_t) prefix_size_;
+        node->count = (uint32_t) count_;
+        return node;
+    }
+};
+}
+
+#endif
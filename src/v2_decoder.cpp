@@ -40,12 +40,14 @@
 
 zmq::v2_decoder_t::v2_decoder_t (size_t bufsize_,
                                  int64_t maxmsgsize_,
-                                 bool zero_copy_) :
-    shared_message_memory_allocator (bufsize_),
+                                 bool zero_copy_,
+                                 const allocator_t &allocator_) :
+    shared_message_memory_allocator (bufsize_, allocator_),
     decoder_base_t<v2_decoder_t, shared_message_memory_allocator> (this),
     msg_flags (0),
     zero_copy (zero_copy_),
-    maxmsgsize (maxmsgsize_)
+    maxmsgsize (maxmsgsize_),
+    msg_allocator (allocator_)
 {
     int rc = in_progress.init ();
     errno_assert (rc == 0);
@@ -60,6 +62,43 @@ zmq::v2_decoder_t::~v2_decoder_t ()
     errno_assert (rc == 0);
 }
 
+int zmq::v2_decoder_t::decode (const unsigned char *data_,
+                               std::size_t size_,
+                               std::size_t &bytes_used_)
+{
+    //  Fast path: if the data starts with a complete frame small enough to
+    //  be stored in the message itself, decode it in one go rather than
+    //  walking through the state machine.
+    if (at_step (&v2_decoder_t::flags_ready) && size_ >= 2
+        && !(data_[0] & v2_protocol_t::large_flag)) {
+        const size_t msg_size = data_[1];
+        if (msg_size <= msg_t::max_vsm_size && msg_size <= size_ - 2
+            && (maxmsgsize < 0
+                || msg_size <= static_cast<uint64_t> (maxmsgsize))) {
+            int rc = in_progress.close ();
+            errno_assert (rc == 0);
+            rc = in_progress.init_size (msg_size);
+            errno_assert (rc == 0);
+            memcpy (in_progress.data (), data_ + 2, msg_size);
+
+            unsigned char flags = 0;
+            if (data_[0] & v2_protocol_t::more_flag)
+                flags |= msg_t::more;
+            if (data_[0] & v2_protocol_t::command_flag)
+                flags |= msg_t::command;
+            in_progress.set_flags (flags);
+
+            bytes_used_ = msg_size + 2;
+            return 1;
+        }
+    }
+
+    return decoder_base_t<v2_decoder_t,
+                          shared_message_memory_allocator>::decode (data_,
+                                                                    size_,
+                                                                    bytes_used_);
+}
+
 int zmq::v2_decoder_t::flags_ready (unsigned char const *)
 {
     msg_flags = 0;
@@ -119,7 +158,8 @@ int zmq::v2_decoder_t::size_ready (uint64_t msg_size,
           || ((unsigned char *) read_pos + msg_size > (data () + size ())))) {
         // a new message has started, but the size would exceed the pre-allocated arena
         // this happens every time when a message does not fit completely into the buffer
-        rc = in_progress.init_size (static_cast<size_t> (msg_size));
+        rc = in_progress.init_size (static_cast<size_t> (msg_size),
+                                    &msg_allocator);
     } else {
         // construct message using n bytes from the buffer as storage
         // increase buffer ref count
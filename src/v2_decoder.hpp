@@ -44,10 +44,16 @@ class v2_decoder_t :
   public decoder_base_t<v2_decoder_t, shared_message_memory_allocator>
 {
   public:
-    v2_decoder_t (size_t bufsize_, int64_t maxmsgsize_, bool zero_copy_);
+    v2_decoder_t (size_t bufsize_,
+                  int64_t maxmsgsize_,
+                  bool zero_copy_,
+                  const allocator_t &allocator_ = allocator_t ());
     virtual ~v2_decoder_t ();
 
     //  i_decoder interface.
+    virtual int decode (const unsigned char *data_,
+                        std::size_t size_,
+                        std::size_t &bytes_used_);
     virtual msg_t *msg () { return &in_progress; }
 
   private:
@@ -65,6 +71,9 @@ class v2_decoder_t :
     const bool zero_copy;
     const int64_t maxmsgsize;
 
+    //  Allocator of the content of the messages not stored in the buffer.
+    const allocator_t msg_allocator;
+
     v2_decoder_t (const v2_decoder_t &);
     void operator= (const v2_decoder_t &);
 };
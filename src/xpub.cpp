@@ -108,15 +108,24 @@ void zmq::xpub_t::xread_activated (pipe_t *pipe_)
                 pending_flags.push_back (0);
             } else {
                 bool notify;
+                const bool exact = options.exact_topics && size > 1;
                 if (*data == 0) {
-                    mtrie_t::rm_result rm_result =
-                      subscriptions.rm (data + 1, size - 1, pipe_);
+                    bool values_remain;
+                    if (exact)
+                        values_remain =
+                          exact_subscriptions.rm (data + 1, size - 1, pipe_)
+                          == topic_map_t::values_remain;
+                    else
+                        values_remain =
+                          subscriptions.rm (data + 1, size - 1, pipe_)
+                          == mtrie_t::values_remain;
                     //  TODO reconsider what to do if rm_result == mtrie_t::not_found
-                    notify =
-                      rm_result != mtrie_t::values_remain || verbose_unsubs;
+                    notify = !values_remain || verbose_unsubs;
                 } else {
                     bool first_added =
-                      subscriptions.add (data + 1, size - 1, pipe_);
+                      exact
+                        ? exact_subscriptions.add (data + 1, size - 1, pipe_)
+                        : subscriptions.add (data + 1, size - 1, pipe_);
                     notify = first_added || verbose_subs;
                 }
 
@@ -170,12 +179,23 @@ int zmq::xpub_t::xsetsockopt (int option_,
         else if (option_ == ZMQ_XPUB_MANUAL)
             manual = (*static_cast<const int *> (optval_) != 0);
     } else if (option_ == ZMQ_SUBSCRIBE && manual) {
-        if (last_pipe != NULL)
-            subscriptions.add ((unsigned char *) optval_, optvallen_,
-                               last_pipe);
+        if (last_pipe != NULL) {
+            if (options.exact_topics && optvallen_ > 0)
+                exact_subscriptions.add ((unsigned char *) optval_,
+                                         optvallen_, last_pipe);
+            else
+                subscriptions.add ((unsigned char *) optval_, optvallen_,
+                                   last_pipe);
+        }
     } else if (option_ == ZMQ_UNSUBSCRIBE && manual) {
-        if (last_pipe != NULL)
-            subscriptions.rm ((unsigned char *) optval_, optvallen_, last_pipe);
+        if (last_pipe != NULL) {
+            if (options.exact_topics && optvallen_ > 0)
+                exact_subscriptions.rm ((unsigned char *) optval_, optvallen_,
+                                        last_pipe);
+            else
+                subscriptions.rm ((unsigned char *) optval_, optvallen_,
+                                  last_pipe);
+        }
     } else if (option_ == ZMQ_XPUB_WELCOME_MSG) {
         welcome_msg.close ();
 
@@ -211,11 +231,14 @@ void zmq::xpub_t::xpipe_terminated (pipe_t *pipe_)
         //  care of by the manual call above. subscriptions is the real mtrie,
         //  so the pipe must be removed from there or it will be left over.
         subscriptions.rm (pipe_, stub, (void *) NULL, false);
+        exact_subscriptions.rm (pipe_, stub, (void *) NULL, false);
     } else {
         //  Remove the pipe from the trie. If there are topics that nobody
         //  is interested in anymore, send corresponding unsubscriptions
         //  upstream.
         subscriptions.rm (pipe_, send_unsubscription, this, !verbose_unsubs);
+        exact_subscriptions.rm (pipe_, send_unsubscription, this,
+                                !verbose_unsubs);
     }
 
     dist.pipe_terminated (pipe_);
@@ -234,6 +257,8 @@ int zmq::xpub_t::xsend (msg_t *msg_)
     if (!more) {
         subscriptions.match ((unsigned char *) msg_->data (), msg_->size (),
                              mark_as_matching, this);
+        exact_subscriptions.match ((unsigned char *) msg_->data (),
+                                   msg_->size (), mark_as_matching, this);
         // If inverted matching is used, reverse the selection now
         if (options.invert_matching) {
             dist.reverse_match ();
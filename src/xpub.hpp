@@ -36,6 +36,7 @@
 #include "socket_base.hpp"
 #include "session_base.hpp"
 #include "mtrie.hpp"
+#include "topic_map.hpp"
 #include "array.hpp"
 #include "dist.hpp"
 
@@ -76,6 +77,10 @@ class xpub_t : public socket_base_t
     //  List of all subscriptions mapped to corresponding pipes.
     mtrie_t subscriptions;
 
+    //  List of subscriptions made with ZMQ_EXACT_TOPICS set mapped to
+    //  corresponding pipes.
+    topic_map_t exact_subscriptions;
+
     //  List of manual subscriptions mapped to corresponding pipes.
     mtrie_t manual_subscriptions;
 
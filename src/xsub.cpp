@@ -36,6 +36,7 @@
 
 zmq::xsub_t::xsub_t (class ctx_t *parent_, uint32_t tid_, int sid_) :
     socket_base_t (parent_, tid_, sid_),
+    fq (options),
     has_message (false),
     more (false)
 {
@@ -65,6 +66,7 @@ void zmq::xsub_t::xattach_pipe (pipe_t *pipe_, bool subscribe_to_all_)
 
     //  Send all the cached subscriptions to the new upstream peer.
     subscriptions.apply (send_subscription, pipe_);
+    exact_subscriptions.apply (send_subscription, pipe_);
     pipe_->flush ();
 }
 
@@ -88,6 +90,7 @@ void zmq::xsub_t::xhiccuped (pipe_t *pipe_)
 {
     //  Send all the cached subscriptions to the hiccuped pipe.
     subscriptions.apply (send_subscription, pipe_);
+    exact_subscriptions.apply (send_subscription, pipe_);
     pipe_->flush ();
 }
 
@@ -102,11 +105,17 @@ int zmq::xsub_t::xsend (msg_t *msg_)
         //  however this is alread done on the XPUB side and
         //  doing it here as well breaks ZMQ_XPUB_VERBOSE
         //  when there are forwarding devices involved.
-        subscriptions.add (data + 1, size - 1);
+        if (options.exact_topics && size > 1)
+            exact_subscriptions.add (data + 1, size - 1);
+        else
+            subscriptions.add (data + 1, size - 1);
         return dist.send_to_all (msg_);
     } else if (size > 0 && *data == 0) {
         //  Process unsubscribe message
-        if (subscriptions.rm (data + 1, size - 1))
+        const bool removed = options.exact_topics && size > 1
+                               ? exact_subscriptions.rm (data + 1, size - 1)
+                               : subscriptions.rm (data + 1, size - 1);
+        if (removed)
             return dist.send_to_all (msg_);
     } else
         //  User message sent upstream to XPUB socket
@@ -213,7 +222,9 @@ const zmq::blob_t &zmq::xsub_t::get_credential () const
 bool zmq::xsub_t::match (msg_t *msg_)
 {
     bool matching =
-      subscriptions.check ((unsigned char *) msg_->data (), msg_->size ());
+      subscriptions.check ((unsigned char *) msg_->data (), msg_->size ())
+      || exact_subscriptions.check ((unsigned char *) msg_->data (),
+                                    msg_->size ());
 
     return matching ^ options.invert_matching;
 }
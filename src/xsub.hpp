@@ -35,6 +35,7 @@
 #include "dist.hpp"
 #include "fq.hpp"
 #include "trie.hpp"
+#include "topic_set.hpp"
 
 namespace zmq
 {
@@ -79,6 +80,9 @@ class xsub_t : public socket_base_t
     //  The repository of subscriptions.
     trie_t subscriptions;
 
+    //  The repository of subscriptions made with ZMQ_EXACT_TOPICS set.
+    topic_set_t exact_subscriptions;
+
     //  If true, 'message' contains a matching message to return on the
     //  next recv call.
     bool has_message;
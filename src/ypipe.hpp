@@ -46,8 +46,10 @@ namespace zmq
 template <typename T, int N> class ypipe_t : public ypipe_base_t<T>
 {
   public:
-    //  Initialises the pipe.
-    inline ypipe_t ()
+    //  Initialises the pipe. Memory for the items is taken from
+    //  the given allocator.
+    inline explicit ypipe_t (const allocator_t &allocator_ = allocator_t ()) :
+        queue (allocator_)
     {
         //  Insert terminator element into the queue.
         queue.push ();
@@ -75,7 +77,7 @@ template <typename T, int N> class ypipe_t : public ypipe_base_t<T>
     //  set to true the item is assumed to be continued by items
     //  subsequently written to the pipe. Incomplete items are never
     //  flushed down the stream.
-    inline void write (const T &value_, bool incomplete_)
+    inline bool write (const T &value_, bool incomplete_)
     {
         //  Place the value to the queue, add new terminator element.
         queue.back () = value_;
@@ -84,6 +86,7 @@ template <typename T, int N> class ypipe_t : public ypipe_base_t<T>
         //  Move the "flush up to here" poiter.
         if (!incomplete_)
             f = &queue.back ();
+        return true;
     }
 
 #ifdef ZMQ_HAVE_OPENVMS
@@ -42,7 +42,9 @@ template <typename T> class ypipe_base_t
 {
   public:
     virtual ~ypipe_base_t () {}
-    virtual void write (const T &value_, bool incomplete_) = 0;
+    //  Returns false if the item completed a message which replaced a
+    //  message not read yet instead of being queued.
+    virtual bool write (const T &value_, bool incomplete_) = 0;
     virtual bool unwrite (T *value_) = 0;
     virtual bool flush () = 0;
     virtual bool check_read () = 0;
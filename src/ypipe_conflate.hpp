@@ -61,11 +61,12 @@ template <typename T> class ypipe_conflate_t : public ypipe_base_t<T>
 #pragma message save
 #pragma message disable(UNINIT)
 #endif
-    inline void write (const T &value_, bool incomplete_)
+    inline bool write (const T &value_, bool incomplete_)
     {
         (void) incomplete_;
 
         dbuffer.write (value_);
+        return true;
     }
 
 #ifdef ZMQ_HAVE_OPENVMS
@@ -0,0 +1,287 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include <new>
+
+#include "macros.hpp"
+#include "err.hpp"
+#include "ypipe_conflate_topics.hpp"
+
+zmq::ypipe_conflate_topics_t::ypipe_conflate_topics_t () :
+    incoming (NULL),
+    idle_head (NULL),
+    idle_tail (NULL),
+    idle_count (0),
+    current (NULL),
+    current_frame (0)
+{
+}
+
+zmq::ypipe_conflate_topics_t::~ypipe_conflate_topics_t ()
+{
+    if (incoming)
+        destroy (incoming);
+
+    if (current) {
+        for (size_t i = current_frame; i != current->frames.size (); i++) {
+            const int rc = current->frames[i].close ();
+            errno_assert (rc == 0);
+        }
+        if (current->slot->transient)
+            LIBZMQ_DELETE (current->slot);
+        LIBZMQ_DELETE (current);
+    }
+
+    //  The slots of the topics are deallocated below.
+    slot_t *slot;
+    while (queue.read (&slot))
+        if (slot->transient) {
+            destroy (slot->message.xchg (NULL));
+            LIBZMQ_DELETE (slot);
+        }
+
+    //  The frames of the messages handed back were read already.
+    message_t *message = handbacks.xchg (NULL);
+    while (message) {
+        message_t *next = message->next;
+        if (message->slot->transient)
+            LIBZMQ_DELETE (message->slot);
+        LIBZMQ_DELETE (message);
+        message = next;
+    }
+
+    for (slots_t::iterator it = slots.begin (); it != slots.end (); ++it) {
+        message = it->second->message.xchg (NULL);
+        if (message)
+            destroy (message);
+        LIBZMQ_DELETE (it->second);
+    }
+
+    for (size_t i = 0; i != spare.size (); i++)
+        LIBZMQ_DELETE (spare[i]);
+}
+
+void zmq::ypipe_conflate_topics_t::destroy (message_t *message_)
+{
+    for (size_t i = 0; i != message_->frames.size (); i++) {
+        const int rc = message_->frames[i].close ();
+        errno_assert (rc == 0);
+    }
+    LIBZMQ_DELETE (message_);
+}
+
+bool zmq::ypipe_conflate_topics_t::write (const msg_t &value_,
+                                          bool incomplete_)
+{
+    if (!incoming) {
+        if (!spare.empty ()) {
+            incoming = spare.back ();
+            spare.pop_back ();
+        } else {
+            incoming = new (std::nothrow) message_t;
+            alloc_assert (incoming);
+        }
+    }
+    incoming->frames.push_back (value_);
+
+    if (incomplete_)
+        return true;
+    return publish ();
+}
+
+bool zmq::ypipe_conflate_topics_t::publish ()
+{
+    reclaim ();
+
+    msg_t &first = incoming->frames.front ();
+
+    slot_t *slot;
+    if (first.is_delimiter () || first.is_routing_id ()
+        || first.is_credential ()) {
+        slot = new (std::nothrow) slot_t;
+        alloc_assert (slot);
+        slot->transient = true;
+        slot->queued = 0;
+    } else {
+        unsigned char *data = static_cast<unsigned char *> (first.data ());
+        const blob_t topic (data, first.size (), reference_tag_t ());
+        const slots_t::iterator it = slots.find (topic);
+        if (it != slots.end ()) {
+            slot = it->second;
+            if (slot->queued == 0)
+                unlink_idle (slot);
+        } else {
+            slot = new (std::nothrow) slot_t;
+            alloc_assert (slot);
+            slot->transient = false;
+            slot->queued = 0;
+            slot->position =
+              slots
+                .ZMQ_MAP_INSERT_OR_EMPLACE (blob_t (data, first.size ()), slot)
+                .first;
+        }
+    }
+
+    incoming->slot = slot;
+    message_t *previous = slot->message.xchg (incoming);
+    incoming = NULL;
+
+    //  If the pending message of the topic was not read yet, it is replaced
+    //  in place and the slot is queued already. The replaced message is
+    //  reused for the next one.
+    if (previous) {
+        for (size_t i = 0; i != previous->frames.size (); i++) {
+            const int rc = previous->frames[i].close ();
+            errno_assert (rc == 0);
+        }
+        previous->frames.clear ();
+        incoming = previous;
+        return false;
+    }
+
+    slot->queued++;
+    queue.write (slot, false);
+    return true;
+}
+
+void zmq::ypipe_conflate_topics_t::reclaim ()
+{
+    message_t *message = handbacks.xchg (NULL);
+    while (message) {
+        message_t *next = message->next;
+        slot_t *slot = message->slot;
+        recycle (message);
+        if (slot->transient) {
+            LIBZMQ_DELETE (slot);
+        } else if (--slot->queued == 0)
+            make_idle (slot);
+        message = next;
+    }
+}
+
+void zmq::ypipe_conflate_topics_t::recycle (message_t *message_)
+{
+    //  The frames were handed over to the reader, they are not closed.
+    message_->frames.clear ();
+    if (spare.size () < conflate_topics_cache_size)
+        spare.push_back (message_);
+    else {
+        LIBZMQ_DELETE (message_);
+    }
+}
+
+void zmq::ypipe_conflate_topics_t::make_idle (slot_t *slot_)
+{
+    slot_->prev = idle_tail;
+    slot_->next = NULL;
+    if (idle_tail)
+        idle_tail->next = slot_;
+    else
+        idle_head = slot_;
+    idle_tail = slot_;
+
+    if (++idle_count > conflate_topics_cache_size) {
+        slot_t *oldest = idle_head;
+        unlink_idle (oldest);
+        slots.erase (oldest->position);
+        LIBZMQ_DELETE (oldest);
+    }
+}
+
+void zmq::ypipe_conflate_topics_t::unlink_idle (slot_t *slot_)
+{
+    if (slot_->prev)
+        slot_->prev->next = slot_->next;
+    else
+        idle_head = slot_->next;
+    if (slot_->next)
+        slot_->next->prev = slot_->prev;
+    else
+        idle_tail = slot_->prev;
+    idle_count--;
+}
+
+bool zmq::ypipe_conflate_topics_t::unwrite (msg_t *value_)
+{
+    if (!incoming || incoming->frames.empty ())
+        return false;
+
+    *value_ = incoming->frames.back ();
+    incoming->frames.pop_back ();
+    return true;
+}
+
+bool zmq::ypipe_conflate_topics_t::flush ()
+{
+    return queue.flush ();
+}
+
+bool zmq::ypipe_conflate_topics_t::check_read ()
+{
+    if (current)
+        return true;
+
+    slot_t *slot;
+    if (!queue.read (&slot))
+        return false;
+
+    //  Only the reader empties the slots, so a queued slot is never empty.
+    current = slot->message.xchg (NULL);
+    zmq_assert (current);
+    current_frame = 0;
+    return true;
+}
+
+bool zmq::ypipe_conflate_topics_t::read (msg_t *value_)
+{
+    if (!check_read ())
+        return false;
+
+    *value_ = current->frames[current_frame++];
+    if (current_frame == current->frames.size ()) {
+        //  Hand the message back to the writer. The writer only ever takes
+        //  all the messages at once, so pushing them is free of ABA issues.
+        message_t *head = NULL;
+        while (true) {
+            current->next = head;
+            message_t *const old = handbacks.cas (head, current);
+            if (old == head)
+                break;
+            head = old;
+        }
+        current = NULL;
+    }
+    return true;
+}
+
+bool zmq::ypipe_conflate_topics_t::probe (bool (*fn) (const msg_t &))
+{
+    return (*fn) (current->frames[current_frame]);
+}
@@ -0,0 +1,177 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_YPIPE_CONFLATE_TOPICS_HPP_INCLUDED__
+#define __ZMQ_YPIPE_CONFLATE_TOPICS_HPP_INCLUDED__
+
+#include <map>
+#include <vector>
+
+#include "atomic_ptr.hpp"
+#include "blob.hpp"
+#include "config.hpp"
+#include "msg.hpp"
+#include "ypipe.hpp"
+#include "ypipe_base.hpp"
+
+namespace zmq
+{
+//  Pipe keeping only the most recently arrived message of each topic,
+//  the topic being the content of the first frame of the message. It is
+//  plugged in instead of a queue to implement the ZMQ_CONFLATE_TOPICS
+//  socket option. Messages may have several frames; a message replaces
+//  the pending message of its topic, if any, as a whole, otherwise it is
+//  read after the pending messages of the other topics.
+//
+//  Each topic has a slot holding its pending message. The writer hands
+//  messages over by exchanging them with the content of the slot; when
+//  the slot was empty it also queues the slot to the reader through a
+//  ypipe, which provides the reader asleep behaviour of the usual pipe.
+//  The reader empties the slots in the order they were queued, and hands
+//  each message back to the writer once it is read, so that the writer
+//  can reuse it and learns which slots are no longer queued.
+//
+//  Messages which are not data (delimiters, routing ids and credentials)
+//  are never conflated, they are queued in slots of their own.
+//
+//  The writer keeps the slots of the topics while they are queued, and
+//  up to conflate_topics_cache_size idle ones, evicting the one idle for
+//  the longest time. The number of topics with a pending message is
+//  bound by the high water mark of the pipe.
+
+class ypipe_conflate_topics_t : public ypipe_base_t<msg_t>
+{
+  public:
+    ypipe_conflate_topics_t ();
+    ~ypipe_conflate_topics_t ();
+
+    bool write (const msg_t &value_, bool incomplete_);
+    bool unwrite (msg_t *value_);
+
+    //  Returns false if the reader thread is sleeping. In that case,
+    //  caller is obliged to wake the reader up before using the pipe again.
+    bool flush ();
+
+    bool check_read ();
+    bool read (msg_t *value_);
+    bool probe (bool (*fn) (const msg_t &));
+
+  private:
+    struct slot_t;
+
+    //  Slots of the topics, indexed by topic.
+    typedef std::map<blob_t, slot_t *> slots_t;
+
+    struct message_t
+    {
+        std::vector<msg_t> frames;
+
+        //  Slot the message was handed over through.
+        slot_t *slot;
+
+        //  Next message handed back by the reader.
+        message_t *next;
+    };
+
+    struct slot_t
+    {
+        //  Pending message, NULL once read.
+        atomic_ptr_t<message_t> message;
+
+        //  If true, the slot holds a single message which is not to be
+        //  conflated and the slot is deallocated once the message is
+        //  handed back. Owned by the writer, as all the following members.
+        bool transient;
+
+        //  Number of times the slot was queued and its message not handed
+        //  back yet. The slot is idle once it drops to zero.
+        int queued;
+
+        //  Position of the slot in the slots of the topics.
+        slots_t::iterator position;
+
+        //  Neighbours in the list of idle slots.
+        slot_t *prev;
+        slot_t *next;
+    };
+
+    //  Closes the frames of the message and deallocates it.
+    static void destroy (message_t *message_);
+
+    //  Hands the message written over to the reader. Returns false if it
+    //  replaced the pending message of its topic.
+    bool publish ();
+
+    //  Takes back the messages the reader is done with.
+    void reclaim ();
+
+    //  Keeps the message read for reuse if there are not enough spare
+    //  ones yet, deallocates it otherwise.
+    void recycle (message_t *message_);
+
+    //  Appends the slot to the list of idle slots, evicting the oldest
+    //  one if there are too many.
+    void make_idle (slot_t *slot_);
+
+    //  Removes the slot from the list of idle slots.
+    void unlink_idle (slot_t *slot_);
+
+    //  Message being written. Owned by the writer.
+    message_t *incoming;
+
+    //  Slots of the topics. Owned by the writer.
+    slots_t slots;
+
+    //  Idle slots, from the oldest to the most recently handed back.
+    //  Owned by the writer.
+    slot_t *idle_head;
+    slot_t *idle_tail;
+    size_t idle_count;
+
+    //  Messages ready to be reused. Owned by the writer.
+    std::vector<message_t *> spare;
+
+    //  Slots with a pending message, in the order they got it.
+    ypipe_t<slot_t *, message_pipe_granularity> queue;
+
+    //  Messages the reader is done with, the last handed back first.
+    atomic_ptr_t<message_t> handbacks;
+
+    //  Message being read and the index of its next frame. Owned by the
+    //  reader.
+    message_t *current;
+    size_t current_frame;
+
+    //  Disable copying of ypipe object.
+    ypipe_conflate_topics_t (const ypipe_conflate_topics_t &);
+    const ypipe_conflate_topics_t &operator= (const ypipe_conflate_topics_t &);
+};
+}
+
+#endif
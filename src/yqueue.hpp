@@ -34,7 +34,9 @@
 #include <stddef.h>
 
 #include "err.hpp"
+#include "stdint.hpp"
 #include "atomic_ptr.hpp"
+#include "allocator.hpp"
 
 namespace zmq
 {
@@ -62,8 +64,9 @@ template <typename T, int N> class yqueue_t
 #endif
 {
   public:
-    //  Create the queue.
-    inline yqueue_t ()
+    //  Create the queue. Its chunks are taken from the given allocator.
+    inline explicit yqueue_t (const allocator_t &allocator_ = allocator_t ()) :
+        allocator (allocator_)
     {
         begin_chunk = allocate_chunk ();
         alloc_assert (begin_chunk);
@@ -79,16 +82,16 @@ template <typename T, int N> class yqueue_t
     {
         while (true) {
             if (begin_chunk == end_chunk) {
-                free (begin_chunk);
+                deallocate_chunk (begin_chunk);
                 break;
             }
             chunk_t *o = begin_chunk;
             begin_chunk = begin_chunk->next;
-            free (o);
+            deallocate_chunk (o);
         }
 
         chunk_t *sc = spare_chunk.xchg (NULL);
-        free (sc);
+        deallocate_chunk (sc);
     }
 
     //  Returns reference to the front element of the queue.
@@ -147,7 +150,7 @@ template <typename T, int N> class yqueue_t
         else {
             end_pos = N - 1;
             end_chunk = end_chunk->prev;
-            free (end_chunk->next);
+            deallocate_chunk (end_chunk->next);
             end_chunk->next = NULL;
         }
     }
@@ -165,7 +168,7 @@ template <typename T, int N> class yqueue_t
             //  so for cache reasons we'll get rid of the spare and
             //  use 'o' as the spare.
             chunk_t *cs = spare_chunk.xchg (o);
-            free (cs);
+            deallocate_chunk (cs);
         }
     }
 
@@ -178,8 +181,42 @@ template <typename T, int N> class yqueue_t
         chunk_t *next;
     };
 
+    //  Custom allocators only guarantee malloc alignment, so their chunks
+    //  are over-allocated and aligned by hand to ALIGN (64 bytes when
+    //  posix_memalign is not available). The pointer returned by the
+    //  allocator is stored right in front of the aligned chunk.
+    enum
+    {
+#ifdef HAVE_POSIX_MEMALIGN
+        custom_chunk_align = ALIGN,
+#else
+        custom_chunk_align = 64,
+#endif
+        custom_chunk_size =
+          sizeof (chunk_t) + custom_chunk_align + sizeof (void *)
+    };
+
+    inline chunk_t *allocate_custom_chunk ()
+    {
+        void *raw = allocator.allocate (custom_chunk_size);
+        if (!raw)
+            return NULL;
+        uintptr_t pos = (uintptr_t) raw + sizeof (void *);
+        pos = (pos + custom_chunk_align - 1)
+              & ~((uintptr_t) custom_chunk_align - 1);
+        ((void **) pos)[-1] = raw;
+        return (chunk_t *) pos;
+    }
+
+    inline void deallocate_custom_chunk (chunk_t *chunk_)
+    {
+        allocator.deallocate (((void **) chunk_)[-1], custom_chunk_size);
+    }
+
     inline chunk_t *allocate_chunk ()
     {
+        if (!allocator.is_default ())
+            return allocate_custom_chunk ();
 #ifdef HAVE_POSIX_MEMALIGN
         void *pv;
         if (posix_memalign (&pv, ALIGN, sizeof (chunk_t)) == 0)
@@ -190,6 +227,19 @@ template <typename T, int N> class yqueue_t
 #endif
     }
 
+    inline void deallocate_chunk (chunk_t *chunk_)
+    {
+        if (!chunk_)
+            return;
+        if (!allocator.is_default ())
+            deallocate_custom_chunk (chunk_);
+        else
+            free (chunk_);
+    }
+
+    //  Allocator the chunks are taken from.
+    const allocator_t allocator;
+
     //  Back position may point to invalid memory if the queue is empty,
     //  while begin & end positions are always valid. Begin position is
     //  accessed exclusively be queue reader (front/pop), while back and
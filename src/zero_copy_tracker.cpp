@@ -0,0 +1,190 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "precompiled.hpp"
+#include "macros.hpp"
+
+#ifndef ZMQ_HAVE_WINDOWS
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+
+#include "zero_copy_tracker.hpp"
+#include "config.hpp"
+#include "err.hpp"
+#include "tcp.hpp"
+
+zmq::zero_copy_tracker_t::zero_copy_tracker_t () :
+    writes (0),
+    s (retired_fd),
+    handle (static_cast<handle_t> (NULL))
+{
+}
+
+zmq::zero_copy_tracker_t::~zero_copy_tracker_t ()
+{
+    zmq_assert (s == retired_fd);
+
+    for (retained_msgs_t::iterator it = retained.begin ();
+         it != retained.end (); ++it) {
+        const int rc = it->msg.close ();
+        errno_assert (rc == 0);
+    }
+}
+
+bool zmq::zero_copy_tracker_t::busy () const
+{
+    return !retained.empty ();
+}
+
+void zmq::zero_copy_tracker_t::retain (msg_t &msg_)
+{
+    retained_msg_t retained_msg;
+    int rc = retained_msg.msg.init ();
+    errno_assert (rc == 0);
+    rc = retained_msg.msg.copy (msg_);
+    errno_assert (rc == 0);
+    retained_msg.first_write = writes;
+    retained_msg.last_write = writes;
+    retained_msg.completed = 0;
+    retained.push_back (retained_msg);
+}
+
+void zmq::zero_copy_tracker_t::add_write ()
+{
+    zmq_assert (!retained.empty ());
+    retained.back ().last_write = writes++;
+}
+
+bool zmq::zero_copy_tracker_t::reap (fd_t s_)
+{
+    bool reaped = false;
+    uint32_t first;
+    uint32_t last;
+    while (tcp_read_zero_copy_completion (s_, &first, &last) == 0) {
+        reaped = true;
+        if (retained.empty ())
+            continue;
+
+        //  Sequence numbers wrap around, so they are compared as offsets
+        //  from the oldest write still referring to a retained message.
+        const uint32_t base = retained.front ().first_write;
+        const uint32_t lo = first - base;
+        const uint32_t hi = last - base;
+        for (retained_msgs_t::iterator it = retained.begin ();
+             it != retained.end (); ++it) {
+            const uint32_t msg_lo = it->first_write - base;
+            const uint32_t msg_hi = it->last_write - base;
+            if (msg_lo > hi)
+                break;
+            if (msg_hi >= lo)
+                it->completed +=
+                  std::min (msg_hi, hi) - std::max (msg_lo, lo) + 1;
+        }
+    }
+
+    //  Completions may be reported out of order, but the messages are
+    //  released in order.
+    while (!retained.empty ()) {
+        retained_msg_t &oldest = retained.front ();
+        if (oldest.completed != oldest.last_write - oldest.first_write + 1)
+            break;
+        const int rc = oldest.msg.close ();
+        errno_assert (rc == 0);
+        retained.pop_front ();
+    }
+    return reaped;
+}
+
+void zmq::zero_copy_tracker_t::linger (fd_t s_)
+{
+    zmq_assert (busy ());
+    zmq_assert (s == retired_fd);
+    s = s_;
+
+    //  Completions are reported as errors on the socket, which are polled
+    //  for even with an empty interest set.
+    handle = add_fd (s);
+    add_timer (zero_copy_linger, linger_timer_id);
+}
+
+void zmq::zero_copy_tracker_t::in_event ()
+{
+    //  An event that is not a completion means the socket failed or the
+    //  peer is gone, so there is no point in waiting any further.
+    const bool reaped = reap (s);
+    if (!busy () || !reaped) {
+        cancel_timer (linger_timer_id);
+        finish (busy ());
+    }
+}
+
+void zmq::zero_copy_tracker_t::timer_event (int id_)
+{
+    zmq_assert (id_ == linger_timer_id);
+    reap (s);
+    finish (busy ());
+}
+
+void zmq::zero_copy_tracker_t::finish (bool reset_)
+{
+    rm_fd (handle);
+
+    //  Resetting the connection discards the data the kernel holds for it,
+    //  so that it can't send them from the buffers released below.
+    if (reset_) {
+        const struct linger so_linger = {1, 0};
+        const int rc = setsockopt (s, SOL_SOCKET, SO_LINGER,
+                                   (const char *) &so_linger, sizeof so_linger);
+#ifdef ZMQ_HAVE_WINDOWS
+        wsa_assert (rc != SOCKET_ERROR);
+#else
+        errno_assert (rc == 0);
+#endif
+    }
+
+#ifdef ZMQ_HAVE_WINDOWS
+    const int rc = closesocket (s);
+    wsa_assert (rc != SOCKET_ERROR);
+#else
+    int rc = close (s);
+#if defined(__FreeBSD_kernel__) || defined(__FreeBSD__)
+    // FreeBSD may return ECONNRESET on close() under load but this is not
+    // an error.
+    if (rc == -1 && errno == ECONNRESET)
+        rc = 0;
+#endif
+    errno_assert (rc == 0);
+#endif
+    s = retired_fd;
+
+    delete this;
+}
@@ -0,0 +1,114 @@
+/*
+    Copyright (c) 2007-2016 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef __ZMQ_ZERO_COPY_TRACKER_HPP_INCLUDED__
+#define __ZMQ_ZERO_COPY_TRACKER_HPP_INCLUDED__
+
+#include <deque>
+
+#include "fd.hpp"
+#include "io_object.hpp"
+#include "msg.hpp"
+#include "stdint.hpp"
+
+namespace zmq
+{
+class io_thread_t;
+
+//  Keeps the messages written to a TCP socket using zero-copy writes alive
+//  until the kernel is done with them. If the engine owning the socket
+//  goes away while some of the writes are still in flight, the tracker
+//  takes the socket over and stays in the I/O thread until they complete.
+
+class zero_copy_tracker_t : public io_object_t
+{
+  public:
+    zero_copy_tracker_t ();
+    ~zero_copy_tracker_t ();
+
+    //  Returns true if any zero-copy write is still in flight.
+    bool busy () const;
+
+    //  Takes a reference to the message whose content is to be written.
+    void retain (msg_t &msg_);
+
+    //  Records a zero-copy write of the content of the message retained
+    //  last.
+    void add_write ();
+
+    //  Releases the messages whose writes are all completed. Returns true
+    //  if the socket reported any completion.
+    bool reap (fd_t s_);
+
+    //  Takes the socket over from its engine. The tracker must be plugged
+    //  into the engine's I/O thread and busy. Once all the writes complete,
+    //  the socket is closed and the tracker deallocates itself. If they
+    //  don't complete in time, the connection is reset.
+    void linger (fd_t s_);
+
+  private:
+    //  i_poll_events interface implementation.
+    void in_event ();
+    void timer_event (int id_);
+
+    //  Closes the socket, resetting the connection if reset_ is true,
+    //  and deallocates the tracker.
+    void finish (bool reset_);
+
+    enum
+    {
+        linger_timer_id = 0x50
+    };
+
+    //  Messages retained until the kernel is done with the zero-copy writes
+    //  referring to them, oldest first. Each one is referred to by a range
+    //  of writes, of which a number were reported as completed.
+    struct retained_msg_t
+    {
+        msg_t msg;
+        uint32_t first_write;
+        uint32_t last_write;
+        uint32_t completed;
+    };
+    typedef std::deque<retained_msg_t> retained_msgs_t;
+    retained_msgs_t retained;
+
+    //  Sequence number of the next zero-copy write.
+    uint32_t writes;
+
+    //  The socket taken over from the engine, if any.
+    fd_t s;
+    handle_t handle;
+
+    zero_copy_tracker_t (const zero_copy_tracker_t &);
+    const zero_copy_tracker_t &operator= (const zero_copy_tracker_t &);
+};
+}
+
+#endif
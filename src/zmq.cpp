@@ -188,6 +188,25 @@ int zmq_ctx_get (void *ctx_, int option_)
     return ((zmq::ctx_t *) ctx_)->get (option_);
 }
 
+int zmq_ctx_set_allocator (void *ctx_, const zmq_allocator_t *allocator_)
+{
+    if (!ctx_ || !((zmq::ctx_t *) ctx_)->check_tag ()) {
+        errno = EFAULT;
+        return -1;
+    }
+    if (!allocator_) {
+        ((zmq::ctx_t *) ctx_)->set_allocator (zmq::allocator_t ());
+        return 0;
+    }
+    if (!allocator_->allocate || !allocator_->deallocate) {
+        errno = EINVAL;
+        return -1;
+    }
+    ((zmq::ctx_t *) ctx_)->set_allocator (zmq::allocator_t (
+      allocator_->allocate, allocator_->deallocate, allocator_->hint));
+    return 0;
+}
+
 //  Stable/legacy context API
 
 void *zmq_init (int io_threads_)
@@ -436,6 +455,98 @@ int zmq_sendiov (void *s_, iovec *a_, size_t count_, int flags_)
     return rc;
 }
 
+// Send multiple messages without copying them.
+//
+// As with zmq_sendiov, if flag bit ZMQ_SNDMORE is set the vector is
+// treated as a single multi-part message.
+//
+// Parts too large to be stored in the message itself are sent by
+// reference; once they are no longer needed, ffn_ is called with their
+// iov_base and hint_, possibly from another thread and after the function
+// returns. Smaller parts are copied and ffn_ is called for them straight
+// away. If ffn_ is NULL the parts are deemed constant and never released.
+// Unless the arguments are invalid, all the parts are released this way,
+// whether they could be sent or not.
+// Returns number of messages sent, or -1 on error.
+//
+int zmq_sendiov_ref (void *s_,
+                     iovec *a_,
+                     size_t count_,
+                     int flags_,
+                     zmq_free_fn *ffn_,
+                     void *hint_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    if (unlikely (count_ <= 0 || !a_)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    int rc = 0;
+    size_t i = 0;
+    while (i < count_) {
+        zmq_msg_t msg;
+        if (a_[i].iov_len <= zmq::msg_t::max_vsm_size) {
+            rc = zmq_msg_init_size (&msg, a_[i].iov_len);
+            errno_assert (rc == 0);
+            memcpy (zmq_msg_data (&msg), a_[i].iov_base, a_[i].iov_len);
+            if (ffn_)
+                ffn_ (a_[i].iov_base, hint_);
+        } else {
+            rc = zmq_msg_init_data (&msg, a_[i].iov_base, a_[i].iov_len, ffn_,
+                                    hint_);
+            if (unlikely (rc != 0))
+                break;
+        }
+        //  From now on the part is released along with the message.
+        i++;
+
+        if (i == count_)
+            flags_ = flags_ & ~ZMQ_SNDMORE;
+        rc = s_sendmsg (s, &msg, flags_);
+        if (unlikely (rc < 0)) {
+            int err = errno;
+            int rc2 = zmq_msg_close (&msg);
+            errno_assert (rc2 == 0);
+            errno = err;
+            break;
+        }
+    }
+
+    if (unlikely (rc < 0)) {
+        //  Release the parts that were not handed over.
+        int err = errno;
+        if (ffn_)
+            for (; i < count_; ++i)
+                ffn_ (a_[i].iov_base, hint_);
+        errno = err;
+        return -1;
+    }
+    return static_cast<int> (count_);
+}
+
+// Send a batch of messages.
+//
+// Sends up to count_ messages from the msgs_ array in a single call, so
+// that command processing and flushing of the underlying pipes is done
+// once per batch rather than once per message.
+// If flag bit ZMQ_SNDMORE is set the array is treated as a single
+// multi-part message, i.e. the last message has ZMQ_SNDMORE bit
+// switched off.
+// Returns number of messages sent, or -1 if no message was sent.
+// As with zmq_msg_send, the messages sent are emptied, the rest of the
+// array is left untouched.
+//
+int zmq_sendmmsg (void *s_, zmq_msg_t *msgs_, size_t count_, int flags_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    return s->send_batch ((zmq::msg_t *) msgs_, count_, flags_);
+}
+
 // Receiving functions.
 
 static int s_recvmsg (zmq::socket_base_t *s_, zmq_msg_t *msg_, int flags_)
@@ -554,6 +665,86 @@ int zmq_recviov (void *s_, iovec *a_, size_t *count_, int flags_)
     return nread;
 }
 
+// Receive a multi-part message without copying its parts.
+//
+// Works as zmq_recviov, except that the parts are received into the
+// msgs_ array, which must hold initialised messages, and that the iovecs
+// point to the content of these messages rather than to copies of it.
+// The iovecs are valid until the messages are released with
+// zmq_recviov_release, and the messages must not be moved in between.
+//
+int zmq_recviov_ref (
+  void *s_, iovec *a_, zmq_msg_t *msgs_, size_t *count_, int flags_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    if (unlikely (!count_ || *count_ <= 0 || !a_ || !msgs_)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    size_t count = *count_;
+    int nread = 0;
+    bool recvmore = true;
+
+    *count_ = 0;
+
+    for (size_t i = 0; recvmore && i < count; ++i) {
+        int nbytes = s_recvmsg (s, &msgs_[i], flags_);
+        if (unlikely (nbytes < 0)) {
+            nread = -1;
+            break;
+        }
+
+        a_[i].iov_base = zmq_msg_data (&msgs_[i]);
+        a_[i].iov_len = zmq_msg_size (&msgs_[i]);
+        recvmore = zmq_msg_more (&msgs_[i]) != 0;
+        ++*count_;
+        ++nread;
+    }
+    return nread;
+}
+
+// Release the parts of a multi-part message received by zmq_recviov_ref.
+//
+// The messages are left initialised and empty, so that they can be used
+// to receive the next message.
+//
+int zmq_recviov_release (zmq_msg_t *msgs_, size_t count_)
+{
+    if (unlikely (count_ > 0 && !msgs_)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    for (size_t i = 0; i < count_; ++i) {
+        int rc = zmq_msg_close (&msgs_[i]);
+        if (unlikely (rc != 0))
+            return -1;
+        rc = zmq_msg_init (&msgs_[i]);
+        errno_assert (rc == 0);
+    }
+    return 0;
+}
+
+// Receive a batch of messages.
+//
+// Receives up to count_ messages into the msgs_ array, which must hold
+// initialised messages. Blocks (unless ZMQ_DONTWAIT is set) only until
+// the first message is available, then returns all the messages that
+// can be received without blocking. Message boundaries are preserved,
+// ZMQ_RCVMORE reflects the last message received.
+// Returns number of messages received, or -1 on error.
+//
+int zmq_recvmmsg (void *s_, zmq_msg_t *msgs_, size_t count_, int flags_)
+{
+    zmq::socket_base_t *s = as_socket_base_t (s_);
+    if (!s)
+        return -1;
+    return s->recv_batch ((zmq::msg_t *) msgs_, count_, flags_);
+}
+
 // Message manipulators.
 
 int zmq_msg_init (zmq_msg_t *msg_)
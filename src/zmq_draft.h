@@ -57,6 +57,25 @@ unsigned long zmq_stopwatch_intermediate (void *watch_);
 #define ZMQ_ZAP_ENFORCE_DOMAIN 93
 #define ZMQ_LOOPBACK_FASTPATH 94
 #define ZMQ_METADATA 95
+#define ZMQ_COUNTERS 96
+#define ZMQ_PIPE_COUNTERS 97
+#define ZMQ_COUNTERS_IVL 98
+#define ZMQ_ZERO_COPY_SEND 99
+#define ZMQ_EXACT_TOPICS 100
+#define ZMQ_TCP_LISTENERS 101
+#define ZMQ_LB_STRATEGY 102
+#define ZMQ_LB_WEIGHT 103
+#define ZMQ_LB_KEY_OFFSET 104
+#define ZMQ_LB_KEY_SIZE 105
+#define ZMQ_FQ_BATCH 106
+#define ZMQ_CONFLATE_TOPICS 107
+
+/*  DRAFT Load balancing strategies, see ZMQ_LB_STRATEGY.                     */
+#define ZMQ_LB_ROUND_ROBIN 0
+#define ZMQ_LB_SHORTEST_QUEUE 1
+#define ZMQ_LB_POWER_OF_TWO 2
+#define ZMQ_LB_WEIGHTED 3
+#define ZMQ_LB_CONSISTENT_HASH 4
 
 /*  DRAFT 0MQ socket events and monitoring                                    */
 /*  Unspecified system errors during handshake. Event value is an errno.      */
@@ -70,6 +89,10 @@ unsigned long zmq_stopwatch_intermediate (void *watch_);
 /*  Failed authentication requests. Event value is the numeric ZAP status     *
  *  code, i.e. 300, 400 or 500.                                               */
 #define ZMQ_EVENT_HANDSHAKE_FAILED_AUTH 0x4000
+/*  Periodic counters snapshot, see ZMQ_COUNTERS_IVL. Event value is the      *
+ *  number of pipes, the address frame carries a zmq_counters_t followed by   *
+ *  that many zmq_pipe_counters_t.                                            */
+#define ZMQ_EVENT_COUNTERS 0x8000
 
 #define ZMQ_PROTOCOL_ERROR_ZMTP_UNSPECIFIED 0x10000000
 #define ZMQ_PROTOCOL_ERROR_ZMTP_UNEXPECTED_COMMAND 0x10000001
@@ -101,10 +124,59 @@ unsigned long zmq_stopwatch_intermediate (void *watch_);
 #define ZMQ_THREAD_AFFINITY_CPU_REMOVE 8
 #define ZMQ_THREAD_NAME_PREFIX 9
 #define ZMQ_ZERO_COPY_RECV 10
+#define ZMQ_BUSY_POLL 11
+#define ZMQ_MSG_SLAB 12
+#define ZMQ_DNS_CACHE_TTL 13
+
+/*  DRAFT Context memory allocator, see zmq_ctx_set_allocator.                */
+typedef struct zmq_allocator_t
+{
+    void *(*allocate) (size_t size, void *hint);
+    void (*deallocate) (void *data, size_t size, void *hint);
+    void *hint;
+} zmq_allocator_t;
+
+/*  DRAFT Context methods.                                                    */
+int zmq_ctx_set_allocator (void *context, const zmq_allocator_t *allocator);
+
+/*  DRAFT Socket counters, see ZMQ_COUNTERS and ZMQ_PIPE_COUNTERS.            */
+typedef struct zmq_counters_t
+{
+    uint64_t msgs_in;
+    uint64_t bytes_in;
+    uint64_t msgs_out;
+    uint64_t bytes_out;
+    uint64_t msgs_dropped;
+    uint64_t activations;
+    uint64_t batched_activations;
+    uint64_t pipes;
+} zmq_counters_t;
+
+typedef struct zmq_pipe_counters_t
+{
+    uint64_t msgs_in;
+    uint64_t msgs_out;
+    uint64_t msgs_queued;
+    uint64_t msgs_dropped;
+    uint64_t activations;
+    uint8_t routing_id_size;
+    uint8_t routing_id[255];
+} zmq_pipe_counters_t;
 
 /*  DRAFT Socket methods.                                                     */
 int zmq_join (void *s, const char *group);
 int zmq_leave (void *s, const char *group);
+int zmq_sendmmsg (void *s, zmq_msg_t *msgs, size_t count, int flags);
+int zmq_recvmmsg (void *s, zmq_msg_t *msgs, size_t count, int flags);
+int zmq_sendiov_ref (void *s,
+                     struct iovec *iov,
+                     size_t count,
+                     int flags,
+                     zmq_free_fn *ffn,
+                     void *hint);
+int zmq_recviov_ref (
+  void *s, struct iovec *iov, zmq_msg_t *msgs, size_t *count, int flags);
+int zmq_recviov_release (zmq_msg_t *msgs, size_t count);
 
 /*  DRAFT Msg methods.                                                        */
 int zmq_msg_set_routing_id (zmq_msg_t *msg, uint32_t routing_id);
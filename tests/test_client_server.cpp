@@ -32,6 +32,8 @@
 
 #include <unity.h>
 
+#include <set>
+
 void setUp ()
 {
     setup_test_context ();
@@ -133,6 +135,101 @@ void test_routing_id ()
     test_context_socket_close (client);
 }
 
+static uint32_t recv_routing_id (void *server)
+{
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, server, 0));
+    const uint32_t routing_id = zmq_msg_routing_id (&msg);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+    return routing_id;
+}
+
+static int send_to (void *server, uint32_t routing_id)
+{
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msg, 1));
+    *(char *) zmq_msg_data (&msg) = 'Y';
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_set_routing_id (&msg, routing_id));
+    const int rc = zmq_msg_send (&msg, server, ZMQ_DONTWAIT);
+    if (rc == -1)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+    return rc;
+}
+
+void test_stale_routing_id ()
+{
+    void *server, *client;
+    create_inproc_client_server_pair (&server, &client);
+
+    send_string_expect_success (client, "X", 0);
+    const uint32_t old_routing_id = recv_routing_id (server);
+    test_context_socket_close (client);
+
+    //  Wait for the server to notice the disconnection, which it does
+    //  when it reads the end of the inbound stream of the peer.
+    while (send_to (server, old_routing_id) == 1 || errno == EAGAIN) {
+        char buffer[1];
+        TEST_ASSERT_FAILURE_ERRNO (
+          EAGAIN, zmq_recv (server, buffer, sizeof (buffer), ZMQ_DONTWAIT));
+        msleep (SETTLE_TIME / 10);
+    }
+    TEST_ASSERT_EQUAL_INT (EHOSTUNREACH, errno);
+
+    //  The ID of the disconnected peer is not handed out to its successor.
+    client = test_context_socket (ZMQ_CLIENT);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_connect (client, "inproc://test-client-server"));
+    send_string_expect_success (client, "X", 0);
+    const uint32_t routing_id = recv_routing_id (server);
+    TEST_ASSERT_NOT_EQUAL (0, routing_id);
+    TEST_ASSERT_NOT_EQUAL (old_routing_id, routing_id);
+
+    TEST_ASSERT_EQUAL_INT (-1, send_to (server, old_routing_id));
+    TEST_ASSERT_EQUAL_INT (EHOSTUNREACH, errno);
+    TEST_ASSERT_EQUAL_INT (1, send_to (server, routing_id));
+    recv_string_expect_success (client, "Y", 0);
+
+    test_context_socket_close (server);
+    test_context_socket_close (client);
+}
+
+//  A peer reconnecting over and over keeps getting the same slot, yet its
+//  IDs do not repeat once all the generations of the slot were used.
+//  TCP is used, so that the closed peers are torn down by their sessions.
+void test_routing_id_reuse ()
+{
+    void *server = test_context_socket (ZMQ_SERVER);
+    char endpoint[MAX_SOCKET_STRING];
+    size_t len = sizeof endpoint;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (server, "tcp://127.0.0.1:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (server, ZMQ_LAST_ENDPOINT, endpoint, &len));
+
+    std::set<uint32_t> routing_ids;
+    for (int i = 0; i != 4200; i++) {
+        void *client = test_context_socket (ZMQ_CLIENT);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (client, endpoint));
+        send_string_expect_success (client, "X", 0);
+        const uint32_t routing_id = recv_routing_id (server);
+        TEST_ASSERT_TRUE (routing_ids.insert (routing_id).second);
+        test_context_socket_close (client);
+
+        //  Wait for the server to notice the disconnection, so that the
+        //  slot is free when the next peer arrives.
+        while (send_to (server, routing_id) == 1 || errno == EAGAIN) {
+            char buffer[1];
+            TEST_ASSERT_FAILURE_ERRNO (
+              EAGAIN,
+              zmq_recv (server, buffer, sizeof (buffer), ZMQ_DONTWAIT));
+            msleep (0);
+        }
+        TEST_ASSERT_EQUAL_INT (EHOSTUNREACH, errno);
+    }
+
+    test_context_socket_close (server);
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -141,5 +238,7 @@ int main (void)
     RUN_TEST (test_client_sndmore_fails);
     RUN_TEST (test_server_sndmore_fails);
     RUN_TEST (test_routing_id);
+    RUN_TEST (test_stale_routing_id);
+    RUN_TEST (test_routing_id_reuse);
     return UNITY_END ();
 }
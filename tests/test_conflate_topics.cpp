@@ -0,0 +1,273 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+#include <stdio.h>
+#include <string.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+void test_option ()
+{
+    void *sub = test_context_socket (ZMQ_SUB);
+    int conflate = -1;
+    size_t size = sizeof (conflate);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sub, ZMQ_CONFLATE_TOPICS, &conflate, &size));
+    TEST_ASSERT_EQUAL_INT (0, conflate);
+
+    conflate = 2;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_setsockopt (sub, ZMQ_CONFLATE_TOPICS,
+                                               &conflate, sizeof (conflate)));
+
+    conflate = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_CONFLATE_TOPICS,
+                                               &conflate, sizeof (conflate)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sub, ZMQ_CONFLATE_TOPICS, &conflate, &size));
+    TEST_ASSERT_EQUAL_INT (1, conflate);
+
+    test_context_socket_close (sub);
+}
+
+static void send_value (void *pub_, const char *topic_, int value_)
+{
+    char buffer[16];
+    sprintf (buffer, "%d", value_);
+    send_string_expect_success (pub_, topic_, ZMQ_SNDMORE);
+    send_string_expect_success (pub_, buffer, 0);
+}
+
+static void recv_value (void *sub_, const char *topic_, int value_)
+{
+    char buffer[16];
+    sprintf (buffer, "%d", value_);
+    recv_string_expect_success (sub_, topic_, 0);
+    recv_string_expect_success (sub_, buffer, 0);
+}
+
+//  Sends several values of three topics, one of them with messages of three
+//  frames, and checks that only the latest value of each topic is received,
+//  in the order the topics were first sent.
+static void test_latest_values (int sub_type_,
+                                const char *endpoint_,
+                                bool connect_first_)
+{
+    void *pub = test_context_socket (ZMQ_PUB);
+    void *sub = test_context_socket (sub_type_);
+    int conflate = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_CONFLATE_TOPICS,
+                                               &conflate, sizeof (conflate)));
+
+    //  The high water mark limits the number of topics with a pending
+    //  message, not the number of messages. Over TCP, the publisher has its
+    //  own queue, which is not conflated.
+    int hwm = 4;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm)));
+    if (strncmp (endpoint_, "inproc://", 9) != 0) {
+        hwm = 0;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm)));
+    }
+
+    if (sub_type_ == ZMQ_SUB)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+
+    if (connect_first_) {
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, endpoint_));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, endpoint_));
+    } else {
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, endpoint_));
+        char endpoint[MAX_SOCKET_STRING];
+        size_t endpoint_len = sizeof endpoint;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_getsockopt (pub, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, endpoint));
+    }
+    if (sub_type_ == ZMQ_XSUB)
+        send_string_expect_success (sub, "\1", 0);
+    msleep (SETTLE_TIME);
+
+    for (int i = 0; i != 1000; i++) {
+        send_value (pub, "A", i);
+        send_value (pub, "B", i);
+        send_string_expect_success (pub, "C", ZMQ_SNDMORE);
+        send_string_expect_success (pub, "x", ZMQ_SNDMORE);
+        send_string_expect_success (pub, i % 2 ? "odd" : "even", 0);
+    }
+    send_value (pub, "A", 1000);
+    msleep (SETTLE_TIME);
+
+    recv_value (sub, "A", 1000);
+    recv_value (sub, "B", 999);
+    recv_string_expect_success (sub, "C", 0);
+    recv_string_expect_success (sub, "x", 0);
+    recv_string_expect_success (sub, "odd", 0);
+    char buffer[16];
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_recv (sub, buffer, sizeof buffer, ZMQ_DONTWAIT));
+
+    //  Values arriving once the topic was read are received again.
+    send_value (pub, "B", 1000);
+    recv_value (sub, "B", 1000);
+
+    //  Pending messages are dropped when the socket is closed.
+    send_value (pub, "A", 1001);
+    send_value (pub, "D", 0);
+    msleep (SETTLE_TIME);
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+void test_sub_tcp ()
+{
+    test_latest_values (ZMQ_SUB, "tcp://127.0.0.1:*", false);
+}
+
+void test_xsub_tcp ()
+{
+    test_latest_values (ZMQ_XSUB, "tcp://127.0.0.1:*", false);
+}
+
+void test_sub_inproc ()
+{
+    test_latest_values (ZMQ_SUB, "inproc://conflate-topics", false);
+}
+
+void test_sub_inproc_connect_first ()
+{
+    test_latest_values (ZMQ_SUB, "inproc://conflate-topics", true);
+}
+
+//  Connects a SUB socket conflating the messages by topic to an XPUB one
+//  over inproc, and waits for the subscription to arrive.
+static void connect_inproc (void *pub_, void *sub_, const char *endpoint_)
+{
+    int conflate = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub_, ZMQ_CONFLATE_TOPICS,
+                                               &conflate, sizeof (conflate)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub_, ZMQ_SUBSCRIBE, "", 0));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub_, endpoint_));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub_, endpoint_));
+    recv_string_expect_success (pub_, "\1", 0);
+}
+
+//  On inproc connections the high water marks of both ends add up.
+void test_hwm_inproc ()
+{
+    void *pub = test_context_socket (ZMQ_XPUB);
+    void *sub = test_context_socket (ZMQ_SUB);
+    int hwm = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm)));
+    hwm = 2;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm)));
+    connect_inproc (pub, sub, "inproc://conflate-topics-hwm");
+
+    //  Once three topics are pending, the publisher drops the messages,
+    //  including those of the pending topics.
+    const char *topics[] = {"A", "B", "C", "D", "E"};
+    for (int i = 0; i != 5; i++)
+        send_value (pub, topics[i], i);
+    send_value (pub, "A", 5);
+
+    recv_value (sub, "A", 0);
+    recv_value (sub, "B", 1);
+    recv_value (sub, "C", 2);
+    char buffer[16];
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_recv (sub, buffer, sizeof buffer, ZMQ_DONTWAIT));
+
+    //  Receiving the messages makes room for the other topics, once the
+    //  publisher processed the notification.
+    int events;
+    size_t events_size = sizeof (events);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pub, ZMQ_EVENTS, &events, &events_size));
+    send_value (pub, "D", 6);
+    recv_value (sub, "D", 6);
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+//  Topics carrying a sequence number, each sent twice, do not accumulate.
+void test_many_topics_inproc ()
+{
+    void *pub = test_context_socket (ZMQ_XPUB);
+    void *sub = test_context_socket (ZMQ_SUB);
+    int hwm = 0;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof (hwm)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof (hwm)));
+    connect_inproc (pub, sub, "inproc://conflate-topics-many");
+
+    char topic[16];
+    for (int i = 0; i != 10000; i++) {
+        sprintf (topic, "T%d", i);
+        send_value (pub, topic, i);
+        send_value (pub, topic, i + 1);
+        recv_value (sub, topic, i + 1);
+    }
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_sub_tcp);
+    RUN_TEST (test_xsub_tcp);
+    RUN_TEST (test_sub_inproc);
+    RUN_TEST (test_sub_inproc_connect_first);
+    RUN_TEST (test_hwm_inproc);
+    RUN_TEST (test_many_topics_inproc);
+    return UNITY_END ();
+}
@@ -0,0 +1,264 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void get_counters (void *socket_, zmq_counters_t *counters_)
+{
+    size_t size = sizeof *counters_;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket_, ZMQ_COUNTERS, counters_, &size));
+    TEST_ASSERT_EQUAL_INT (sizeof *counters_, size);
+}
+
+void test_counters_messages_and_bytes ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://counters"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://counters"));
+
+    zmq_counters_t counters;
+    get_counters (push, &counters);
+    TEST_ASSERT_EQUAL_UINT64 (0, counters.msgs_out);
+    TEST_ASSERT_EQUAL_UINT64 (0, counters.bytes_out);
+
+    for (int i = 0; i != 10; i++)
+        send_string_expect_success (push, "abcde", 0);
+    //  A multi-part message is counted once, its bytes are all counted.
+    send_string_expect_success (push, "abc", ZMQ_SNDMORE);
+    send_string_expect_success (push, "defg", 0);
+
+    for (int i = 0; i != 10; i++)
+        recv_string_expect_success (pull, "abcde", 0);
+    recv_string_expect_success (pull, "abc", 0);
+    recv_string_expect_success (pull, "defg", 0);
+
+    get_counters (push, &counters);
+    TEST_ASSERT_EQUAL_UINT64 (11, counters.msgs_out);
+    TEST_ASSERT_EQUAL_UINT64 (57, counters.bytes_out);
+    TEST_ASSERT_EQUAL_UINT64 (0, counters.msgs_in);
+    TEST_ASSERT_EQUAL_UINT64 (0, counters.msgs_dropped);
+    TEST_ASSERT_EQUAL_UINT64 (1, counters.pipes);
+
+    get_counters (pull, &counters);
+    TEST_ASSERT_EQUAL_UINT64 (11, counters.msgs_in);
+    TEST_ASSERT_EQUAL_UINT64 (57, counters.bytes_in);
+    TEST_ASSERT_EQUAL_UINT64 (0, counters.msgs_out);
+    TEST_ASSERT_EQUAL_UINT64 (1, counters.pipes);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_pipe_counters ()
+{
+    void *router = test_context_socket (ZMQ_ROUTER);
+    void *dealer = test_context_socket (ZMQ_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (dealer, ZMQ_ROUTING_ID, "X", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (router, "inproc://counters"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (dealer, "inproc://counters"));
+
+    send_string_expect_success (dealer, "hello", 0);
+    recv_string_expect_success (router, "X", 0);
+    recv_string_expect_success (router, "hello", 0);
+
+    //  The buffer must be large enough for all the pipes.
+    zmq_pipe_counters_t pipes[4];
+    size_t size = sizeof pipes[0] / 2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_getsockopt (router, ZMQ_PIPE_COUNTERS, pipes, &size));
+
+    size = sizeof pipes;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (router, ZMQ_PIPE_COUNTERS, pipes, &size));
+    TEST_ASSERT_EQUAL_INT (sizeof pipes[0], size);
+    TEST_ASSERT_EQUAL_UINT64 (1, pipes[0].msgs_in);
+    TEST_ASSERT_EQUAL_UINT64 (0, pipes[0].msgs_out);
+    TEST_ASSERT_EQUAL_INT (1, pipes[0].routing_id_size);
+    TEST_ASSERT_EQUAL_INT ('X', pipes[0].routing_id[0]);
+
+    test_context_socket_close (router);
+    test_context_socket_close (dealer);
+}
+
+void test_counters_drops ()
+{
+    void *pub = test_context_socket (ZMQ_PUB);
+    void *sub = test_context_socket (ZMQ_SUB);
+    int hwm = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://counters"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://counters"));
+
+    //  The subscriber never reads, so the messages beyond HWM are dropped.
+    for (int i = 0; i != 10; i++)
+        send_string_expect_success (pub, "abc", 0);
+
+    zmq_counters_t counters;
+    get_counters (pub, &counters);
+    TEST_ASSERT_EQUAL_UINT64 (10, counters.msgs_out);
+    TEST_ASSERT_GREATER_THAN_INT (0, (int) counters.msgs_dropped);
+
+    zmq_pipe_counters_t pipe;
+    size_t size = sizeof pipe;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pub, ZMQ_PIPE_COUNTERS, &pipe, &size));
+    TEST_ASSERT_EQUAL_UINT64 (counters.msgs_dropped, pipe.msgs_dropped);
+    TEST_ASSERT_EQUAL_UINT64 (10, pipe.msgs_out + pipe.msgs_dropped);
+    TEST_ASSERT_EQUAL_UINT64 (pipe.msgs_out, pipe.msgs_queued);
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+void test_counters_drops_overlapping_subscriptions ()
+{
+    void *pub = test_context_socket (ZMQ_PUB);
+    void *sub = test_context_socket (ZMQ_SUB);
+    int hwm = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pub, ZMQ_SNDHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_RCVHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "a", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "ab", 2));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://counters"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (sub, "inproc://counters"));
+
+    //  Each message matches all three subscriptions of the pipe, yet it is
+    //  either delivered or dropped exactly once.
+    for (int i = 0; i != 10; i++)
+        send_string_expect_success (pub, "abc", 0);
+
+    zmq_pipe_counters_t pipe;
+    size_t size = sizeof pipe;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pub, ZMQ_PIPE_COUNTERS, &pipe, &size));
+    TEST_ASSERT_GREATER_THAN_INT (0, (int) pipe.msgs_dropped);
+    TEST_ASSERT_EQUAL_UINT64 (10, pipe.msgs_out + pipe.msgs_dropped);
+
+    test_context_socket_close (pub);
+    test_context_socket_close (sub);
+}
+
+void test_counters_ivl_invalid ()
+{
+    void *socket = test_context_socket (ZMQ_PUSH);
+    int ivl = -1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (socket, ZMQ_COUNTERS_IVL, &ivl, sizeof ivl));
+    test_context_socket_close (socket);
+}
+
+void test_counters_monitor ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://counters"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://counters"));
+    send_string_expect_success (push, "abc", 0);
+    recv_string_expect_success (pull, "abc", 0);
+
+    int ivl = 10;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_COUNTERS_IVL, &ivl, sizeof ivl));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_socket_monitor (push, "inproc://monitor", ZMQ_EVENT_COUNTERS));
+    void *monitor = test_context_socket (ZMQ_PAIR);
+    int timeout = 1000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (monitor, ZMQ_RCVTIMEO, &timeout, sizeof timeout));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (monitor, "inproc://monitor"));
+
+    //  The counters are published from within the calls on the socket.
+    msleep (2 * ivl);
+    int events;
+    size_t size = sizeof events;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (push, ZMQ_EVENTS, &events, &size));
+
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    TEST_ASSERT_EQUAL_INT (6, TEST_ASSERT_SUCCESS_ERRNO (
+                                zmq_msg_recv (&msg, monitor, 0)));
+    uint16_t event;
+    uint32_t pipes;
+    memcpy (&event, zmq_msg_data (&msg), sizeof event);
+    memcpy (&pipes, (uint8_t *) zmq_msg_data (&msg) + 2, sizeof pipes);
+    TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_COUNTERS, event);
+    TEST_ASSERT_EQUAL_INT (1, pipes);
+    TEST_ASSERT_TRUE (zmq_msg_more (&msg));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, monitor, 0));
+    TEST_ASSERT_EQUAL_INT (sizeof (zmq_counters_t)
+                             + pipes * sizeof (zmq_pipe_counters_t),
+                           zmq_msg_size (&msg));
+    zmq_counters_t counters;
+    memcpy (&counters, zmq_msg_data (&msg), sizeof counters);
+    TEST_ASSERT_EQUAL_UINT64 (1, counters.msgs_out);
+    TEST_ASSERT_EQUAL_UINT64 (3, counters.bytes_out);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+    test_context_socket_close (monitor);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_counters_messages_and_bytes);
+    RUN_TEST (test_pipe_counters);
+    RUN_TEST (test_counters_drops);
+    RUN_TEST (test_counters_drops_overlapping_subscriptions);
+    RUN_TEST (test_counters_ivl_invalid);
+    RUN_TEST (test_counters_monitor);
+    return UNITY_END ();
+}
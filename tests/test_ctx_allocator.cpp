@@ -0,0 +1,229 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <stdlib.h>
+#include <string.h>
+#include <unity.h>
+
+void setUp ()
+{
+}
+
+void tearDown ()
+{
+}
+
+//  Allocator counting the memory allocated from it. Each block starts
+//  with its size, so that the size given back on deallocation is checked.
+struct counting_allocator_t
+{
+    void *allocations;
+    void *deallocations;
+};
+
+static void *counting_allocate (size_t size_, void *hint_)
+{
+    counting_allocator_t *counters = (counting_allocator_t *) hint_;
+    size_t *block = (size_t *) malloc (sizeof (size_t) * 2 + size_);
+    if (!block)
+        return NULL;
+    block[0] = size_;
+    zmq_atomic_counter_inc (counters->allocations);
+    return block + 2;
+}
+
+static void counting_deallocate (void *data_, size_t size_, void *hint_)
+{
+    counting_allocator_t *counters = (counting_allocator_t *) hint_;
+    size_t *block = (size_t *) data_ - 2;
+    TEST_ASSERT_EQUAL_UINT (block[0], size_);
+    zmq_atomic_counter_inc (counters->deallocations);
+    free (block);
+}
+
+static void init_allocator (zmq_allocator_t *allocator_,
+                            counting_allocator_t *counters_)
+{
+    counters_->allocations = zmq_atomic_counter_new ();
+    counters_->deallocations = zmq_atomic_counter_new ();
+    allocator_->allocate = counting_allocate;
+    allocator_->deallocate = counting_deallocate;
+    allocator_->hint = counters_;
+}
+
+static void destroy_allocator (counting_allocator_t *counters_)
+{
+    zmq_atomic_counter_destroy (&counters_->allocations);
+    zmq_atomic_counter_destroy (&counters_->deallocations);
+}
+
+void test_invalid_arguments ()
+{
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+
+    counting_allocator_t counters;
+    zmq_allocator_t allocator;
+    init_allocator (&allocator, &counters);
+
+    allocator.deallocate = NULL;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set_allocator (ctx, &allocator));
+    allocator.deallocate = counting_deallocate;
+    allocator.allocate = NULL;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_ctx_set_allocator (ctx, &allocator));
+    TEST_ASSERT_FAILURE_ERRNO (EFAULT,
+                               zmq_ctx_set_allocator (NULL, &allocator));
+
+    //  Restoring the default allocator always succeeds.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set_allocator (ctx, NULL));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+    destroy_allocator (&counters);
+}
+
+static const int message_count = 100;
+
+//  Passes large messages from a PUSH socket to a PULL socket.
+static void transfer_messages (void *ctx_, const char *endpoint_)
+{
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    TEST_ASSERT_NOT_NULL (pull);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, endpoint_));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t endpoint_len = sizeof (endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    TEST_ASSERT_NOT_NULL (push);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    char buffer[1000];
+    for (int i = 0; i != message_count; i++) {
+        memset (buffer, 'a' + i % 26, sizeof (buffer));
+        TEST_ASSERT_EQUAL_INT (
+          (int) sizeof (buffer),
+          TEST_ASSERT_SUCCESS_ERRNO (
+            zmq_send (push, buffer, sizeof (buffer), 0)));
+    }
+
+    //  Keep some of the messages open until the context is terminated.
+    zmq_msg_t msgs[message_count];
+    for (int i = 0; i != message_count; i++) {
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msgs[i]));
+        TEST_ASSERT_EQUAL_INT (
+          (int) sizeof (buffer),
+          TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msgs[i], pull, 0)));
+        memset (buffer, 'a' + i % 26, sizeof (buffer));
+        TEST_ASSERT_EQUAL_MEMORY (buffer, zmq_msg_data (&msgs[i]),
+                                  sizeof (buffer));
+    }
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (push));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+    for (int i = 0; i != message_count / 2; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msgs[i]));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx_));
+    for (int i = message_count / 2; i != message_count; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msgs[i]));
+}
+
+static void
+test_transfer (const char *endpoint_, bool zero_copy_, int min_allocations_)
+{
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_ctx_set (ctx, ZMQ_ZERO_COPY_RECV, zero_copy_ ? 1 : 0));
+
+    counting_allocator_t counters;
+    zmq_allocator_t allocator;
+    init_allocator (&allocator, &counters);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set_allocator (ctx, &allocator));
+
+    transfer_messages (ctx, endpoint_);
+
+    const int allocations = zmq_atomic_counter_value (counters.allocations);
+    TEST_ASSERT_GREATER_OR_EQUAL_INT (min_allocations_, allocations);
+    TEST_ASSERT_EQUAL_INT (allocations,
+                           zmq_atomic_counter_value (counters.deallocations));
+    destroy_allocator (&counters);
+}
+
+void test_tcp_zero_copy ()
+{
+    test_transfer ("tcp://127.0.0.1:*", true, 1);
+}
+
+void test_tcp_copy ()
+{
+    //  Each message is copied out of the receive buffer.
+    test_transfer ("tcp://127.0.0.1:*", false, message_count);
+}
+
+void test_inproc ()
+{
+    //  Only the pipes use the allocator, as messages are not decoded.
+    test_transfer ("inproc://allocator", true, 1);
+}
+
+void test_default_allocator_restored ()
+{
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+
+    counting_allocator_t counters;
+    zmq_allocator_t allocator;
+    init_allocator (&allocator, &counters);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set_allocator (ctx, &allocator));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set_allocator (ctx, NULL));
+
+    transfer_messages (ctx, "tcp://127.0.0.1:*");
+
+    TEST_ASSERT_EQUAL_INT (0, zmq_atomic_counter_value (counters.allocations));
+    destroy_allocator (&counters);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_invalid_arguments);
+    RUN_TEST (test_tcp_zero_copy);
+    RUN_TEST (test_tcp_copy);
+    RUN_TEST (test_inproc);
+    RUN_TEST (test_default_allocator_restored);
+    return UNITY_END ();
+}
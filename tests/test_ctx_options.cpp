@@ -197,6 +197,144 @@ void test_ctx_zero_copy (void *ctx)
 #endif
 }
 
+void test_ctx_busy_poll ()
+{
+#ifdef ZMQ_BUSY_POLL
+    //  Busy polling is picked up by the I/O threads when they are started,
+    //  so a fresh context is needed.
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    // Default value is 0.
+    assert (zmq_ctx_get (ctx, ZMQ_BUSY_POLL) == 0);
+    assert (zmq_ctx_set (ctx, ZMQ_BUSY_POLL, -1) == -1 && errno == EINVAL);
+    assert (0 == zmq_ctx_set (ctx, ZMQ_BUSY_POLL, 100));
+    assert (zmq_ctx_get (ctx, ZMQ_BUSY_POLL) == 100);
+
+    const char *endpoints[] = {"tcp://127.0.0.1:*", "inproc://busy_poll"};
+    for (int i = 0; i != 2; i++) {
+        void *pull = zmq_socket (ctx, ZMQ_PULL);
+        assert (0 == zmq_bind (pull, endpoints[i]));
+
+        void *push = zmq_socket (ctx, ZMQ_PUSH);
+        size_t endpoint_len = MAX_SOCKET_STRING;
+        char endpoint[MAX_SOCKET_STRING];
+        assert (0
+                == zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint,
+                                   &endpoint_len));
+        assert (0 == zmq_connect (push, endpoint));
+
+        char buffer[16];
+        for (int j = 0; j != 100; j++) {
+            assert (4 == zmq_send (push, "abcd", 4, 0));
+            assert (4 == zmq_recv (pull, buffer, sizeof buffer, 0));
+            assert (!memcmp (buffer, "abcd", 4));
+        }
+
+        //  Timeouts still apply.
+        int timeout = 10;
+        assert (0
+                == zmq_setsockopt (pull, ZMQ_RCVTIMEO, &timeout,
+                                   sizeof timeout));
+        assert (-1 == zmq_recv (pull, buffer, sizeof buffer, 0));
+        assert (errno == EAGAIN);
+
+        //  The socket is signalled again after it gave up busy polling.
+        assert (4 == zmq_send (push, "abcd", 4, 0));
+        zmq_pollitem_t item = {pull, 0, ZMQ_POLLIN, 0};
+        assert (1 == zmq_poll (&item, 1, 1000));
+        assert (4 == zmq_recv (pull, buffer, sizeof buffer, 0));
+
+        assert (0 == zmq_close (push));
+        assert (0 == zmq_close (pull));
+    }
+
+    assert (0 == zmq_ctx_term (ctx));
+#endif
+}
+
+void test_ctx_msg_slab ()
+{
+#ifdef ZMQ_MSG_SLAB
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    // Default value is 0.
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_SLAB) == 0);
+    assert (zmq_ctx_set (ctx, ZMQ_MSG_SLAB, -1) == -1 && errno == EINVAL);
+    assert (0 == zmq_ctx_set (ctx, ZMQ_MSG_SLAB, 1));
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_SLAB) == 1);
+
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (0 == zmq_bind (pull, "tcp://127.0.0.1:*"));
+    void *push = zmq_socket (ctx, ZMQ_PUSH);
+    size_t endpoint_len = MAX_SOCKET_STRING;
+    char endpoint[MAX_SOCKET_STRING];
+    assert (0
+            == zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint,
+                               &endpoint_len));
+    assert (0 == zmq_connect (push, endpoint));
+
+    //  Messages allocated while the caches are enabled can be closed
+    //  after they are disabled.
+    char buffer[1000];
+    memset (buffer, 'x', sizeof buffer);
+    zmq_msg_t msgs[10];
+    for (int i = 0; i != 10; i++) {
+        assert (1000 == zmq_send (push, buffer, sizeof buffer, 0));
+        assert (0 == zmq_msg_init (&msgs[i]));
+        assert (1000 == zmq_msg_recv (&msgs[i], pull, 0));
+        assert (!memcmp (zmq_msg_data (&msgs[i]), buffer, sizeof buffer));
+    }
+
+    assert (0 == zmq_ctx_set (ctx, ZMQ_MSG_SLAB, 0));
+    assert (zmq_ctx_get (ctx, ZMQ_MSG_SLAB) == 0);
+    for (int i = 0; i != 10; i++)
+        assert (0 == zmq_msg_close (&msgs[i]));
+
+    assert (0 == zmq_close (push));
+    assert (0 == zmq_close (pull));
+    assert (0 == zmq_ctx_term (ctx));
+#endif
+}
+
+void test_ctx_dns_cache_ttl ()
+{
+#ifdef ZMQ_DNS_CACHE_TTL
+    void *ctx = zmq_ctx_new ();
+    assert (ctx);
+
+    // Default value is 0, the cache is disabled.
+    assert (zmq_ctx_get (ctx, ZMQ_DNS_CACHE_TTL) == 0);
+    assert (zmq_ctx_set (ctx, ZMQ_DNS_CACHE_TTL, -1) == -1 && errno == EINVAL);
+    assert (0 == zmq_ctx_set (ctx, ZMQ_DNS_CACHE_TTL, 30000));
+    assert (zmq_ctx_get (ctx, ZMQ_DNS_CACHE_TTL) == 30000);
+
+    //  Host names are resolved off the I/O thread.
+    void *pull = zmq_socket (ctx, ZMQ_PULL);
+    assert (0 == zmq_bind (pull, "tcp://127.0.0.1:*"));
+    size_t endpoint_len = MAX_SOCKET_STRING;
+    char endpoint[MAX_SOCKET_STRING];
+    assert (0
+            == zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint,
+                               &endpoint_len));
+    char connect_address[MAX_SOCKET_STRING];
+    sprintf (connect_address, "tcp://localhost:%s",
+             strrchr (endpoint, ':') + 1);
+    for (int i = 0; i != 2; i++) {
+        void *push = zmq_socket (ctx, ZMQ_PUSH);
+        assert (0 == zmq_connect (push, connect_address));
+        assert (5 == zmq_send (push, "hello", 5, 0));
+        char buffer[5];
+        assert (5 == zmq_recv (pull, buffer, 5, 0));
+        assert (0 == zmq_close (push));
+    }
+
+    assert (0 == zmq_close (pull));
+    assert (0 == zmq_ctx_term (ctx));
+#endif
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -224,6 +362,9 @@ int main (void)
 
     test_ctx_thread_opts (ctx);
     test_ctx_zero_copy (ctx);
+    test_ctx_busy_poll ();
+    test_ctx_msg_slab ();
+    test_ctx_dns_cache_ttl ();
 
     void *router = zmq_socket (ctx, ZMQ_ROUTER);
     int value;
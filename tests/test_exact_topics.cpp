@@ -0,0 +1,198 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void set_exact_topics (void *socket_)
+{
+    int exact = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, ZMQ_EXACT_TOPICS, &exact, sizeof (exact)));
+}
+
+//  Receives a (un)subscription message on an XPUB socket.
+static void recv_subscription (void *xpub_, bool subscribe_, const char *topic_)
+{
+    char buffer[256];
+    const int rc =
+      TEST_ASSERT_SUCCESS_ERRNO (zmq_recv (xpub_, buffer, sizeof (buffer), 0));
+    TEST_ASSERT_EQUAL_INT ((int) strlen (topic_) + 1, rc);
+    TEST_ASSERT_EQUAL_INT (subscribe_ ? 1 : 0, buffer[0]);
+    TEST_ASSERT_EQUAL_STRING_LEN (topic_, buffer + 1, rc - 1);
+}
+
+//  Creates an XPUB socket and a socket of the given type connected to it.
+static void create_pair (void **xpub_, void **sub_, int sub_type_)
+{
+    *xpub_ = test_context_socket (ZMQ_XPUB);
+    *sub_ = test_context_socket (sub_type_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (*xpub_, "inproc://exact_topics"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (*sub_, "inproc://exact_topics"));
+}
+
+void test_option ()
+{
+    void *sub = test_context_socket (ZMQ_SUB);
+    int exact = -1;
+    size_t size = sizeof (exact);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sub, ZMQ_EXACT_TOPICS, &exact, &size));
+    TEST_ASSERT_EQUAL_INT (0, exact);
+
+    set_exact_topics (sub);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (sub, ZMQ_EXACT_TOPICS, &exact, &size));
+    TEST_ASSERT_EQUAL_INT (1, exact);
+
+    exact = 2;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (sub, ZMQ_EXACT_TOPICS, &exact, sizeof (exact)));
+    test_context_socket_close (sub);
+}
+
+void test_sub_filters_exact_topics ()
+{
+    void *xpub, *sub;
+    create_pair (&xpub, &sub, ZMQ_SUB);
+    set_exact_topics (sub);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "foo", 3));
+    recv_subscription (xpub, true, "foo");
+
+    //  XPUB matches prefixes and forwards all of these, SUB drops all but
+    //  the exact topic.
+    send_string_expect_success (xpub, "foobar", 0);
+    send_string_expect_success (xpub, "fo", 0);
+    send_string_expect_success (xpub, "foo", 0);
+    recv_string_expect_success (sub, "foo", 0);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (xpub);
+}
+
+void test_xpub_matches_exact_topics ()
+{
+    void *xpub, *xsub;
+    create_pair (&xpub, &xsub, ZMQ_XSUB);
+    set_exact_topics (xpub);
+
+    send_string_expect_success (xsub, "\1foo", 0);
+    recv_subscription (xpub, true, "foo");
+
+    //  XSUB doesn't filter, so only the exact topic must have been sent.
+    send_string_expect_success (xpub, "foobar", 0);
+    send_string_expect_success (xpub, "fo", 0);
+    send_string_expect_success (xpub, "foo", 0);
+    recv_string_expect_success (xsub, "foo", 0);
+
+    test_context_socket_close (xsub);
+    test_context_socket_close (xpub);
+}
+
+void test_empty_subscription_matches_all ()
+{
+    void *xpub, *sub;
+    create_pair (&xpub, &sub, ZMQ_SUB);
+    set_exact_topics (xpub);
+    set_exact_topics (sub);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "", 0));
+    recv_subscription (xpub, true, "");
+
+    send_string_expect_success (xpub, "anything", 0);
+    recv_string_expect_success (sub, "anything", 0);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (xpub);
+}
+
+void test_unsubscribe ()
+{
+    void *xpub, *sub;
+    create_pair (&xpub, &sub, ZMQ_SUB);
+    set_exact_topics (xpub);
+    set_exact_topics (sub);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "foo", 3));
+    recv_subscription (xpub, true, "foo");
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "bar", 3));
+    recv_subscription (xpub, true, "bar");
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (sub, ZMQ_UNSUBSCRIBE, "foo", 3));
+    recv_subscription (xpub, false, "foo");
+
+    send_string_expect_success (xpub, "foo", 0);
+    send_string_expect_success (xpub, "bar", 0);
+    recv_string_expect_success (sub, "bar", 0);
+
+    test_context_socket_close (sub);
+    test_context_socket_close (xpub);
+}
+
+void test_unsubscribe_on_disconnect ()
+{
+    void *xpub, *sub;
+    create_pair (&xpub, &sub, ZMQ_SUB);
+    set_exact_topics (xpub);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (sub, ZMQ_SUBSCRIBE, "foo", 3));
+    recv_subscription (xpub, true, "foo");
+
+    test_context_socket_close (sub);
+    recv_subscription (xpub, false, "foo");
+
+    test_context_socket_close (xpub);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_sub_filters_exact_topics);
+    RUN_TEST (test_xpub_matches_exact_topics);
+    RUN_TEST (test_empty_subscription_matches_all);
+    RUN_TEST (test_unsubscribe);
+    RUN_TEST (test_unsubscribe_on_disconnect);
+    return UNITY_END ();
+}
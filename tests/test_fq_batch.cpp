@@ -0,0 +1,128 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+#include <string>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+void test_option ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    int batch = 0;
+    size_t size = sizeof (batch);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_FQ_BATCH, &batch, &size));
+    TEST_ASSERT_EQUAL_INT (1, batch);
+
+    batch = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (pull, ZMQ_FQ_BATCH, &batch, sizeof (batch)));
+
+    batch = 16;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_FQ_BATCH, &batch, sizeof (batch)));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_FQ_BATCH, &batch, &size));
+    TEST_ASSERT_EQUAL_INT (16, batch);
+
+    test_context_socket_close (pull);
+}
+
+//  Queues four messages from each of two senders, and returns the order
+//  in which the receiver gets them with the given batch.
+static std::string receive_order (int batch_)
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_FQ_BATCH, &batch_, sizeof (batch_)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://fq-batch"));
+
+    const char *names[] = {"a", "b"};
+    void *pushes[2];
+    for (int i = 0; i != 2; i++) {
+        pushes[i] = test_context_socket (ZMQ_PUSH);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_connect (pushes[i], "inproc://fq-batch"));
+        for (int j = 0; j != 4; j++)
+            send_string_expect_success (pushes[i], names[i], 0);
+    }
+
+    std::string order;
+    for (int i = 0; i != 8; i++) {
+        char buffer[2];
+        TEST_ASSERT_EQUAL_INT (
+          1, TEST_ASSERT_SUCCESS_ERRNO (zmq_recv (pull, buffer, 1, 0)));
+        order += buffer[0];
+    }
+
+    for (int i = 0; i != 2; i++)
+        test_context_socket_close (pushes[i]);
+    test_context_socket_close (pull);
+    return order;
+}
+
+void test_strict_rotation ()
+{
+    TEST_ASSERT_EQUAL_STRING ("abababab", receive_order (1).c_str ());
+}
+
+void test_batch ()
+{
+    TEST_ASSERT_EQUAL_STRING ("aaabbbab", receive_order (3).c_str ());
+}
+
+void test_batch_larger_than_queue ()
+{
+    TEST_ASSERT_EQUAL_STRING ("aaaabbbb", receive_order (10).c_str ());
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_strict_rotation);
+    RUN_TEST (test_batch);
+    RUN_TEST (test_batch_larger_than_queue);
+    return UNITY_END ();
+}
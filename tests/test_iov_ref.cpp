@@ -0,0 +1,275 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+// XSI vector I/O
+#if defined ZMQ_HAVE_UIO
+#include <sys/uio.h>
+#else
+struct iovec
+{
+    void *iov_base;
+    size_t iov_len;
+};
+#endif
+
+#define PART_COUNT 3
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void count_release (void *, void *hint_)
+{
+    zmq_atomic_counter_inc (hint_);
+}
+
+//  Waits until all the parts handed over to libzmq are released.
+static void wait_for_releases (void *released_, int expected_)
+{
+    for (int i = 0; i != 100; i++) {
+        if (zmq_atomic_counter_value (released_) == expected_)
+            break;
+        msleep (SETTLE_TIME / 10);
+    }
+    TEST_ASSERT_EQUAL_INT (expected_, zmq_atomic_counter_value (released_));
+}
+
+//  Fills a message made of a small part and two large ones.
+static void init_parts (char *small_,
+                        char *large1_,
+                        char *large2_,
+                        size_t large_size_,
+                        struct iovec *iov_)
+{
+    strcpy (small_, "header");
+    memset (large1_, 'a', large_size_);
+    memset (large2_, 'b', large_size_);
+    iov_[0].iov_base = small_;
+    iov_[0].iov_len = strlen (small_);
+    iov_[1].iov_base = large1_;
+    iov_[1].iov_len = large_size_;
+    iov_[2].iov_base = large2_;
+    iov_[2].iov_len = large_size_;
+}
+
+//  Sends the parts as a single multi-part message.
+static void send_message (void *socket_, struct iovec *iov_, void *released_)
+{
+    TEST_ASSERT_EQUAL_INT (PART_COUNT,
+                           zmq_sendiov_ref (socket_, iov_, PART_COUNT,
+                                            ZMQ_SNDMORE, count_release,
+                                            released_));
+}
+
+static void check_roundtrip (const char *endpoint_, bool same_buffers_)
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, endpoint_));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t endpoint_len = sizeof (endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    char small[16];
+    char large1[4096];
+    char large2[4096];
+    struct iovec send_iov[PART_COUNT];
+    init_parts (small, large1, large2, sizeof (large1), send_iov);
+
+    void *released = zmq_atomic_counter_new ();
+    send_message (push, send_iov, released);
+
+    struct iovec recv_iov[PART_COUNT + 1];
+    zmq_msg_t msgs[PART_COUNT + 1];
+    for (int i = 0; i != PART_COUNT + 1; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msgs[i]));
+    size_t count = PART_COUNT + 1;
+    TEST_ASSERT_EQUAL_INT (
+      PART_COUNT, zmq_recviov_ref (pull, recv_iov, msgs, &count, 0));
+    TEST_ASSERT_EQUAL_INT (PART_COUNT, count);
+
+    for (int i = 0; i != PART_COUNT; i++) {
+        TEST_ASSERT_EQUAL_INT (send_iov[i].iov_len, recv_iov[i].iov_len);
+        TEST_ASSERT_EQUAL_MEMORY (send_iov[i].iov_base, recv_iov[i].iov_base,
+                                  send_iov[i].iov_len);
+
+        //  The iovecs point to the content of the messages.
+        TEST_ASSERT_EQUAL_PTR (zmq_msg_data (&msgs[i]), recv_iov[i].iov_base);
+    }
+
+    //  Over inproc, large parts are passed by reference end to end.
+    if (same_buffers_) {
+        TEST_ASSERT_EQUAL_PTR (large1, recv_iov[1].iov_base);
+        TEST_ASSERT_EQUAL_PTR (large2, recv_iov[2].iov_base);
+    }
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_recviov_release (msgs, count));
+    wait_for_releases (released, PART_COUNT);
+
+    //  Released messages can receive the next message straight away.
+    send_message (push, send_iov, released);
+    count = PART_COUNT + 1;
+    TEST_ASSERT_EQUAL_INT (
+      PART_COUNT, zmq_recviov_ref (pull, recv_iov, msgs, &count, 0));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_recviov_release (msgs, PART_COUNT + 1));
+    wait_for_releases (released, 2 * PART_COUNT);
+
+    for (int i = 0; i != PART_COUNT + 1; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msgs[i]));
+    zmq_atomic_counter_destroy (&released);
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_roundtrip_tcp ()
+{
+    check_roundtrip ("tcp://127.0.0.1:*", false);
+}
+
+void test_roundtrip_inproc ()
+{
+    check_roundtrip ("inproc://iov_ref", true);
+}
+
+void test_partial_receive ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "inproc://iov_ref_partial"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://iov_ref_partial"));
+
+    char small[16];
+    char large1[1024];
+    char large2[1024];
+    struct iovec send_iov[PART_COUNT];
+    init_parts (small, large1, large2, sizeof (large1), send_iov);
+    TEST_ASSERT_EQUAL_INT (PART_COUNT,
+                           zmq_sendiov_ref (push, send_iov, PART_COUNT,
+                                            ZMQ_SNDMORE, NULL, NULL));
+
+    struct iovec recv_iov[PART_COUNT];
+    zmq_msg_t msgs[PART_COUNT];
+    for (int i = 0; i != PART_COUNT; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msgs[i]));
+
+    size_t count = 2;
+    TEST_ASSERT_EQUAL_INT (2,
+                           zmq_recviov_ref (pull, recv_iov, msgs, &count, 0));
+    TEST_ASSERT_EQUAL_INT (2, count);
+    int more;
+    size_t more_size = sizeof (more);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_RCVMORE, &more, &more_size));
+    TEST_ASSERT_EQUAL_INT (1, more);
+
+    count = PART_COUNT;
+    TEST_ASSERT_EQUAL_INT (
+      1, zmq_recviov_ref (pull, recv_iov + 2, msgs + 2, &count, 0));
+    TEST_ASSERT_EQUAL_INT (1, count);
+    TEST_ASSERT_EQUAL_MEMORY (large2, recv_iov[2].iov_base, sizeof (large2));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_recviov_release (msgs, PART_COUNT));
+    for (int i = 0; i != PART_COUNT; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msgs[i]));
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_parts_released_on_failure ()
+{
+    //  With no peer, a PUSH socket can not send.
+    void *push = test_context_socket (ZMQ_PUSH);
+
+    char small[16];
+    char large1[1024];
+    char large2[1024];
+    struct iovec send_iov[PART_COUNT];
+    init_parts (small, large1, large2, sizeof (large1), send_iov);
+
+    void *released = zmq_atomic_counter_new ();
+    TEST_ASSERT_FAILURE_ERRNO (EAGAIN,
+                               zmq_sendiov_ref (push, send_iov, PART_COUNT,
+                                                ZMQ_SNDMORE | ZMQ_DONTWAIT,
+                                                count_release,
+                                                released));
+    TEST_ASSERT_EQUAL_INT (PART_COUNT, zmq_atomic_counter_value (released));
+
+    zmq_atomic_counter_destroy (&released);
+    test_context_socket_close (push);
+}
+
+void test_invalid_arguments ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    struct iovec iov[1];
+    zmq_msg_t msgs[1];
+    size_t count = 1;
+
+    TEST_ASSERT_FAILURE_ERRNO (
+      ENOTSOCK, zmq_sendiov_ref (NULL, iov, 1, 0, NULL, NULL));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_sendiov_ref (pull, iov, 0, 0, NULL, NULL));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_sendiov_ref (pull, NULL, 1, 0, NULL, NULL));
+    TEST_ASSERT_FAILURE_ERRNO (ENOTSOCK,
+                               zmq_recviov_ref (NULL, iov, msgs, &count, 0));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_recviov_ref (pull, iov, NULL, &count, 0));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_recviov_ref (pull, iov, msgs, NULL, 0));
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL, zmq_recviov_release (NULL, 1));
+
+    test_context_socket_close (pull);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_roundtrip_tcp);
+    RUN_TEST (test_roundtrip_inproc);
+    RUN_TEST (test_partial_receive);
+    RUN_TEST (test_parts_released_on_failure);
+    RUN_TEST (test_invalid_arguments);
+    return UNITY_END ();
+}
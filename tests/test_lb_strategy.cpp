@@ -0,0 +1,447 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+#include <map>
+#include <string>
+
+#define MESSAGE_COUNT 10
+#define KEY_COUNT 30
+#define PULL_COUNT 3
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void set_int_option (void *socket_, int option_, int value_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket_, option_, &value_, sizeof (value_)));
+}
+
+static int get_int_option (void *socket_, int option_)
+{
+    int value = -1;
+    size_t size = sizeof (value);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket_, option_, &value, &size));
+    return value;
+}
+
+//  Returns the number of messages that can be received without blocking.
+static int count_pending (void *socket_)
+{
+    int count = 0;
+    char buffer[32];
+    while (zmq_recv (socket_, buffer, sizeof (buffer), ZMQ_DONTWAIT) >= 0)
+        count++;
+    TEST_ASSERT_EQUAL_INT (EAGAIN, zmq_errno ());
+    return count;
+}
+
+//  Creates a PULL socket bound to the given inproc endpoint.
+static void *bind_pull (const char *endpoint_, int rcvhwm_)
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    set_int_option (pull, ZMQ_RCVHWM, rcvhwm_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, endpoint_));
+    return pull;
+}
+
+void test_options ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_EQUAL_INT (ZMQ_LB_ROUND_ROBIN,
+                           get_int_option (push, ZMQ_LB_STRATEGY));
+    TEST_ASSERT_EQUAL_INT (1, get_int_option (push, ZMQ_LB_WEIGHT));
+
+    set_int_option (push, ZMQ_LB_STRATEGY, ZMQ_LB_WEIGHTED);
+    TEST_ASSERT_EQUAL_INT (ZMQ_LB_WEIGHTED,
+                           get_int_option (push, ZMQ_LB_STRATEGY));
+    set_int_option (push, ZMQ_LB_WEIGHT, 5);
+    TEST_ASSERT_EQUAL_INT (5, get_int_option (push, ZMQ_LB_WEIGHT));
+
+    int value = ZMQ_LB_CONSISTENT_HASH + 1;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_LB_STRATEGY, &value, sizeof (value)));
+    value = 0;
+    TEST_ASSERT_FAILURE_ERRNO (
+      EINVAL, zmq_setsockopt (push, ZMQ_LB_WEIGHT, &value, sizeof (value)));
+
+    test_context_socket_close (push);
+}
+
+void test_weighted ()
+{
+    void *heavy = bind_pull ("inproc://heavy", 1000);
+    void *light = bind_pull ("inproc://light", 1000);
+
+    void *push = test_context_socket (ZMQ_PUSH);
+    set_int_option (push, ZMQ_LB_STRATEGY, ZMQ_LB_WEIGHTED);
+    set_int_option (push, ZMQ_LB_WEIGHT, 3);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://heavy"));
+    set_int_option (push, ZMQ_LB_WEIGHT, 1);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://light"));
+
+    for (int i = 0; i != 2 * (3 + 1); i++)
+        send_string_expect_success (push, "weighted", 0);
+
+    TEST_ASSERT_EQUAL_INT (2 * 3, count_pending (heavy));
+    TEST_ASSERT_EQUAL_INT (2 * 1, count_pending (light));
+
+    test_context_socket_close (push);
+    test_context_socket_close (light);
+    test_context_socket_close (heavy);
+}
+
+//  Sends messages to a stalled and to a draining peer with the given
+//  strategy, and returns the number of messages the stalled peer got.
+static int send_to_stalled_peer (int strategy_)
+{
+    //  With queues this short, the readers report every message they read.
+    void *stalled = bind_pull ("inproc://stalled", 1);
+    void *draining = bind_pull ("inproc://draining", 1);
+
+    void *push = test_context_socket (ZMQ_PUSH);
+    set_int_option (push, ZMQ_SNDHWM, 1);
+    set_int_option (push, ZMQ_LB_STRATEGY, strategy_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://stalled"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, "inproc://draining"));
+
+    int drained = 0;
+    for (int i = 0; i != MESSAGE_COUNT; i++) {
+        send_string_expect_success (push, "load", 0);
+        drained += count_pending (draining);
+
+        //  Process the reports of the reader.
+        get_int_option (push, ZMQ_EVENTS);
+    }
+    const int stalled_count = count_pending (stalled);
+    TEST_ASSERT_EQUAL_INT (MESSAGE_COUNT, stalled_count + drained);
+
+    test_context_socket_close (push);
+    test_context_socket_close (draining);
+    test_context_socket_close (stalled);
+    return stalled_count;
+}
+
+void test_round_robin ()
+{
+    //  The stalled peer gets messages until its queue of 1 + 1 is full.
+    TEST_ASSERT_EQUAL_INT (2, send_to_stalled_peer (ZMQ_LB_ROUND_ROBIN));
+}
+
+void test_shortest_queue ()
+{
+    TEST_ASSERT_EQUAL_INT (1, send_to_stalled_peer (ZMQ_LB_SHORTEST_QUEUE));
+}
+
+void test_power_of_two ()
+{
+    TEST_ASSERT_LESS_OR_EQUAL_INT (1,
+                                   send_to_stalled_peer (ZMQ_LB_POWER_OF_TWO));
+}
+
+//  Receives the pending messages of the pulls and records which of them
+//  got each message, checking that a message always goes to the same pull.
+static void
+receive_keys (void **pulls_, int pull_count_, std::map<std::string, int> *keys_)
+{
+    for (int i = 0; i != pull_count_; i++) {
+        char buffer[32];
+        int rc;
+        while ((rc = zmq_recv (pulls_[i], buffer, sizeof (buffer) - 1,
+                               ZMQ_DONTWAIT))
+               >= 0) {
+            const std::string key (buffer, rc);
+            std::map<std::string, int>::iterator it = keys_->find (key);
+            if (it == keys_->end ())
+                keys_->insert (std::make_pair (key, i));
+            else
+                TEST_ASSERT_EQUAL_INT (it->second, i);
+        }
+        TEST_ASSERT_EQUAL_INT (EAGAIN, zmq_errno ());
+    }
+}
+
+static void send_keys (void *push_)
+{
+    for (int i = 0; i != KEY_COUNT; i++) {
+        char key[32];
+        sprintf (key, "key-%d", i);
+        send_string_expect_success (push_, key, 0);
+    }
+}
+
+void test_consistent_hash ()
+{
+    void *pulls[PULL_COUNT];
+    char endpoints[PULL_COUNT][32];
+    void *push = test_context_socket (ZMQ_PUSH);
+    set_int_option (push, ZMQ_LB_STRATEGY, ZMQ_LB_CONSISTENT_HASH);
+    for (int i = 0; i != PULL_COUNT; i++) {
+        sprintf (endpoints[i], "inproc://hashed-%d", i);
+        pulls[i] = bind_pull (endpoints[i], 1000);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoints[i]));
+    }
+
+    //  Each key sticks to its pull.
+    std::map<std::string, int> keys;
+    send_keys (push);
+    send_keys (push);
+    receive_keys (pulls, PULL_COUNT, &keys);
+    TEST_ASSERT_EQUAL_INT (KEY_COUNT, (int) keys.size ());
+
+    //  The keys spread over all the pulls.
+    int per_pull[PULL_COUNT] = {0};
+    for (std::map<std::string, int>::iterator it = keys.begin ();
+         it != keys.end (); ++it)
+        per_pull[it->second]++;
+    for (int i = 0; i != PULL_COUNT; i++)
+        TEST_ASSERT_GREATER_THAN_INT (0, per_pull[i]);
+
+    //  Once a pull is gone, only its keys are sent elsewhere.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_disconnect (push, endpoints[0]));
+    std::map<std::string, int> remaining_keys;
+    send_keys (push);
+    receive_keys (pulls, PULL_COUNT, &remaining_keys);
+    TEST_ASSERT_EQUAL_INT (KEY_COUNT, (int) remaining_keys.size ());
+    for (std::map<std::string, int>::iterator it = keys.begin ();
+         it != keys.end (); ++it) {
+        if (it->second == 0) {
+            TEST_ASSERT_NOT_EQUAL (0, remaining_keys[it->first]);
+        } else {
+            TEST_ASSERT_EQUAL_INT (it->second, remaining_keys[it->first]);
+        }
+    }
+
+    test_context_socket_close (push);
+    for (int i = 0; i != PULL_COUNT; i++)
+        test_context_socket_close (pulls[i]);
+}
+
+//  Once a peer the socket connected to is reconnected, its keys come back.
+void test_consistent_hash_reconnect ()
+{
+    void *pulls[PULL_COUNT];
+    char endpoints[PULL_COUNT][32];
+    void *push = test_context_socket (ZMQ_PUSH);
+    set_int_option (push, ZMQ_LB_STRATEGY, ZMQ_LB_CONSISTENT_HASH);
+    for (int i = 0; i != PULL_COUNT; i++) {
+        sprintf (endpoints[i], "inproc://sticky-%d", i);
+        pulls[i] = bind_pull (endpoints[i], 1000);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoints[i]));
+    }
+
+    std::map<std::string, int> keys;
+    send_keys (push);
+    receive_keys (pulls, PULL_COUNT, &keys);
+    TEST_ASSERT_EQUAL_INT (KEY_COUNT, (int) keys.size ());
+
+    //  Reconnect while the old pipe still exists, so that the new one is
+    //  a different object, and let the old one terminate.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_disconnect (push, endpoints[0]));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoints[0]));
+    TEST_ASSERT_EQUAL_INT (0, count_pending (pulls[0]));
+    get_int_option (push, ZMQ_EVENTS);
+
+    std::map<std::string, int> reconnected_keys;
+    send_keys (push);
+    receive_keys (pulls, PULL_COUNT, &reconnected_keys);
+    TEST_ASSERT_EQUAL_INT (KEY_COUNT, (int) reconnected_keys.size ());
+    for (std::map<std::string, int>::iterator it = keys.begin ();
+         it != keys.end (); ++it)
+        TEST_ASSERT_EQUAL_INT (it->second, reconnected_keys[it->first]);
+
+    test_context_socket_close (push);
+    for (int i = 0; i != PULL_COUNT; i++)
+        test_context_socket_close (pulls[i]);
+}
+
+//  Receives the pending requests of the routers, checking that a key
+//  always goes to the same router, and returns the number of routers
+//  that got requests.
+static int receive_requests (void **routers_, int router_count_)
+{
+    std::map<std::string, int> keys;
+    int used = 0;
+    for (int i = 0; i != router_count_; i++) {
+        int requests = 0;
+        zmq_msg_t frame;
+        zmq_msg_init (&frame);
+        while (zmq_msg_recv (&frame, routers_[i], ZMQ_DONTWAIT) >= 0) {
+            //  The key is the last frame of the request.
+            while (zmq_msg_more (&frame))
+                TEST_ASSERT_SUCCESS_ERRNO (
+                  zmq_msg_recv (&frame, routers_[i], 0));
+            const std::string key ((char *) zmq_msg_data (&frame),
+                                   zmq_msg_size (&frame));
+            std::map<std::string, int>::iterator it = keys.find (key);
+            if (it == keys.end ())
+                keys.insert (std::make_pair (key, i));
+            else
+                TEST_ASSERT_EQUAL_INT (it->second, i);
+            requests++;
+        }
+        TEST_ASSERT_EQUAL_INT (EAGAIN, zmq_errno ());
+        zmq_msg_close (&frame);
+        if (requests > 0)
+            used++;
+    }
+    TEST_ASSERT_EQUAL_INT (KEY_COUNT, (int) keys.size ());
+    return used;
+}
+
+//  REQ sockets hash the request rather than its envelope.
+static void test_consistent_hash_req (int correlate_)
+{
+    void *routers[PULL_COUNT];
+    void *req = test_context_socket (ZMQ_REQ);
+    set_int_option (req, ZMQ_LB_STRATEGY, ZMQ_LB_CONSISTENT_HASH);
+    set_int_option (req, ZMQ_REQ_RELAXED, 1);
+    set_int_option (req, ZMQ_REQ_CORRELATE, correlate_);
+    for (int i = 0; i != PULL_COUNT; i++) {
+        char endpoint[32];
+        sprintf (endpoint, "inproc://req-hashed-%d-%d", correlate_, i);
+        routers[i] = test_context_socket (ZMQ_ROUTER);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (routers[i], endpoint));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (req, endpoint));
+    }
+
+    send_keys (req);
+    send_keys (req);
+    TEST_ASSERT_EQUAL_INT (PULL_COUNT, receive_requests (routers, PULL_COUNT));
+
+    test_context_socket_close (req);
+    for (int i = 0; i != PULL_COUNT; i++)
+        test_context_socket_close (routers[i]);
+}
+
+void test_consistent_hash_req_plain ()
+{
+    test_consistent_hash_req (0);
+}
+
+void test_consistent_hash_req_correlated ()
+{
+    test_consistent_hash_req (1);
+}
+
+void test_consistent_hash_key_range ()
+{
+    void *pulls[PULL_COUNT];
+    void *push = test_context_socket (ZMQ_PUSH);
+    set_int_option (push, ZMQ_LB_STRATEGY, ZMQ_LB_CONSISTENT_HASH);
+    set_int_option (push, ZMQ_LB_KEY_OFFSET, 4);
+    set_int_option (push, ZMQ_LB_KEY_SIZE, 2);
+    TEST_ASSERT_EQUAL_INT (4, get_int_option (push, ZMQ_LB_KEY_OFFSET));
+    TEST_ASSERT_EQUAL_INT (2, get_int_option (push, ZMQ_LB_KEY_SIZE));
+    for (int i = 0; i != PULL_COUNT; i++) {
+        char endpoint[32];
+        sprintf (endpoint, "inproc://ranged-%d", i);
+        pulls[i] = bind_pull (endpoint, 1000);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+    }
+
+    //  Only the bytes in the range matter.
+    for (int i = 0; i != KEY_COUNT; i++) {
+        char message[32];
+        sprintf (message, "%04dKY%d", i, i);
+        send_string_expect_success (push, message, 0);
+    }
+    int received = 0;
+    for (int i = 0; i != PULL_COUNT; i++) {
+        const int count = count_pending (pulls[i]);
+        TEST_ASSERT_TRUE (count == 0 || count == KEY_COUNT);
+        received += count;
+    }
+    TEST_ASSERT_EQUAL_INT (KEY_COUNT, received);
+
+    test_context_socket_close (push);
+    for (int i = 0; i != PULL_COUNT; i++)
+        test_context_socket_close (pulls[i]);
+}
+
+void test_consistent_hash_full ()
+{
+    void *pulls[PULL_COUNT];
+    void *push = test_context_socket (ZMQ_PUSH);
+    set_int_option (push, ZMQ_SNDHWM, 1);
+    set_int_option (push, ZMQ_LB_STRATEGY, ZMQ_LB_CONSISTENT_HASH);
+    for (int i = 0; i != PULL_COUNT; i++) {
+        char endpoint[32];
+        sprintf (endpoint, "inproc://full-%d", i);
+        pulls[i] = bind_pull (endpoint, 1);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+    }
+
+    //  Once the pull of the key is full, the other pulls get the messages.
+    for (int i = 0; i != MESSAGE_COUNT / 2; i++)
+        send_string_expect_success (push, "key", ZMQ_DONTWAIT);
+    int received = 0;
+    for (int i = 0; i != PULL_COUNT; i++) {
+        const int count = count_pending (pulls[i]);
+        TEST_ASSERT_LESS_OR_EQUAL_INT (2, count);
+        received += count;
+    }
+    TEST_ASSERT_EQUAL_INT (MESSAGE_COUNT / 2, received);
+
+    test_context_socket_close (push);
+    for (int i = 0; i != PULL_COUNT; i++)
+        test_context_socket_close (pulls[i]);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_options);
+    RUN_TEST (test_weighted);
+    RUN_TEST (test_round_robin);
+    RUN_TEST (test_shortest_queue);
+    RUN_TEST (test_power_of_two);
+    RUN_TEST (test_consistent_hash);
+    RUN_TEST (test_consistent_hash_reconnect);
+    RUN_TEST (test_consistent_hash_req_plain);
+    RUN_TEST (test_consistent_hash_req_correlated);
+    RUN_TEST (test_consistent_hash_key_range);
+    RUN_TEST (test_consistent_hash_full);
+    return UNITY_END ();
+}
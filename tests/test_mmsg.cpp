@@ -0,0 +1,328 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+#define BATCH_SIZE 16
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void init_batch (zmq_msg_t *msgs_, size_t count_, size_t first_)
+{
+    for (size_t i = 0; i != count_; i++) {
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msgs_[i], sizeof (int)));
+        int value = (int) (first_ + i);
+        memcpy (zmq_msg_data (&msgs_[i]), &value, sizeof value);
+    }
+}
+
+static void init_empty_batch (zmq_msg_t *msgs_, size_t count_)
+{
+    for (size_t i = 0; i != count_; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msgs_[i]));
+}
+
+static void close_batch (zmq_msg_t *msgs_, size_t count_)
+{
+    for (size_t i = 0; i != count_; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msgs_[i]));
+}
+
+static int batch_value (zmq_msg_t *msg_)
+{
+    TEST_ASSERT_EQUAL_INT (sizeof (int), zmq_msg_size (msg_));
+    int value;
+    memcpy (&value, zmq_msg_data (msg_), sizeof value);
+    return value;
+}
+
+static void test_batch_roundtrip (int type_out_,
+                                  int type_in_,
+                                  const char *endpoint_)
+{
+    void *out = test_context_socket (type_out_);
+    void *in = test_context_socket (type_in_);
+    if (type_in_ == ZMQ_SUB)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (in, ZMQ_SUBSCRIBE, "", 0));
+
+    char endpoint[MAX_SOCKET_STRING];
+    size_t len = sizeof endpoint;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (in, endpoint_));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (in, ZMQ_LAST_ENDPOINT, endpoint, &len));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (out, endpoint));
+    msleep (SETTLE_TIME);
+
+    //  Make the receiving socket process its pending commands, so that
+    //  a subscription, if any, reaches the sender before the batch does.
+    zmq_msg_t received[BATCH_SIZE];
+    init_empty_batch (received, BATCH_SIZE);
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_recvmmsg (in, received, BATCH_SIZE, ZMQ_DONTWAIT));
+    msleep (SETTLE_TIME);
+
+    zmq_msg_t msgs[BATCH_SIZE];
+    init_batch (msgs, BATCH_SIZE, 0);
+    TEST_ASSERT_EQUAL_INT (BATCH_SIZE,
+                           zmq_sendmmsg (out, msgs, BATCH_SIZE, 0));
+
+    //  Sent messages are emptied, the same as with zmq_msg_send.
+    for (size_t i = 0; i != BATCH_SIZE; i++)
+        TEST_ASSERT_EQUAL_INT (0, zmq_msg_size (&msgs[i]));
+    close_batch (msgs, BATCH_SIZE);
+
+    int total = 0;
+    while (total < BATCH_SIZE) {
+        const int rc = TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_recvmmsg (in, received + total, BATCH_SIZE - total, 0));
+        TEST_ASSERT_GREATER_THAN_INT (0, rc);
+        total += rc;
+    }
+    for (int i = 0; i != BATCH_SIZE; i++) {
+        TEST_ASSERT_EQUAL_INT (i, batch_value (&received[i]));
+        TEST_ASSERT_EQUAL_INT (0, zmq_msg_more (&received[i]));
+    }
+    close_batch (received, BATCH_SIZE);
+
+    test_context_socket_close (out);
+    test_context_socket_close (in);
+}
+
+void test_push_pull_inproc ()
+{
+    test_batch_roundtrip (ZMQ_PUSH, ZMQ_PULL, "inproc://mmsg");
+}
+
+void test_push_pull_tcp ()
+{
+    test_batch_roundtrip (ZMQ_PUSH, ZMQ_PULL, "tcp://127.0.0.1:*");
+}
+
+void test_pub_sub_inproc ()
+{
+    test_batch_roundtrip (ZMQ_PUB, ZMQ_SUB, "inproc://mmsg");
+}
+
+void test_dealer_dealer_tcp ()
+{
+    test_batch_roundtrip (ZMQ_DEALER, ZMQ_DEALER, "tcp://127.0.0.1:*");
+}
+
+void test_pub_fanout ()
+{
+    //  Subscribers connected over TCP share the I/O thread, the inproc one
+    //  lives in this thread, so their activations are sent separately.
+    const int sub_count = 5;
+    void *pub = test_context_socket (ZMQ_PUB);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "tcp://127.0.0.1:*"));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t endpoint_len = sizeof endpoint;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pub, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pub, "inproc://mmsg"));
+
+    void *subs[sub_count];
+    for (int i = 0; i != sub_count; i++) {
+        subs[i] = test_context_socket (ZMQ_SUB);
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (subs[i], ZMQ_SUBSCRIBE, "", 0));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (
+          subs[i], i == sub_count - 1 ? "inproc://mmsg" : endpoint));
+    }
+    msleep (SETTLE_TIME);
+
+    zmq_msg_t received[BATCH_SIZE];
+    init_empty_batch (received, BATCH_SIZE);
+    for (int i = 0; i != sub_count; i++)
+        TEST_ASSERT_FAILURE_ERRNO (
+          EAGAIN, zmq_recvmmsg (subs[i], received, BATCH_SIZE, ZMQ_DONTWAIT));
+    msleep (SETTLE_TIME);
+
+    //  A batch, then a single message, each delivered to all subscribers.
+    zmq_msg_t msgs[BATCH_SIZE];
+    init_batch (msgs, BATCH_SIZE - 1, 0);
+    TEST_ASSERT_EQUAL_INT (BATCH_SIZE - 1,
+                           zmq_sendmmsg (pub, msgs, BATCH_SIZE - 1, 0));
+    close_batch (msgs, BATCH_SIZE - 1);
+    init_batch (msgs, 1, BATCH_SIZE - 1);
+    TEST_ASSERT_EQUAL_INT (sizeof (int), zmq_msg_send (&msgs[0], pub, 0));
+    close_batch (msgs, 1);
+
+    for (int i = 0; i != sub_count; i++) {
+        int total = 0;
+        while (total < BATCH_SIZE) {
+            const int rc = TEST_ASSERT_SUCCESS_ERRNO (zmq_recvmmsg (
+              subs[i], received + total, BATCH_SIZE - total, 0));
+            total += rc;
+        }
+        for (int j = 0; j != BATCH_SIZE; j++)
+            TEST_ASSERT_EQUAL_INT (j, batch_value (&received[j]));
+    }
+    close_batch (received, BATCH_SIZE);
+
+    //  The TCP subscribers were woken up together at least once.
+    zmq_counters_t counters;
+    size_t counters_len = sizeof counters;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pub, ZMQ_COUNTERS, &counters, &counters_len));
+    TEST_ASSERT_GREATER_OR_EQUAL (sub_count - 1,
+                                  counters.batched_activations);
+
+    for (int i = 0; i != sub_count; i++)
+        test_context_socket_close (subs[i]);
+    test_context_socket_close (pub);
+}
+
+void test_multipart ()
+{
+    void *out = test_context_socket (ZMQ_PUSH);
+    void *in = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (in, "inproc://mmsg"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (out, "inproc://mmsg"));
+
+    //  With ZMQ_SNDMORE the whole batch is a single multi-part message.
+    zmq_msg_t msgs[3];
+    init_batch (msgs, 3, 0);
+    TEST_ASSERT_EQUAL_INT (3, zmq_sendmmsg (out, msgs, 3, ZMQ_SNDMORE));
+    close_batch (msgs, 3);
+
+    init_empty_batch (msgs, 3);
+    TEST_ASSERT_EQUAL_INT (3, zmq_recvmmsg (in, msgs, 3, 0));
+    TEST_ASSERT_EQUAL_INT (1, zmq_msg_more (&msgs[0]));
+    TEST_ASSERT_EQUAL_INT (1, zmq_msg_more (&msgs[1]));
+    TEST_ASSERT_EQUAL_INT (0, zmq_msg_more (&msgs[2]));
+    close_batch (msgs, 3);
+
+    int rcvmore;
+    size_t size = sizeof rcvmore;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (in, ZMQ_RCVMORE, &rcvmore, &size));
+    TEST_ASSERT_EQUAL_INT (0, rcvmore);
+
+    test_context_socket_close (out);
+    test_context_socket_close (in);
+}
+
+void test_router_routing_id ()
+{
+    void *router = test_context_socket (ZMQ_ROUTER);
+    void *dealer = test_context_socket (ZMQ_DEALER);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (dealer, ZMQ_ROUTING_ID, "D", 1));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (router, "inproc://mmsg"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (dealer, "inproc://mmsg"));
+
+    zmq_msg_t msgs[2];
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msgs[0], 1));
+    memcpy (zmq_msg_data (&msgs[0]), "D", 1);
+    init_batch (msgs + 1, 1, 42);
+    TEST_ASSERT_EQUAL_INT (2, zmq_sendmmsg (router, msgs, 2, ZMQ_SNDMORE));
+    close_batch (msgs, 2);
+
+    init_empty_batch (msgs, 1);
+    TEST_ASSERT_EQUAL_INT (1, zmq_recvmmsg (dealer, msgs, 1, 0));
+    TEST_ASSERT_EQUAL_INT (42, batch_value (&msgs[0]));
+    close_batch (msgs, 1);
+
+    test_context_socket_close (router);
+    test_context_socket_close (dealer);
+}
+
+void test_recv_nonblocking ()
+{
+    void *in = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (in, "inproc://mmsg"));
+
+    zmq_msg_t msgs[BATCH_SIZE];
+    init_empty_batch (msgs, BATCH_SIZE);
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_recvmmsg (in, msgs, BATCH_SIZE, ZMQ_DONTWAIT));
+    close_batch (msgs, BATCH_SIZE);
+
+    test_context_socket_close (in);
+}
+
+void test_send_hwm ()
+{
+    void *out = test_context_socket (ZMQ_PUSH);
+    void *in = test_context_socket (ZMQ_PULL);
+    int hwm = 4;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (out, ZMQ_SNDHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (in, ZMQ_RCVHWM, &hwm, sizeof hwm));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (in, "inproc://mmsg"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (out, "inproc://mmsg"));
+
+    //  Only the messages fitting under the high water marks are sent.
+    zmq_msg_t msgs[BATCH_SIZE];
+    init_batch (msgs, BATCH_SIZE, 0);
+    TEST_ASSERT_EQUAL_INT (
+      2 * hwm, zmq_sendmmsg (out, msgs, BATCH_SIZE, ZMQ_DONTWAIT));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, zmq_sendmmsg (out, msgs + 2 * hwm, BATCH_SIZE - 2 * hwm,
+                            ZMQ_DONTWAIT));
+    TEST_ASSERT_EQUAL_INT (2 * hwm, batch_value (&msgs[2 * hwm]));
+    close_batch (msgs, BATCH_SIZE);
+
+    init_empty_batch (msgs, BATCH_SIZE);
+    TEST_ASSERT_EQUAL_INT (2 * hwm,
+                           zmq_recvmmsg (in, msgs, BATCH_SIZE, ZMQ_DONTWAIT));
+    close_batch (msgs, BATCH_SIZE);
+
+    test_context_socket_close (out);
+    test_context_socket_close (in);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_push_pull_inproc);
+    RUN_TEST (test_push_pull_tcp);
+    RUN_TEST (test_pub_sub_inproc);
+    RUN_TEST (test_dealer_dealer_tcp);
+    RUN_TEST (test_pub_fanout);
+    RUN_TEST (test_multipart);
+    RUN_TEST (test_router_routing_id);
+    RUN_TEST (test_recv_nonblocking);
+    RUN_TEST (test_send_hwm);
+    return UNITY_END ();
+}
@@ -0,0 +1,236 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <unity.h>
+
+#define CLIENT_COUNT 50
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void set_tcp_listeners (void *socket_, int listeners_)
+{
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      socket_, ZMQ_TCP_LISTENERS, &listeners_, sizeof (listeners_)));
+}
+
+void test_option ()
+{
+    void *pull = test_context_socket (ZMQ_PULL);
+    int listeners = 0;
+    size_t size = sizeof (listeners);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_TCP_LISTENERS, &listeners, &size));
+    TEST_ASSERT_EQUAL_INT (1, listeners);
+
+    listeners = 0;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_setsockopt (pull, ZMQ_TCP_LISTENERS,
+                                               &listeners, sizeof (listeners)));
+
+    set_tcp_listeners (pull, 1);
+    test_context_socket_close (pull);
+}
+
+//  Returns the number of listening events pending on the monitor.
+static int count_listening_events (void *monitor_)
+{
+    int count = 0;
+    while (true) {
+        zmq_msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+        if (zmq_msg_recv (&msg, monitor_, ZMQ_DONTWAIT) == -1) {
+            TEST_ASSERT_EQUAL_INT (EAGAIN, zmq_errno ());
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+            return count;
+        }
+        uint16_t event;
+        memcpy (&event, zmq_msg_data (&msg), sizeof (event));
+        TEST_ASSERT_EQUAL_INT (ZMQ_EVENT_LISTENING, event);
+        count++;
+
+        //  Skip the address frame.
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, monitor_, 0));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+    }
+}
+
+//  Connects many clients to a PULL socket bound with the given number of
+//  listeners, and checks that they all get through.
+static void check_clients (void *ctx_, int listeners_)
+{
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    TEST_ASSERT_NOT_NULL (pull);
+    set_tcp_listeners (pull, listeners_);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_socket_monitor (
+      pull, "inproc://monitor-listeners", ZMQ_EVENT_LISTENING));
+    void *monitor = zmq_socket (ctx_, ZMQ_PAIR);
+    TEST_ASSERT_NOT_NULL (monitor);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_connect (monitor, "inproc://monitor-listeners"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "tcp://127.0.0.1:*"));
+
+    //  Each listener reports that it is listening while binding.
+    msleep (SETTLE_TIME);
+    TEST_ASSERT_EQUAL_INT (listeners_, count_listening_events (monitor));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (monitor));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t endpoint_len = sizeof (endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+
+    void *pushes[CLIENT_COUNT];
+    for (int i = 0; i != CLIENT_COUNT; i++) {
+        pushes[i] = zmq_socket (ctx_, ZMQ_PUSH);
+        TEST_ASSERT_NOT_NULL (pushes[i]);
+        int linger = 0;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_setsockopt (pushes[i], ZMQ_LINGER, &linger, sizeof (linger)));
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (pushes[i], endpoint));
+        send_string_expect_success (pushes[i], "hello", 0);
+    }
+
+    for (int i = 0; i != CLIENT_COUNT; i++)
+        recv_string_expect_success (pull, "hello", 0);
+
+    for (int i = 0; i != CLIENT_COUNT; i++)
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pushes[i]));
+
+    //  All the listeners are closed along with the endpoint, so that
+    //  the address can be bound again.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_unbind (pull, endpoint));
+    msleep (SETTLE_TIME);
+    void *rebound = zmq_socket (ctx_, ZMQ_PULL);
+    TEST_ASSERT_NOT_NULL (rebound);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (rebound, endpoint));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (rebound));
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+}
+
+void test_single_listener ()
+{
+    check_clients (get_test_context (), 1);
+}
+
+void test_sharded_listeners ()
+{
+#ifdef ZMQ_HAVE_LINUX
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_set (ctx, ZMQ_IO_THREADS, 4));
+    check_clients (ctx, 4);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+#else
+    TEST_IGNORE_MESSAGE ("SO_REUSEPORT not known to be available");
+#endif
+}
+
+//  Receives a monitor event, returning its value.
+static int recv_monitor_event (void *monitor_, uint16_t expected_event_)
+{
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    TEST_ASSERT_EQUAL_INT (6, zmq_msg_recv (&msg, monitor_, 0));
+    const uint8_t *data = (const uint8_t *) zmq_msg_data (&msg);
+    uint16_t event;
+    memcpy (&event, data, sizeof (event));
+    uint32_t value;
+    memcpy (&value, data + sizeof (event), sizeof (value));
+    TEST_ASSERT_EQUAL_INT (expected_event_, event);
+
+    //  Skip the address frame.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_recv (&msg, monitor_, 0));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+    return (int) value;
+}
+
+void test_filtered_connection ()
+{
+#ifdef ZMQ_HAVE_LINUX
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_TCP_ACCEPT_FILTER, "127.0.0.2", 9));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_socket_monitor (
+      pull, "inproc://monitor-filter", ZMQ_EVENT_ACCEPT_FAILED));
+    void *monitor = test_context_socket (ZMQ_PAIR);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_connect (monitor, "inproc://monitor-filter"));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "tcp://127.0.0.1:*"));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t endpoint_len = sizeof (endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+
+    //  The connection from an address not in the filters is reported as
+    //  refused rather than with whatever errno was left behind.
+    void *refused = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (refused, endpoint));
+    TEST_ASSERT_EQUAL_INT (
+      ECONNREFUSED, recv_monitor_event (monitor, ZMQ_EVENT_ACCEPT_FAILED));
+
+    //  Connections from the allowed address still get through.
+    char allowed_endpoint[MAX_SOCKET_STRING + 16];
+    sprintf (allowed_endpoint, "tcp://127.0.0.2:0;%s",
+             endpoint + strlen ("tcp://"));
+    void *allowed = test_context_socket (ZMQ_PUSH);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (allowed, allowed_endpoint));
+    send_string_expect_success (allowed, "hello", 0);
+    recv_string_expect_success (pull, "hello", 0);
+
+    test_context_socket_close (refused);
+    test_context_socket_close (allowed);
+    test_context_socket_close (monitor);
+    test_context_socket_close (pull);
+#else
+    TEST_IGNORE_MESSAGE ("127.0.0.2 not known to be a local address");
+#endif
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_option);
+    RUN_TEST (test_single_listener);
+    RUN_TEST (test_sharded_listeners);
+    RUN_TEST (test_filtered_connection);
+    return UNITY_END ();
+}
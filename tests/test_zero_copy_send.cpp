@@ -0,0 +1,268 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "testutil.hpp"
+#include "testutil_unity.hpp"
+
+#include <stdlib.h>
+
+#include <unity.h>
+
+void setUp ()
+{
+    setup_test_context ();
+}
+
+void tearDown ()
+{
+    teardown_test_context ();
+}
+
+static void fill (unsigned char *data_, size_t size_, size_t seed_)
+{
+    for (size_t i = 0; i != size_; i++)
+        data_[i] = (unsigned char) ((i * 31 + seed_) & 0xff);
+}
+
+static void check (const unsigned char *data_, size_t size_, size_t seed_)
+{
+    for (size_t i = 0; i != size_; i++)
+        if (data_[i] != (unsigned char) ((i * 31 + seed_) & 0xff))
+            TEST_FAIL_MESSAGE ("message content mismatch");
+}
+
+static void free_fn (void *data_, void *hint_)
+{
+    free (data_);
+    ++*(int *) hint_;
+}
+
+//  Sizes around the encoder's buffer size, where the content starts
+//  to be written straight from the message.
+static const size_t sizes[] = {0,    1,     8191,  8192,   8193,
+                               9000, 65536, 65537, 1000000};
+static const size_t sizes_count = sizeof sizes / sizeof sizes[0];
+
+static void test_roundtrip (int zero_copy_send_, const char *endpoint_)
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      push, ZMQ_ZERO_COPY_SEND, &zero_copy_send_, sizeof zero_copy_send_));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t len = sizeof endpoint;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, endpoint_));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &len));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    //  Messages are sent back to back, so that small and large ones get
+    //  batched together, and as multi-part messages.
+    int freed = 0;
+    for (size_t i = 0; i != 2 * sizes_count; i++) {
+        const size_t size = sizes[i % sizes_count];
+        unsigned char *data = (unsigned char *) malloc (size ? size : 1);
+        TEST_ASSERT_NOT_NULL (data);
+        fill (data, size, i);
+        zmq_msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_msg_init_data (&msg, data, size, free_fn, &freed));
+        const int flags = i < sizes_count ? 0 : ZMQ_SNDMORE;
+        TEST_ASSERT_EQUAL_INT ((int) size, zmq_msg_send (&msg, push, flags));
+    }
+    send_string_expect_success (push, "end", 0);
+
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    for (size_t i = 0; i != 2 * sizes_count; i++) {
+        const size_t size = sizes[i % sizes_count];
+        TEST_ASSERT_EQUAL_INT ((int) size, zmq_msg_recv (&msg, pull, 0));
+        check ((const unsigned char *) zmq_msg_data (&msg), size, i);
+        TEST_ASSERT_EQUAL_INT (i >= sizes_count, zmq_msg_more (&msg));
+    }
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+    recv_string_expect_success (pull, "end", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+
+    //  All the messages are released once the connection is gone.
+    teardown_test_context ();
+    TEST_ASSERT_EQUAL_INT ((int) (2 * sizes_count), freed);
+}
+
+void test_copy_tcp ()
+{
+    test_roundtrip (0, "tcp://127.0.0.1:*");
+}
+
+void test_zero_copy_tcp ()
+{
+    test_roundtrip (8192, "tcp://127.0.0.1:*");
+}
+
+void test_zero_copy_small_threshold_tcp ()
+{
+    test_roundtrip (1, "tcp://127.0.0.1:*");
+}
+
+void test_zero_copy_small_parts_tcp ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    int zero_copy_send = 20;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      push, ZMQ_ZERO_COPY_SEND, &zero_copy_send, sizeof zero_copy_send));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t len = sizeof endpoint;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "tcp://127.0.0.1:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &len));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    //  Parts just above the threshold, many of them small enough to be
+    //  stored in the message itself, are sent without receiving any, so
+    //  that plenty of them are in flight at once.
+    const int parts = 1000;
+    for (int i = 0; i != parts; i++) {
+        const size_t size = zero_copy_send + i % 48;
+        zmq_msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init_size (&msg, size));
+        fill ((unsigned char *) zmq_msg_data (&msg), size, i);
+        TEST_ASSERT_EQUAL_INT ((int) size,
+                               zmq_msg_send (&msg, push, ZMQ_SNDMORE));
+    }
+    send_string_expect_success (push, "end", 0);
+
+    zmq_msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_init (&msg));
+    for (int i = 0; i != parts; i++) {
+        const size_t size = zero_copy_send + i % 48;
+        TEST_ASSERT_EQUAL_INT ((int) size, zmq_msg_recv (&msg, pull, 0));
+        check ((const unsigned char *) zmq_msg_data (&msg), size, i);
+    }
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+    recv_string_expect_success (pull, "end", 0);
+
+    test_context_socket_close (push);
+    test_context_socket_close (pull);
+}
+
+void test_zero_copy_unread_tcp ()
+{
+    void *push = test_context_socket (ZMQ_PUSH);
+    void *pull = test_context_socket (ZMQ_PULL);
+    int zero_copy_send = 8192;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_setsockopt (
+      push, ZMQ_ZERO_COPY_SEND, &zero_copy_send, sizeof zero_copy_send));
+    int hwm = 1;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_RCVHWM, &hwm, sizeof hwm));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t len = sizeof endpoint;
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "tcp://127.0.0.1:*"));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &len));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, endpoint));
+
+    //  The messages are never received, so the connection is still full
+    //  of data written from them when the sending engine goes away.
+    int sent = 0;
+    int freed = 0;
+    const size_t size = 1000000;
+    for (int i = 0; i != 16; i++) {
+        unsigned char *data = (unsigned char *) malloc (size);
+        TEST_ASSERT_NOT_NULL (data);
+        zmq_msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (
+          zmq_msg_init_data (&msg, data, size, free_fn, &freed));
+        if (zmq_msg_send (&msg, push, ZMQ_DONTWAIT) == -1) {
+            TEST_ASSERT_EQUAL_INT (EAGAIN, errno);
+            TEST_ASSERT_SUCCESS_ERRNO (zmq_msg_close (&msg));
+            break;
+        }
+        sent++;
+    }
+    msleep (SETTLE_TIME);
+
+    int linger = 0;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LINGER, &linger, sizeof linger));
+    test_context_socket_close (push);
+    msleep (SETTLE_TIME);
+    test_context_socket_close (pull);
+
+    //  All the messages are released once the kernel is done with them.
+    teardown_test_context ();
+    TEST_ASSERT_EQUAL_INT (sent + (sent < 16), freed);
+}
+
+#if !defined ZMQ_HAVE_WINDOWS
+void test_zero_copy_ipc ()
+{
+    //  Not supported for IPC, messages are copied.
+    test_roundtrip (8192, "ipc:///tmp/test_zero_copy_send");
+}
+#endif
+
+void test_zero_copy_send_option ()
+{
+    void *socket = test_context_socket (ZMQ_PUSH);
+    int value = -1;
+    TEST_ASSERT_FAILURE_ERRNO (EINVAL,
+                               zmq_setsockopt (socket, ZMQ_ZERO_COPY_SEND,
+                                               &value, sizeof value));
+
+    value = 65536;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (socket, ZMQ_ZERO_COPY_SEND, &value, sizeof value));
+    value = 0;
+    size_t size = sizeof value;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (socket, ZMQ_ZERO_COPY_SEND, &value, &size));
+    TEST_ASSERT_EQUAL_INT (65536, value);
+    test_context_socket_close (socket);
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_copy_tcp);
+    RUN_TEST (test_zero_copy_tcp);
+    RUN_TEST (test_zero_copy_small_threshold_tcp);
+    RUN_TEST (test_zero_copy_small_parts_tcp);
+    RUN_TEST (test_zero_copy_unread_tcp);
+#if !defined ZMQ_HAVE_WINDOWS
+    RUN_TEST (test_zero_copy_ipc);
+#endif
+    RUN_TEST (test_zero_copy_send_option);
+    return UNITY_END ();
+}
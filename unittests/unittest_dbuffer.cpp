@@ -0,0 +1,279 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+#include "../tests/testutil_unity.hpp"
+
+#include <dbuffer.hpp>
+#include <atomic_counter.hpp>
+#include <mutex.hpp>
+
+#include <unity.h>
+
+#include <algorithm>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static void write_value (zmq::dbuffer_t<zmq::msg_t> &dbuffer_, int value_)
+{
+    zmq::msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (msg.init_size (sizeof value_));
+    memcpy (msg.data (), &value_, sizeof value_);
+    dbuffer_.write (msg);
+    TEST_ASSERT_EQUAL_INT (0, msg.size ());
+    TEST_ASSERT_SUCCESS_ERRNO (msg.close ());
+}
+
+static int read_value (zmq::dbuffer_t<zmq::msg_t> &dbuffer_)
+{
+    zmq::msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (msg.init ());
+    TEST_ASSERT_TRUE (dbuffer_.read (&msg));
+    TEST_ASSERT_EQUAL_INT (sizeof (int), msg.size ());
+    int value;
+    memcpy (&value, msg.data (), sizeof value);
+    TEST_ASSERT_SUCCESS_ERRNO (msg.close ());
+    return value;
+}
+
+void test_read_empty ()
+{
+    zmq::dbuffer_t<zmq::msg_t> dbuffer;
+    TEST_ASSERT_FALSE (dbuffer.check_read ());
+
+    zmq::msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (msg.init ());
+    TEST_ASSERT_FALSE (dbuffer.read (&msg));
+    TEST_ASSERT_FALSE (dbuffer.read (NULL));
+    TEST_ASSERT_SUCCESS_ERRNO (msg.close ());
+}
+
+void test_write_read ()
+{
+    zmq::dbuffer_t<zmq::msg_t> dbuffer;
+    for (int i = 0; i != 10; i++) {
+        write_value (dbuffer, i);
+        TEST_ASSERT_TRUE (dbuffer.check_read ());
+        TEST_ASSERT_EQUAL_INT (i, read_value (dbuffer));
+        TEST_ASSERT_FALSE (dbuffer.check_read ());
+    }
+}
+
+void test_last_value_wins ()
+{
+    zmq::dbuffer_t<zmq::msg_t> dbuffer;
+    for (int i = 0; i != 10; i++)
+        write_value (dbuffer, i);
+    TEST_ASSERT_EQUAL_INT (9, read_value (dbuffer));
+    TEST_ASSERT_FALSE (dbuffer.check_read ());
+
+    //  Once check_read found a value, the value is kept for the next read
+    //  and the later ones follow it.
+    write_value (dbuffer, 10);
+    TEST_ASSERT_TRUE (dbuffer.check_read ());
+    write_value (dbuffer, 11);
+    TEST_ASSERT_EQUAL_INT (10, read_value (dbuffer));
+    TEST_ASSERT_EQUAL_INT (11, read_value (dbuffer));
+    TEST_ASSERT_FALSE (dbuffer.check_read ());
+}
+
+void test_destroy_non_empty ()
+{
+    //  Values too large to be stored inline must be released.
+    zmq::dbuffer_t<zmq::msg_t> dbuffer;
+    for (int i = 0; i != 3; i++) {
+        zmq::msg_t msg;
+        TEST_ASSERT_SUCCESS_ERRNO (msg.init_size (1024));
+        dbuffer.write (msg);
+        TEST_ASSERT_SUCCESS_ERRNO (msg.close ());
+    }
+}
+
+//  The dbuffer as it was before, swapping the buffers under a mutex. Used
+//  as the benchmark baseline.
+class locked_dbuffer_t
+{
+  public:
+    locked_dbuffer_t () :
+        back (&storage[0]),
+        front (&storage[1]),
+        has_msg (false)
+    {
+        back->init ();
+        front->init ();
+    }
+
+    ~locked_dbuffer_t ()
+    {
+        back->close ();
+        front->close ();
+    }
+
+    void write (const zmq::msg_t &value_)
+    {
+        zmq::msg_t &xvalue = const_cast<zmq::msg_t &> (value_);
+        back->move (xvalue);
+        if (sync.try_lock ()) {
+            std::swap (back, front);
+            has_msg = true;
+            sync.unlock ();
+        }
+    }
+
+    bool read (zmq::msg_t *value_)
+    {
+        zmq::scoped_lock_t lock (sync);
+        if (!has_msg)
+            return false;
+        *value_ = *front;
+        front->init ();
+        has_msg = false;
+        return true;
+    }
+
+  private:
+    zmq::msg_t storage[2];
+    zmq::msg_t *back, *front;
+    zmq::mutex_t sync;
+    bool has_msg;
+};
+
+template <typename B> struct producer_t
+{
+    B *dbuffer;
+    int count;
+    zmq::atomic_counter_t done;
+};
+
+template <typename B> void produce (void *arg_)
+{
+    producer_t<B> *producer = (producer_t<B> *) arg_;
+    for (int i = 1; i <= producer->count; i++) {
+        zmq::msg_t msg;
+        int rc = msg.init_size (sizeof i);
+        zmq_assert (rc == 0);
+        memcpy (msg.data (), &i, sizeof i);
+        producer->dbuffer->write (msg);
+        rc = msg.close ();
+        zmq_assert (rc == 0);
+    }
+    producer->done.set (1);
+}
+
+//  Writes count values from another thread while reading them as fast as
+//  possible. Values must be read in order, though most are skipped.
+//  Returns the last value read, fills in the number of values read and
+//  the elapsed time.
+template <typename B>
+int run_producer (B &dbuffer_, int count_, int *reads_, unsigned long *us_)
+{
+    producer_t<B> producer;
+    producer.dbuffer = &dbuffer_;
+    producer.count = count_;
+
+    zmq::msg_t msg;
+    TEST_ASSERT_SUCCESS_ERRNO (msg.init ());
+
+    void *watch = zmq_stopwatch_start ();
+    void *thread = zmq_threadstart (&produce<B>, &producer);
+    int last = 0;
+    *reads_ = 0;
+    while (true) {
+        //  Once done is seen, all the writes are visible.
+        const bool done = producer.done.get () != 0;
+        if (dbuffer_.read (&msg)) {
+            int value;
+            memcpy (&value, msg.data (), sizeof value);
+            TEST_ASSERT_GREATER_THAN_INT (last, value);
+            last = value;
+            (*reads_)++;
+        } else if (done)
+            break;
+    }
+    *us_ = zmq_stopwatch_stop (watch);
+    zmq_threadclose (thread);
+
+    TEST_ASSERT_SUCCESS_ERRNO (msg.close ());
+    return last;
+}
+
+void test_concurrent ()
+{
+    const int count = 100000;
+    zmq::dbuffer_t<zmq::msg_t> dbuffer;
+    int reads;
+    unsigned long elapsed;
+
+    //  The last value written is never lost.
+    TEST_ASSERT_EQUAL_INT (count,
+                           run_producer (dbuffer, count, &reads, &elapsed));
+    TEST_ASSERT_FALSE (dbuffer.check_read ());
+}
+
+void test_benchmark ()
+{
+    const int count = 1000000;
+    int locked_reads, lock_free_reads;
+    unsigned long locked_us, lock_free_us;
+
+    locked_dbuffer_t locked;
+    const int locked_last =
+      run_producer (locked, count, &locked_reads, &locked_us);
+    zmq::dbuffer_t<zmq::msg_t> lock_free;
+    const int lock_free_last =
+      run_producer (lock_free, count, &lock_free_reads, &lock_free_us);
+
+    //  Rates in millions of writes per second.
+    printf ("locked %.2f Mmsg/s, %d read, last %d\n",
+            (double) count / (locked_us ? locked_us : 1), locked_reads,
+            locked_last);
+    printf ("lock-free %.2f Mmsg/s, %d read, last %d\n",
+            (double) count / (lock_free_us ? lock_free_us : 1),
+            lock_free_reads, lock_free_last);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_read_empty);
+    RUN_TEST (test_write_read);
+    RUN_TEST (test_last_value_wins);
+    RUN_TEST (test_destroy_non_empty);
+    RUN_TEST (test_concurrent);
+    RUN_TEST (test_benchmark);
+    return UNITY_END ();
+}
@@ -0,0 +1,210 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <decoder_allocators.hpp>
+#include <config.hpp>
+
+#include <unity.h>
+
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+//  Builds a zero-copy message on top of the current buffer of the
+//  allocator, the way the decoders do.
+static void init_msg (zmq::shared_message_memory_allocator &allocator_,
+                      zmq::msg_t &msg_)
+{
+    int rc = msg_.init (allocator_.data (), 64,
+                        zmq::shared_message_memory_allocator::call_dec_ref,
+                        allocator_.buffer (), allocator_.provide_content ());
+    TEST_ASSERT_EQUAL_INT (0, rc);
+    TEST_ASSERT_TRUE (msg_.is_zcmsg ());
+    allocator_.advance_content ();
+    allocator_.inc_ref ();
+}
+
+//  Counts the buffers taken from and given back to the heap.
+struct heap_counts_t
+{
+    size_t allocated;
+    size_t freed;
+};
+
+static void *counting_allocate (size_t size_, void *hint_)
+{
+    static_cast<heap_counts_t *> (hint_)->allocated++;
+    return malloc (size_);
+}
+
+static void counting_deallocate (void *data_, size_t, void *hint_)
+{
+    static_cast<heap_counts_t *> (hint_)->freed++;
+    free (data_);
+}
+
+static zmq::allocator_t counting_allocator (heap_counts_t &counts_)
+{
+    counts_.allocated = 0;
+    counts_.freed = 0;
+    return zmq::allocator_t (counting_allocate, counting_deallocate, &counts_);
+}
+
+void test_buffer_reused ()
+{
+    heap_counts_t counts;
+    {
+        zmq::shared_message_memory_allocator allocator (
+          8192, counting_allocator (counts));
+        allocator.allocate ();
+        unsigned char *first = allocator.buffer ();
+
+        //  The buffer is still in use by the message, so a new one is
+        //  needed.
+        zmq::msg_t msg;
+        init_msg (allocator, msg);
+        allocator.allocate ();
+        TEST_ASSERT_TRUE (allocator.buffer () != first);
+        TEST_ASSERT_EQUAL_UINT (2, counts.allocated);
+
+        //  Closing the message puts the first buffer back into the pool
+        //  rather than freeing it.
+        TEST_ASSERT_EQUAL_INT (0, msg.close ());
+        TEST_ASSERT_EQUAL_UINT (0, counts.freed);
+
+        init_msg (allocator, msg);
+        allocator.allocate ();
+        TEST_ASSERT_TRUE (allocator.buffer () == first);
+        TEST_ASSERT_EQUAL_UINT (2, counts.allocated);
+
+        TEST_ASSERT_EQUAL_INT (0, msg.close ());
+    }
+    TEST_ASSERT_EQUAL_UINT (counts.allocated, counts.freed);
+}
+
+void test_pool_bounded ()
+{
+    const size_t count = zmq::recv_buffer_pool_size + 6;
+    heap_counts_t counts;
+    {
+        zmq::shared_message_memory_allocator allocator (
+          8192, counting_allocator (counts));
+        allocator.allocate ();
+
+        std::vector<zmq::msg_t> msgs (count);
+        for (size_t i = 0; i != count; i++) {
+            init_msg (allocator, msgs[i]);
+            allocator.allocate ();
+        }
+        for (size_t i = 0; i != count; i++)
+            TEST_ASSERT_EQUAL_INT (0, msgs[i].close ());
+
+        TEST_ASSERT_EQUAL_UINT (count + 1, counts.allocated);
+        TEST_ASSERT_EQUAL_UINT (count - zmq::recv_buffer_pool_size,
+                                  counts.freed);
+    }
+    TEST_ASSERT_EQUAL_UINT (counts.allocated, counts.freed);
+}
+
+void test_msg_outlives_allocator ()
+{
+    heap_counts_t counts;
+    zmq::msg_t msgs[2];
+    {
+        zmq::shared_message_memory_allocator allocator (
+          8192, counting_allocator (counts));
+        allocator.allocate ();
+        init_msg (allocator, msgs[0]);
+        allocator.allocate ();
+        init_msg (allocator, msgs[1]);
+        allocator.allocate ();
+
+        //  Puts a buffer into the pool before it is closed.
+        TEST_ASSERT_EQUAL_INT (0, msgs[0].close ());
+        TEST_ASSERT_EQUAL_UINT (0, counts.freed);
+    }
+
+    //  The buffer is freed along with the pool it was taken from.
+    TEST_ASSERT_EQUAL_UINT (2, counts.freed);
+    TEST_ASSERT_EQUAL_INT (0, msgs[1].close ());
+    TEST_ASSERT_EQUAL_UINT (3, counts.freed);
+}
+
+static void close_msgs (void *msgs_)
+{
+    std::vector<zmq::msg_t> &msgs =
+      *static_cast<std::vector<zmq::msg_t> *> (msgs_);
+    for (size_t i = 0; i != msgs.size (); i++)
+        TEST_ASSERT_EQUAL_INT (0, msgs[i].close ());
+}
+
+void test_close_from_other_thread ()
+{
+    const size_t batches = 100;
+    const size_t count = 100;
+    heap_counts_t counts;
+    {
+        zmq::shared_message_memory_allocator allocator (
+          8192, counting_allocator (counts));
+        allocator.allocate ();
+
+        for (size_t i = 0; i != batches; i++) {
+            std::vector<zmq::msg_t> msgs (count);
+            for (size_t j = 0; j != count; j++) {
+                init_msg (allocator, msgs[j]);
+                allocator.allocate ();
+            }
+            void *thread = zmq_threadstart (close_msgs, &msgs);
+            zmq_threadclose (thread);
+        }
+
+        //  Buffers put back by the other thread are taken again.
+        TEST_ASSERT_TRUE (counts.allocated < batches * count + 1);
+    }
+    TEST_ASSERT_EQUAL_UINT (counts.allocated, counts.freed);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_buffer_reused);
+    RUN_TEST (test_pool_bounded);
+    RUN_TEST (test_msg_outlives_allocator);
+    RUN_TEST (test_close_from_other_thread);
+    return UNITY_END ();
+}
@@ -0,0 +1,250 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+#include "../tests/testutil_unity.hpp"
+
+#include <ctx.hpp>
+#include <dns_resolver.hpp>
+#include <mutex.hpp>
+#include <tcp_address.hpp>
+
+#include <unity.h>
+
+#include <string>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+//  Stub resolver mapping every host name to the loopback address. Lookups
+//  of the names starting with "slow." block until released, for at most
+//  a few seconds so that a stalled I/O thread fails the test rather than
+//  hanging it.
+static zmq::mutex_t stub_sync;
+static bool stub_released;
+static int stub_calls;
+
+static int stub_resolve (zmq::tcp_address_t *addr_,
+                         const char *address_,
+                         bool ipv6_)
+{
+    const std::string address (address_);
+    bool slow;
+    {
+        zmq::scoped_lock_t locker (stub_sync);
+        stub_calls++;
+        slow = address.compare (0, 5, "slow.") == 0;
+    }
+    for (int i = 0; slow && i != 500; i++) {
+        {
+            zmq::scoped_lock_t locker (stub_sync);
+            if (stub_released)
+                break;
+        }
+        msleep (10);
+    }
+    const std::string loopback =
+      "127.0.0.1" + address.substr (address.rfind (':'));
+    return addr_->resolve (loopback.c_str (), false, ipv6_);
+}
+
+static void reset_stub ()
+{
+    zmq::scoped_lock_t locker (stub_sync);
+    stub_released = false;
+    stub_calls = 0;
+}
+
+static void release_stub ()
+{
+    zmq::scoped_lock_t locker (stub_sync);
+    stub_released = true;
+}
+
+static int get_stub_calls ()
+{
+    zmq::scoped_lock_t locker (stub_sync);
+    return stub_calls;
+}
+
+static void *create_context ()
+{
+    reset_stub ();
+    void *ctx = zmq_ctx_new ();
+    TEST_ASSERT_NOT_NULL (ctx);
+    ((zmq::ctx_t *) ctx)->get_dns_resolver ()->set_resolve_fn (stub_resolve);
+    return ctx;
+}
+
+//  Binds a PULL socket to a loopback port and returns the address to
+//  connect to it through the given host name.
+static void *bind_pull (void *ctx_, const char *host_, std::string *address_)
+{
+    void *pull = zmq_socket (ctx_, ZMQ_PULL);
+    TEST_ASSERT_NOT_NULL (pull);
+    int timeout = 2000;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (pull, ZMQ_RCVTIMEO, &timeout, sizeof (int)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_bind (pull, "tcp://127.0.0.1:*"));
+    char endpoint[MAX_SOCKET_STRING];
+    size_t endpoint_len = sizeof (endpoint);
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_getsockopt (pull, ZMQ_LAST_ENDPOINT, endpoint, &endpoint_len));
+    *address_ = std::string ("tcp://") + host_ + strrchr (endpoint, ':');
+    return pull;
+}
+
+static void *connect_push (void *ctx_, const std::string &address_)
+{
+    void *push = zmq_socket (ctx_, ZMQ_PUSH);
+    TEST_ASSERT_NOT_NULL (push);
+    int linger = 0;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      zmq_setsockopt (push, ZMQ_LINGER, &linger, sizeof (int)));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_connect (push, address_.c_str ()));
+    return push;
+}
+
+void test_lookup_numeric ()
+{
+    zmq::dns_resolver_t resolver (NULL);
+    resolver.set_resolve_fn (stub_resolve);
+    reset_stub ();
+
+    zmq::tcp_address_t addr;
+    TEST_ASSERT_SUCCESS_ERRNO (
+      resolver.lookup ("127.0.0.1:5555", false, &addr));
+    TEST_ASSERT_SUCCESS_ERRNO (
+      resolver.lookup ("127.0.0.1:0;127.0.0.1:5555", false, &addr));
+    TEST_ASSERT_SUCCESS_ERRNO (resolver.lookup ("[::1]:5555", true, &addr));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, resolver.lookup ("example.stub:5555", false, &addr));
+    TEST_ASSERT_FAILURE_ERRNO (
+      EAGAIN, resolver.lookup ("127.0.0.1:0;example.stub:5555", false, &addr));
+
+    //  Numeric addresses never reach the resolve function.
+    TEST_ASSERT_EQUAL_INT (0, get_stub_calls ());
+}
+
+void test_slow_lookup_does_not_stall_io_thread ()
+{
+    void *ctx = create_context ();
+
+    std::string slow_address;
+    void *slow_pull = bind_pull (ctx, "slow.stub", &slow_address);
+    std::string fast_address;
+    void *fast_pull = bind_pull (ctx, "127.0.0.1", &fast_address);
+
+    //  Both connections are handled by the single I/O thread.
+    void *slow_push = connect_push (ctx, slow_address);
+    void *fast_push = connect_push (ctx, fast_address);
+
+    //  The other connection keeps flowing while the lookup is pending.
+    while (get_stub_calls () == 0)
+        msleep (1);
+    for (int i = 0; i != 10; i++) {
+        send_string_expect_success (fast_push, "fast", 0);
+        recv_string_expect_success (fast_pull, "fast", 0);
+    }
+
+    release_stub ();
+    send_string_expect_success (slow_push, "slow", 0);
+    recv_string_expect_success (slow_pull, "slow", 0);
+
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (slow_push));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (fast_push));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (slow_pull));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (fast_pull));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+}
+
+static void connect_twice (void *ctx_, int ttl_)
+{
+    ((zmq::ctx_t *) ctx_)->get_dns_resolver ()->set_cache_ttl (ttl_);
+
+    std::string address;
+    void *pull = bind_pull (ctx_, "cached.stub", &address);
+    for (int i = 0; i != 2; i++) {
+        void *push = connect_push (ctx_, address);
+        send_string_expect_success (push, "cached", 0);
+        recv_string_expect_success (pull, "cached", 0);
+        TEST_ASSERT_SUCCESS_ERRNO (zmq_close (push));
+    }
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+}
+
+void test_cache ()
+{
+    void *ctx = create_context ();
+    connect_twice (ctx, 60000);
+    TEST_ASSERT_EQUAL_INT (1, get_stub_calls ());
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+}
+
+void test_cache_disabled ()
+{
+    void *ctx = create_context ();
+    connect_twice (ctx, 0);
+    TEST_ASSERT_EQUAL_INT (2, get_stub_calls ());
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+}
+
+void test_close_during_lookup ()
+{
+    void *ctx = create_context ();
+
+    std::string address;
+    void *pull = bind_pull (ctx, "slow.stub", &address);
+    void *push = connect_push (ctx, address);
+    while (get_stub_calls () == 0)
+        msleep (1);
+
+    //  The connecter waits for the pending lookup before going away.
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (push));
+    release_stub ();
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_close (pull));
+    TEST_ASSERT_SUCCESS_ERRNO (zmq_ctx_term (ctx));
+}
+
+int main ()
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_lookup_numeric);
+    RUN_TEST (test_slow_lookup_does_not_stall_io_thread);
+    RUN_TEST (test_cache);
+    RUN_TEST (test_cache_disabled);
+    RUN_TEST (test_close_during_lookup);
+    return UNITY_END ();
+}
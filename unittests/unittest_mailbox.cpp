@@ -0,0 +1,293 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <mailbox.hpp>
+#include <mailbox_safe.hpp>
+#include <mpsc_queue.hpp>
+#include <ypipe.hpp>
+#include <mutex.hpp>
+
+#include <unity.h>
+
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+void test_read_empty ()
+{
+    zmq::mpsc_queue_t<int, 4> queue;
+    int value = -1;
+    TEST_ASSERT_FALSE (queue.read (&value));
+    TEST_ASSERT_EQUAL_INT (-1, value);
+}
+
+void test_write_wakes_reader_once ()
+{
+    zmq::mpsc_queue_t<int, 4> queue;
+
+    //  The reader is not asleep until it finds the queue empty.
+    TEST_ASSERT_TRUE (queue.write (1));
+    int value = -1;
+    TEST_ASSERT_TRUE (queue.read (&value));
+    TEST_ASSERT_EQUAL_INT (1, value);
+    TEST_ASSERT_FALSE (queue.read (&value));
+
+    //  Only the first write after that has to wake the reader up.
+    TEST_ASSERT_FALSE (queue.write (2));
+    TEST_ASSERT_TRUE (queue.write (3));
+    TEST_ASSERT_TRUE (queue.read (&value));
+    TEST_ASSERT_EQUAL_INT (2, value);
+    TEST_ASSERT_TRUE (queue.read (&value));
+    TEST_ASSERT_EQUAL_INT (3, value);
+    TEST_ASSERT_FALSE (queue.read (&value));
+    TEST_ASSERT_FALSE (queue.read (&value));
+    TEST_ASSERT_FALSE (queue.write (4));
+}
+
+void test_overflow ()
+{
+    zmq::mpsc_queue_t<int, 4> queue;
+    int value = -1;
+    TEST_ASSERT_FALSE (queue.read (&value));
+
+    //  Items that don't fit into the ring are still read in order.
+    TEST_ASSERT_FALSE (queue.write (0));
+    for (int i = 1; i != 10; i++)
+        TEST_ASSERT_TRUE (queue.write (i));
+    for (int i = 0; i != 5; i++) {
+        TEST_ASSERT_TRUE (queue.read (&value));
+        TEST_ASSERT_EQUAL_INT (i, value);
+    }
+    for (int i = 10; i != 20; i++)
+        TEST_ASSERT_TRUE (queue.write (i));
+    for (int i = 5; i != 20; i++) {
+        TEST_ASSERT_TRUE (queue.read (&value));
+        TEST_ASSERT_EQUAL_INT (i, value);
+    }
+    TEST_ASSERT_FALSE (queue.read (&value));
+
+    //  Once drained, the ring is used again, wrapping around.
+    for (int round = 0; round != 3; round++) {
+        TEST_ASSERT_FALSE (queue.write (round));
+        TEST_ASSERT_TRUE (queue.write (round + 1));
+        TEST_ASSERT_TRUE (queue.read (&value));
+        TEST_ASSERT_EQUAL_INT (round, value);
+        TEST_ASSERT_TRUE (queue.read (&value));
+        TEST_ASSERT_EQUAL_INT (round + 1, value);
+        TEST_ASSERT_FALSE (queue.read (&value));
+    }
+}
+
+void test_destroy_non_empty ()
+{
+    zmq::mpsc_queue_t<int, 4> queue;
+    for (int i = 0; i != 100; i++)
+        queue.write (i);
+}
+
+//  The mailbox as it was before the lock-free queue, i.e. a ypipe with
+//  the writing side protected by a mutex. Used as the benchmark baseline.
+class locked_mailbox_t
+{
+  public:
+    locked_mailbox_t ()
+    {
+        const bool ok = cpipe.read (NULL);
+        zmq_assert (!ok);
+        active = false;
+    }
+
+    void send (const zmq::command_t &cmd_)
+    {
+        sync.lock ();
+        cpipe.write (cmd_, false);
+        const bool ok = cpipe.flush ();
+        sync.unlock ();
+        if (!ok)
+            signaler.send ();
+    }
+
+    int recv (zmq::command_t *cmd_, int timeout_)
+    {
+        if (active) {
+            if (cpipe.read (cmd_))
+                return 0;
+            active = false;
+        }
+        int rc = signaler.wait (timeout_);
+        if (rc == -1)
+            return -1;
+        rc = signaler.recv_failable ();
+        if (rc == -1)
+            return -1;
+        active = true;
+        const bool ok = cpipe.read (cmd_);
+        zmq_assert (ok);
+        return 0;
+    }
+
+  private:
+    zmq::ypipe_t<zmq::command_t, 16> cpipe;
+    zmq::signaler_t signaler;
+    zmq::mutex_t sync;
+    bool active;
+};
+
+template <typename M> struct producer_t
+{
+    M *mailbox;
+    int id;
+    int count;
+};
+
+template <typename M> void produce (void *arg_)
+{
+    producer_t<M> *producer = (producer_t<M> *) arg_;
+    zmq::command_t cmd;
+    cmd.destination = NULL;
+    cmd.type = zmq::command_t::activate_write;
+    for (int i = 0; i != producer->count; i++) {
+        //  Encode the producer and the sequence number into the command.
+        cmd.args.activate_write.msgs_read =
+          ((uint64_t) producer->id << 32) | (uint64_t) i;
+        producer->mailbox->send (cmd);
+    }
+}
+
+//  Sends count commands from each of the producers threads and checks that
+//  all of them arrive, in order per producer. Returns the elapsed time.
+template <typename M>
+unsigned long run_producers (M &mailbox_, int producers_, int count_)
+{
+    std::vector<producer_t<M> > producers (producers_);
+    std::vector<void *> threads (producers_);
+    std::vector<int> next (producers_, 0);
+
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != producers_; i++) {
+        producers[i].mailbox = &mailbox_;
+        producers[i].id = i;
+        producers[i].count = count_;
+        threads[i] = zmq_threadstart (&produce<M>, &producers[i]);
+    }
+
+    for (int received = 0; received != producers_ * count_;) {
+        zmq::command_t cmd;
+        if (mailbox_.recv (&cmd, -1) != 0)
+            continue;
+        const uint64_t value = cmd.args.activate_write.msgs_read;
+        const int id = (int) (value >> 32);
+        TEST_ASSERT_LESS_THAN_INT (producers_, id);
+        TEST_ASSERT_EQUAL_INT (next[id], (int) (value & 0xffffffff));
+        next[id]++;
+        received++;
+    }
+    const unsigned long elapsed = zmq_stopwatch_stop (watch);
+
+    for (int i = 0; i != producers_; i++)
+        zmq_threadclose (threads[i]);
+
+    //  Nothing else may have arrived.
+    zmq::command_t cmd;
+    TEST_ASSERT_EQUAL_INT (-1, mailbox_.recv (&cmd, 0));
+    return elapsed;
+}
+
+void test_mailbox_multiple_producers ()
+{
+    zmq::mailbox_t mailbox;
+    run_producers (mailbox, 8, 10000);
+}
+
+//  mailbox_safe_t expects its receivers to hold the mutex.
+struct safe_mailbox_t
+{
+    safe_mailbox_t () : mailbox (&sync) {}
+
+    void send (const zmq::command_t &cmd_) { mailbox.send (cmd_); }
+
+    int recv (zmq::command_t *cmd_, int timeout_)
+    {
+        zmq::scoped_lock_t lock (sync);
+        return mailbox.recv (cmd_, timeout_);
+    }
+
+    zmq::mutex_t sync;
+    zmq::mailbox_safe_t mailbox;
+};
+
+void test_mailbox_safe_multiple_producers ()
+{
+    safe_mailbox_t mailbox;
+    run_producers (mailbox, 8, 10000);
+}
+
+void test_benchmark ()
+{
+    const int total = 160000;
+    const int producer_counts[] = {1, 4, 16};
+
+    for (size_t i = 0;
+         i != sizeof producer_counts / sizeof producer_counts[0]; i++) {
+        const int producers = producer_counts[i];
+        locked_mailbox_t locked;
+        const unsigned long locked_us =
+          run_producers (locked, producers, total / producers);
+        zmq::mailbox_t lock_free;
+        const unsigned long lock_free_us =
+          run_producers (lock_free, producers, total / producers);
+
+        //  Rates in millions of commands per second.
+        printf ("%2d producers: locked %.2f Mcmd/s, lock-free %.2f Mcmd/s\n",
+                producers, (double) total / (locked_us ? locked_us : 1),
+                (double) total / (lock_free_us ? lock_free_us : 1));
+    }
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_read_empty);
+    RUN_TEST (test_write_wakes_reader_once);
+    RUN_TEST (test_overflow);
+    RUN_TEST (test_destroy_non_empty);
+    RUN_TEST (test_mailbox_multiple_producers);
+    RUN_TEST (test_mailbox_safe_multiple_producers);
+    RUN_TEST (test_benchmark);
+    return UNITY_END ();
+}
@@ -27,6 +27,14 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #include <unity.h>
 
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined __GLIBC__
+#include <malloc.h>
+#endif
+
 void setUp ()
 {
 }
@@ -421,6 +429,129 @@ void test_rm_with_callback_duplicate_uniq_only ()
     mtrie.rm (&pipes[1], check_count, &count, true);
 }
 
+void test_split_and_merge ()
+{
+    int pipes[4];
+    const char *names[] = {"foobar", "foo", "fox", "foobaz"};
+
+    zmq::generic_mtrie_t<int> mtrie;
+    add_entries (mtrie, pipes, names);
+
+    const zmq::generic_mtrie_t<int>::prefix_t data =
+      reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> ("foobarbaz");
+    int count = 0;
+    mtrie.match (data, getlen (data), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (2, count);
+
+    const zmq::generic_mtrie_t<int>::prefix_t name_data =
+      reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> (names[1]);
+    TEST_ASSERT_EQUAL (zmq::generic_mtrie_t<int>::last_value_removed,
+                       mtrie.rm (name_data, getlen (name_data), &pipes[1]));
+    TEST_ASSERT_EQUAL (zmq::generic_mtrie_t<int>::not_found,
+                       mtrie.rm (name_data, getlen (name_data), &pipes[1]));
+
+    count = 0;
+    mtrie.match (data, getlen (data), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (1, count);
+
+    for (size_t i = 0; i < sizeof (names) / sizeof (names[0]); ++i)
+        if (i != 1)
+            mtrie.rm (&pipes[i], check_name, names[i], false);
+
+    count = 0;
+    mtrie.match (data, getlen (data), mtrie_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+}
+
+void rm_count (zmq::generic_mtrie_t<int>::prefix_t data_,
+               size_t len_,
+               int *count_)
+{
+    LIBZMQ_UNUSED (data_);
+    LIBZMQ_UNUSED (len_);
+    ++*count_;
+}
+
+//  Generates distinct topics of 20 to 60 bytes sharing a few hierarchical
+//  prefixes, the way market data topics typically look like.
+static void make_topics (std::vector<std::string> &topics_, int count_)
+{
+    std::set<std::string> unique;
+    const char *venues[] = {"xnas", "xnys", "bats", "arcx"};
+    const char *digits = "0123456789abcdef";
+    uint32_t seed = 1;
+    char buf[64];
+
+    while (topics_.size () != (size_t) count_) {
+        seed = seed * 1103515245 + 12345;
+        const size_t size = 20 + (seed >> 8) % 41;
+        int len = sprintf (buf, "md.%s.%04u.", venues[seed >> 30],
+                           (unsigned int) (seed >> 16) % 5000);
+        while ((size_t) len < size) {
+            seed = seed * 1103515245 + 12345;
+            buf[len++] = digits[seed >> 28];
+        }
+        if (unique.insert (std::string (buf, size)).second)
+            topics_.push_back (std::string (buf, size));
+    }
+}
+
+//  Returns the number of bytes allocated from the heap, 0 if unknown.
+static size_t heap_in_use ()
+{
+#if defined __GLIBC__ && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2 ().uordblks;
+#else
+    return 0;
+#endif
+}
+
+void test_benchmark_100k ()
+{
+    const int count = 100000;
+    std::vector<std::string> topics;
+    make_topics (topics, count);
+    int pipes[16];
+
+    const size_t heap_before = heap_in_use ();
+    void *watch = zmq_stopwatch_start ();
+
+    zmq::generic_mtrie_t<int> *mtrie = new zmq::generic_mtrie_t<int>;
+    for (int i = 0; i != count; i++)
+        mtrie->add (
+          reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> (
+            topics[i].data ()),
+          topics[i].size (), &pipes[i % 16]);
+    const unsigned long add_us = zmq_stopwatch_intermediate (watch);
+    const size_t heap_after = heap_in_use ();
+
+    int matches = 0;
+    for (int i = 0; i != count; i++)
+        mtrie->match (reinterpret_cast<zmq::generic_mtrie_t<int>::prefix_t> (
+                        topics[i].data ()),
+                      topics[i].size (), mtrie_count, &matches);
+    const unsigned long match_us = zmq_stopwatch_intermediate (watch) - add_us;
+    TEST_ASSERT_GREATER_OR_EQUAL (count, matches);
+
+    int removed = 0;
+    for (int i = 0; i != 16; i++)
+        mtrie->rm (&pipes[i], rm_count, &removed, false);
+    const unsigned long rm_us =
+      zmq_stopwatch_stop (watch) - add_us - match_us;
+    delete mtrie;
+    TEST_ASSERT_EQUAL_INT (count, removed);
+
+    //  Rates in millions of operations per second, latency in nanoseconds.
+    printf ("add: %.2f Mops/s, match: %.1f ns, rm: %.2f Mops/s",
+            (double) count / (add_us ? add_us : 1),
+            (double) match_us * 1000 / count,
+            (double) count / (rm_us ? rm_us : 1));
+    if (heap_after > heap_before)
+        printf (", memory: %.1f bytes/subscription",
+                (double) (heap_after - heap_before) / count);
+    printf ("\n");
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -453,5 +584,9 @@ int main (void)
     RUN_TEST (test_rm_with_callback_duplicate);
     RUN_TEST (test_rm_with_callback_duplicate_uniq_only);
 
+    RUN_TEST (test_split_and_merge);
+
+    RUN_TEST (test_benchmark_100k);
+
     return UNITY_END ();
 }
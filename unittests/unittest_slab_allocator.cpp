@@ -0,0 +1,227 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <slab_allocator.hpp>
+#include <config.hpp>
+#include <msg.hpp>
+
+#include <unity.h>
+
+#include <algorithm>
+#include <string.h>
+#include <vector>
+
+void setUp ()
+{
+    zmq::slab_enable ();
+}
+void tearDown ()
+{
+    zmq::slab_disable ();
+}
+
+void test_reuse ()
+{
+    void *block = zmq::slab_alloc (500);
+    TEST_ASSERT_NOT_NULL (block);
+    memset (block, 0, 500);
+    zmq::slab_free (block);
+
+    //  Blocks of the same size class are reused.
+    void *again = zmq::slab_alloc (600);
+    TEST_ASSERT_EQUAL_PTR (block, again);
+    zmq::slab_free (again);
+}
+
+void test_large_and_disabled ()
+{
+    //  Too large for any size class, allocated from the heap.
+    void *large = zmq::slab_alloc (1000000);
+    TEST_ASSERT_NOT_NULL (large);
+    memset (large, 0, 1000000);
+
+    void *block = zmq::slab_alloc (100);
+    zmq::slab_free (block);
+
+    //  Heap blocks can be freed after the allocator is disabled and
+    //  cached blocks are not handed out anymore.
+    zmq::slab_disable ();
+    void *heap = zmq::slab_alloc (100);
+    TEST_ASSERT_NOT_NULL (heap);
+    TEST_ASSERT_TRUE (heap != block);
+    zmq::slab_free (heap);
+    zmq::slab_free (large);
+    zmq::slab_enable ();
+
+    TEST_ASSERT_EQUAL_PTR (block, zmq::slab_alloc (100));
+    zmq::slab_free (block);
+}
+
+struct blocks_t
+{
+    std::vector<void *> blocks;
+    size_t size;
+};
+
+static void alloc_blocks (void *blocks_)
+{
+    blocks_t *blocks = static_cast<blocks_t *> (blocks_);
+    for (size_t i = 0; i != blocks->blocks.size (); i++) {
+        blocks->blocks[i] = zmq::slab_alloc (blocks->size);
+        TEST_ASSERT_NOT_NULL (blocks->blocks[i]);
+        memset (blocks->blocks[i], (int) i, blocks->size);
+    }
+}
+
+static void free_blocks (void *blocks_)
+{
+    blocks_t *blocks = static_cast<blocks_t *> (blocks_);
+    for (size_t i = 0; i != blocks->blocks.size (); i++)
+        zmq::slab_free (blocks->blocks[i]);
+}
+
+//  Blocks freed by other threads go back to the cache of the thread
+//  that allocated them.
+void test_remote_free ()
+{
+    blocks_t blocks;
+    blocks.blocks.resize (100);
+    blocks.size = 1000;
+    alloc_blocks (&blocks);
+    std::vector<void *> first = blocks.blocks;
+
+    void *thread = zmq_threadstart (free_blocks, &blocks);
+    zmq_threadclose (thread);
+
+    alloc_blocks (&blocks);
+    for (size_t i = 0; i != blocks.blocks.size (); i++)
+        TEST_ASSERT_TRUE (std::find (first.begin (), first.end (),
+                                     blocks.blocks[i])
+                          != first.end ());
+    free_blocks (&blocks);
+}
+
+//  Of a burst of blocks freed by other threads, the cache keeps as many as
+//  it keeps of the blocks freed locally, the others go back to the heap.
+void test_remote_free_burst ()
+{
+    const size_t limit = zmq::slab_cache_size / 8192;
+    blocks_t blocks;
+    blocks.blocks.resize (4 * limit);
+    blocks.size = 8000;
+    alloc_blocks (&blocks);
+    std::vector<void *> first = blocks.blocks;
+
+    void *thread = zmq_threadstart (free_blocks, &blocks);
+    zmq_threadclose (thread);
+
+    //  The blocks kept are handed out first.
+    blocks.blocks.resize (limit);
+    alloc_blocks (&blocks);
+    for (size_t i = 0; i != blocks.blocks.size (); i++)
+        TEST_ASSERT_TRUE (std::find (first.begin (), first.end (),
+                                     blocks.blocks[i])
+                          != first.end ());
+    free_blocks (&blocks);
+}
+
+//  Blocks can be freed after the thread that allocated them exited.
+void test_owner_exited ()
+{
+    blocks_t blocks;
+    blocks.blocks.resize (100);
+    blocks.size = 2000;
+    void *thread = zmq_threadstart (alloc_blocks, &blocks);
+    zmq_threadclose (thread);
+
+    free_blocks (&blocks);
+}
+
+struct transfer_t
+{
+    zmq::msg_t *msgs;
+    size_t count;
+};
+
+static void close_msgs (void *transfer_)
+{
+    transfer_t *transfer = static_cast<transfer_t *> (transfer_);
+    for (size_t i = 0; i != transfer->count; i++)
+        TEST_ASSERT_EQUAL_INT (0, transfer->msgs[i].close ());
+}
+
+//  Measures initialising messages of 100 to 2000 bytes in one thread and
+//  closing them in another one.
+static unsigned long benchmark ()
+{
+    const size_t batch = 10000;
+    const int batches = 50;
+    std::vector<zmq::msg_t> msgs (batch);
+    transfer_t transfer = {&msgs[0], batch};
+
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != batches; i++) {
+        for (size_t j = 0; j != batch; j++)
+            TEST_ASSERT_EQUAL_INT (0,
+                                   msgs[j].init_size (100 + (j * 97) % 1900));
+        void *thread = zmq_threadstart (close_msgs, &transfer);
+        zmq_threadclose (thread);
+    }
+    return zmq_stopwatch_stop (watch) * 1000 / (batch * batches);
+}
+
+void test_benchmark ()
+{
+    //  Warm the caches up.
+    benchmark ();
+    const unsigned long slab_ns = benchmark ();
+    zmq::slab_disable ();
+    const unsigned long heap_ns = benchmark ();
+    zmq::slab_enable ();
+
+    printf ("message of 100-2000 bytes: slab %lu ns, heap %lu ns\n", slab_ns,
+            heap_ns);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_reuse);
+    RUN_TEST (test_large_and_disabled);
+    RUN_TEST (test_remote_free);
+    RUN_TEST (test_remote_free_burst);
+    RUN_TEST (test_owner_exited);
+
+    RUN_TEST (test_benchmark);
+    return UNITY_END ();
+}
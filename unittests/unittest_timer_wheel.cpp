@@ -0,0 +1,292 @@
+/*
+Copyright (c) 2018 Contributors as noted in the AUTHORS file
+
+This file is part of 0MQ.
+
+0MQ is free software; you can redistribute it and/or modify it under
+the terms of the GNU Lesser General Public License as published by
+the Free Software Foundation; either version 3 of the License, or
+(at your option) any later version.
+
+0MQ is distributed in the hope that it will be useful,
+but WITHOUT ANY WARRANTY; without even the implied warranty of
+MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+GNU Lesser General Public License for more details.
+
+You should have received a copy of the GNU Lesser General Public License
+along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "../tests/testutil.hpp"
+
+#include <timer_wheel.hpp>
+#include <i_poll_events.hpp>
+
+#include <unity.h>
+
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+struct test_sink_t : zmq::i_poll_events
+{
+    test_sink_t () : wheel (NULL), now (0) {}
+
+    virtual void in_event () {}
+    virtual void out_event () {}
+
+    virtual void timer_event (int id_)
+    {
+        fired.push_back (std::make_pair (id_, now));
+
+        //  Negative IDs re-add the timer to expire immediately, once.
+        if (id_ < 0)
+            wheel->add (now, this, -id_);
+    }
+
+    //  Executes the timers due at now_.
+    uint64_t execute (zmq::timer_wheel_t &wheel_, uint64_t now_)
+    {
+        wheel = &wheel_;
+        now = now_;
+        return wheel_.execute (now_);
+    }
+
+    zmq::timer_wheel_t *wheel;
+    uint64_t now;
+    std::vector<std::pair<int, uint64_t> > fired;
+};
+
+void test_create ()
+{
+    zmq::timer_wheel_t wheel;
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_execute_empty ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    TEST_ASSERT_EQUAL_UINT64 (0, sink.execute (wheel, 1000));
+}
+
+void test_add_execute_single ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.execute (wheel, 1000);
+
+    wheel.add (1100, &sink, 1);
+    TEST_ASSERT_FALSE (wheel.empty ());
+
+    TEST_ASSERT_EQUAL_UINT64 (100, sink.execute (wheel, 1000));
+    TEST_ASSERT_EQUAL_UINT64 (1, sink.execute (wheel, 1099));
+    TEST_ASSERT_EQUAL_UINT64 (0, sink.fired.size ());
+
+    TEST_ASSERT_EQUAL_UINT64 (0, sink.execute (wheel, 1100));
+    TEST_ASSERT_EQUAL_UINT64 (1, sink.fired.size ());
+    TEST_ASSERT_EQUAL_INT (1, sink.fired[0].first);
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_add_expired ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.execute (wheel, 1000);
+
+    wheel.add (900, &sink, 1);
+    sink.execute (wheel, 1000);
+    TEST_ASSERT_EQUAL_UINT64 (1, sink.fired.size ());
+}
+
+void test_cancel ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.execute (wheel, 1000);
+
+    zmq::timer_wheel_t::handle_t handle = wheel.add (1010, &sink, 1);
+    wheel.add (1020, &sink, 2);
+    wheel.cancel (handle);
+
+    sink.execute (wheel, 2000);
+    TEST_ASSERT_EQUAL_UINT64 (1, sink.fired.size ());
+    TEST_ASSERT_EQUAL_INT (2, sink.fired[0].first);
+    TEST_ASSERT_TRUE (wheel.empty ());
+}
+
+void test_cancel_last_timer ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+
+    wheel.cancel (wheel.add (1010, &sink, 1));
+    TEST_ASSERT_TRUE (wheel.empty ());
+    TEST_ASSERT_EQUAL_UINT64 (0, sink.execute (wheel, 2000));
+}
+
+void test_pending ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.execute (wheel, 1000);
+
+    zmq::timer_wheel_t::handle_t expired = wheel.add (1010, &sink, 1);
+    zmq::timer_wheel_t::handle_t cancelled = wheel.add (1020, &sink, 2);
+    TEST_ASSERT_TRUE (wheel.pending (expired));
+    TEST_ASSERT_TRUE (wheel.pending (cancelled));
+
+    wheel.cancel (cancelled);
+    TEST_ASSERT_FALSE (wheel.pending (cancelled));
+    sink.execute (wheel, 1015);
+    TEST_ASSERT_FALSE (wheel.pending (expired));
+
+    //  Handles of released entries stay stale when the entries are reused.
+    zmq::timer_wheel_t::handle_t handle = wheel.add (1030, &sink, 3);
+    TEST_ASSERT_TRUE (wheel.pending (handle));
+    TEST_ASSERT_FALSE (wheel.pending (expired));
+    TEST_ASSERT_FALSE (wheel.pending (cancelled));
+}
+
+void test_add_from_handler ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.execute (wheel, 1000);
+
+    wheel.add (1005, &sink, -1);
+    sink.execute (wheel, 1005);
+    TEST_ASSERT_EQUAL_UINT64 (2, sink.fired.size ());
+    TEST_ASSERT_EQUAL_INT (1, sink.fired[1].first);
+    TEST_ASSERT_EQUAL_UINT64 (1005, sink.fired[1].second);
+}
+
+//  Timers spanning all the levels of the wheel must fire exactly at their
+//  expiration when the wheel is advanced the way the pollers do.
+void test_expiration_across_levels ()
+{
+    const uint64_t base = 123456789;
+    const uint64_t timeouts[] = {0,
+                                 1,
+                                 255,
+                                 256,
+                                 257,
+                                 65535,
+                                 65536,
+                                 65537,
+                                 1000000,
+                                 1 << 24,
+                                 (1 << 24) + 1,
+                                 2147483647,
+                                 4294967303ULL};
+    const int count = sizeof timeouts / sizeof timeouts[0];
+
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.execute (wheel, base);
+    for (int i = 0; i != count; i++)
+        wheel.add (base + timeouts[i], &sink, i);
+
+    uint64_t now = base;
+    while (!wheel.empty ()) {
+        const uint64_t timeout = sink.execute (wheel, now);
+        if (timeout)
+            now += timeout;
+    }
+
+    TEST_ASSERT_EQUAL_UINT64 (count, sink.fired.size ());
+    for (int i = 0; i != count; i++) {
+        TEST_ASSERT_EQUAL_INT (i, sink.fired[i].first);
+        TEST_ASSERT_EQUAL_UINT64 (base + timeouts[i], sink.fired[i].second);
+    }
+}
+
+//  Advancing the clock in big leaps fires all the due timers in order.
+void test_clock_leap ()
+{
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.execute (wheel, 0);
+    for (int i = 0; i != 1000; i++)
+        wheel.add ((uint64_t) (999 - i) * 997, &sink, 999 - i);
+
+    sink.execute (wheel, 500000);
+    sink.execute (wheel, 1000000);
+
+    TEST_ASSERT_EQUAL_UINT64 (1000, sink.fired.size ());
+    for (int i = 0; i != 1000; i++)
+        TEST_ASSERT_EQUAL_INT (i, sink.fired[i].first);
+}
+
+//  Measures throughput of adding, cancelling and executing timers with
+//  100k timers scheduled, with timeouts in the range of heartbeat,
+//  handshake and reconnect intervals.
+void test_benchmark_100k ()
+{
+    const int count = 100000;
+    const uint64_t base = 1000000;
+
+    zmq::timer_wheel_t wheel;
+    test_sink_t sink;
+    sink.fired.reserve (count);
+    sink.execute (wheel, base);
+
+    std::vector<zmq::timer_wheel_t::handle_t> handles (count);
+    uint32_t seed = 1;
+
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != count; i++) {
+        seed = seed * 1103515245 + 12345;
+        handles[i] = wheel.add (base + 1 + (seed >> 8) % 60000, &sink, i);
+    }
+    const unsigned long add_us = zmq_stopwatch_intermediate (watch);
+
+    for (int i = 0; i < count; i += 2)
+        wheel.cancel (handles[i]);
+    const unsigned long cancel_us = zmq_stopwatch_intermediate (watch);
+
+    uint64_t now = base;
+    while (!wheel.empty ()) {
+        const uint64_t timeout = sink.execute (wheel, now);
+        if (timeout)
+            now += timeout;
+    }
+    const unsigned long execute_us = zmq_stopwatch_stop (watch) - cancel_us;
+    const unsigned long cancel_only_us = cancel_us - add_us;
+
+    TEST_ASSERT_EQUAL_UINT64 (count / 2, sink.fired.size ());
+    for (size_t i = 1; i < sink.fired.size (); i++)
+        TEST_ASSERT_TRUE (sink.fired[i - 1].second <= sink.fired[i].second);
+
+    //  Rates in millions of operations per second.
+    printf ("add: %.1f Mops/s, cancel: %.1f Mops/s, execute: %.1f Mops/s\n",
+            (double) count / (add_us ? add_us : 1),
+            (double) (count / 2) / (cancel_only_us ? cancel_only_us : 1),
+            (double) (count / 2) / (execute_us ? execute_us : 1));
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_create);
+    RUN_TEST (test_execute_empty);
+    RUN_TEST (test_add_execute_single);
+    RUN_TEST (test_add_expired);
+    RUN_TEST (test_cancel);
+    RUN_TEST (test_cancel_last_timer);
+    RUN_TEST (test_pending);
+    RUN_TEST (test_add_from_handler);
+    RUN_TEST (test_expiration_across_levels);
+    RUN_TEST (test_clock_leap);
+    RUN_TEST (test_benchmark_100k);
+    return UNITY_END ();
+}
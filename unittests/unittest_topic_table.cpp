@@ -0,0 +1,289 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#if defined(min)
+#undef min
+#endif
+
+#include <topic_table.hpp>
+#include <topic_set.hpp>
+#include <topic_map.hpp>
+#include <generic_mtrie_impl.hpp>
+
+#include <unity.h>
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static const unsigned char *data (const std::string &s_)
+{
+    return (const unsigned char *) s_.data ();
+}
+
+void test_table_insert_find_erase ()
+{
+    zmq::topic_table_t<int> table;
+    TEST_ASSERT_NULL (table.find (data ("foo"), 3));
+    TEST_ASSERT_FALSE (table.erase (data ("foo"), 3));
+
+    table.insert (data ("foo"), 3) = 1;
+    table.insert (data ("fo"), 2) = 2;
+    table.insert (NULL, 0) = 3;
+    TEST_ASSERT_EQUAL_UINT (3, table.size ());
+    TEST_ASSERT_EQUAL_INT (1, *table.find (data ("foo"), 3));
+    TEST_ASSERT_EQUAL_INT (2, *table.find (data ("fo"), 2));
+    TEST_ASSERT_EQUAL_INT (3, *table.find (NULL, 0));
+    TEST_ASSERT_NULL (table.find (data ("foobar"), 6));
+
+    TEST_ASSERT_EQUAL_INT (1, table.insert (data ("foo"), 3));
+    TEST_ASSERT_TRUE (table.erase (data ("foo"), 3));
+    TEST_ASSERT_NULL (table.find (data ("foo"), 3));
+    TEST_ASSERT_EQUAL_INT (2, *table.find (data ("fo"), 2));
+    TEST_ASSERT_EQUAL_UINT (2, table.size ());
+}
+
+//  Compares the table with std::map over random insertions and removals,
+//  exercising growth and the backward shift of colliding entries.
+void test_table_random ()
+{
+    zmq::topic_table_t<int> table;
+    std::map<std::string, int> reference;
+    uint32_t seed = 1;
+    char buf[16];
+
+    for (int i = 0; i != 100000; i++) {
+        seed = seed * 1103515245 + 12345;
+        const std::string key (buf, sprintf (buf, "t%u", (seed >> 16) % 2000));
+        if ((seed >> 8) & 1) {
+            table.insert (data (key), key.size ()) = i;
+            reference[key] = i;
+        } else
+            TEST_ASSERT_EQUAL (reference.erase (key) == 1,
+                               table.erase (data (key), key.size ()));
+    }
+
+    TEST_ASSERT_EQUAL_UINT (reference.size (), table.size ());
+    for (std::map<std::string, int>::iterator it = reference.begin ();
+         it != reference.end (); ++it) {
+        int *value = table.find (data (it->first), it->first.size ());
+        TEST_ASSERT_NOT_NULL (value);
+        TEST_ASSERT_EQUAL_INT (it->second, *value);
+    }
+
+    size_t count = 0;
+    for (size_t i = 0; i != table.capacity (); i++)
+        if (table.key (i))
+            count++;
+    TEST_ASSERT_EQUAL_UINT (reference.size (), count);
+}
+
+//  Each table seeds its hash, so the same keys end up in different slots
+//  of different tables.
+void test_table_seeded ()
+{
+    zmq::topic_table_t<int> first;
+    zmq::topic_table_t<int> second;
+    char buf[16];
+    for (int i = 0; i != 1000; i++) {
+        const std::string key (buf, sprintf (buf, "t%d", i));
+        first.insert (data (key), key.size ()) = 1;
+        second.insert (data (key), key.size ()) = 1;
+    }
+
+    TEST_ASSERT_EQUAL_UINT (first.capacity (), second.capacity ());
+    size_t same = 0;
+    for (size_t i = 0; i != first.capacity (); i++)
+        if (first.key (i) && second.key (i)
+            && first.key_size (i) == second.key_size (i)
+            && memcmp (first.key (i), second.key (i), first.key_size (i))
+                 == 0)
+            same++;
+    TEST_ASSERT_LESS_THAN_UINT (1000, same);
+}
+
+void test_table_compact ()
+{
+    zmq::topic_table_t<int> table;
+    table.compact ();
+    table.insert (data ("foo"), 3) = 1;
+    table.insert (data ("bar"), 3) = 0;
+    table.insert (data ("baz"), 3) = 2;
+    table.compact ();
+    TEST_ASSERT_EQUAL_UINT (2, table.size ());
+    TEST_ASSERT_NULL (table.find (data ("bar"), 3));
+    TEST_ASSERT_EQUAL_INT (2, *table.find (data ("baz"), 3));
+}
+
+void test_set ()
+{
+    zmq::topic_set_t set;
+    unsigned char *foo = (unsigned char *) "foo";
+    TEST_ASSERT_TRUE (set.add (foo, 3));
+    TEST_ASSERT_FALSE (set.add (foo, 3));
+    TEST_ASSERT_TRUE (set.check (foo, 3));
+    TEST_ASSERT_FALSE (set.check (foo, 2));
+    TEST_ASSERT_FALSE (set.check ((unsigned char *) "foobar", 6));
+
+    TEST_ASSERT_FALSE (set.rm (foo, 3));
+    TEST_ASSERT_TRUE (set.check (foo, 3));
+    TEST_ASSERT_TRUE (set.rm (foo, 3));
+    TEST_ASSERT_FALSE (set.check (foo, 3));
+    TEST_ASSERT_FALSE (set.rm (foo, 3));
+}
+
+static void map_count (int *pipe_, int *count_)
+{
+    LIBZMQ_UNUSED (pipe_);
+    ++*count_;
+}
+
+static void rm_count (const unsigned char *data_, size_t size_, int *count_)
+{
+    LIBZMQ_UNUSED (data_);
+    LIBZMQ_UNUSED (size_);
+    ++*count_;
+}
+
+void test_map ()
+{
+    int pipes[2];
+    zmq::generic_topic_map_t<int> map;
+    TEST_ASSERT_TRUE (map.add (data ("foo"), 3, &pipes[0]));
+    TEST_ASSERT_FALSE (map.add (data ("foo"), 3, &pipes[1]));
+    TEST_ASSERT_TRUE (map.add (data ("bar"), 3, &pipes[0]));
+
+    int count = 0;
+    map.match (data ("foo"), 3, map_count, &count);
+    TEST_ASSERT_EQUAL_INT (2, count);
+    count = 0;
+    map.match (data ("foobar"), 6, map_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+
+    TEST_ASSERT_EQUAL (zmq::generic_topic_map_t<int>::values_remain,
+                       map.rm (data ("foo"), 3, &pipes[1]));
+    TEST_ASSERT_EQUAL (zmq::generic_topic_map_t<int>::not_found,
+                       map.rm (data ("foo"), 3, &pipes[1]));
+
+    //  Removing the pipe reports both of its topics.
+    count = 0;
+    map.rm (&pipes[0], rm_count, &count, true);
+    TEST_ASSERT_EQUAL_INT (2, count);
+    count = 0;
+    map.match (data ("foo"), 3, map_count, &count);
+    map.match (data ("bar"), 3, map_count, &count);
+    TEST_ASSERT_EQUAL_INT (0, count);
+}
+
+//  Generates distinct topics of 20 to 60 bytes sharing a few hierarchical
+//  prefixes, the way market data topics typically look like.
+static void make_topics (std::vector<std::string> &topics_, int count_)
+{
+    std::set<std::string> unique;
+    const char *venues[] = {"xnas", "xnys", "bats", "arcx"};
+    const char *digits = "0123456789abcdef";
+    uint32_t seed = 1;
+    char buf[64];
+
+    while (topics_.size () != (size_t) count_) {
+        seed = seed * 1103515245 + 12345;
+        const size_t size = 20 + (seed >> 8) % 41;
+        int len = sprintf (buf, "md.%s.%04u.", venues[seed >> 30],
+                           (unsigned int) (seed >> 16) % 5000);
+        while ((size_t) len < size) {
+            seed = seed * 1103515245 + 12345;
+            buf[len++] = digits[seed >> 28];
+        }
+        if (unique.insert (std::string (buf, size)).second)
+            topics_.push_back (std::string (buf, size));
+    }
+}
+
+//  Compares matching 100k exact topics, each subscribed by one of 16
+//  pipes, with the topic map and with the prefix trie.
+void test_benchmark_100k ()
+{
+    const int count = 100000;
+    std::vector<std::string> topics;
+    make_topics (topics, count);
+    int pipes[16];
+
+    zmq::generic_topic_map_t<int> map;
+    zmq::generic_mtrie_t<int> mtrie;
+    for (int i = 0; i != count; i++) {
+        map.add (data (topics[i]), topics[i].size (), &pipes[i % 16]);
+        mtrie.add (data (topics[i]), topics[i].size (), &pipes[i % 16]);
+    }
+
+    int map_matches = 0;
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != count; i++)
+        map.match (data (topics[i]), topics[i].size (), map_count,
+                   &map_matches);
+    const unsigned long map_us = zmq_stopwatch_intermediate (watch);
+
+    int mtrie_matches = 0;
+    for (int i = 0; i != count; i++)
+        mtrie.match (data (topics[i]), topics[i].size (), map_count,
+                     &mtrie_matches);
+    const unsigned long mtrie_us = zmq_stopwatch_stop (watch) - map_us;
+
+    TEST_ASSERT_EQUAL_INT (count, map_matches);
+    TEST_ASSERT_EQUAL_INT (count, mtrie_matches);
+
+    //  Latency in nanoseconds.
+    printf ("match: topic map %.1f ns, mtrie %.1f ns\n",
+            (double) map_us * 1000 / count, (double) mtrie_us * 1000 / count);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_table_insert_find_erase);
+    RUN_TEST (test_table_random);
+    RUN_TEST (test_table_seeded);
+    RUN_TEST (test_table_compact);
+    RUN_TEST (test_set);
+    RUN_TEST (test_map);
+
+    RUN_TEST (test_benchmark_100k);
+    return UNITY_END ();
+}
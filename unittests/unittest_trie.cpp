@@ -0,0 +1,248 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <trie.hpp>
+
+#include <unity.h>
+
+#include <set>
+#include <string>
+#include <vector>
+
+#if defined __GLIBC__
+#include <malloc.h>
+#endif
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+static bool add (zmq::trie_t &trie_, const char *name_)
+{
+    return trie_.add ((unsigned char *) name_, strlen (name_));
+}
+
+static bool rm (zmq::trie_t &trie_, const char *name_)
+{
+    return trie_.rm ((unsigned char *) name_, strlen (name_));
+}
+
+static bool check (zmq::trie_t &trie_, const char *data_)
+{
+    return trie_.check ((unsigned char *) data_, strlen (data_));
+}
+
+void test_check_empty ()
+{
+    zmq::trie_t trie;
+    TEST_ASSERT_FALSE (check (trie, ""));
+    TEST_ASSERT_FALSE (check (trie, "foo"));
+}
+
+void test_add_check ()
+{
+    zmq::trie_t trie;
+    TEST_ASSERT_TRUE (add (trie, "foo"));
+    TEST_ASSERT_FALSE (add (trie, "foo"));
+
+    TEST_ASSERT_TRUE (check (trie, "foo"));
+    TEST_ASSERT_TRUE (check (trie, "foobar"));
+    TEST_ASSERT_FALSE (check (trie, "fo"));
+    TEST_ASSERT_FALSE (check (trie, "fox"));
+    TEST_ASSERT_FALSE (check (trie, ""));
+}
+
+void test_add_empty_prefix ()
+{
+    zmq::trie_t trie;
+    TEST_ASSERT_TRUE (add (trie, ""));
+    TEST_ASSERT_TRUE (check (trie, ""));
+    TEST_ASSERT_TRUE (check (trie, "anything"));
+    TEST_ASSERT_TRUE (rm (trie, ""));
+    TEST_ASSERT_FALSE (check (trie, "anything"));
+}
+
+void test_split_and_merge ()
+{
+    zmq::trie_t trie;
+    TEST_ASSERT_TRUE (add (trie, "foobar"));
+    TEST_ASSERT_TRUE (add (trie, "foobaz"));
+    TEST_ASSERT_TRUE (add (trie, "foo"));
+    TEST_ASSERT_TRUE (add (trie, "fox"));
+
+    TEST_ASSERT_TRUE (check (trie, "foobar"));
+    TEST_ASSERT_TRUE (check (trie, "foobaz"));
+    TEST_ASSERT_TRUE (check (trie, "fooba"));
+    TEST_ASSERT_TRUE (check (trie, "fox1"));
+    TEST_ASSERT_FALSE (check (trie, "fo"));
+
+    TEST_ASSERT_TRUE (rm (trie, "foo"));
+    TEST_ASSERT_FALSE (rm (trie, "foo"));
+    TEST_ASSERT_FALSE (rm (trie, "fooba"));
+    TEST_ASSERT_FALSE (check (trie, "fooba"));
+    TEST_ASSERT_TRUE (check (trie, "foobar"));
+
+    TEST_ASSERT_TRUE (rm (trie, "foobar"));
+    TEST_ASSERT_FALSE (check (trie, "foobar"));
+    TEST_ASSERT_TRUE (check (trie, "foobaz"));
+    TEST_ASSERT_TRUE (rm (trie, "foobaz"));
+    TEST_ASSERT_TRUE (rm (trie, "fox"));
+    TEST_ASSERT_FALSE (check (trie, "fox"));
+}
+
+void test_rm_refcounted ()
+{
+    zmq::trie_t trie;
+    TEST_ASSERT_TRUE (add (trie, "foo"));
+    TEST_ASSERT_FALSE (add (trie, "foo"));
+    TEST_ASSERT_FALSE (rm (trie, "foo"));
+    TEST_ASSERT_TRUE (check (trie, "foo"));
+    TEST_ASSERT_TRUE (rm (trie, "foo"));
+    TEST_ASSERT_FALSE (check (trie, "foo"));
+}
+
+static void collect (unsigned char *data_, size_t size_, void *arg_)
+{
+    static_cast<std::vector<std::string> *> (arg_)->push_back (
+      std::string ((char *) data_, size_));
+}
+
+void test_apply ()
+{
+    const char *names[] = {"foobar", "", "fox", "foo", "bar"};
+    zmq::trie_t trie;
+    for (size_t i = 0; i != sizeof (names) / sizeof (names[0]); i++)
+        add (trie, names[i]);
+
+    std::vector<std::string> subscriptions;
+    trie.apply (collect, &subscriptions);
+
+    TEST_ASSERT_EQUAL_UINT (5, subscriptions.size ());
+    TEST_ASSERT_EQUAL_STRING ("", subscriptions[0].c_str ());
+    TEST_ASSERT_EQUAL_STRING ("bar", subscriptions[1].c_str ());
+    TEST_ASSERT_EQUAL_STRING ("foo", subscriptions[2].c_str ());
+    TEST_ASSERT_EQUAL_STRING ("foobar", subscriptions[3].c_str ());
+    TEST_ASSERT_EQUAL_STRING ("fox", subscriptions[4].c_str ());
+}
+
+//  Generates distinct topics of 20 to 60 bytes sharing a few hierarchical
+//  prefixes, the way market data topics typically look like.
+static void make_topics (std::vector<std::string> &topics_, int count_)
+{
+    std::set<std::string> unique;
+    const char *venues[] = {"xnas", "xnys", "bats", "arcx"};
+    const char *digits = "0123456789abcdef";
+    uint32_t seed = 1;
+    char buf[64];
+
+    while (topics_.size () != (size_t) count_) {
+        seed = seed * 1103515245 + 12345;
+        const size_t size = 20 + (seed >> 8) % 41;
+        int len = sprintf (buf, "md.%s.%04u.", venues[seed >> 30],
+                           (unsigned int) (seed >> 16) % 5000);
+        while ((size_t) len < size) {
+            seed = seed * 1103515245 + 12345;
+            buf[len++] = digits[seed >> 28];
+        }
+        if (unique.insert (std::string (buf, size)).second)
+            topics_.push_back (std::string (buf, size));
+    }
+}
+
+//  Returns the number of bytes allocated from the heap, 0 if unknown.
+static size_t heap_in_use ()
+{
+#if defined __GLIBC__ && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+    return mallinfo2 ().uordblks;
+#else
+    return 0;
+#endif
+}
+
+void test_benchmark_100k ()
+{
+    const int count = 100000;
+    std::vector<std::string> topics;
+    make_topics (topics, count);
+
+    const size_t heap_before = heap_in_use ();
+    void *watch = zmq_stopwatch_start ();
+
+    zmq::trie_t *trie = new zmq::trie_t;
+    for (int i = 0; i != count; i++)
+        TEST_ASSERT_TRUE (trie->add ((unsigned char *) topics[i].data (),
+                                     topics[i].size ()));
+    const unsigned long add_us = zmq_stopwatch_intermediate (watch);
+    const size_t heap_after = heap_in_use ();
+
+    int matches = 0;
+    for (int i = 0; i != count; i++)
+        matches += trie->check ((unsigned char *) topics[i].data (),
+                                topics[i].size ());
+    const unsigned long check_us = zmq_stopwatch_intermediate (watch) - add_us;
+    TEST_ASSERT_EQUAL_INT (count, matches);
+
+    for (int i = 0; i != count; i++)
+        TEST_ASSERT_TRUE (
+          trie->rm ((unsigned char *) topics[i].data (), topics[i].size ()));
+    const unsigned long rm_us =
+      zmq_stopwatch_stop (watch) - add_us - check_us;
+    delete trie;
+
+    //  Rates in millions of operations per second, latency in nanoseconds.
+    printf ("add: %.2f Mops/s, check: %.1f ns, rm: %.2f Mops/s",
+            (double) count / (add_us ? add_us : 1),
+            (double) check_us * 1000 / count,
+            (double) count / (rm_us ? rm_us : 1));
+    if (heap_after > heap_before)
+        printf (", memory: %.1f bytes/subscription",
+                (double) (heap_after - heap_before) / count);
+    printf ("\n");
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_check_empty);
+    RUN_TEST (test_add_check);
+    RUN_TEST (test_add_empty_prefix);
+    RUN_TEST (test_split_and_merge);
+    RUN_TEST (test_rm_refcounted);
+    RUN_TEST (test_apply);
+
+    RUN_TEST (test_benchmark_100k);
+    return UNITY_END ();
+}
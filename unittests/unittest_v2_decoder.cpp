@@ -0,0 +1,234 @@
+/*
+    Copyright (c) 2007-2018 Contributors as noted in the AUTHORS file
+
+    This file is part of libzmq, the ZeroMQ core engine in C++.
+
+    libzmq is free software; you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License (LGPL) as published
+    by the Free Software Foundation; either version 3 of the License, or
+    (at your option) any later version.
+
+    As a special exception, the Contributors give you permission to link
+    this library with independent modules to produce an executable,
+    regardless of the license terms of these independent modules, and to
+    copy and distribute the resulting executable under terms of your choice,
+    provided that you also meet, for each linked independent module, the
+    terms and conditions of the license of that module. An independent
+    module is a module which is not derived from or based on this library.
+    If you modify this library, you must extend this exception to your
+    version of the library.
+
+    libzmq is distributed in the hope that it will be useful, but WITHOUT
+    ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "../tests/testutil.hpp"
+
+#include <v2_decoder.hpp>
+#include <v2_protocol.hpp>
+#include <wire.hpp>
+
+#include <unity.h>
+
+#include <string.h>
+#include <vector>
+
+void setUp ()
+{
+}
+void tearDown ()
+{
+}
+
+typedef std::vector<unsigned char> bytes_t;
+
+//  Appends a ZMTP/2.0 frame of the given size, filled with a pattern
+//  derived from the size, to the stream.
+static void add_frame (bytes_t &stream_, size_t size_, unsigned char flags_)
+{
+    if (size_ > UCHAR_MAX) {
+        unsigned char size[8];
+        zmq::put_uint64 (size, size_);
+        stream_.push_back (flags_ | zmq::v2_protocol_t::large_flag);
+        stream_.insert (stream_.end (), size, size + 8);
+    } else {
+        stream_.push_back (flags_);
+        stream_.push_back (static_cast<unsigned char> (size_));
+    }
+    for (size_t i = 0; i != size_; i++)
+        stream_.push_back (static_cast<unsigned char> (size_ + i));
+}
+
+static void check_frame (zmq::msg_t *msg_, size_t size_, unsigned char flags_)
+{
+    TEST_ASSERT_EQUAL_UINT (size_, msg_->size ());
+    TEST_ASSERT_EQUAL (
+      (flags_ & zmq::v2_protocol_t::more_flag) != 0,
+      (msg_->flags () & zmq::msg_t::more) != 0);
+    TEST_ASSERT_EQUAL (
+      (flags_ & zmq::v2_protocol_t::command_flag) != 0,
+      (msg_->flags () & zmq::msg_t::command) != 0);
+    const unsigned char *data =
+      static_cast<const unsigned char *> (msg_->data ());
+    for (size_t i = 0; i != size_; i++)
+        TEST_ASSERT_EQUAL_UINT8 (static_cast<unsigned char> (size_ + i),
+                                 data[i]);
+}
+
+//  Feeds the stream to the decoder the way the stream engine does, at
+//  most chunk_ bytes per read. Returns the number of frames decoded,
+//  each of them passed to the callback.
+template <typename F>
+static size_t
+decode_stream (zmq::v2_decoder_t &decoder_, const bytes_t &stream_,
+               size_t chunk_, F func_)
+{
+    size_t frames = 0;
+    size_t pos = 0;
+    while (pos < stream_.size ()) {
+        unsigned char *buf;
+        size_t size;
+        decoder_.get_buffer (&buf, &size);
+        size = std::min (size, std::min (chunk_, stream_.size () - pos));
+        memcpy (buf, &stream_[pos], size);
+        pos += size;
+
+        size_t used = 0;
+        while (used < size) {
+            size_t processed;
+            const int rc = decoder_.decode (buf + used, size - used, processed);
+            TEST_ASSERT_NOT_EQUAL (-1, rc);
+            used += processed;
+            if (rc == 1)
+                func_ (decoder_.msg (), frames++);
+        }
+    }
+    return frames;
+}
+
+static const size_t sizes[] = {0, 1, 8, 20, 33, 34, 64, 255, 256, 1024, 9000};
+
+//  Flags of the index_-th frame of the mixed stream.
+static unsigned char mixed_flags (size_t index_)
+{
+    if (index_ % 3 == 0)
+        return zmq::v2_protocol_t::more_flag;
+    if (index_ % 3 == 1)
+        return zmq::v2_protocol_t::command_flag;
+    return 0;
+}
+
+struct check_mixed_t
+{
+    void operator() (zmq::msg_t *msg_, size_t index_)
+    {
+        const size_t count = sizeof sizes / sizeof sizes[0];
+        check_frame (msg_, sizes[index_ % count], mixed_flags (index_));
+    }
+};
+
+static void test_mixed_frames (bool zero_copy_, size_t chunk_)
+{
+    const size_t count = sizeof sizes / sizeof sizes[0];
+    bytes_t stream;
+    for (size_t i = 0; i != 3 * count; i++)
+        add_frame (stream, sizes[i % count], mixed_flags (i));
+
+    zmq::v2_decoder_t decoder (8192, -1, zero_copy_);
+    TEST_ASSERT_EQUAL_UINT (3 * count,
+                            decode_stream (decoder, stream, chunk_,
+                                           check_mixed_t ()));
+}
+
+void test_mixed_frames_whole ()
+{
+    test_mixed_frames (false, SIZE_MAX);
+    test_mixed_frames (true, SIZE_MAX);
+}
+
+void test_mixed_frames_split ()
+{
+    const size_t chunks[] = {1, 2, 3, 7, 35, 100};
+    for (size_t i = 0; i != sizeof chunks / sizeof chunks[0]; i++) {
+        test_mixed_frames (false, chunks[i]);
+        test_mixed_frames (true, chunks[i]);
+    }
+}
+
+void test_maxmsgsize ()
+{
+    bytes_t stream;
+    add_frame (stream, 4, 0);
+    add_frame (stream, 5, 0);
+
+    zmq::v2_decoder_t decoder (8192, 4, false);
+    unsigned char *buf;
+    size_t size;
+    decoder.get_buffer (&buf, &size);
+    memcpy (buf, &stream[0], stream.size ());
+
+    size_t processed;
+    TEST_ASSERT_EQUAL_INT (1, decoder.decode (buf, stream.size (), processed));
+    TEST_ASSERT_EQUAL_UINT (6, processed);
+    check_frame (decoder.msg (), 4, 0);
+
+    TEST_ASSERT_EQUAL_INT (
+      -1, decoder.decode (buf + 6, stream.size () - 6, processed));
+    TEST_ASSERT_EQUAL_INT (EMSGSIZE, errno);
+}
+
+struct count_t
+{
+    void operator() (zmq::msg_t *, size_t) {}
+};
+
+//  Measures the decoding rate of a stream of frames of the given size,
+//  read in batches of the default size.
+static void benchmark (size_t size_)
+{
+    const size_t count = 1000000;
+    bytes_t frame;
+    add_frame (frame, size_, 0);
+    bytes_t stream;
+    stream.reserve (frame.size () * (count / 10));
+    for (size_t i = 0; i != count / 10; i++)
+        stream.insert (stream.end (), frame.begin (), frame.end ());
+
+    zmq::v2_decoder_t decoder (8192, -1, true);
+    size_t frames = 0;
+    void *watch = zmq_stopwatch_start ();
+    for (int i = 0; i != 10; i++)
+        frames += decode_stream (decoder, stream, SIZE_MAX, count_t ());
+    unsigned long elapsed = zmq_stopwatch_stop (watch);
+    if (elapsed == 0)
+        elapsed = 1;
+
+    TEST_ASSERT_EQUAL_UINT (count, frames);
+    printf ("decode %d-byte frames: %lu frames/s\n", (int) size_,
+            (unsigned long) ((double) count * 1000000 / elapsed));
+}
+
+void test_benchmark ()
+{
+    benchmark (8);
+    benchmark (64);
+    benchmark (1024);
+}
+
+int main (void)
+{
+    setup_test_environment ();
+
+    UNITY_BEGIN ();
+    RUN_TEST (test_mixed_frames_whole);
+    RUN_TEST (test_mixed_frames_split);
+    RUN_TEST (test_maxmsgsize);
+
+    RUN_TEST (test_benchmark);
+    return UNITY_END ();
+}
@@ -72,6 +72,50 @@ void test_write_complete_and_flush_and_check_read_and_read ()
     TEST_ASSERT_EQUAL_INT (value, read_value);
 }
 
+//  Allocator handing out memory that is 8 bytes past a 64-byte boundary.
+//  The pointer returned by malloc is stored right in front of it.
+static int allocated_chunks = 0;
+
+static void *misaligned_allocate (size_t size_, void *)
+{
+    void *raw = malloc (size_ + 80);
+    TEST_ASSERT_NOT_NULL (raw);
+    uintptr_t pos = ((uintptr_t) raw + sizeof (void *) + 63) & ~(uintptr_t) 63;
+    pos += 8;
+    ((void **) pos)[-1] = raw;
+    allocated_chunks++;
+    return (void *) pos;
+}
+
+static void misaligned_deallocate (void *data_, size_t, void *)
+{
+    allocated_chunks--;
+    free (((void **) data_)[-1]);
+}
+
+void test_yqueue_custom_allocator_alignment ()
+{
+    const zmq::allocator_t allocator (misaligned_allocate,
+                                      misaligned_deallocate, NULL);
+    {
+        zmq::yqueue_t<int, 4> yqueue (allocator);
+
+        //  Each push into a fresh chunk stores the value at the start of
+        //  the chunk.
+        for (int i = 0; i != 32; i++) {
+            yqueue.push ();
+            yqueue.back () = i;
+            if (i % 4 == 0)
+                TEST_ASSERT_EQUAL_INT (0, (uintptr_t) &yqueue.back () % 64);
+        }
+        for (int i = 0; i != 32; i++) {
+            TEST_ASSERT_EQUAL_INT (i, yqueue.front ());
+            yqueue.pop ();
+        }
+    }
+    TEST_ASSERT_EQUAL_INT (0, allocated_chunks);
+}
+
 int main (void)
 {
     setup_test_environment ();
@@ -82,6 +126,7 @@ int main (void)
     RUN_TEST (test_read_empty);
     RUN_TEST (test_write_complete_and_check_read_and_read);
     RUN_TEST (test_write_complete_and_flush_and_check_read_and_read);
+    RUN_TEST (test_yqueue_custom_allocator_alignment);
 
     return UNITY_END ();
 }